@@ -69,6 +69,9 @@ struct fftwapidef<T> \
    FFTW_TEMPLATED_API_FUNC( MANGLE, cleanup_threads ); \
    FFTW_TEMPLATED_API_FUNC( MANGLE, destroy_plan ); \
    FFTW_TEMPLATED_API_FUNC( MANGLE, print_plan ); \
+   FFTW_TEMPLATED_API_FUNC( MANGLE, export_wisdom ); \
+   FFTW_TEMPLATED_API_FUNC( MANGLE, import_wisdom_from_string ); \
+   FFTW_TEMPLATED_API_FUNC( MANGLE, forget_wisdom ); \
    FFTW_TEMPLATED_API_FUNC( MANGLE, malloc ); \
    FFTW_TEMPLATED_API_FUNC( MANGLE, free ); \
 } // end fftwapidef<>
@@ -77,6 +77,8 @@ namespace dip {
 ///  - "ICS support": indicates ICS file reading and writing is available.
 ///  - "TIFF support": indicates TIFF file reading and writing is available.
 ///  - "JPEG support": indicates JPEG file reading and writing is available.
+///  - "CPU dispatch": indicates that some functions have code paths for specific instruction sets
+///    (SSE4.1, AVX2, AVX-512), selected at run time; see `dip::GetActiveISA`.
 struct DIP_NO_EXPORT LibraryInformation {
    String name;         ///< The library name
    String description;  ///< A short description string
@@ -90,6 +92,21 @@ struct DIP_NO_EXPORT LibraryInformation {
 /// \brief Constant that holds information about the *DIPlib* binary.
 DIP_EXPORT extern const LibraryInformation libraryInformation;
 
+/// \brief Returns the name of the instruction set used by the functions that have code paths for specific
+/// instruction sets.
+///
+/// Some of the most time-critical functions (data type conversion, arithmetic, 1D morphology, convolution)
+/// are compiled for several instruction sets, and the one to use is selected at run time depending on the
+/// capabilities of the CPU. This allows the library to be compiled for a generic CPU, and still take advantage
+/// of newer instruction sets on the machine it runs on. The returned string is one of `"AVX-512"`, `"AVX2"`,
+/// `"SSE4.1"` or `"baseline"`, the latter meaning that the code compiled for the target given when
+/// building the library is used. The AVX-512 level requires the F, BW, DQ and VL extensions. All code paths
+/// produce identical results.
+///
+/// CPU dispatch is only available when the library is compiled with GCC or Clang for x86 processors, and the
+/// CMake option `DIP_ENABLE_CPU_DISPATCH` is set; otherwise this function returns `"baseline"`.
+DIP_EXPORT String GetActiveISA();
+
 /// \}
 
 } // namespace dip
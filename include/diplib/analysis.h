@@ -970,6 +970,12 @@ DIP_EXPORT Distribution DistanceDistribution(
 ///  - `"isotropic"`: An isotropic SE leads to a size distribution dictated by the width of objects.
 ///  - `"length"`: A line SE leads to a size distribution dictated by the length of objects. We use (constrained)
 ///    path openings or closings (see Luengo, 2010).
+///  - `"area"`: Area openings or closings lead to a size distribution dictated by the area (or volume in 3D) of
+///    objects, independently of their shape. The area threshold for each scale is the scale raised to the power
+///    of the image dimensionality, so that the scale is the side length of a square (or cube) with that area.
+///    A single `dip::ComponentTree` is built for the image, and filtered for each scale. The tree is built only
+///    from the pixels within `mask`, so objects are cut off at the mask edge, and only their area inside the mask
+///    is counted.
 ///
 /// The `polarity` flag determines whether it is white objects on a black background (`"opening"`) or black objects
 /// on a white background (`"closing"`) that are being analyzed.
@@ -991,6 +997,7 @@ DIP_EXPORT Distribution DistanceDistribution(
 ///        of the measurement, but is a little bit more expensive (see Luengo, 2010). This option causes the use
 ///        of normal path openings or closings.
 ///      - `"robust"`: applies path openings or closings in such a way that they are less sensitive to noise.
+///  - For `"area"` granulometries there are no options.
 ///
 /// `scales` defaults to a series of 12 values geometrically spaced by `sqrt(2)`, and starting at `sqrt(2)`. `scales`
 /// are in pixels, the image's pixel size is not taken into account.
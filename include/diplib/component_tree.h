@@ -0,0 +1,195 @@
+/*
+ * DIPlib 3.0
+ * This file contains the declaration for dip::ComponentTree.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIP_COMPONENT_TREE_H
+#define DIP_COMPONENT_TREE_H
+
+#include "diplib.h"
+
+
+/// \file
+/// \brief Declares `dip::ComponentTree`, the max-tree and min-tree of an image.
+/// \see morphology
+
+
+namespace dip {
+
+
+/// \addtogroup morphology
+/// \{
+
+
+/// \brief The component tree (max-tree or min-tree) of a grey-value image.
+///
+/// The max-tree represents all connected components of all upper level sets of the image (the sets of pixels with
+/// a value larger or equal to a threshold). Each node of the tree is one such connected component, but only
+/// the pixels with a value equal to the node's level are directly assigned to it; the component is formed by the
+/// node together with all its descendants. The parent of a node is the smallest component that contains it, at a
+/// lower level. The min-tree is the dual: it represents the connected components of the lower level sets.
+///
+/// The tree is built once, after which any number of attribute filters can be applied to it at a cost linear in
+/// the number of pixels. An attribute filter removes all nodes for which the attribute does not satisfy some
+/// criterion, as in:
+///
+/// ```cpp
+/// dip::ComponentTree tree( img );
+/// auto area = tree.Area();
+/// std::vector< bool > keep( area.size() );
+/// for( dip::uint ii = 0; ii < area.size(); ++ii ) {
+///    keep[ ii ] = area[ ii ] >= 100;
+/// }
+/// dip::Image out = tree.Filter( keep );
+/// ```
+///
+/// The tree is built in parallel: the image is divided into slabs along the last dimension, the tree for each slab
+/// is computed independently using the union-find algorithm of Berger et al. (2007), and the trees for neighboring
+/// slabs are merged along their common boundary as described by Wilkinson et al. (2008).
+///
+/// Nodes are indexed by consecutive integers, each node's parent has a lower index than the node itself. A root
+/// node is its own parent. There is one root for each connected component of `mask`.
+///
+/// \literature
+/// <li>P. Salembier, A. Oliveras and L. Garrido, "Antiextensive connected operators for image and sequence processing",
+///     IEEE Transactions on %Image Processing 7(4):555-570, 1998.
+/// <li>Ch. Berger, T. Géraud, R. Levillain, N. Widynski, A. Baillard and E. Bertin, "Effective component tree
+///     computation with application to pattern recognition in astronomical imaging", IEEE International Conference
+///     on %Image Processing 4:41-44, 2007.
+/// <li>M.H.F. Wilkinson, H. Gao, W.H. Hesselink, J.E. Jonker and A. Meijster, "Concurrent computation of attribute
+///     filters on shared memory parallel machines", IEEE Transactions on Pattern Analysis and Machine Intelligence
+///     30(10):1800-1813, 2008.
+/// \endliterature
+///
+/// \see dip::AreaOpening, dip::VolumeOpening
+class DIP_NO_EXPORT ComponentTree {
+   public:
+      using NodeIndex = dip::uint;   ///< Type for indices to nodes
+
+      /// \brief The bounding box of a component, in pixel coordinates. Both corners are included in the box.
+      struct BoundingBox {
+         UnsignedArray topLeft;        ///< The smallest coordinates along each dimension
+         UnsignedArray bottomRight;    ///< The largest coordinates along each dimension
+      };
+
+      /// \brief Builds the component tree of `in`.
+      ///
+      /// `in` must be scalar and real-valued, or binary. `mask` restricts the pixels that are represented in the
+      /// tree, pixels outside of the mask are not changed by `dip::ComponentTree::Filter`.
+      ///
+      /// `connectivity` determines what a connected component is. See \ref connectivity for information on the
+      /// connectivity parameter.
+      ///
+      /// If `polarity` is `"opening"`, the max-tree is built, if it is `"closing"`, the min-tree is built.
+      DIP_EXPORT explicit ComponentTree(
+            Image const& in,
+            Image const& mask = {},
+            dip::uint connectivity = 0,
+            String const& polarity = S::OPENING
+      );
+
+      /// \brief Returns the number of nodes in the tree.
+      dip::uint NumberOfNodes() const {
+         return parent_.size();
+      }
+
+      /// \brief Returns the sizes of the image the tree was built from.
+      UnsignedArray const& Sizes() const {
+         return sizes_;
+      }
+
+      /// \brief Returns true for the max-tree, false for the min-tree.
+      bool IsMaxTree() const {
+         return maxTree_;
+      }
+
+      /// \brief Returns the parent of node `node`. The parent of a root node is the node itself.
+      NodeIndex Parent( NodeIndex node ) const {
+         return parent_[ node ];
+      }
+
+      /// \brief Returns true if `node` is a root node.
+      bool IsRoot( NodeIndex node ) const {
+         return parent_[ node ] == node;
+      }
+
+      /// \brief Returns the grey value of the pixels directly assigned to node `node`.
+      dfloat Level( NodeIndex node ) const {
+         return level_[ node ];
+      }
+
+      /// \brief Returns the node that pixel `index` is directly assigned to. `index` is a linear index, see \ref pointers.
+      /// Returns `dip::ComponentTree::NOT_IN_TREE` for pixels excluded by the mask.
+      NodeIndex PixelNode( dip::uint index ) const {
+         return pixelNode_[ index ];
+      }
+
+      /// \brief Value returned by `dip::ComponentTree::PixelNode` for pixels that are not in the tree.
+      static constexpr NodeIndex NOT_IN_TREE = std::numeric_limits< NodeIndex >::max();
+
+      /// \brief Returns, for each node, the number of pixels in the component.
+      DIP_EXPORT std::vector< dip::uint > Area() const;
+
+      /// \brief Returns, for each node, the volume of the component.
+      ///
+      /// The volume is the sum, over all pixels in the component, of the absolute difference between the pixel value
+      /// and the level of the parent node. For root nodes, the node's own level is used instead.
+      DIP_EXPORT std::vector< dfloat > Volume() const;
+
+      /// \brief Returns, for each node, the contrast of the component.
+      ///
+      /// The contrast is the absolute difference between the extremal pixel value in the component (the largest
+      /// value for the max-tree, the smallest for the min-tree) and the level of the parent node. For root nodes,
+      /// the node's own level is used instead.
+      DIP_EXPORT std::vector< dfloat > Contrast() const;
+
+      /// \brief Returns, for each node, the bounding box of the component.
+      DIP_EXPORT std::vector< BoundingBox > BoundingBoxes() const;
+
+      /// \brief Filters the image the tree was built from, removing the nodes for which `keep` is false.
+      ///
+      /// `keep` must have `dip::ComponentTree::NumberOfNodes` elements. The pixels in each removed node
+      /// are given the level of the nearest ancestor that is kept (the "direct" filtering rule). Root nodes are
+      /// never removed. For increasing attributes (attributes that do not decrease from a node to its parent, such
+      /// as area, volume and contrast) this is identical to an attribute opening or closing.
+      ///
+      /// `out` has the same sizes, data type and pixel size as the image the tree was built from.
+      DIP_EXPORT void Filter( std::vector< bool > const& keep, Image& out ) const;
+      Image Filter( std::vector< bool > const& keep ) const {
+         Image out;
+         Filter( keep, out );
+         return out;
+      }
+
+   private:
+      UnsignedArray sizes_;
+      DataType dataType_;
+      PixelSize pixelSize_;
+      bool maxTree_ = true;
+      std::vector< NodeIndex > parent_;      // The parent of each node
+      std::vector< dfloat > level_;          // The grey value of each node
+      std::vector< dip::uint > ownArea_;     // The number of pixels directly assigned to each node
+      std::vector< NodeIndex > pixelNode_;   // The node for each pixel (linear index)
+      Image excluded_;                       // A copy of the input image, only if a mask was given
+};
+
+
+/// \}
+
+} // namespace dip
+
+#endif // DIP_COMPONENT_TREE_H
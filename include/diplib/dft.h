@@ -26,6 +26,7 @@
 #include <vector>
 #include <complex>
 #include <limits>
+#include <memory>
 
 #include "diplib/library/export.h"
 
@@ -75,7 +76,9 @@ class DFT {
       }
 
       /// \brief Re-configure a `%DFT` object to the given transform size and direction.
-      /// Note that this is not a trivial operation.
+      ///
+      /// The tables needed to compute the transform are kept in a process-wide cache, so that configuring
+      /// an object for a size that was used before is cheap. This function is thread safe.
       DIP_EXPORT void Initialize( size_t size, bool inverse );
 
       /// \brief Apply the transform that the `%DFT` object is configured for.
@@ -106,12 +109,86 @@ class DFT {
       size_t BufferSize() const { return static_cast< size_t >( sz_ ); }
 
    private:
+      struct Tables; // The factorization, index and twiddle factor tables, these depend only on the size
       int nfft_ = 0;
       bool inverse_ = false;
-      std::vector< int > factors_;
-      std::vector< int > itab_;
-      std::vector< std::complex< T >> wave_;
       int sz_ = 0; // Size of the buffer to be passed to DFT.
+      std::shared_ptr< Tables const > tables_; // Shared by all objects of the same size
+};
+
+/// \brief An object that encapsulates the Discrete Fourier Transform (DFT) of real-valued data.
+///
+/// The forward transform takes `size` real values, and produces the `size/2+1` complex values of the non-redundant
+/// half of the spectrum (the other half follows from the conjugate symmetry of the spectrum). The inverse transform
+/// takes these `size/2+1` complex values, and produces `size` real values. The imaginary component of the zero
+/// frequency and, for even sizes, of the Nyquist frequency, are ignored.
+///
+/// For even sizes, the real data are packed into a complex array of half the size, and transformed with a
+/// `dip::DFT` of half the size. This takes about half the time of the complex transform of the same size. For
+/// odd sizes, the complex transform of the full size is used.
+///
+/// Usage is identical to that of `dip::DFT`, except that `Apply` takes a real-valued `source` for the forward
+/// transform, and a real-valued `destination` for the inverse transform.
+///
+/// The template can be instantiated for `T = float` or `T = double`. Linker errors will result for other types.
+template< typename T >
+class RDFT {
+   public:
+
+      /// \brief A default-initialized `%RDFT` object is useless. Call `Initialize` to make it useful.
+      RDFT() = default;
+
+      /// \brief Construct a `%RDFT` object by specifying the size and direction of the transform.
+      /// Note that this is not a trivial operation.
+      RDFT( size_t size, bool inverse ) {
+         Initialize( size, inverse );
+      }
+
+      /// \brief Re-configure a `%RDFT` object to the given transform size and direction.
+      /// Note that this is not a trivial operation.
+      DIP_EXPORT void Initialize( size_t size, bool inverse );
+
+      /// \brief Apply the forward transform.
+      ///
+      /// `source` is a pointer to a contiguous buffer with `TransformSize` real values. `destination` is a pointer
+      /// to a contiguous buffer with `TransformSize/2+1` complex values. `buffer` is a pointer to a contiguous
+      /// buffer used for intermediate data. It should have `BufferSize` elements.
+      ///
+      /// `scale` is a real scalar that the output values are multiplied by.
+      DIP_EXPORT void Apply(
+            const T* source,
+            std::complex< T >* destination,
+            std::complex< T >* buffer,
+            T scale
+      ) const;
+
+      /// \brief Apply the inverse transform.
+      ///
+      /// `source` is a pointer to a contiguous buffer with `TransformSize/2+1` complex values. `destination` is
+      /// a pointer to a contiguous buffer with `TransformSize` real values. `buffer` is a pointer to a contiguous
+      /// buffer used for intermediate data. It should have `BufferSize` elements.
+      ///
+      /// `scale` is a real scalar that the output values are multiplied by. It is typically set to `1/size`.
+      DIP_EXPORT void Apply(
+            const std::complex< T >* source,
+            T* destination,
+            std::complex< T >* buffer,
+            T scale
+      ) const;
+
+      /// \brief Returns true if this represents an inverse transform, false for a forward transform.
+      bool IsInverse() const { return dft_.IsInverse(); }
+
+      /// \brief Returns the size that the transform is configured for.
+      size_t TransformSize() const { return nfft_; }
+
+      /// \brief Returns the size of the buffer expected by `Apply`.
+      size_t BufferSize() const { return 2 * dft_.TransformSize() + dft_.BufferSize(); }
+
+   private:
+      size_t nfft_ = 0;
+      DFT< T > dft_;                             // Of half the size for even `nfft_`, of the full size otherwise
+      std::vector< std::complex< T >> twiddle_;  // Twiddle factors to split the half-sized DFT into even and odd parts
 };
 
 /// \brief Returns a size equal or larger to `size0` that is efficient for our DFT implementation.
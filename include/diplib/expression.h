@@ -0,0 +1,209 @@
+/*
+ * DIPlib 3.0
+ * This file contains declarations for deferred evaluation of image arithmetic.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef DIP_EXPRESSION_H
+#define DIP_EXPRESSION_H
+
+#include <memory>
+
+#include "diplib.h"
+
+
+/// \file
+/// \brief Declares `dip::Expression`, for deferred evaluation of image arithmetic.
+/// \see math_arithmetic
+
+
+namespace dip {
+
+
+/// \addtogroup math_arithmetic
+/// \{
+
+
+/// \brief An arithmetic expression on images, evaluated in a single pass over the image data.
+///
+/// The arithmetic operators on `dip::Image` compute their result immediately, so that an expression like
+/// `a * b + c / 2` creates two temporary images and runs over all pixels three times. When one of the operands
+/// is a `%dip::Expression`, the operators instead build an expression tree, which is only evaluated when it
+/// is converted to an image:
+///
+/// ```cpp
+///     dip::Image out = dip::Expression( a ) * b + c / 2;
+/// ```
+///
+/// The evaluation uses `dip::Framework::Scan` with a single line filter that computes the whole expression,
+/// one chunk of pixels at the time, so that the intermediate results stay in the cache.
+///
+/// Supported are the operators `+`, `-`, `*`, `/`, the comparison operators, the unary `-`, the
+/// logical operators `!`, `&` and `|` (for binary operands only), and the functions `dip::Abs`, `dip::Sqrt`,
+/// `dip::Square`, `dip::Exp`, `dip::Ln`, `dip::Sin` and `dip::Cos`. Operands can be `%dip::Expression`
+/// objects, images, or scalar constants. The rules for singleton expansion and for the data type of the
+/// result are the same as for the functions that the operators call, and so is the saturation of the result
+/// of each operation with an integer or binary data type. All computations are done in a floating-point
+/// type, double precision if any of the operands is double precision or has a 32-bit or 64-bit integer type.
+/// Division of integers truncates the result, as `dip::Divide` does, but division by zero saturates instead
+/// of being undefined. 64-bit integers are not computed exactly.
+///
+/// The operations are applied sample-wise to tensor images. Because `dip::Multiply` computes a matrix
+/// product, multiplying two tensor expressions throws an exception.
+class DIP_NO_EXPORT Expression {
+   public:
+      /// \brief The operations that can be represented in an expression tree.
+      enum class Operation {
+            Image,
+            Add,
+            Subtract,
+            Multiply,
+            Divide,
+            Equal,
+            NotEqual,
+            Lesser,
+            Greater,
+            NotGreater,
+            NotLesser,
+            And,
+            Or,
+            Negate,
+            Not,
+            Abs,
+            Sqrt,
+            Square,
+            Exp,
+            Ln,
+            Sin,
+            Cos
+      };
+
+      /// \brief A node in the expression tree.
+      struct Node {
+         Operation operation;
+         dip::DataType dataType;                // The data type of the result of this operation
+         dip::uint tensorElements;              // The number of tensor elements of the result of this operation
+         dip::Image image;                      // The image, for `Operation::Image`
+         std::shared_ptr< Node const > lhs;     // The first (or only) operand
+         std::shared_ptr< Node const > rhs;     // The second operand, for dyadic operations
+      };
+
+      /// \brief An expression that evaluates to `image`.
+      Expression( Image const& image ) {
+         DIP_THROW_IF( !image.IsForged(), E::IMAGE_NOT_FORGED );
+         node_ = std::make_shared< Node const >( Node{ Operation::Image, image.DataType(), image.TensorElements(), image, nullptr, nullptr } );
+      }
+
+      /// \brief An expression that applies the monadic `operation` to `in`.
+      DIP_EXPORT Expression( Operation operation, Expression const& in );
+
+      /// \brief An expression that applies the dyadic `operation` to `lhs` and `rhs`.
+      DIP_EXPORT Expression( Operation operation, Expression const& lhs, Expression const& rhs );
+
+      /// \brief Evaluates the expression, writing the result in `out`.
+      DIP_EXPORT void Evaluate( Image& out ) const;
+
+      /// \brief Evaluates the expression.
+      Image Evaluate() const {
+         Image out;
+         Evaluate( out );
+         return out;
+      }
+
+      /// \brief Evaluates the expression.
+      operator Image() const {
+         return Evaluate();
+      }
+
+      /// \brief The data type of the result of the expression.
+      dip::DataType DataType() const { return node_->dataType; }
+
+      /// \brief The root node of the expression tree.
+      Node const& Root() const { return *node_; }
+
+   private:
+      std::shared_ptr< Node const > node_;
+};
+
+namespace detail {
+
+template< typename T >
+using isExpression = isa< T, Expression >;
+
+} // namespace detail
+
+template< typename T >
+using EnableIfNotImageOrViewOrExpression = std::enable_if_t< !detail::isImage< T >::value && !detail::isView< T >::value && !detail::isExpression< T >::value >;
+
+#define DIP_DEFINE_EXPRESSION_OPERATOR( op, operation ) \
+inline Expression op( Expression const& lhs, Expression const& rhs ) { return Expression( Expression::Operation::operation, lhs, rhs ); } \
+inline Expression op( Image const& lhs, Expression const& rhs ) { return Expression( Expression::Operation::operation, Expression( lhs ), rhs ); } \
+inline Expression op( Expression const& lhs, Image const& rhs ) { return Expression( Expression::Operation::operation, lhs, Expression( rhs )); } \
+template< typename T, typename = EnableIfNotImageOrViewOrExpression< T >> inline Expression op( Expression const& lhs, T const& rhs ) { return Expression( Expression::Operation::operation, lhs, Expression( Image{ rhs } )); } \
+template< typename T, typename = EnableIfNotImageOrViewOrExpression< T >> inline Expression op( T const& lhs, Expression const& rhs ) { return Expression( Expression::Operation::operation, Expression( Image{ lhs } ), rhs ); }
+
+/// \brief Arithmetic operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator+, Add )
+/// \brief Arithmetic operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator-, Subtract )
+/// \brief Arithmetic operator for deferred evaluation, see `dip::Expression`. Multiplies sample-wise.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator*, Multiply )
+/// \brief Arithmetic operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator/, Divide )
+/// \brief Comparison operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator==, Equal )
+/// \brief Comparison operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator!=, NotEqual )
+/// \brief Comparison operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator<, Lesser )
+/// \brief Comparison operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator>, Greater )
+/// \brief Comparison operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator<=, NotGreater )
+/// \brief Comparison operator for deferred evaluation, see `dip::Expression`.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator>=, NotLesser )
+/// \brief Logical operator for deferred evaluation, see `dip::Expression`. Both operands must be binary.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator&, And )
+/// \brief Logical operator for deferred evaluation, see `dip::Expression`. Both operands must be binary.
+DIP_DEFINE_EXPRESSION_OPERATOR( operator|, Or )
+
+#undef DIP_DEFINE_EXPRESSION_OPERATOR
+
+/// \brief Unary operator for deferred evaluation, see `dip::Expression`.
+inline Expression operator-( Expression const& in ) { return Expression( Expression::Operation::Negate, in ); }
+/// \brief Logical unary operator for deferred evaluation, see `dip::Expression`. The operand must be binary.
+inline Expression operator!( Expression const& in ) { return Expression( Expression::Operation::Not, in ); }
+/// \brief Computes the absolute value, deferred evaluation, see `dip::Expression`.
+inline Expression Abs( Expression const& in ) { return Expression( Expression::Operation::Abs, in ); }
+/// \brief Computes the square root, deferred evaluation, see `dip::Expression`.
+inline Expression Sqrt( Expression const& in ) { return Expression( Expression::Operation::Sqrt, in ); }
+/// \brief Computes the square, deferred evaluation, see `dip::Expression`.
+inline Expression Square( Expression const& in ) { return Expression( Expression::Operation::Square, in ); }
+/// \brief Computes the base e exponent, deferred evaluation, see `dip::Expression`.
+inline Expression Exp( Expression const& in ) { return Expression( Expression::Operation::Exp, in ); }
+/// \brief Computes the natural logarithm, deferred evaluation, see `dip::Expression`.
+inline Expression Ln( Expression const& in ) { return Expression( Expression::Operation::Ln, in ); }
+/// \brief Computes the sine, deferred evaluation, see `dip::Expression`.
+inline Expression Sin( Expression const& in ) { return Expression( Expression::Operation::Sin, in ); }
+/// \brief Computes the cosine, deferred evaluation, see `dip::Expression`.
+inline Expression Cos( Expression const& in ) { return Expression( Expression::Operation::Cos, in ); }
+
+/// \}
+
+} // namespace dip
+
+#endif // DIP_EXPRESSION_H
@@ -66,6 +66,11 @@ namespace Framework {
 // Maximum number of pixels in a buffer for the scan framework
 constexpr dip::uint MAX_BUFFER_SIZE = 256 * 1024;
 
+/// \brief Alignment in bytes of the buffers when `SeparableOption::AlignedBuffers` or `FullOption::AlignedBuffers` are given.
+///
+/// This is enough for the widest SIMD registers (AVX-512), and for FFTW's SIMD code.
+constexpr dip::uint bufferAlignment = 64;
+
 
 //
 // Support functions
@@ -600,6 +605,9 @@ inline std::unique_ptr< ScanLineFilter > NewTetradicScanLineFilter( F const& fun
 /// `SeparableOption::UseOutputBuffer`      | The output buffer is guaranteed to have contiguous samples.
 /// `SeparableOption::CanWorkInPlace`       | The input and output buffer are allowed to both point to the same memory.
 /// `SeparableOption::UseRealComponentOfOutput` | If the buffer type is complex, and the output type is not, cast by taking the real component of the complex data, rather than the modulus.
+/// `SeparableOption::AlignedBuffers`       | Input and output buffers are always used, their first sample is aligned to `dip::Framework::bufferAlignment` bytes, and they are padded at the end to a multiple of that size.
+/// `SeparableOption::RealInputBuffer`      | If the buffer type is complex, the input buffer for the first dimension processed is of the corresponding real type.
+/// `SeparableOption::RealOutputBuffer`     | If the buffer type is complex, the output buffer for the last dimension processed is of the corresponding real type.
 ///
 /// Combine options by adding constants together.
 enum class SeparableOption {
@@ -611,7 +619,10 @@ enum class SeparableOption {
       UseInputBuffer,
       UseOutputBuffer,
       CanWorkInPlace,
-      UseRealComponentOfOutput
+      UseRealComponentOfOutput,
+      AlignedBuffers,
+      RealInputBuffer,
+      RealOutputBuffer
 };
 DIP_DECLARE_OPTIONS( SeparableOption, SeparableOptions )
 
@@ -653,6 +664,30 @@ struct DIP_NO_EXPORT SeparableLineFilterParameters {
    dip::uint thread;                  ///< Thread number
 };
 
+/// \brief Parameters to the block filter for `dip::Framework::Separable`.
+///
+/// A block is a set of `nLines` adjacent image lines, as passed to `dip::Framework::SeparableLineFilter::FilterBlock`.
+/// The lines in a block are adjacent along dimension `blockDimension`, and are stored interleaved in the input and
+/// output buffers: pixel `ii` of line `jj` is at `buffer[ ii * stride + jj ]`. That is, `stride` is the block size,
+/// and the lines can be processed together by looping over `jj` in the innermost loop. The buffers are always scalar
+/// (`tensorLength` is 1), and `nLines` is never larger than `stride`, but can be smaller.
+///
+/// `position` gives the coordinates of the first pixel of the first line in the block, the other lines in the
+/// block are at increasing coordinates along `blockDimension`. The other members are as in
+/// `dip::Framework::SeparableLineFilterParameters`.
+struct DIP_NO_EXPORT SeparableBlockFilterParameters {
+   SeparableBuffer const& inBuffer;   ///< Input buffer (`nLines` interleaved lines)
+   SeparableBuffer& outBuffer;        ///< Output buffer (`nLines` interleaved lines)
+   dip::uint nLines;                  ///< Number of lines in the block
+   dip::uint dimension;               ///< Dimension along which the line filter is applied
+   dip::uint pass;                    ///< Pass number (0..nPasses-1)
+   dip::uint nPasses;                 ///< Number of passes (typically nDims)
+   UnsignedArray const& position;     ///< Coordinates of first pixel in first line of the block
+   dip::uint blockDimension;          ///< Dimension along which the lines in the block are adjacent
+   bool tensorToSpatial;              ///< `true` if the tensor dimension was converted to spatial dimension
+   dip::uint thread;                  ///< Thread number
+};
+
 /// \brief Prototype line filter for `dip::Framework::Separable`.
 ///
 /// An object of a class derived from `%SeparableLineFilter` must be passed to the separable framework. The derived
@@ -667,10 +702,24 @@ struct DIP_NO_EXPORT SeparableLineFilterParameters {
 /// The `GetNumberOfOperations` method is called to determine if it is worthwhile to start worker threads and
 /// perform the computation in parallel. This function should not perform any other tasks, as it is not
 /// guaranteed to be called. It is not important that the function be very precise, see \ref design_multithreading.
+///
+/// If the `ProcessesBlocks` method returns `true`, the framework can pass blocks of adjacent image lines to
+/// the `FilterBlock` method instead of single lines to `Filter`. The lines in a block are interleaved in the
+/// buffers, such that the filter can process them simultaneously, with the inner loop over the lines, which
+/// the compiler can vectorize. See `dip::Framework::SeparableBlockFilterParameters`.
 class DIP_EXPORT SeparableLineFilter {
    public:
       /// \brief The derived class must must define this method, this is the actual line filter.
       virtual void Filter( SeparableLineFilterParameters const& params ) = 0;
+      /// \brief The derived class must define this method if `ProcessesBlocks` returns `true`, it filters a block
+      /// of adjacent image lines at once.
+      virtual void FilterBlock( SeparableBlockFilterParameters const& params ) {
+         ( void )params;
+         DIP_THROW( E::NOT_IMPLEMENTED );
+      }
+      /// \brief The derived class can define this function to return `true` if it wants to receive blocks of
+      /// image lines through `FilterBlock`.
+      virtual bool ProcessesBlocks() { return false; }
       /// \brief The derived class can define this function for setting up the processing.
       virtual void SetNumberOfThreads( dip::uint threads ) { ( void )threads; }
       /// \brief The derived class can define this function for helping to determine whether to whether to compute
@@ -798,6 +847,21 @@ class DIP_EXPORT SeparableLineFilter {
 /// temporary images. For this to be possible, `outImageType`, `bufferType` and
 /// the input image data type must all be the same.
 ///
+/// With a complex `bufferType`, the options `dip::FrameWork::SeparableOption::RealInputBuffer` and
+/// `dip::FrameWork::SeparableOption::RealOutputBuffer` cause the input buffer in the first pass and the output buffer
+/// in the last pass, respectively, to hold values of the corresponding real type. This allows a line filter to
+/// convert between real and complex values, as a real-to-complex Fourier transform does. Use the first option only
+/// with a real-valued input image, and the second one only with a real-valued output image.
+///
+/// If `lineFilter.ProcessesBlocks()` returns `true`, then lines along a dimension whose stride is not 1
+/// are gathered in blocks of adjacent lines, which are passed to `lineFilter.FilterBlock()` instead of
+/// `lineFilter.Filter()`. Each block holds as many lines as fit in 128 bytes of one pixel, so that reading
+/// one pixel position for all lines in the block uses whole cache lines. Blocks are not used for tensor
+/// images (unless `dip::FrameWork::SeparableOption::AsScalarImage` is given), nor when
+/// `dip::FrameWork::SeparableOption::UseRealComponentOfOutput`, `dip::FrameWork::SeparableOption::RealInputBuffer`
+/// or `dip::FrameWork::SeparableOption::RealOutputBuffer` applies. Block buffers always point
+/// to temporary storage, never to image data.
+///
 /// `%dip::Framework::Separable` will process the image using multiple threads, so
 /// `lineFilter` will be called from multiple threads simultaneously. If it is not
 /// thread safe, specify `dip::FrameWork::SeparableOption::NoMultiThreading` as an option.
@@ -835,13 +899,15 @@ DIP_EXPORT void Separable(
 /// `FullOption::AsScalarImage`         | The line filter is called for each tensor element separately, and thus always sees pixels as scalar values.
 /// `FullOption::ExpandTensorInBuffer`  | The line filter always gets input tensor elements as a standard, column-major matrix.
 /// `FullOption::BorderAlreadyExpanded` | The input image already has expanded boundaries (see `dip::ExtendImage`, use `"masked"` option).
+/// `FullOption::AlignedBuffers`        | The output buffer is always used, it is aligned to `dip::Framework::bufferAlignment` bytes, and padded at the end to a multiple of that size.
 ///
 /// Combine options by adding constants together.
 enum class FullOption {
       NoMultiThreading,
       AsScalarImage,
       ExpandTensorInBuffer,
-      BorderAlreadyExpanded
+      BorderAlreadyExpanded,
+      AlignedBuffers
 };
 DIP_DECLARE_OPTIONS( FullOption, FullOptions )
 
@@ -97,6 +97,15 @@ class DIP_NO_EXPORT Graph {
       /// Vertex values are set to the corresponding pixel value.
       DIP_EXPORT explicit Graph( Image const& image, dip::uint connectivity = 1, String const& weights = "difference" );
 
+      /// \brief Adds a vertex to the graph, with value `value` and reserved space for `nEdges` edges.
+      /// Returns the index to the new vertex.
+      VertexIndex AddVertex( dip::uint nEdges = 0, dfloat value = 0.0 ) {
+         VertexIndex index = vertices_.size();
+         vertices_.emplace_back( nEdges );
+         vertices_.back().value = value;
+         return index;
+      }
+
       /// \brief Returns the number of vertices in the graph.
       dip::uint NumberOfVertices() const {
          return vertices_.size();
@@ -259,13 +268,17 @@ class DIP_NO_EXPORT Graph {
          }
       }
 
-      /// \brief Computes the minimum spanning forest (MSF) using Prim's algorithm.
+      /// \brief Computes the minimum spanning forest (MSF) using Boruvka's algorithm.
       ///
       /// If `roots` is an empty set, the vertex with index 0 is used as the root, and the resulting graph
       /// will be a minimum spanning tree (MST). If multiple roots are given, each one will spawn a tree.
       ///
       /// The output graph only contains edges reachable from the given roots. Any components not connected
       /// to the roots will not remain in the graph (the vertices will be copied over, but not connected).
+      ///
+      /// The result is the same as that of Prim's algorithm started simultaneously from all roots. Edges with
+      /// equal weight are ordered by their index, so the result is unique. The search for the cheapest edge
+      /// out of each tree is done in parallel.
       DIP_EXPORT Graph MinimumSpanningForest( std::vector< VertexIndex > const& roots = {} ) const;
 
       /// \brief Removes `number` edges with the largest weights from the graph.
@@ -275,6 +288,22 @@ class DIP_NO_EXPORT Graph {
       /// trees.
       DIP_EXPORT void RemoveLargestEdges( dip::uint number );
 
+      /// \brief Removes the edges of the minimum cut that separates vertex `source` from vertex `sink`.
+      /// Returns the sum of the weights of the removed edges.
+      ///
+      /// The edge weights are the capacities of the edges, in both directions, and must not be negative.
+      /// After the cut, `source` and `sink` are in different connected components. Of all minimum cuts,
+      /// the one closest to `source` is chosen.
+      ///
+      /// To segment an image, add two vertices to the graph with `AddVertex`, to use as `source` and `sink`.
+      /// Edges from each pixel to these two vertices (terminal links) have as weight the cost of assigning the
+      /// pixel to the background and to the foreground, respectively. After the cut, the foreground pixels
+      /// are the ones connected to `source`.
+      ///
+      /// The cut is computed from the maximum flow between `source` and `sink`, found with Dinic's algorithm.
+      /// Unlike `MinimumSpanningForest`, this algorithm is serial, it runs in a single thread.
+      DIP_EXPORT dfloat MinimumCut( VertexIndex source, VertexIndex sink );
+
    private:
       std::vector< Vertex > vertices_;
       std::vector< Edge > edges_;
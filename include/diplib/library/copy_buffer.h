@@ -62,6 +62,19 @@ void CopyBuffer(
       std::vector< dip::sint > const& lookUpTable = {} // it this is null, simply copy over the tensor as is; otherwise use this to determine which tensor values to copy where
 );
 
+// Copies `samples` contiguous samples from `inBuffer` to `outBuffer`, converting data type using `clamp_cast`,
+// using SIMD instructions. Returns `false` without doing anything if there is no SIMD implementation for
+// this combination of data types, or if the CPU doesn't support the required instructions.
+//
+// This is an internal function not meant to be used by the library user.
+bool CopyBufferContiguous(
+      void const* inBuffer,
+      DataType inType,
+      void* outBuffer,
+      DataType outType,
+      dip::uint samples
+);
+
 // Expands the boundary of a 1D buffer, which extends `left` pixels on to the left, and `right` pixels to the right.
 // That is, the total number of pixels in the buffer is `pixels + left + right`, but the `buffer` pointer
 // points at the middle `pixels` elements, which are filled in. This function fills out the other `left + right`
@@ -0,0 +1,125 @@
+/*
+ * DIPlib 3.0
+ * This file contains support for selecting code paths depending on the instruction sets the CPU supports.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+//
+// NOTE!
+// Unlike other files in diplib/library, this file is NOT included through diplib.h.
+// However, it contains no publicly documented functionality.
+//
+
+
+#ifndef DIP_CPU_DISPATCH_H
+#define DIP_CPU_DISPATCH_H
+
+#include "diplib/library/types.h"
+
+
+// `DIP_CONFIG_ENABLE_CPU_DISPATCH` is set by CMake if the compiler supports the `target` function attribute
+// and `__builtin_cpu_supports`, which is the case for GCC and Clang on x86.
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+// `flatten` causes all functions called by the annotated function to be inlined into it, and consequently
+// also compiled for the given instruction set. FMA is not enabled, and CMake adds `-ffp-contract=off` to the
+// files that use `DispatchIsa`, so that all versions produce identical results.
+#define DIP__TARGET_SSE41 __attribute__(( target( "sse4.1" ), flatten ))
+#define DIP__TARGET_AVX2 __attribute__(( target( "avx2" ), flatten ))
+#define DIP__TARGET_AVX512 __attribute__(( target( "avx2,avx512f,avx512bw,avx512dq,avx512vl" ), flatten ))
+#endif
+
+
+namespace dip {
+namespace detail {
+
+
+// Instruction set levels, each level includes the previous ones.
+enum class IsaLevel {
+   Baseline,   // Whatever the library was compiled for
+   SSE41,      // SSE4.1
+   AVX2,       // AVX2
+   AVX512      // AVX-512 F, BW, DQ and VL
+};
+
+// Returns the instruction set level used by `DispatchIsa` and other CPU-specific code. This is the highest level
+// supported by the CPU, unless lowered with `SetIsaLevel`.
+//
+// This is an internal function not meant to be used by the library user.
+IsaLevel GetIsaLevel();
+
+// Sets the instruction set level to use, clamped to what the CPU supports. Returns the previous level.
+// Meant for testing the different code paths.
+//
+// This is an internal function not meant to be used by the library user.
+IsaLevel SetIsaLevel( IsaLevel level );
+
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+
+template< typename F >
+DIP__TARGET_SSE41 void CallWithSse41( F const& function ) {
+   function();
+}
+
+template< typename F >
+DIP__TARGET_AVX2 void CallWithAvx2( F const& function ) {
+   function();
+}
+
+template< typename F >
+DIP__TARGET_AVX512 void CallWithAvx512( F const& function ) {
+   function();
+}
+
+#endif
+
+// Calls `function()`, compiled for each of the instruction sets SSE4.1, AVX2 and AVX-512, as well as for the baseline,
+// and selects the version to run depending on `GetIsaLevel()`. `function` is typically a lambda that calls the
+// inner loop of a line filter, which is inlined into the dispatched versions:
+//
+//    virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
+//       DispatchIsa( [ & ]() { DoFilter( params ); } );
+//    }
+//
+// Without CPU dispatch support, this simply calls `function()`.
+//
+// This is an internal function not meant to be used by the library user.
+template< typename F >
+inline void DispatchIsa( F const& function ) {
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+   switch( GetIsaLevel() ) {
+      case IsaLevel::AVX512:
+         CallWithAvx512( function );
+         return;
+      case IsaLevel::AVX2:
+         CallWithAvx2( function );
+         return;
+      case IsaLevel::SSE41:
+         CallWithSse41( function );
+         return;
+      default:
+         break;
+   }
+#endif
+   function();
+}
+
+
+} // namespace detail
+} // namespace dip
+
+
+#endif // DIP_CPU_DISPATCH_H
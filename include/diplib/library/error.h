@@ -177,6 +177,7 @@ constexpr char const* ITERATOR_NOT_VALID = "Iterator is not valid";
 
 // miscellaneous errors
 constexpr char const* NOT_IMPLEMENTED = "Functionality has not (yet) been implemented";
+constexpr char const* OPERATION_CANCELLED = "Operation was cancelled";
 
 // function parameter errors
 constexpr char const* INVALID_PARAMETER = "Parameter has invalid value";
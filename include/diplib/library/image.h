@@ -155,6 +155,42 @@ class DIP_CLASS_EXPORT AlignedAllocInterface : public ExternalInterface {
       }
 };
 
+/// \brief ExternalInterface that allocates data from the memory pool.
+///
+/// Memory is allocated with `dip::PoolAllocate`, and returned to the pool when the image data is freed.
+/// This is useful for temporary images in code that is called repeatedly with images of similar sizes,
+/// as the memory of a previous temporary image is re-used instead of being returned to the system.
+/// Data are aligned to `dip::memoryPoolAlignment` bytes. See `dip::GetMemoryPoolStatistics` for
+/// information on how effective the pool is.
+///
+/// The class is designed as a singleton: `dip::PoolAllocInterface::GetInstance()`
+/// returns a pointer to the unique instance.
+///
+/// ```cpp
+///     dip::Image tmp;
+///     tmp.SetExternalInterface( dip::PoolAllocInterface::GetInstance() );
+///     tmp.ReForge( in );
+/// ```
+class DIP_CLASS_EXPORT PoolAllocInterface : public ExternalInterface {
+   private:
+      // Private constructor to enforce the singleton interface
+      PoolAllocInterface() = default;
+
+   public:
+      /// Called by `dip::Image::Forge`.
+      DIP_EXPORT virtual DataSegment AllocateData(
+            void*& origin,
+            dip::DataType dataType,
+            UnsignedArray const& sizes,
+            IntegerArray& strides,
+            dip::Tensor const& tensor,
+            dip::sint& tensorStride
+      ) override;
+
+      /// \brief Singleton interface.
+      DIP_EXPORT static PoolAllocInterface* GetInstance();
+};
+
 
 //
 // Functor that converts indices or offsets to coordinates.
@@ -168,6 +168,7 @@ constexpr char const* REAL = "real";
 constexpr char const* SYMMETRIC = "symmetric";
 constexpr char const* CORNER = "corner";
 //constexpr char const* FAST = "fast";
+constexpr char const* HALF = "half";
 
 // Distance transforms
 //constexpr char const* FAST = "fast";
@@ -165,10 +165,15 @@ inline Image ConvolveFT(
 /// As elsewhere, the origin of `filter` is in the middle of the image, on the pixel to the right of
 /// the center in case of an even-sized image.
 ///
-/// Note that this is a really expensive way to compute the convolution for any `filter` that has more than a
-/// small amount of non-zero values. It is always advantageous to try to separate your filter into a set of 1D
-/// filters (see `dip::SeparateFilter` and `dip::SeparableConvolution`). If this is not possible, use
-/// `dip::ConvolveFT` with larger filters to compute the convolution in the Fourier domain.
+/// The cost of the direct convolution sum is proportional to the number of non-zero values in `filter`. If `filter`
+/// is scalar and large enough that this is more expensive than computing the convolution through the Fourier
+/// domain, the overlap-save method is used instead: the image is divided into blocks of a size that is efficient for the Fourier
+/// transform, and each block is convolved in the Fourier domain, using the Fourier transform of `filter` computed
+/// only once. Blocks are processed in parallel. This yields the same result as the direct convolution sum,
+/// including the handling of the image boundary. There is therefore no need to call `dip::ConvolveFT` for large
+/// filters; `dip::ConvolveFT` imposes a periodic boundary condition, and uses more memory. Still, it is always
+/// advantageous to try to separate your filter into a set of 1D filters (see `dip::SeparateFilter` and
+/// `dip::SeparableConvolution`).
 ///
 /// Also, if all non-zero filter weights have the same value, `dip::Uniform` implements a more efficient
 /// algorithm. If `filter` is a binary image, `dip::Uniform` is called.
@@ -355,15 +360,16 @@ inline Image GaussIIR(
 /// - `"FIR"`: Finite impulse response implementation, see `dip::GaussFIR`.
 /// - `"IIR"`: Infinite impulse response implementation, see `dip::GaussIIR`.
 /// - `"FT"`: Fourier domain implementation, see `dip::GaussFT`.
-/// - `"best"`: Picks the best method, according to the values of `sigmas` and `derivativeOrder`:
+/// - `"best"`: Picks the method that is predicted to be fastest, among the ones that are accurate enough,
+///   see `dip::PredictGaussTimes`:
 ///     - if any `derivativeOrder` is larger than 3, use the FT method,
 ///     - else if any `sigmas` is smaller than 0.8, use the FT method,
-///     - else if any `sigmas` is larger than 10, use the IIR method,
-///     - else use the FIR method.
+///     - else the IIR method is only considered if all `sigmas` are at least 2,
+///     - and the FT method is only considered if `boundaryCondition` is `"periodic"` for all dimensions.
 ///
 /// `boundaryCondition` indicates how the boundary should be expanded in each dimension. See `dip::BoundaryCondition`.
 ///
-/// \see dip::GaussFIR, dip::GaussFT, dip::GaussIIR, dip::Derivative, dip::FiniteDifference, dip::Uniform
+/// \see dip::GaussFIR, dip::GaussFT, dip::GaussIIR, dip::PredictGaussTimes, dip::Derivative, dip::FiniteDifference, dip::Uniform
 DIP_EXPORT void Gauss(
       Image const& in,
       Image& out,
@@ -386,6 +392,84 @@ inline Image Gauss(
    return out;
 }
 
+/// \brief Parameters of the cost model used by `dip::Gauss` to choose between the FIR, IIR and FT methods.
+///
+/// Times are given in nanoseconds, for one thread, one real-valued image channel. For each dimension processed,
+/// the FIR method is modeled to take `firPerPixel` for each pixel in the image lines extended by the boundary,
+/// plus `firPerWeight` for each multiplication with a kernel weight. The IIR method takes `iirPerPixel`
+/// plus `iirPerFilterOrder` times the filter order, for each pixel in the image lines extended by the boundary.
+/// The FT method takes `ftPerPixel` plus `ftPerPixelPerStage` times the sum of the base-2 logarithm of the image
+/// sizes, for each pixel in the image. Complex-valued images take twice as long.
+///
+/// With `n` threads, a fraction `parallelFraction` of the time is divided by `n`.
+///
+/// The default values reproduce approximately the fixed rules that `dip::Gauss` used before this model was
+/// introduced. Use `dip::CalibrateGauss` to measure the values for the current machine.
+struct GaussCalibration {
+   /// \brief Costs for one computation precision.
+   struct Costs {
+      dfloat firPerPixel = 1.0;           ///< FIR method, per pixel per dimension
+      dfloat firPerWeight = 0.5;          ///< FIR method, per kernel weight per pixel per dimension
+      dfloat iirPerPixel = 4.0;           ///< IIR method, per pixel per dimension
+      dfloat iirPerFilterOrder = 7.0;     ///< IIR method, per filter order per pixel per dimension
+      dfloat ftPerPixel = 20.0;           ///< FT method, per pixel
+      dfloat ftPerPixelPerStage = 5.0;    ///< FT method, per pixel per radix-2 stage
+   };
+   Costs singlePrecision;                 ///< Costs when computing in single precision (integer and `dip::DT_SFLOAT` input)
+   Costs doublePrecision;                 ///< Costs when computing in double precision
+   dfloat firParallelFraction = 0.9;      ///< Fraction of the FIR method's time that is divided over threads
+   dfloat iirParallelFraction = 0.9;      ///< Fraction of the IIR method's time that is divided over threads
+   dfloat ftParallelFraction = 0.9;       ///< Fraction of the FT method's time that is divided over threads
+};
+
+/// \brief Measures the speed of the FIR, IIR and FT implementations of the Gaussian filter on this machine,
+/// and uses the result from here on.
+///
+/// The measurement takes a fraction of a second. Call it when the machine is otherwise idle. If `filename` is
+/// given, the result is also written to that file, so that it can be read with `dip::LoadGaussCalibration`.
+///
+/// If the environment variable `DIP_GAUSS_CALIBRATION` is set to a file name when the calibration is first
+/// needed, that file is loaded; if it doesn't exist, the calibration is measured and written to it. This
+/// way the calibration runs only once on each machine. The measurement is postponed, using the default values
+/// in the meantime, while the calling thread cannot use all threads: within a task started by `dip::ParallelRun`,
+/// or when limited by the `dip::ExecutionContext` or `dip::SetNumberOfThreads`.
+DIP_EXPORT GaussCalibration CalibrateGauss( String const& filename = {} );
+
+/// \brief Reads a calibration written by `dip::CalibrateGauss`, and uses it from here on.
+DIP_EXPORT void LoadGaussCalibration( String const& filename );
+
+/// \brief Sets the cost model parameters used from here on.
+DIP_EXPORT void SetGaussCalibration( GaussCalibration const& calibration );
+
+/// \brief Returns the cost model parameters currently used.
+DIP_EXPORT GaussCalibration GetGaussCalibration();
+
+/// \brief Predicted computation times for the implementations of the Gaussian filter, see `dip::PredictGaussTimes`.
+struct GaussTimes {
+   dfloat fir = 0;      ///< Predicted time for `dip::GaussFIR`, in seconds, infinity if not accurate enough
+   dfloat iir = 0;      ///< Predicted time for `dip::GaussIIR`, in seconds, infinity if not accurate enough
+   dfloat ft = 0;       ///< Predicted time for `dip::GaussFT`, in seconds, infinity if not accurate enough
+   String method;       ///< The method that `dip::Gauss` uses: `"FIR"`, `"IIR"` or `"FT"`
+};
+
+/// \brief Predicts how long each of the implementations of the Gaussian filter take for the given image and
+/// parameters.
+///
+/// The parameters are as for `dip::Gauss`. Only the sizes, data type and number of tensor elements of `in` are
+/// used, `in` does not need to be forged. The prediction uses the model given by `dip::GetGaussCalibration`, and
+/// the number of threads given by `dip::GetNumberOfThreads`.
+///
+/// Methods that do not produce an accurate enough result for the given parameters get an infinite time, see
+/// `dip::Gauss` for the rules. `method` is set to the method with the lowest time, this is the method that
+/// `dip::Gauss` and `dip::Derivative` use when their `method` argument is `"best"`.
+DIP_EXPORT GaussTimes PredictGaussTimes(
+      Image const& in,
+      FloatArray sigmas = { 1.0 },
+      UnsignedArray derivativeOrder = { 0 },
+      StringArray const& boundaryCondition = {},
+      dfloat truncation = 3
+);
+
 /// \brief Finite difference derivatives
 ///
 /// Computes derivatives using the finite difference method. Set a `derivativeOrder` for each dimension.
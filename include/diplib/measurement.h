@@ -726,10 +726,21 @@ class DIP_CLASS_EXPORT Base {
       /// process for one image.
       virtual void Cleanup() {};
 
+      /// \brief Returns `true` if the `Measure` method of a chain-code--based, polygon-based or convex-hull--based
+      /// feature is thread-safe, such that different objects can be measured in parallel. The default
+      /// implementation returns `false`.
+      virtual bool CanMeasureInParallel() const { return false; }
+
       virtual ~Base() = default;
 };
 
 /// \brief The pure virtual base class for all line-based measurement features.
+///
+/// A line-based feature must override `ScanLine`. By default, the image is scanned by a single thread,
+/// calling `ScanLine`. A feature that can accumulate its measurements in
+/// separate partial accumulators should return `true` from `CanScanInParallel`, and override
+/// `SetNumberOfThreads`, `ScanLinePartial` and `MergePartial`. The image can then be scanned by multiple
+/// threads in parallel, if all requested line-based features can do so.
 class DIP_CLASS_EXPORT LineBased : public Base {
    public:
       explicit LineBased( Information const& information ) : Base( information, Type::LINE_BASED ) {};
@@ -754,6 +765,34 @@ class DIP_CLASS_EXPORT LineBased : public Base {
             ObjectIdToIndexMap const& objectIndices ///< A map from objectID (label) to index
       ) = 0;
 
+      /// \brief Returns `true` if the feature supports `SetNumberOfThreads`, `ScanLinePartial` and `MergePartial`,
+      /// such that the image can be scanned by multiple threads in parallel. The default implementation returns `false`.
+      virtual bool CanScanInParallel() const { return false; }
+
+      /// \brief Called before the image is scanned, if `CanScanInParallel` returned `true`. The feature should
+      /// prepare partial accumulators for `nThreads` threads. The accumulators for thread 0 should be the
+      /// ones allocated by `dip::Feature::Base::Initialize`.
+      virtual void SetNumberOfThreads( dip::uint /*nThreads*/ ) {}
+
+      /// \brief Called once for each image line, like `ScanLine`, but accumulates information into the partial
+      /// accumulators for thread `thread`. If `CanScanInParallel` returned `true`, this function is called in
+      /// parallel, but never simultaneously with the same `thread` value. Lines are distributed over the threads
+      /// in order, such that thread `ii` processes lines after thread `ii-1` does, in linear index order.
+      ///
+      /// The default implementation calls `ScanLine` (`thread` will always be 0 in this case).
+      virtual void ScanLinePartial(
+            LineIterator< LabelType > label,
+            LineIterator< dfloat > grey,
+            UnsignedArray coordinates,
+            dip::uint dimension,
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread ///< Index of the thread calling this function
+      );
+
+      /// \brief Called after the image has been scanned in parallel, before `Finish` is called. The feature
+      /// should merge all partial accumulators into those for thread 0, in thread order.
+      virtual void MergePartial() {}
+
       /// \brief Called once for each object, to finalize the measurement
       virtual void Finish( dip::uint objectIndex, Measurement::ValueIterator output ) = 0;
 };
@@ -772,7 +811,8 @@ class DIP_CLASS_EXPORT ChainCodeBased : public Base {
    public:
       explicit ChainCodeBased( Information const& information ) : Base( information, Type::CHAINCODE_BASED ) {};
 
-      /// \brief Called once for each object
+      /// \brief Called once for each object. Called in parallel for different objects only if
+      /// `dip::Feature::Base::CanMeasureInParallel` returns `true`.
       virtual void Measure( ChainCode const& chainCode, Measurement::ValueIterator output ) = 0;
 };
 
@@ -781,7 +821,8 @@ class DIP_CLASS_EXPORT PolygonBased : public Base {
    public:
       explicit PolygonBased( Information const& information ) : Base( information, Type::POLYGON_BASED ) {};
 
-      /// \brief Called once for each object
+      /// \brief Called once for each object. Called in parallel for different objects only if
+      /// `dip::Feature::Base::CanMeasureInParallel` returns `true`.
       virtual void Measure( Polygon const& polygon, Measurement::ValueIterator output ) = 0;
 };
 
@@ -790,7 +831,8 @@ class DIP_CLASS_EXPORT ConvexHullBased : public Base {
    public:
       explicit ConvexHullBased( Information const& information ) : Base( information, Type::CONVEXHULL_BASED ) {};
 
-      /// \brief Called once for each object
+      /// \brief Called once for each object. Called in parallel for different objects only if
+      /// `dip::Feature::Base::CanMeasureInParallel` returns `true`.
       virtual void Measure( ConvexHull const& convexHull, Measurement::ValueIterator output ) = 0;
 };
 
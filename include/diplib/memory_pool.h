@@ -0,0 +1,148 @@
+/*
+ * DIPlib 3.0
+ * This file contains declarations for the memory pool used for temporary buffers.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef DIP_MEMORY_POOL_H
+#define DIP_MEMORY_POOL_H
+
+#include <cstring>
+#include <utility>
+
+#include "diplib/library/types.h"
+
+
+/// \file
+/// \brief Declares the memory pool used for the frameworks' buffers and for temporary images.
+/// \see infrastructure
+
+
+namespace dip {
+
+/// \addtogroup infrastructure
+/// \{
+
+
+/// \brief Statistics of the memory pool, see `dip::GetMemoryPoolStatistics`.
+struct MemoryPoolStatistics {
+   dip::uint hits = 0;           ///< Number of allocations served from the pool
+   dip::uint misses = 0;         ///< Number of allocations that needed a new memory block
+   dip::uint cachedBlocks = 0;   ///< Number of unused memory blocks kept in the pool
+   dip::uint cachedBytes = 0;    ///< Total size of the unused memory blocks kept in the pool
+};
+
+/// \brief Allocates a memory block of at least `size` bytes from the memory pool of the calling thread.
+///
+/// The pool keeps the memory blocks that are freed with `dip::PoolFree` in lists per size class (powers of two),
+/// one set of lists for each thread, so that a new allocation of a similar size does not need to go to the
+/// system allocator. This avoids the cost of `malloc`, `free` and page faults in code that repeatedly processes
+/// small images. Each thread keeps at most `dip::memoryPoolMaxCachedBytes` bytes in its pool. Blocks larger
+/// than `dip::memoryPoolMaxBlockSize` are not pooled. The block can be larger than `size`, see
+/// `dip::PoolBlockSize`.
+///
+/// The returned pointer is aligned to `dip::memoryPoolAlignment` bytes. Throws if the memory cannot be allocated.
+DIP_EXPORT void* PoolAllocate( dip::uint size );
+
+/// \brief Returns a memory block obtained with `dip::PoolAllocate` to the pool of the calling thread.
+///
+/// It is not necessary to free the memory in the same thread where it was allocated, but only the thread that
+/// allocated a block keeps it in its pool; blocks freed by other threads are returned to the system.
+/// `ptr` can be `nullptr`.
+DIP_EXPORT void PoolFree( void* ptr ) noexcept;
+
+/// \brief Returns the usable size of a memory block obtained with `dip::PoolAllocate`, which can be larger
+/// than the size requested. Returns 0 if `ptr` is `nullptr`.
+DIP_EXPORT dip::uint PoolBlockSize( void* ptr ) noexcept;
+
+/// \brief Frees the memory blocks kept in the pools of all threads.
+///
+/// The pool of the calling thread is emptied immediately. Each other thread empties its pool the next time it
+/// allocates or frees a memory block from the pool, or when it ends.
+DIP_EXPORT void ReleaseMemoryPool();
+
+/// \brief Returns the statistics of the memory pool, combined for all threads.
+DIP_EXPORT MemoryPoolStatistics GetMemoryPoolStatistics();
+
+/// \brief Resets the `hits` and `misses` counts of the memory pool statistics to zero.
+DIP_EXPORT void ResetMemoryPoolStatistics();
+
+/// \brief The alignment of memory blocks allocated by `dip::PoolAllocate`, in bytes.
+constexpr dip::uint memoryPoolAlignment = 64;
+
+/// \brief The size, in bytes, of the largest memory block that is kept in the pool.
+constexpr dip::uint memoryPoolMaxBlockSize = 64 * 1024 * 1024;
+
+/// \brief The maximum number of bytes each thread keeps in its pool.
+constexpr dip::uint memoryPoolMaxCachedBytes = 64 * 1024 * 1024;
+
+
+/// \brief A buffer of bytes allocated from the memory pool.
+///
+/// Has the same interface as `std::vector< uint8 >` as far as the frameworks use it: `resize` keeps the existing
+/// contents, new bytes are not initialized. The memory is returned to the pool when the buffer is destroyed.
+class PoolBuffer {
+   public:
+      PoolBuffer() = default;
+      /// \brief Allocates a buffer of `size` bytes.
+      explicit PoolBuffer( dip::uint size ) { resize( size ); }
+      PoolBuffer( PoolBuffer const& ) = delete;
+      PoolBuffer( PoolBuffer&& other ) noexcept : data_( other.data_ ), size_( other.size_ ), capacity_( other.capacity_ ) {
+         other.data_ = nullptr;
+         other.size_ = 0;
+         other.capacity_ = 0;
+      }
+      PoolBuffer& operator=( PoolBuffer const& ) = delete;
+      PoolBuffer& operator=( PoolBuffer&& other ) noexcept {
+         std::swap( data_, other.data_ );
+         std::swap( size_, other.size_ );
+         std::swap( capacity_, other.capacity_ );
+         return *this;
+      }
+      ~PoolBuffer() { PoolFree( data_ ); }
+
+      /// \brief Sets the size of the buffer. Only allocates new memory when the buffer grows beyond its capacity.
+      void resize( dip::uint size ) {
+         if( size > capacity_ ) {
+            uint8* data = static_cast< uint8* >( PoolAllocate( size ));
+            if( size_ > 0 ) {
+               std::memcpy( data, data_, size_ );
+            }
+            PoolFree( data_ );
+            data_ = data;
+            capacity_ = PoolBlockSize( data );
+         }
+         size_ = size;
+      }
+
+      uint8* data() { return data_; }
+      uint8 const* data() const { return data_; }
+      dip::uint size() const { return size_; }
+      bool empty() const { return size_ == 0; }
+
+   private:
+      uint8* data_ = nullptr;
+      dip::uint size_ = 0;
+      dip::uint capacity_ = 0;
+};
+
+
+/// \}
+
+} // namespace dip
+
+#endif // DIP_MEMORY_POOL_H
@@ -1448,9 +1448,10 @@ inline Image Leveling(
 ///
 /// `polarity` can be `"opening"` (the default) or `"closing"`, to compute the area opening or area closing, respectively.
 ///
-/// We use a union-find implementation similar to that described my Meijster and Wilkinson (2002), and is based on
-/// the algorithm for our fast watershed (`"fast"` mode to `dip::Watershed`). For binary images, this function calls
-/// `dip::BinaryAreaOpening` or `dip::BinaryAreaClosing`.
+/// The filter is computed by building the max-tree (or min-tree for the closing) of the image, see
+/// `dip::ComponentTree`, and removing the nodes with an area smaller than `filterSize`. To apply multiple area
+/// filters to the same image, it is more efficient to build the `dip::ComponentTree` once, and filter it
+/// repeatedly. For binary images, this function calls `dip::BinaryAreaOpening` or `dip::BinaryAreaClosing`.
 ///
 /// \literature
 /// <li>L. Vincent, "Grayscale area openings and closings, their efficient implementation and applications",
@@ -1459,7 +1460,7 @@ inline Image Leveling(
 ///     IEEE Transactions on Pattern Analysis and Machine Intelligence 24(4):484-494, 2002.
 /// \endliterature
 ///
-/// \see dip::PathOpening, dip::DirectedPathOpening, dip::Opening, dip::Closing, dip::Maxima, dip::Minima, dip::SmallObjectsRemove
+/// \see dip::VolumeOpening, dip::ComponentTree, dip::PathOpening, dip::DirectedPathOpening, dip::Opening, dip::Closing, dip::Maxima, dip::Minima, dip::SmallObjectsRemove
 DIP_EXPORT void AreaOpening(
       Image const& in,
       Image const& mask,
@@ -1502,6 +1503,73 @@ inline Image AreaClosing(
    return out;
 }
 
+/// \brief Computes the volume opening or closing
+///
+/// The volume opening removes all local maxima that have a volume smaller than the given parameter `filterSize`.
+/// The volume of a connected component of an upper level set of the image is the sum of the grey values of its
+/// pixels, measured from the level at which the component merges with another one (see
+/// `dip::ComponentTree::Volume`). Contrary to the area opening, which removes small peaks independently of their
+/// height, and to the h-maxima transform, which removes low peaks independently of their size, the volume opening
+/// removes peaks that are both small and low. The volume closing is the dual operation.
+///
+/// `mask` restricts the image regions used for the operation.
+///
+/// `connectivity` determines what a connected component is. See \ref connectivity for information on the
+/// connectivity parameter.
+///
+/// `polarity` can be `"opening"` (the default) or `"closing"`, to compute the volume opening or volume closing,
+/// respectively.
+///
+/// The filter is computed by building the max-tree (or min-tree for the closing) of the image, see
+/// `dip::ComponentTree`, and removing the nodes with a volume smaller than `filterSize`.
+///
+/// \literature
+/// <li>C. Vachier, "Extraction de caractéristiques, segmentation d'image et morphologie mathématique",
+///     PhD thesis, École Nationale Supérieure des Mines de Paris, 1995.
+/// \endliterature
+///
+/// \see dip::AreaOpening, dip::ComponentTree, dip::HMaxima
+DIP_EXPORT void VolumeOpening(
+      Image const& in,
+      Image const& mask,
+      Image& out,
+      dfloat filterSize,
+      dip::uint connectivity = 0,
+      String const& polarity = S::OPENING
+);
+inline Image VolumeOpening(
+      Image const& in,
+      Image const& mask,
+      dfloat filterSize,
+      dip::uint connectivity = 0,
+      String const& polarity = S::OPENING
+) {
+   Image out;
+   VolumeOpening( in, mask, out, filterSize, connectivity, polarity );
+   return out;
+}
+
+/// \brief Computes the volume closing, calling `dip::VolumeOpening` with `polarity="closing"`.
+inline void VolumeClosing(
+      Image const& in,
+      Image const& mask,
+      Image& out,
+      dfloat filterSize,
+      dip::uint connectivity = 0
+) {
+   VolumeOpening( in, mask, out, filterSize, connectivity, S::CLOSING );
+}
+inline Image VolumeClosing(
+      Image const& in,
+      Image const& mask,
+      dfloat filterSize,
+      dip::uint connectivity = 0
+) {
+   Image out;
+   VolumeClosing( in, mask, out, filterSize, connectivity );
+   return out;
+}
+
 /// \brief Applies a path opening or closing in all possible directions
 ///
 /// `length` is the length of the path. All `filterParam` arguments to `dip::DirectedPathOpening` that yield a
@@ -22,6 +22,10 @@
 #ifndef DIP_MULTITHREADING_H
 #define DIP_MULTITHREADING_H
 
+#include <atomic>
+#include <functional>
+#include <memory>
+
 #include "diplib/library/types.h"
 
 #ifdef _OPENMP
@@ -35,6 +39,10 @@ inline int omp_get_max_threads() { return 1; }
 
 /// \file
 /// \brief Declares functions to control multithreading within DIPlib, and imports the OpenMP header.
+///
+/// The frameworks (\ref frameworks) do not start threads themselves, they hand their work to an executor through
+/// `dip::ParallelRun`. By default this is a built-in work-stealing thread pool, but an application can install its
+/// own executor with `dip::SetExecutor` to share threads with the rest of the program.
 /// \see infrastructure
 
 
@@ -57,6 +65,9 @@ namespace dip {
 ///
 /// If `nThreads` is 0, resets the maximum number of threads to the default value.
 ///
+/// This setting applies to the whole process. Use `dip::ScopedExecutionContext` to use a different
+/// number of threads for the calls made from one thread.
+///
 /// If DIPlib was compiled without OpenMP support, this function does nothing.
 DIP_EXPORT void SetNumberOfThreads( dip::uint nThreads );
 
@@ -64,9 +75,12 @@ DIP_EXPORT void SetNumberOfThreads( dip::uint nThreads );
 /// \brief Gets the maximum number of threads that can be used in computations.
 ///
 /// Returns the value given in the last call to `dip::SetNumberOfThreads`, or the default maximum value if that
-/// function was never called.
+/// function was never called. If the current `dip::ExecutionContext` sets a number of threads, returns that
+/// value instead.
 ///
-/// If DIPlib was compiled without OpenMP support, this function always returns 1.
+/// If DIPlib was compiled without OpenMP support, this function always returns 1. Within a task started by
+/// `dip::ParallelRun`, this function also returns 1, unless the current `dip::ExecutionContext` allows
+/// nested parallelism.
 DIP_EXPORT dip::uint GetNumberOfThreads();
 
 
@@ -74,7 +88,176 @@ DIP_EXPORT dip::uint GetNumberOfThreads();
 // (experimentally determined on Cris' computer, might be different elsewhere).
 // I also noticed that going to 2 threads or 4 threads does not make a huge difference in overhead, so this is a
 // threshold for single vs multithreaded computation, not a threshold per thread created.
-constexpr dip::uint threadingThreshold = 70000;
+// Algorithms should use `dip::GetThreadingThreshold` or `dip::GetOptimalNumberOfThreads` instead, which use
+// the calibrated cost model and can be changed through `dip::ExecutionContext`.
+constexpr dip::uint defaultThreadingThreshold = 70000;
+
+// Old name for `defaultThreadingThreshold`, kept for backwards compatibility.
+[[ deprecated( "Use dip::GetThreadingThreshold() instead." ) ]]
+constexpr dip::uint threadingThreshold = defaultThreadingThreshold;
+
+
+/// \brief Parameters of the cost model used to decide how many threads to use.
+///
+/// Processing `W` operations (clock cycles) with `n > 1` threads is modeled to cost
+/// `W / n + startupCost + perThreadCost * n`. Multithreading is used if this is less than `W`, and the number
+/// of threads is chosen to minimize the cost.
+///
+/// The default values correspond to the fixed `dip::defaultThreadingThreshold` that DIPlib used before this
+/// model was introduced. Use `dip::CalibrateThreading` to measure the values for the current machine.
+struct ThreadingCalibration {
+   dfloat startupCost = 33000;   ///< Fixed cost of starting parallel work, in operations
+   dfloat perThreadCost = 1000;  ///< Additional cost for each thread used, in operations
+
+   /// \brief The smallest number of operations for which using two threads is faster than one thread.
+   dip::uint Threshold() const {
+      return static_cast< dip::uint >( 2 * startupCost + 4 * perThreadCost );
+   }
+};
+
+/// \brief Measures the cost of starting parallel work on this machine, and uses the result from here on.
+///
+/// The measurement takes a fraction of a second. Call it when the machine is otherwise idle. If `filename` is
+/// given, the result is also written to that file, so that it can be read with `dip::LoadThreadingCalibration`.
+///
+/// If the environment variable `DIP_THREADING_CALIBRATION` is set to a file name when the calibration is first
+/// needed, that file is loaded; if it doesn't exist, the calibration is measured and written to it. This
+/// way the calibration runs only once on each machine. The measurement is postponed, using the default values
+/// in the meantime, while the calling thread cannot use all threads: within a task started by `dip::ParallelRun`,
+/// or when limited by the `dip::ExecutionContext` or `dip::SetNumberOfThreads`.
+DIP_EXPORT ThreadingCalibration CalibrateThreading( String const& filename = {} );
+
+/// \brief Reads a calibration written by `dip::CalibrateThreading`, and uses it from here on.
+DIP_EXPORT void LoadThreadingCalibration( String const& filename );
+
+/// \brief Sets the cost model parameters used from here on.
+DIP_EXPORT void SetThreadingCalibration( ThreadingCalibration const& calibration );
+
+/// \brief Returns the cost model parameters currently used.
+DIP_EXPORT ThreadingCalibration GetThreadingCalibration();
+
+
+/// \brief Settings that control multithreading for the calls made from one thread.
+///
+/// Install a context with `dip::ScopedExecutionContext`. The context is thread-local, it affects only calls made
+/// from the thread that installed it, and from the tasks that these calls start through `dip::ParallelRun`.
+/// This allows, for example, running a latency-critical request with many threads while background jobs in the
+/// same process use only a few.
+struct ExecutionContext {
+   /// \brief The maximum number of threads to use. If 0, the value set with `dip::SetNumberOfThreads` is used.
+   dip::uint maxThreads = 0;
+
+   /// \brief The number of operations (clock cycles) it takes to make it worth going into multiple threads.
+   /// If 0, the value is derived from the `dip::ThreadingCalibration`.
+   dip::uint threadingThreshold = 0;
+
+   /// \brief If true, tasks started by `dip::ParallelRun` can start parallel work of their own.
+   bool allowNestedParallelism = false;
+
+   /// \brief If not `nullptr`, algorithms stop with an exception as soon as possible after this flag is set.
+   ///
+   /// The flag is tested by the frameworks once per image line, and by `dip::ParallelRun` before each task.
+   /// Long-running algorithms can test it by calling `dip::ThrowIfCancelled`.
+   std::atomic< bool > const* cancelled = nullptr;
+
+   /// \brief Returns true if the operation should be cancelled.
+   bool IsCancelled() const {
+      return cancelled && cancelled->load( std::memory_order_relaxed );
+   }
+};
+
+/// \brief Installs a `dip::ExecutionContext` for the current thread, for the lifetime of the object.
+///
+/// The previous context is restored when the object is destroyed. Scopes can be nested.
+///
+/// ```cpp
+/// std::atomic< bool > cancel{ false };
+/// dip::ExecutionContext context;
+/// context.maxThreads = 16;
+/// context.cancelled = &cancel;
+/// {
+///    dip::ScopedExecutionContext scope( context );
+///    dip::Gauss( in, out, { 5 } ); // uses up to 16 threads, stops if `cancel` is set by another thread
+/// }
+/// ```
+class DIP_CLASS_EXPORT ScopedExecutionContext {
+   public:
+      explicit ScopedExecutionContext( ExecutionContext const& context );
+      ~ScopedExecutionContext();
+      ScopedExecutionContext( ScopedExecutionContext const& ) = delete;
+      ScopedExecutionContext& operator=( ScopedExecutionContext const& ) = delete;
+   private:
+      ExecutionContext context_;
+      ExecutionContext const* previous_;
+};
+
+/// \brief Returns the execution context for the current thread.
+DIP_EXPORT ExecutionContext const& GetExecutionContext();
+
+/// \brief Returns the number of operations (clock cycles) it takes to make it worth going into multiple threads,
+/// as given by the current `dip::ExecutionContext`, or by the `dip::ThreadingCalibration` if the context
+/// doesn't set it.
+DIP_EXPORT dip::uint GetThreadingThreshold();
+
+/// \brief Returns the number of threads to use for a computation of `operations` operations (clock cycles).
+///
+/// Returns 1 if `operations` is smaller than `dip::GetThreadingThreshold`, otherwise the number of threads that
+/// minimizes the cost according to the `dip::ThreadingCalibration`, at least 2 and at most `maxThreads`. If
+/// `maxThreads` is 0, `dip::GetNumberOfThreads` is used as the maximum.
+DIP_EXPORT dip::uint GetOptimalNumberOfThreads( dip::uint operations, dip::uint maxThreads = 0 );
+
+/// \brief Throws a `dip::RunTimeError` if the current `dip::ExecutionContext` says the operation should be cancelled.
+DIP_EXPORT void ThrowIfCancelled();
+
+
+/// \brief An executor runs a set of tasks, potentially concurrently.
+///
+/// Derive from this class to make DIPlib use your own thread pool or task scheduler, and install an
+/// instance with `dip::SetExecutor`.
+class DIP_CLASS_EXPORT Executor {
+   public:
+      virtual ~Executor() = default;
+
+      /// \brief Calls `task( ii )` for each `ii` in the range [0,`nTasks`), and returns when all calls have finished.
+      ///
+      /// The tasks are independent, they never wait for each other, so it is allowed to run them in any order,
+      /// and to run some or all of them sequentially on the calling thread. `task` never throws.
+      virtual void Run( dip::uint nTasks, std::function< void( dip::uint ) > const& task ) = 0;
+};
+
+/// \brief Returns the built-in work-stealing thread pool, this is the default executor.
+///
+/// The pool starts worker threads as they are needed, up to one fewer than the largest number of tasks it
+/// was asked to run in parallel. The calling thread always takes part in the work. All callers share the
+/// same pool, so concurrent calls from different threads do not lead to oversubscription.
+DIP_EXPORT std::shared_ptr< Executor > ThreadPoolExecutor();
+
+/// \brief Returns an executor that runs tasks in an OpenMP parallel region.
+///
+/// If DIPlib was compiled without OpenMP support, this executor runs all tasks sequentially.
+DIP_EXPORT std::shared_ptr< Executor > OpenMPExecutor();
+
+/// \brief Sets the executor used for all parallel processing in the frameworks.
+///
+/// If `executor` is `nullptr`, resets to the default executor, `dip::ThreadPoolExecutor`.
+DIP_EXPORT void SetExecutor( std::shared_ptr< Executor > executor );
+
+/// \brief Gets the executor used for all parallel processing in the frameworks.
+DIP_EXPORT std::shared_ptr< Executor > GetExecutor();
+
+/// \brief Calls `task( thread )` for each `thread` in the range [0,`nThreads`), using the current executor.
+///
+/// Returns when all calls have finished. If any call throws an exception, the first one of each kind is
+/// rethrown after all calls have finished.
+///
+/// Calls to this function made from within a task, directly or indirectly, run all their tasks sequentially
+/// on the current thread instead of starting new parallel work. Within a task, `dip::GetNumberOfThreads`
+/// returns 1, so that nested algorithms don't try to parallelize. Both can be changed by setting
+/// `dip::ExecutionContext::allowNestedParallelism`.
+///
+/// Each task runs with the `dip::ExecutionContext` of the caller, and is not started if the context says the
+/// operation should be cancelled.
+DIP_EXPORT void ParallelRun( dip::uint nThreads, std::function< void( dip::uint thread ) > const& task );
 
 /// \}
 
@@ -293,12 +293,18 @@ class DIP_NO_EXPORT PixelTable {
       void Mirror() {
          dip::uint nDims = sizes_.size();
          IntegerArray origin( nDims, std::numeric_limits< dip::sint >::max() );
+         auto weight = weights_.begin();
          for( auto& run : runs_ ) {
             run.coordinates[ procDim_ ] += static_cast< dip::sint >( run.length ) - 1; // coordinates now points at end of run
             for( dip::uint ii = 0; ii < nDims; ++ii ) {
                run.coordinates[ ii ] = -run.coordinates[ ii ]; // mirror coordinates, it points at beginning of run again
                origin[ ii ] = std::min( origin[ ii ], run.coordinates[ ii ] );
             }
+            if( !weights_.empty() ) {
+               // The pixels in the run are now visited in the opposite order
+               std::reverse( weight, weight + static_cast< dip::sint >( run.length ));
+               weight += static_cast< dip::sint >( run.length );
+            }
          }
          origin_ = origin;
       }
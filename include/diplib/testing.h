@@ -21,13 +21,19 @@
 #ifndef DIP_TESTING_H
 #define DIP_TESTING_H
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
+#include <functional>
 #include <iomanip>
+#include <random>
 
 #include "diplib.h"
 #include "diplib/statistics.h"
 #include "diplib/iterators.h"
+#include "diplib/multithreading.h"
 
 
 /// \file
@@ -319,6 +325,79 @@ inline std::ostream& operator<<(
    return os;
 }
 
+/// \brief A file name in the system's temporary directory, the file is deleted when the object is destroyed.
+///
+/// The directory is given by the `TMPDIR`, `TMP` or `TEMP` environment variable, or is `/tmp` if none are set.
+/// A random number is appended to `name`, so that concurrently running programs don't use the same file.
+class DIP_NO_EXPORT TemporaryFile {
+   public:
+      explicit TemporaryFile( String const& name ) {
+         char const* directory = "/tmp";
+         for( char const* variable : { "TMPDIR", "TMP", "TEMP" } ) {
+            char const* value = std::getenv( variable );
+            if( value && ( value[ 0 ] != '\0' )) {
+               directory = value;
+               break;
+            }
+         }
+         path_ = String( directory ) + "/" + name + "_" + std::to_string( std::random_device{}() );
+      }
+      TemporaryFile( TemporaryFile const& ) = delete;
+      TemporaryFile& operator=( TemporaryFile const& ) = delete;
+      ~TemporaryFile() {
+         std::remove( path_.c_str() );
+      }
+
+      /// \brief Returns the full path to the file.
+      String const& Path() const { return path_; }
+
+   private:
+      String path_;
+};
+
+/// \brief An executor that runs all tasks in order on the calling thread, and records how it was used.
+///
+/// Use it with `dip::SetExecutor` to test that an algorithm distributes its work through the executor.
+class DIP_NO_EXPORT RecordingExecutor : public Executor {
+   public:
+      void Run( uint nTasks, std::function< void( uint ) > const& task ) override {
+         ++calls;
+         maxTasks = std::max( maxTasks, nTasks );
+         for( uint ii = 0; ii < nTasks; ++ii ) {
+            task( ii );
+         }
+      }
+
+      uint calls = 0;     ///< The number of times `Run` was called
+      uint maxTasks = 0;  ///< The largest number of tasks `Run` was asked to run
+};
+
+/// \brief Allows a test to use 4 threads, even on a single-core machine.
+///
+/// The destructor restores the number of threads, and resets the executor to the default one.
+class DIP_NO_EXPORT FourThreads {
+   public:
+      FourThreads() {
+#ifdef _OPENMP
+         omp_set_num_threads( 4 ); // `dip::SetNumberOfThreads` doesn't go beyond this value
+#endif
+         SetNumberOfThreads( 4 );
+      }
+      FourThreads( FourThreads const& ) = delete;
+      FourThreads& operator=( FourThreads const& ) = delete;
+      ~FourThreads() {
+#ifdef _OPENMP
+         omp_set_num_threads( ompThreads_ );
+#endif
+         SetNumberOfThreads( nThreads_ );
+         SetExecutor( nullptr );
+      }
+
+   private:
+      int ompThreads_ = omp_get_max_threads();
+      uint nThreads_ = GetNumberOfThreads();
+};
+
 /// \}
 
 } // namespace testing
@@ -75,9 +75,20 @@ namespace dip {
 ///   - "symmetric": the normalization is made symmetric, where both forward and inverse transforms
 ///     are normalized by the same amount. Each transform is multiplied by `1/sqrt(size)` for each
 ///     dimension. This makes the transform identical to how it was in *DIPlib 2*.
+///   - "half": the frequency domain is represented by only its non-redundant half, see below.
 ///
 /// For tensor images, each plane is transformed independently.
 ///
+/// The Fourier transform of a real-valued image is conjugate symmetric, meaning that half of the frequency domain
+/// is redundant. The "half" option causes the forward transform of a real-valued image to produce only the
+/// non-redundant half, saving time and memory. The first dimension in `process` is halved: an image with `N` pixels
+/// along that dimension produces a frequency domain with `N/2+1` pixels. These are the first `N/2+1` pixels of the
+/// full frequency domain, and thus include the origin. Filtering operations that preserve the conjugate symmetry
+/// can be applied to this half of the frequency domain, then the "half" option to the inverse transform produces
+/// the real-valued result. This inverse transform assumes that `N` was even, unless `out` is protected and has
+/// an odd size along the halved dimension (see \ref protect). When used with the inverse transform, "half" implies
+/// "real". Using "half" with the forward transform of a complex-valued image is an error.
+///
 /// With the "fast" mode, the input will be padded. If "corner" is given, the padding is to the right.
 /// Otherwise it is split evenly on both sides, in such a way that the origin remains in the middle pixel.
 /// For the forward transform, the padding applied is the "zero order" boundary condition (see `dip::BoundaryCondition`).
@@ -105,10 +116,57 @@ inline Image FourierTransform(
    return out;
 }
 
+/// \brief Computes the forward and inverse Fourier Transform of a set of images of equal sizes.
+///
+/// Each of the images in `in` is transformed as `dip::FourierTransform`, with the given `options` and
+/// `process`, and the result is written to the corresponding image in `out`. `out` must have as many images
+/// as `in`. The input images must all have the same sizes. `out[ii]` can be the same image as `in[ii]`,
+/// but should not share data with any of the other input images.
+///
+/// When the images are small, transforming each of them with multiple threads is not efficient. This
+/// function then transforms different images in parallel, each one in a single thread. Large images are
+/// transformed one after the other, each one using multiple threads.
+///
+/// To transform a stack of images stored as a single image, use `dip::FourierTransform` with `process` set to
+/// exclude the stacking dimension.
+DIP_EXPORT void FourierTransform(
+      ImageConstRefArray const& in,
+      ImageRefArray& out,
+      StringSet const& options = {},
+      BooleanArray const& process = {}
+);
+inline ImageArray FourierTransform(
+      ImageConstRefArray const& in,
+      StringSet const& options = {},
+      BooleanArray const& process = {}
+) {
+   ImageArray out( in.size() );
+   ImageRefArray refOut = CreateImageRefArray( out );
+   FourierTransform( in, refOut, options, process );
+   return out;
+}
+
 /// \brief Returns the next higher multiple of {2, 3, 5}. The largest value that can be returned is 2125764000
 /// (smaller than 2<sup>31</sup>-1, the largest possible value of an `int` on most platforms).
 DIP_EXPORT dip::uint OptimalFourierTransformSize( dip::uint size );
 
+/// \brief Returns the FFTW wisdom accumulated by this process, as a string.
+///
+/// When *DIPlib* is linked against FFTW, `dip::FourierTransform` plans each transform size the first time it is
+/// used, and keeps the plan for the remainder of the process. Planning can take a significant amount of time.
+/// The knowledge gathered by the planner (the "wisdom") can be exported with this function, stored, and
+/// imported into a new process with `dip::FFTWisdomImport`, which then does not need to measure the transforms
+/// of the same sizes again. The string contains the wisdom for both single and double precision transforms.
+///
+/// Returns an empty string if *DIPlib* was not linked against FFTW.
+DIP_EXPORT String FFTWisdomExport();
+
+/// \brief Imports FFTW wisdom previously exported with `dip::FFTWisdomExport`.
+///
+/// Returns `true` on success, and `false` if the string could not be parsed or if *DIPlib* was not linked against
+/// FFTW. Wisdom is only valid on the machine and with the FFTW version it was created with.
+DIP_EXPORT bool FFTWisdomImport( String const& wisdom );
+
 
 /// \brief Computes the Riesz transform of a scalar image.
 ///
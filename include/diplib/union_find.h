@@ -21,6 +21,11 @@
 #ifndef DIP_UNION_FIND_H
 #define DIP_UNION_FIND_H
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <vector>
+
 #include "diplib/library/types.h"
 
 
@@ -106,6 +111,11 @@ class UnionFind {
          return index;
       }
 
+      /// \brief Returns the number of elements created, which is also the largest index in use.
+      dip::uint Size() const {
+         return list.size() - 1;
+      }
+
       /// \brief Merges two trees. Returns the index of the new root.
       IndexType Union( IndexType index1, IndexType index2 ) {
          index1 = FindRoot( index1 );
@@ -227,6 +237,133 @@ class SimpleUnionFind : public UnionFind< IndexType_, detail::DummyUnionFindData
 };
 
 
+/// \brief A variant of `dip::SimpleUnionFind` that can be used concurrently from multiple threads.
+///
+/// `Create`, `FindRoot` and `Union` can be called simultaneously from any number of threads without locking.
+/// The parent links are stored in an array of atomic values; `Union` links one root to the other with a
+/// compare-and-swap operation, retrying if another thread modified either tree in the meantime, and `FindRoot`
+/// shortens the paths it traverses by path halving.
+///
+/// As with `dip::UnionFind`, the lower of the two labels becomes the root when two trees are merged. Consequently,
+/// the root of each tree is its lowest label, and the trees obtained do not depend on the order in which the
+/// `Union` calls are made. `Relabel` thus assigns the same labels as it would for a `dip::SimpleUnionFind` with
+/// the same equivalences.
+///
+/// The number of elements that can be created is fixed when constructing the object, since the array cannot be
+/// reallocated while other threads are accessing it. `Relabel` must not be called concurrently with other
+/// methods; typically, the threads are joined before relabeling.
+///
+/// There is no version of this class that stores data for each tree, as it is not possible to merge such
+/// values atomically.
+template< typename IndexType_ >
+class ConcurrentUnionFind {
+   public:
+      using IndexType = IndexType_; ///< The type of the index (or label) that identifies each tree element
+
+      /// \brief Creates `n` trees, with indices 1 through `n`, and room for `Create` to add elements until
+      /// there are `capacity` elements.
+      explicit ConcurrentUnionFind( dip::uint n, dip::uint capacity = 0 ) : list( std::max( n, capacity ) + 1 ), size_( n ) {
+         DIP_THROW_IF( list.size() - 1 > static_cast< dip::uint >( std::numeric_limits< IndexType >::max() ), "Cannot create this many regions!" );
+         for( dip::uint ii = 0; ii < list.size(); ++ii ) {
+            list[ ii ].store( static_cast< IndexType >( ii ), std::memory_order_relaxed );
+         }
+      }
+
+      /// \brief Creates a new element, and places it in its own tree.
+      IndexType Create() {
+         dip::uint index = ++size_;
+         if( index >= list.size() ) {
+            --size_;
+            DIP_THROW( "Cannot create more regions!" );
+         }
+         return static_cast< IndexType >( index );
+      }
+
+      /// \brief Returns the number of elements created, which is also the largest index in use.
+      dip::uint Size() const {
+         return size_;
+      }
+
+      /// \brief Returns the index (label) for the root of the tree that contains `index`.
+      ///
+      /// If other threads are merging trees, the returned value might not be a root any more by the time it's used.
+      IndexType FindRoot( IndexType index ) const {
+         while( true ) {
+            IndexType parent = list[ index ].load( std::memory_order_acquire );
+            if( parent == index ) {
+               return index;
+            }
+            IndexType grandParent = list[ parent ].load( std::memory_order_acquire );
+            if( grandParent != parent ) {
+               // Path halving: point `index` to its grandparent. If this fails, another thread has already updated
+               // the link to point to an even higher ancestor (parents always have a lower index than their
+               // children), which is fine too.
+               list[ index ].compare_exchange_weak( parent, grandParent, std::memory_order_acq_rel );
+            }
+            index = grandParent;
+         }
+      }
+
+      /// \brief Merges two trees. Returns the index of the new root.
+      ///
+      /// If other threads are merging trees, the returned value might not be a root any more by the time it's used.
+      IndexType Union( IndexType index1, IndexType index2 ) {
+         while( true ) {
+            index1 = FindRoot( index1 );
+            index2 = FindRoot( index2 );
+            if( index1 == index2 ) {
+               return index1;
+            }
+            // We take the lower of the two labels as root.
+            IndexType root = std::min( index1, index2 );
+            IndexType leaf = std::max( index1, index2 );
+            // Link `leaf` to `root`, but only if `leaf` is still a root. Otherwise another thread has just linked it
+            // elsewhere, and we try again from the new roots.
+            IndexType expected = leaf;
+            if( list[ leaf ].compare_exchange_strong( expected, root, std::memory_order_acq_rel )) {
+               return root;
+            }
+         }
+      }
+
+      /// \brief Assigns a new label to each of the trees.
+      ///
+      /// Returns the number of unique labels.
+      ///
+      /// \warning This function destroys the tree structure. After this call, you can only use `Label`.
+      /// It must not be called while other threads are using the object.
+      dip::uint Relabel() {
+         dip::uint n = size_;
+         std::vector< IndexType > newLabels( n + 1, 0 );
+         IndexType lab = 0;
+         // Assign a new, unique and consecutive label to each tree, and point each element directly at its root.
+         // The loop counter is a `dip::uint` because `n` can be the largest value `IndexType` can hold.
+         for( dip::uint ii = 1; ii <= n; ++ii ) {
+            IndexType index = FindRoot( static_cast< IndexType >( ii ));
+            list[ ii ].store( index, std::memory_order_relaxed );
+            if(( index > 0 ) && ( newLabels[ index ] == 0 )) {
+               newLabels[ index ] = ++lab;
+            }
+         }
+         // Write the new labels to the list.
+         for( dip::uint ii = 1; ii <= n; ++ii ) {
+            list[ ii ].store( newLabels[ list[ ii ].load( std::memory_order_relaxed ) ], std::memory_order_relaxed );
+         }
+         return lab;
+      }
+
+      /// \brief Returns the new label associated to the tree that contains `index`. Only useful after calling `Relabel`.
+      IndexType Label( IndexType index ) const {
+         return list[ index ].load( std::memory_order_relaxed );
+      }
+
+   private:
+      // The parent of each element, as in `dip::UnionFind`. Element 0 is not used.
+      std::vector< std::atomic< IndexType >> mutable list;
+      std::atomic< dip::uint > size_;
+};
+
+
 /// \}
 
 } // namespace dip
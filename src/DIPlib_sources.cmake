@@ -8,11 +8,13 @@ set(DIPlib_sources_bogus
 ../include/diplib/boundary.h
 ../include/diplib/chain_code.h
 ../include/diplib/color.h
+../include/diplib/component_tree.h
 ../include/diplib/detection.h
 ../include/diplib/dft.h
 ../include/diplib/display.h
 ../include/diplib/distance.h
 ../include/diplib/distribution.h
+../include/diplib/expression.h
 ../include/diplib/file_io.h
 ../include/diplib/framework.h
 ../include/diplib/generation.h
@@ -25,6 +27,7 @@ set(DIPlib_sources_bogus
 ../include/diplib/kernel.h
 ../include/diplib/library/clamp_cast.h
 ../include/diplib/library/copy_buffer.h
+../include/diplib/library/cpu_dispatch.h
 ../include/diplib/library/datatype.h
 ../include/diplib/library/dimension_array.h
 ../include/diplib/library/error.h
@@ -43,12 +46,14 @@ set(DIPlib_sources_bogus
 ../include/diplib/mapping.h
 ../include/diplib/math.h
 ../include/diplib/measurement.h
+../include/diplib/memory_pool.h
 ../include/diplib/microscopy.h
 ../include/diplib/morphology.h
 ../include/diplib/multithreading.h
 ../include/diplib/neighborlist.h
 ../include/diplib/nonlinear.h
 ../include/diplib/overload.h
+../include/diplib/packed_binary.h
 ../include/diplib/pixel_table.h
 ../include/diplib/private/constfor.h
 ../include/diplib/private/monadic_operators.h
@@ -78,6 +83,7 @@ binary/binary_support.cpp
 binary/binary_support.h
 binary/bucket.h
 binary/count_neighbors.cpp
+binary/packed_binary.cpp
 binary/skeleton.cpp
 binary/sup_inf_generator.cpp
 binary/thick_thin_2D.cpp
@@ -126,7 +132,10 @@ histogram/per_object_hist.cpp
 histogram/statistics.cpp
 histogram/threshold_algorithms.cpp
 library/boundary.cpp
+library/calibration.h
 library/copy_buffer.cpp
+library/copy_buffer_simd.cpp
+library/cpu_dispatch.cpp
 library/datatype.cpp
 library/framework.cpp
 library/framework_full.cpp
@@ -141,11 +150,13 @@ library/image_manip.cpp
 library/image_views.cpp
 library/information.cpp
 library/iterators.cpp
+library/memory_pool.cpp
 library/multithreading.cpp
 library/neighborhood.cpp
 library/physical_dimensions.cpp
 library/pixel_table.cpp
 library/types.cpp
+library/union_find.cpp
 library/unit_tests.cpp
 linear/convolution.cpp
 linear/derivative.cpp
@@ -153,6 +164,7 @@ linear/finitediff.cpp
 linear/gabor.cpp
 linear/gaboriir.cpp
 linear/gauss.cpp
+linear/gauss_method.cpp
 linear/gaussiir.cpp
 linear/separate_filter.cpp
 linear/sharpen.cpp
@@ -165,6 +177,7 @@ math/bitwise.cpp
 math/comparison.cpp
 math/dyadic_operators.cpp
 math/error.cpp
+math/expression.cpp
 math/monadic_operators.cpp
 math/pixel.cpp
 math/projection.cpp
@@ -223,6 +236,7 @@ measurement/measure_polygon.cpp
 measurement/measurement.cpp
 measurement/measurement_tool.cpp
 measurement/object_to_measurement.cpp
+measurement/parallel_line_based.h
 measurement/polygon.cpp
 microscopy/attenuation_correction.cpp
 microscopy/colocalization.cpp
@@ -231,11 +245,13 @@ microscopy/unmix_stains.cpp
 microscopy/wiener.cpp
 morphology/areaopening.cpp
 morphology/basic.cpp
+morphology/component_tree.cpp
 morphology/filters.cpp
 morphology/maxima.cpp
 morphology/one_dimensional.cpp
 morphology/one_dimensional.h
 morphology/pathopening.cpp
+morphology/priority_queues.h
 morphology/reconstruction.cpp
 morphology/upperskeleton2d.cpp
 morphology/watershed.cpp
@@ -265,7 +281,9 @@ support/matrix.cpp
 support/numeric.cpp
 support/thin_plate_spline.cpp
 transform/fourier.cpp
+transform/fourier_support.h
 transform/opencv_dxt.cpp
+transform/real_dft.cpp
 transform/riesz.cpp
 transform/swt.cpp
 )
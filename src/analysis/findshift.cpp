@@ -25,6 +25,7 @@
 #include "diplib/statistics.h"
 #include "diplib/linear.h"
 #include "diplib/geometry.h"
+#include "../transform/fourier_support.h"
 
 namespace dip {
 
@@ -47,17 +48,24 @@ void CrossCorrelationFT(
    DIP_STACK_TRACE_THIS( in2Spatial = BooleanFromString( in2Representation, S::SPATIAL, S::FREQUENCY ));
    bool outSpatial;
    DIP_STACK_TRACE_THIS( outSpatial = BooleanFromString( outRepresentation, S::SPATIAL, S::FREQUENCY ));
+   // If both inputs and the output are in the spatial domain, we need to compute only half of the frequency domain
+   bool half = in1Spatial && in2Spatial && outSpatial;
+   StringSet options;
+   if( half ) {
+      options.insert( S::HALF );
+   }
+   UnsignedArray sizes = in1.Sizes();
    Image in1FT;
    if( in1Spatial ) {
       DIP_THROW_IF( !in1.DataType().IsReal(), E::DATA_TYPE_NOT_SUPPORTED );
-      DIP_STACK_TRACE_THIS( FourierTransform( in1, in1FT ));
+      DIP_STACK_TRACE_THIS( FourierTransform( in1, in1FT, options ));
    } else {
       in1FT = in1.QuickCopy();
    }
    Image in2FT;
    if( in2Spatial ) {
       DIP_THROW_IF( !in2.DataType().IsReal(), E::DATA_TYPE_NOT_SUPPORTED );
-      DIP_STACK_TRACE_THIS( FourierTransform( in2, in2FT ));
+      DIP_STACK_TRACE_THIS( FourierTransform( in2, in2FT, options ));
    } else {
       in2FT = in2.QuickCopy();
    }
@@ -86,7 +94,13 @@ void CrossCorrelationFT(
       DIP_THROW_INVALID_FLAG( normalize );
    }
    if( outSpatial ) {
-      DIP_STACK_TRACE_THIS( FourierTransform( outFT, out, { S::INVERSE, S::REAL } ));
+      options.insert( S::INVERSE );
+      options.insert( S::REAL );
+      if( half ) {
+         DIP_STACK_TRACE_THIS( HalfInverseFourierTransform( outFT, out, sizes, options ));
+      } else {
+         DIP_STACK_TRACE_THIS( FourierTransform( outFT, out, options ));
+      }
    }
 }
 
@@ -22,6 +22,7 @@
 #include "diplib/analysis.h"
 #include "diplib/statistics.h"
 #include "diplib/morphology.h"
+#include "diplib/component_tree.h"
 #include "diplib/generation.h"
 #include "diplib/geometry.h"
 #include "diplib/mapping.h"
@@ -47,8 +48,15 @@ Distribution Granulometry(
    std::sort( scales.begin(), scales.end() );
    DIP_THROW_IF( scales[ 0 ] <= 1.0, E::PARAMETER_OUT_OF_RANGE ); // all scales must be larger than 1
    // Type
-   bool isotropic;
-   DIP_STACK_TRACE_THIS( isotropic = BooleanFromString( type, S::ISOTROPIC, S::LENGTH ));
+   bool isotropic = false;
+   bool area = false;
+   if( type == S::ISOTROPIC ) {
+      isotropic = true;
+   } else if( type == S::AREA ) {
+      area = true;
+   } else if( type != S::LENGTH ) {
+      DIP_THROW_INVALID_FLAG( type );
+   }
    // Polarity
    bool opening;
    DIP_STACK_TRACE_THIS( opening = BooleanFromString( polarity, S::OPENING, S::CLOSING ));
@@ -68,9 +76,9 @@ Distribution Granulometry(
          interpolate = true;
       } else if( isotropic && ( option == S::SUBSAMPLE )) {
          subsample = true;
-      } else if( !isotropic && ( option == S::UNCONSTRAINED )) {
+      } else if( !isotropic && !area && ( option == S::UNCONSTRAINED )) {
          constrained = false;
-      } else if( !isotropic && ( option == S::ROBUST )) {
+      } else if( !isotropic && !area && ( option == S::ROBUST )) {
          robust = true;
       } else {
          DIP_THROW_INVALID_FLAG( option );
@@ -194,6 +202,23 @@ Distribution Granulometry(
          out[ ii ].Y() = clamp(( result - offset ) * gain, 0.0, 1.0 ); // Clamping is necessary if we interpolate and/or subsample
       }
 
+   } else if( area ) {
+      // Area opening/closing, all scales use the same component tree, built only from the pixels within the mask
+
+      ComponentTree tree( in, mask, 0, polarity );
+      std::vector< dip::uint > areas = tree.Area();
+      std::vector< bool > keep( areas.size() );
+      Image tmp;
+      for( dip::uint ii = 0; ii < scales.size(); ++ii ) {
+         dfloat filterSize = std::pow( scales[ ii ], static_cast< dfloat >( nDims ));
+         for( dip::uint jj = 0; jj < areas.size(); ++jj ) {
+            keep[ jj ] = static_cast< dfloat >( areas[ jj ] ) >= filterSize;
+         }
+         tree.Filter( keep, tmp );
+         dfloat result = Mean( tmp, mask ).As< dfloat >();
+         out[ ii ].Y() = ( result - offset ) * gain;
+      }
+
    } else {
       // Path opening/closing
 
@@ -0,0 +1,638 @@
+/*
+ * DIPlib 3.0
+ * This file contains the definitions for bit-packed binary images and the functions that work on them.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <bitset>
+
+#include "diplib.h"
+#include "diplib/packed_binary.h"
+#include "diplib/neighborlist.h"
+#include "diplib/multithreading.h"
+#include "binary_support.h"
+
+namespace dip {
+
+constexpr dip::uint PackedBinaryImage::bitsPerWord;
+
+namespace {
+
+using Word = PackedBinaryImage::Word;
+constexpr dip::uint bitsPerWord = PackedBinaryImage::bitsPerWord;
+constexpr Word allOnes = ~Word( 0 );
+
+// Mask for the valid bits in the last word of a line of length `length`
+Word LastWordMask( dip::uint length ) {
+   dip::uint bits = length % bitsPerWord;
+   return bits == 0 ? allOnes : ( Word( 1 ) << bits ) - 1;
+}
+
+// Computes the coordinates along dimensions 1 and up of line `line`
+void LineCoordinates( UnsignedArray const& sizes, dip::uint line, UnsignedArray& coords ) {
+   coords.resize( sizes.size() - 1 );
+   for( dip::uint ii = 1; ii < sizes.size(); ++ii ) {
+      coords[ ii - 1 ] = line % sizes[ ii ];
+      line /= sizes[ ii ];
+   }
+}
+
+// Calls `function( line, coords, thread )` for each line in the image, distributing the lines over multiple threads.
+// `coords` are the coordinates of the line along dimensions 1 and up. `thread` is the index of the thread processing
+// the line, it is always smaller than `GetNumberOfThreads()`, and can be used to index per-thread buffers.
+template< typename F >
+void ParallelForEachLine( UnsignedArray const& sizes, dip::uint nLines, dip::uint operations, F const& function ) {
+   dip::uint nThreads = GetOptimalNumberOfThreads( operations, std::min( GetNumberOfThreads(), nLines ));
+   ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+      dip::uint first = thread * nLines / nThreads;
+      dip::uint last = ( thread + 1 ) * nLines / nThreads;
+      UnsignedArray coords;
+      LineCoordinates( sizes, first, coords );
+      for( dip::uint line = first; line < last; ++line ) {
+         function( line, coords, thread );
+         for( dip::uint ii = 0; ii < coords.size(); ++ii ) {
+            if( ++( coords[ ii ] ) < sizes[ ii + 1 ] ) {
+               break;
+            }
+            coords[ ii ] = 0;
+         }
+      }
+   } );
+}
+
+// A neighbor, split into the offset to the neighboring line and the offset along the line
+struct LineNeighbor {
+   IntegerArray lineCoords;   // Offset along dimensions 1 and up
+   dip::sint lineOffset;      // Offset in number of lines
+   dip::sint dx;              // Offset along dimension 0
+};
+
+std::vector< LineNeighbor > GetLineNeighbors( UnsignedArray const& sizes, dip::uint connectivity ) {
+   NeighborList neighborList( { Metric::TypeCode::CONNECTED, connectivity }, sizes.size() );
+   std::vector< LineNeighbor > neighbors;
+   neighbors.reserve( neighborList.Size() );
+   for( auto it = neighborList.begin(); it != neighborList.end(); ++it ) {
+      IntegerArray const& coords = it.Coordinates();
+      LineNeighbor neighbor;
+      neighbor.dx = coords[ 0 ];
+      neighbor.lineCoords.resize( sizes.size() - 1 );
+      neighbor.lineOffset = 0;
+      dip::sint stride = 1;
+      for( dip::uint ii = 1; ii < sizes.size(); ++ii ) {
+         neighbor.lineCoords[ ii - 1 ] = coords[ ii ];
+         neighbor.lineOffset += coords[ ii ] * stride;
+         stride *= static_cast< dip::sint >( sizes[ ii ] );
+      }
+      neighbors.push_back( neighbor );
+   }
+   return neighbors;
+}
+
+// Returns a pointer to the line that is the neighbor `neighbor` of line `line`, or `nullptr` if that line falls outside
+// the image
+Word const* NeighborLine(
+      PackedBinaryImage const& img,
+      dip::uint line,
+      UnsignedArray const& coords,
+      LineNeighbor const& neighbor
+) {
+   UnsignedArray const& sizes = img.Sizes();
+   for( dip::uint ii = 0; ii < coords.size(); ++ii ) {
+      dip::sint pos = static_cast< dip::sint >( coords[ ii ] ) + neighbor.lineCoords[ ii ];
+      if(( pos < 0 ) || ( pos >= static_cast< dip::sint >( sizes[ ii + 1 ] ))) {
+         return nullptr;
+      }
+   }
+   return img.Line( static_cast< dip::uint >( static_cast< dip::sint >( line ) + neighbor.lineOffset ));
+}
+
+// Returns word `k` of line `src`, shifted such that bit `x` of the output is pixel `x + dx` of the line. Pixels
+// outside of the line have value `edge`. `src` is `nullptr` for lines outside of the image. `lastBit` is the bit
+// for the last pixel in the last word. The padding bits of the output are not necessarily zero.
+inline Word ShiftedWord( Word const* src, dip::uint k, dip::uint nWords, dip::sint dx, Word lastBit, bool edge ) {
+   if( !src ) {
+      return edge ? allOnes : Word( 0 );
+   }
+   Word w = src[ k ];
+   if( dx > 0 ) {
+      w >>= 1;
+      if( k + 1 < nWords ) {
+         w |= src[ k + 1 ] << ( bitsPerWord - 1 );
+      } else if( edge ) {
+         w |= lastBit;
+      }
+   } else if( dx < 0 ) {
+      w <<= 1;
+      if( k > 0 ) {
+         w |= src[ k - 1 ] >> ( bitsPerWord - 1 );
+      } else if( edge ) {
+         w |= 1u;
+      }
+   }
+   return w;
+}
+
+// One dilation (`dilate` is true) or erosion step with the given neighborhood. If `mask` is given, the output is
+// limited to the mask.
+void DilationErosionStep(
+      PackedBinaryImage const& in,
+      PackedBinaryImage& out,
+      std::vector< LineNeighbor > const& neighbors,
+      bool dilate,
+      bool edge,
+      PackedBinaryImage const* mask = nullptr
+) {
+   dip::uint nWords = in.WordsPerLine();
+   Word lastMask = LastWordMask( in.Sizes()[ 0 ] );
+   Word lastBit = lastMask & ~( lastMask >> 1 );
+   // Pointers to the neighbor lines, one set per thread
+   std::vector< Word const* > buffer( GetNumberOfThreads() * neighbors.size() );
+   ParallelForEachLine( in.Sizes(), in.NumberOfLines(), in.NumberOfLines() * nWords * neighbors.size(),
+                        [ & ]( dip::uint line, UnsignedArray const& coords, dip::uint thread ) {
+      Word const** src = buffer.data() + thread * neighbors.size();
+      for( dip::uint jj = 0; jj < neighbors.size(); ++jj ) {
+         src[ jj ] = NeighborLine( in, line, coords, neighbors[ jj ] );
+      }
+      Word const* self = in.Line( line );
+      Word const* maskLine = mask ? mask->Line( line ) : nullptr;
+      Word* dst = out.Line( line );
+      for( dip::uint k = 0; k < nWords; ++k ) {
+         Word w = self[ k ];
+         if( dilate ) {
+            for( dip::uint jj = 0; jj < neighbors.size(); ++jj ) {
+               w |= ShiftedWord( src[ jj ], k, nWords, neighbors[ jj ].dx, lastBit, edge );
+            }
+         } else {
+            for( dip::uint jj = 0; jj < neighbors.size(); ++jj ) {
+               w &= ShiftedWord( src[ jj ], k, nWords, neighbors[ jj ].dx, lastBit, edge );
+            }
+         }
+         if( maskLine ) {
+            w &= maskLine[ k ];
+         }
+         dst[ k ] = w;
+      }
+      dst[ nWords - 1 ] &= lastMask;
+   } );
+}
+
+// Fills the set pixels in `line` along the line, within the mask `mask`, in both directions
+void FillLine( Word* line, Word const* mask, dip::uint nWords ) {
+   // Forward: propagate towards higher bits (Kogge-Stone occluded fill), carrying over into the next word
+   Word carry = 0;
+   for( dip::uint k = 0; k < nWords; ++k ) {
+      Word pro = mask[ k ];
+      Word gen = line[ k ] | ( carry & pro );
+      gen |= pro & ( gen << 1 );
+      pro &= pro << 1;
+      gen |= pro & ( gen << 2 );
+      pro &= pro << 2;
+      gen |= pro & ( gen << 4 );
+      pro &= pro << 4;
+      gen |= pro & ( gen << 8 );
+      pro &= pro << 8;
+      gen |= pro & ( gen << 16 );
+      pro &= pro << 16;
+      gen |= pro & ( gen << 32 );
+      line[ k ] = gen;
+      carry = gen >> ( bitsPerWord - 1 );
+   }
+   // Backward: propagate towards lower bits
+   carry = 0;
+   for( dip::uint k = nWords; k-- > 0; ) {
+      Word pro = mask[ k ];
+      Word gen = line[ k ] | ( carry & pro );
+      gen |= pro & ( gen >> 1 );
+      pro &= pro >> 1;
+      gen |= pro & ( gen >> 2 );
+      pro &= pro >> 2;
+      gen |= pro & ( gen >> 4 );
+      pro &= pro >> 4;
+      gen |= pro & ( gen >> 8 );
+      pro &= pro >> 8;
+      gen |= pro & ( gen >> 16 );
+      pro &= pro >> 16;
+      gen |= pro & ( gen >> 32 );
+      line[ k ] = gen;
+      carry = ( gen & 1u ) << ( bitsPerWord - 1 );
+   }
+}
+
+// Propagates `current` within `mask` until no more changes occur, using alternating forward and backward raster
+// scans. Within each line, the propagation is done in one go by `FillLine`. Each scan reads the lines it just
+// wrote, so this runs in a single thread.
+void RasterPropagation(
+      PackedBinaryImage& current,
+      PackedBinaryImage const& mask,
+      std::vector< LineNeighbor > const& neighbors
+) {
+   // Neighbors in lines before and after the current one; neighbors in the same line are handled by `FillLine`
+   std::vector< LineNeighbor > backward;
+   std::vector< LineNeighbor > forward;
+   for( auto const& neighbor : neighbors ) {
+      if( neighbor.lineOffset < 0 ) {
+         backward.push_back( neighbor );
+      } else if( neighbor.lineOffset > 0 ) {
+         forward.push_back( neighbor );
+      }
+   }
+   UnsignedArray const& sizes = current.Sizes();
+   dip::uint nLines = current.NumberOfLines();
+   dip::uint nWords = current.WordsPerLine();
+   Word lastBit = LastWordMask( sizes[ 0 ] );
+   lastBit &= ~( lastBit >> 1 );
+   std::vector< Word const* > src;
+   UnsignedArray coords;
+   auto UpdateLine = [ & ]( dip::uint line, std::vector< LineNeighbor > const& lineNeighbors ) {
+      LineCoordinates( sizes, line, coords );
+      src.resize( lineNeighbors.size() );
+      for( dip::uint jj = 0; jj < lineNeighbors.size(); ++jj ) {
+         src[ jj ] = NeighborLine( current, line, coords, lineNeighbors[ jj ] );
+      }
+      Word* dst = current.Line( line );
+      Word const* maskLine = mask.Line( line );
+      bool changed = false;
+      for( dip::uint k = 0; k < nWords; ++k ) {
+         Word w = dst[ k ];
+         for( dip::uint jj = 0; jj < lineNeighbors.size(); ++jj ) {
+            w |= ShiftedWord( src[ jj ], k, nWords, lineNeighbors[ jj ].dx, lastBit, false );
+         }
+         w &= maskLine[ k ];
+         if( w != dst[ k ] ) {
+            dst[ k ] = w;
+            changed = true;
+         }
+      }
+      if( changed ) {
+         FillLine( dst, maskLine, nWords );
+      }
+      return changed;
+   };
+   for( dip::uint line = 0; line < nLines; ++line ) {
+      FillLine( current.Line( line ), mask.Line( line ), nWords );
+   }
+   bool changed = true;
+   while( changed ) {
+      changed = false;
+      for( dip::uint line = 0; line < nLines; ++line ) {
+         changed |= UpdateLine( line, backward );
+      }
+      for( dip::uint line = nLines; line-- > 0; ) {
+         changed |= UpdateLine( line, forward );
+      }
+   }
+}
+
+// Sets `next` to the pixels in `next` not yet in `current`, and adds these to `current`. Returns false if there
+// were no such pixels.
+bool UpdateFrontier( PackedBinaryImage& current, PackedBinaryImage& next ) {
+   Word any = 0;
+   for( dip::uint line = 0; line < current.NumberOfLines(); ++line ) {
+      Word* cur = current.Line( line );
+      Word* nxt = next.Line( line );
+      for( dip::uint k = 0; k < current.WordsPerLine(); ++k ) {
+         nxt[ k ] &= ~cur[ k ];
+         cur[ k ] |= nxt[ k ];
+         any |= nxt[ k ];
+      }
+   }
+   return any != 0;
+}
+
+void BinaryDilationErosion(
+      PackedBinaryImage const& in,
+      PackedBinaryImage& out,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& s_edgeCondition,
+      bool dilate
+) {
+   DIP_THROW_IF( in.IsEmpty(), E::IMAGE_NOT_FORGED );
+   dip::uint nDims = in.Dimensionality();
+   DIP_THROW_IF( connectivity > static_cast< dip::sint >( nDims ), E::ILLEGAL_CONNECTIVITY );
+   bool outsideImageIsObject;
+   DIP_STACK_TRACE_THIS( outsideImageIsObject = BooleanFromString( s_edgeCondition, S::OBJECT, S::BACKGROUND ));
+   PackedBinaryImage current = in;
+   PackedBinaryImage next = in;
+   for( dip::uint ii = 0; ii < iterations; ++ii ) {
+      dip::uint iterConnectivity;
+      DIP_STACK_TRACE_THIS( iterConnectivity = GetAbsBinaryConnectivity( nDims, connectivity, ii ));
+      std::vector< LineNeighbor > neighbors = GetLineNeighbors( in.Sizes(), iterConnectivity );
+      DIP_STACK_TRACE_THIS( DilationErosionStep( current, next, neighbors, dilate, outsideImageIsObject ));
+      std::swap( current, next );
+   }
+   out = std::move( current );
+}
+
+} // namespace
+
+PackedBinaryImage::PackedBinaryImage( UnsignedArray const& sizes, bool value ) {
+   DIP_THROW_IF( sizes.empty(), E::ARRAY_PARAMETER_EMPTY );
+   DIP_THROW_IF( sizes.product() == 0, E::INVALID_PARAMETER );
+   sizes_ = sizes;
+   wordsPerLine_ = div_ceil( sizes_[ 0 ], bitsPerWord );
+   dip::uint nLines = sizes_.product() / sizes_[ 0 ];
+   data_.assign( nLines * wordsPerLine_, value ? allOnes : Word( 0 ));
+   if( value ) {
+      Word lastMask = LastWordMask( sizes_[ 0 ] );
+      for( dip::uint line = 0; line < nLines; ++line ) {
+         Line( line )[ wordsPerLine_ - 1 ] = lastMask;
+      }
+   }
+}
+
+PackedBinaryImage::PackedBinaryImage( Image const& image ) {
+   DIP_THROW_IF( !image.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !image.DataType().IsBinary(), E::IMAGE_NOT_BINARY );
+   DIP_THROW_IF( !image.IsScalar(), E::IMAGE_NOT_SCALAR );
+   DIP_THROW_IF( image.Dimensionality() < 1, E::DIMENSIONALITY_NOT_SUPPORTED );
+   *this = PackedBinaryImage( image.Sizes() );
+   dip::uint length = sizes_[ 0 ];
+   dip::sint stride = image.Stride( 0 );
+   ParallelForEachLine( sizes_, NumberOfLines(), sizes_.product(), [ & ]( dip::uint line, UnsignedArray const& coords, dip::uint /*thread*/ ) {
+      UnsignedArray pos( sizes_.size(), 0 );
+      std::copy( coords.begin(), coords.end(), pos.begin() + 1 );
+      bin const* src = static_cast< bin const* >( image.Pointer( pos ));
+      Word* dst = Line( line );
+      for( dip::uint k = 0; k < wordsPerLine_; ++k ) {
+         dip::uint n = std::min( bitsPerWord, length - k * bitsPerWord );
+         Word w = 0;
+         for( dip::uint bit = 0; bit < n; ++bit, src += stride ) {
+            if( *src ) {
+               w |= Word( 1 ) << bit;
+            }
+         }
+         dst[ k ] = w;
+      }
+   } );
+}
+
+void PackedBinaryImage::Unpack( Image& out ) const {
+   DIP_THROW_IF( IsEmpty(), E::IMAGE_NOT_FORGED );
+   DIP_STACK_TRACE_THIS( out.ReForge( sizes_, 1, DT_BIN ));
+   dip::uint length = sizes_[ 0 ];
+   dip::sint stride = out.Stride( 0 );
+   ParallelForEachLine( sizes_, NumberOfLines(), sizes_.product(), [ & ]( dip::uint line, UnsignedArray const& coords, dip::uint /*thread*/ ) {
+      UnsignedArray pos( sizes_.size(), 0 );
+      std::copy( coords.begin(), coords.end(), pos.begin() + 1 );
+      bin* dst = static_cast< bin* >( out.Pointer( pos ));
+      Word const* src = Line( line );
+      for( dip::uint k = 0; k < wordsPerLine_; ++k ) {
+         dip::uint n = std::min( bitsPerWord, length - k * bitsPerWord );
+         Word w = src[ k ];
+         for( dip::uint bit = 0; bit < n; ++bit, dst += stride ) {
+            *dst = static_cast< bool >(( w >> bit ) & 1u );
+         }
+      }
+   } );
+}
+
+dip::uint PackedBinaryImage::Count() const {
+   dip::uint count = 0;
+   for( Word w : data_ ) {
+      count += std::bitset< bitsPerWord >( w ).count();
+   }
+   return count;
+}
+
+void BinaryDilation(
+      PackedBinaryImage const& in,
+      PackedBinaryImage& out,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& edgeCondition
+) {
+   BinaryDilationErosion( in, out, connectivity, iterations, edgeCondition, true );
+}
+
+void BinaryErosion(
+      PackedBinaryImage const& in,
+      PackedBinaryImage& out,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& edgeCondition
+) {
+   BinaryDilationErosion( in, out, connectivity, iterations, edgeCondition, false );
+}
+
+void BinaryPropagation(
+      PackedBinaryImage const& inSeed,
+      PackedBinaryImage const& inMask,
+      PackedBinaryImage& out,
+      dip::sint connectivity,
+      dip::uint iterations,
+      String const& s_edgeCondition
+) {
+   DIP_THROW_IF( inMask.IsEmpty(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !inSeed.IsEmpty() && ( inSeed.Sizes() != inMask.Sizes() ), E::SIZES_DONT_MATCH );
+   dip::uint nDims = inMask.Dimensionality();
+   DIP_THROW_IF( connectivity > static_cast< dip::sint >( nDims ), E::ILLEGAL_CONNECTIVITY );
+   bool outsideImageIsObject;
+   DIP_STACK_TRACE_THIS( outsideImageIsObject = BooleanFromString( s_edgeCondition, S::OBJECT, S::BACKGROUND ));
+
+   // In the first iteration, seeds propagate into the mask; seeds outside the mask are not part of the output
+   PackedBinaryImage frontier = inSeed.IsEmpty() ? PackedBinaryImage( inMask.Sizes() ) : inSeed;
+   PackedBinaryImage current( inMask.Sizes() );
+   PackedBinaryImage next( inMask.Sizes() );
+   dip::uint iterConnectivity;
+   DIP_STACK_TRACE_THIS( iterConnectivity = GetAbsBinaryConnectivity( nDims, connectivity, 0 ));
+   std::vector< LineNeighbor > neighbors = GetLineNeighbors( inMask.Sizes(), iterConnectivity );
+   DIP_STACK_TRACE_THIS( DilationErosionStep( frontier, next, neighbors, true, outsideImageIsObject, &inMask ));
+
+   if(( iterations == 0 ) && ( connectivity >= 0 )) {
+      // Propagate until done, the order in which pixels are visited does not matter
+      current = std::move( next );
+      DIP_STACK_TRACE_THIS( RasterPropagation( current, inMask, neighbors ));
+   } else {
+      // Propagate from the pixels set in the previous iteration only, as the `dip::Image` version does; with
+      // alternating connectivities the result depends on this
+      if( iterations == 0 ) {
+         iterations = std::numeric_limits< dip::uint >::max();
+      }
+      // Seeds within the mask are not propagated in the second iteration
+      for( dip::uint line = 0; line < current.NumberOfLines(); ++line ) {
+         Word* cur = current.Line( line );
+         Word const* seed = frontier.Line( line );
+         Word const* mask = inMask.Line( line );
+         for( dip::uint k = 0; k < current.WordsPerLine(); ++k ) {
+            cur[ k ] = seed[ k ] & mask[ k ];
+         }
+      }
+      for( dip::uint ii = 1; UpdateFrontier( current, next ) && ( ii < iterations ); ++ii ) {
+         std::swap( frontier, next );
+         DIP_STACK_TRACE_THIS( iterConnectivity = GetAbsBinaryConnectivity( nDims, connectivity, ii ));
+         neighbors = GetLineNeighbors( inMask.Sizes(), iterConnectivity );
+         DIP_STACK_TRACE_THIS( DilationErosionStep( frontier, next, neighbors, true, false, &inMask ));
+      }
+   }
+   out = std::move( current );
+}
+
+void CountNeighbors(
+      PackedBinaryImage const& in,
+      Image& out,
+      dip::uint connectivity,
+      dip::String const& s_mode,
+      dip::String const& s_edgeCondition
+) {
+   DIP_THROW_IF( in.IsEmpty(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( connectivity > in.Dimensionality(), E::ILLEGAL_CONNECTIVITY );
+   bool all;
+   bool edgeCondition;
+   DIP_START_STACK_TRACE
+      all = BooleanFromString( s_mode, S::ALL, S::FOREGROUND );
+      edgeCondition = BooleanFromString( s_edgeCondition, S::OBJECT, S::BACKGROUND );
+   DIP_END_STACK_TRACE
+   std::vector< LineNeighbor > neighbors = GetLineNeighbors( in.Sizes(), connectivity );
+   // The counts are accumulated in bit planes, `counts[ jj ]` holds bit `jj` of the count for 64 pixels
+   constexpr dip::uint maxPlanes = 8; // The output is 8-bit
+   dip::uint nPlanes = 1;
+   while(( nPlanes < maxPlanes ) && (( dip::uint( 1 ) << nPlanes ) <= neighbors.size() + 1 )) {
+      ++nPlanes;
+   }
+   DIP_STACK_TRACE_THIS( out.ReForge( in.Sizes(), 1, DT_UINT8 ));
+   dip::sint stride = out.Stride( 0 );
+   dip::uint length = in.Sizes()[ 0 ];
+   dip::uint nWords = in.WordsPerLine();
+   Word lastBit = LastWordMask( length );
+   lastBit &= ~( lastBit >> 1 );
+   // Pointers to the neighbor lines, one set per thread
+   std::vector< Word const* > buffer( GetNumberOfThreads() * neighbors.size() );
+   ParallelForEachLine( in.Sizes(), in.NumberOfLines(), in.NumberOfLines() * nWords * neighbors.size(),
+                        [ & ]( dip::uint line, UnsignedArray const& coords, dip::uint thread ) {
+      Word const** src = buffer.data() + thread * neighbors.size();
+      for( dip::uint jj = 0; jj < neighbors.size(); ++jj ) {
+         src[ jj ] = NeighborLine( in, line, coords, neighbors[ jj ] );
+      }
+      UnsignedArray pos( in.Dimensionality(), 0 );
+      std::copy( coords.begin(), coords.end(), pos.begin() + 1 );
+      uint8* dst = static_cast< uint8* >( out.Pointer( pos ));
+      Word const* self = in.Line( line );
+      for( dip::uint k = 0; k < nWords; ++k ) {
+         std::array< Word, maxPlanes > counts{};
+         counts[ 0 ] = self[ k ];
+         for( dip::uint jj = 0; jj < neighbors.size(); ++jj ) {
+            // Add one bit to the count for each set bit in `carry`
+            Word carry = ShiftedWord( src[ jj ], k, nWords, neighbors[ jj ].dx, lastBit, edgeCondition );
+            for( dip::uint plane = 0; ( plane < nPlanes ) && carry; ++plane ) {
+               Word sum = counts[ plane ] ^ carry;
+               carry &= counts[ plane ];
+               counts[ plane ] = sum;
+            }
+         }
+         Word active = all ? allOnes : self[ k ];
+         dip::uint n = std::min( bitsPerWord, length - k * bitsPerWord );
+         for( dip::uint bit = 0; bit < n; ++bit, dst += stride ) {
+            uint8 count = 0;
+            if(( active >> bit ) & 1u ) {
+               for( dip::uint plane = 0; plane < nPlanes; ++plane ) {
+                  count = static_cast< uint8 >( count | ((( counts[ plane ] >> bit ) & 1u ) << plane ));
+               }
+            }
+            *dst = count;
+         }
+      }
+   } );
+}
+
+} // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/binary.h"
+#include "diplib/generation.h"
+#include "diplib/statistics.h"
+#include "diplib/testing.h"
+#include "diplib/random.h"
+
+namespace {
+
+dip::Image RandomBinaryImage( dip::UnsignedArray const& sizes, dip::dfloat threshold, dip::Random& random ) {
+   dip::Image img( sizes, 1, dip::DT_SFLOAT );
+   img.Fill( 0 );
+   dip::UniformNoise( img, img, random, 0, 1 );
+   return img > threshold;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::PackedBinaryImage") {
+   dip::Random random( 0 );
+   dip::ExecutionContext context;
+   context.maxThreads = 4;
+   context.threadingThreshold = 1;
+   dip::ScopedExecutionContext scope( context );
+   for( auto const& sizes : { dip::UnsignedArray{ 200 }, dip::UnsignedArray{ 150, 37 }, dip::UnsignedArray{ 70, 9, 8 }, dip::UnsignedArray{ 64, 20 } } ) {
+      dip::Image img = RandomBinaryImage( sizes, 0.6, random );
+      dip::PackedBinaryImage packed( img );
+      DOCTEST_CHECK( packed.Count() == dip::Count( img ));
+      DOCTEST_CHECK( dip::testing::CompareImages( packed.Unpack(), img ));
+      dip::sint nDims = static_cast< dip::sint >( sizes.size() );
+      dip::PackedBinaryImage result;
+      dip::Image expected;
+      // Dilation and erosion
+      bool sameDilation = true;
+      bool sameErosion = true;
+      for( dip::sint connectivity = nDims >= 2 ? -2 : 1; connectivity <= nDims; ++connectivity ) {
+         for( auto edge : { dip::S::BACKGROUND, dip::S::OBJECT } ) {
+            for( dip::uint iterations : { 1u, 3u } ) {
+               dip::BinaryDilation( packed, result, connectivity, iterations, edge );
+               dip::BinaryDilation( img, expected, connectivity, iterations, edge );
+               sameDilation &= dip::testing::CompareImages( result.Unpack(), expected );
+               dip::BinaryErosion( packed, result, connectivity, iterations, edge );
+               dip::BinaryErosion( img, expected, connectivity, iterations, edge );
+               sameErosion &= dip::testing::CompareImages( result.Unpack(), expected );
+            }
+         }
+      }
+      DOCTEST_CHECK( sameDilation );
+      DOCTEST_CHECK( sameErosion );
+      // Propagation
+      dip::Image mask = RandomBinaryImage( sizes, 0.3, random );
+      dip::Image seed = RandomBinaryImage( sizes, 0.995, random );
+      dip::PackedBinaryImage packedMask( mask );
+      dip::PackedBinaryImage packedSeed( seed );
+      bool samePropagation = true;
+      for( dip::sint connectivity = nDims >= 2 ? -1 : 1; connectivity <= nDims; ++connectivity ) {
+         for( auto edge : { dip::S::BACKGROUND, dip::S::OBJECT } ) {
+            for( dip::uint iterations : { 0u, 1u, 4u } ) {
+               dip::BinaryPropagation( packedSeed, packedMask, result, connectivity, iterations, edge );
+               dip::BinaryPropagation( seed, mask, expected, connectivity, iterations, edge );
+               samePropagation &= dip::testing::CompareImages( result.Unpack(), expected );
+               dip::BinaryPropagation( {}, packedMask, result, connectivity, iterations, edge );
+               dip::BinaryPropagation( {}, mask, expected, connectivity, iterations, edge );
+               samePropagation &= dip::testing::CompareImages( result.Unpack(), expected );
+            }
+         }
+      }
+      DOCTEST_CHECK( samePropagation );
+      // Counting neighbors
+      bool sameCount = true;
+      for( dip::uint connectivity = 0; connectivity <= sizes.size(); ++connectivity ) {
+         for( auto mode : { dip::S::FOREGROUND, dip::S::ALL } ) {
+            for( auto edge : { dip::S::BACKGROUND, dip::S::OBJECT } ) {
+               dip::Image count = dip::CountNeighbors( img, connectivity, mode, edge );
+               dip::CountNeighbors( packed, expected, connectivity, mode, edge );
+               sameCount &= dip::testing::CompareImages( count, expected );
+            }
+         }
+      }
+      DOCTEST_CHECK( sameCount );
+   }
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -18,14 +18,13 @@
  * limitations under the License.
  */
 
-#include <queue>
-
 #include "diplib.h"
 #include "diplib/distance.h"
 #include "diplib/statistics.h"
 #include "diplib/generation.h"
 #include "diplib/iterators.h"
 #include "diplib/overload.h"
+#include "../morphology/priority_queues.h"
 
 namespace dip {
 
@@ -48,15 +47,6 @@ inline void Reset( uint8& value, uint8 bit ) {
    value &= static_cast< uint8 >( ~bit );
 }
 
-struct Qitem {
-   dip::sint offset;
-   sfloat value;
-};
-
-bool ShouldBeOutputLater( Qitem const& a, Qitem const& b ) {
-   return a.value > b.value;
-}
-
 inline dip::uint FindDim( IntegerArray const& coords ) { // coords contains one non-zero element
    dip::uint ii = 0;
    while(( ii < coords.size() ) && ( coords[ ii ] == 0 )) {
@@ -65,7 +55,8 @@ inline dip::uint FindDim( IntegerArray const& coords ) { // coords contains one
    return ii;
 }
 
-using PriorityQueue = std::priority_queue< Qitem, std::vector< Qitem >, decltype( &ShouldBeOutputLater ) >;
+// Distances pushed are never smaller than the distance of the pixel being processed, so we can use a radix heap
+using PriorityQueue = RadixHeapPriorityQueue< sfloat >;
 
 PriorityQueue CreateAndInitializePriorityQueue(
       Image const& im_gdt,
@@ -79,7 +70,7 @@ PriorityQueue CreateAndInitializePriorityQueue(
    UnsignedArray const& sizes = im_gdt.Sizes();
 
    // Create priority queue
-   PriorityQueue Q( ShouldBeOutputLater );
+   PriorityQueue Q( true );
 
    // Put all background pixels that have a foreground neighbor in the queue
    ImageIterator< sfloat > it( im_gdt );
@@ -103,7 +94,7 @@ PriorityQueue CreateAndInitializePriorityQueue(
             }
             dip::sint neigh = offset + *oit;
             if(( gdt[ neigh ] != 0 ) && !IsSet( flags[ neigh ], MASKED )) {
-               Q.push( { offset, 0 } );
+               Q.Push( 0, offset );
                Reset( flags[ offset ], FINISHED ); // reset FINISHED flag, so it'll be processed
                //Set( flags[ offset ], INQUEUE );
                break;
@@ -114,7 +105,7 @@ PriorityQueue CreateAndInitializePriorityQueue(
          for( auto o : neighborOffsets ) {
             dip::sint neigh = offset + o;
             if(( gdt[ neigh ] != 0 ) && !IsSet( flags[ neigh ], MASKED )) {
-               Q.push( { offset, 0 } );
+               Q.Push( 0, offset );
                Reset( flags[ offset ], FINISHED ); // reset FINISHED flag, so it'll be processed
                //Set( flags[ offset ], INQUEUE );
                break;
@@ -154,10 +145,9 @@ void FastMarchingAlgorithm(
    // Compute distances
    FloatArray nValues( sizes.size() );
    FloatArray dist( sizes.size() );
-   while( !Q.empty() ) {
+   while( !Q.Empty() ) {
       // Get next pixel to expand distances from
-      dip::sint offset = Q.top().offset;
-      Q.pop();
+      dip::sint offset = Q.Pop();
       if( IsSet( flags[ offset ], FINISHED )) { // this can happen because we push updated elements anew, rather than update them in the queue
          continue;
       }
@@ -244,7 +234,7 @@ void FastMarchingAlgorithm(
          // If we could update stuff that's in the queue, we'd check the INQUEUE flag to see if it's in the queue or not.
          if( value < gdt[ neigh ] ) {
             gdt[ neigh ] = static_cast< sfloat >( value );
-            Q.push( { neigh, static_cast< sfloat >( value ) } );
+            Q.Push( static_cast< sfloat >( value ), neigh );
             //Set( flags[ offset ], INQUEUE );
          }
       }
@@ -272,10 +262,9 @@ void ChamferMetricAlgorithm(
    PriorityQueue Q = CreateAndInitializePriorityQueue( im_gdt, im_flags, neighborhood, neighborOffsets, coordComputer );
 
    // Compute distances
-   while( !Q.empty() ) {
+   while( !Q.Empty() ) {
       // Get next pixel to expand distances from
-      dip::sint offset = Q.top().offset;
-      Q.pop();
+      dip::sint offset = Q.Pop();
       if( IsSet( flags[ offset ], FINISHED )) {
          continue;
       }
@@ -303,7 +292,7 @@ void ChamferMetricAlgorithm(
             if( pdt ) {
                pdt[ neigh ] = pdt[ offset ] + static_cast< sfloat >( *nit );
             }
-            Q.push( { neigh, value } );
+            Q.Push( value, neigh );
          }
       }
    }
@@ -20,6 +20,7 @@
 
 #include <chrono> // std::chrono_literals::
 #include <thread> // std::this_thread::
+#include <unordered_map>
 #include "diplib.h"
 #include "diplib/histogram.h"
 #include "diplib/statistics.h"
@@ -136,24 +137,135 @@ void Histogram::Configuration::Complete( Measurement::IteratorFeature const& fea
 
 namespace {
 
+// Each thread accumulates into its own private bins, which are summed in `Reduce()`. If there are many more bins
+// than pixels per thread, the private bins are stored sparsely (hashed) so that we don't need to zero and add up
+// large, mostly empty arrays. Thread 0 always writes directly into the output histogram.
 class HistogramBaseLineFilter : public Framework::ScanLineFilter {
    public:
-      HistogramBaseLineFilter( Image& image ) : image_( image ) {}
+      HistogramBaseLineFilter( Image& image, dip::uint nPixels ) : image_( image ), nPixels_( nPixels ) {
+         // `image_` is forged by the first thread that gets to it, other threads need its strides before that.
+         strides_.resize( image_.Dimensionality() );
+         dip::sint stride = 1;
+         for( dip::uint ii = 0; ii < strides_.size(); ++ii ) {
+            strides_[ ii ] = stride;
+            stride *= static_cast< dip::sint >( image_.Size( ii ));
+         }
+      }
       virtual void SetNumberOfThreads( dip::uint threads ) override {
-         for( dip::uint ii = 1; ii < threads; ++ii ) {
-            imageArray_.emplace_back( image_ );       // makes a copy; image_ is not yet forged, so data is not shared.
+         if( threads <= 1 ) {
+            return;
+         }
+         // A dense private histogram costs two operations per bin (zeroing and merging), a sparse one costs a hash
+         // table update per pixel. Go sparse if the private histogram would be mostly empty.
+         sparse_ = image_.NumberOfPixels() > nPixels_ / threads;
+         if( sparse_ ) {
+            sparseArray_.resize( threads - 1 );
+         } else {
+            for( dip::uint ii = 1; ii < threads; ++ii ) {
+               imageArray_.emplace_back( image_ );    // makes a copy; image_ is not yet forged, so data is not shared.
+            }
+            // We don't forge the images here, the Filter() function should do that so each thread allocates its own
+            // data segment. This ensures there's no false sharing.
          }
-         // We don't forge the images here, the Filter() function should do that so each thread allocates its own
-         // data segment. This ensures there's no false sharing.
+      }
+      // Turn off multithreading if setting up and merging the per-thread bins costs more than we save by scanning
+      // in parallel. Each private histogram costs two operations per bin, or per pixel if it is sparse.
+      Framework::ScanOptions ScanOptions( dip::uint operationsPerPixel ) const {
+         dip::uint nThreads = GetNumberOfThreads();
+         if( nThreads > 1 ) {
+            dip::uint parallelOperations = nPixels_ * operationsPerPixel;
+            dip::uint sequentialOperations = ( nThreads - 1 ) * ( std::min( image_.NumberOfPixels(), nPixels_ / nThreads ) * 2 + 10000 );
+            if( parallelOperations / nThreads + sequentialOperations + GetThreadingThreshold() > parallelOperations ) {
+               return Framework::ScanOption::NoMultiThreading;
+            }
+         }
+         return {};
       }
       void Reduce() {
-         for( auto const& img : imageArray_ ) {
-            image_ += img;
+         if( !image_.IsForged() ) {
+            image_.Forge();
+            image_.Fill( 0 );
+         }
+         // Note: `image_` strides are always normal.
+         CountType* data = static_cast< CountType* >( image_.Origin() );
+         if( sparse_ ) {
+            // The hash tables together hold at most one entry per pixel, adding them up is cheap compared to the scan
+            for( auto const& bins : sparseArray_ ) {
+               for( auto const& bin : bins ) {
+                  data[ bin.first ] += bin.second;
+               }
+            }
+         } else {
+            std::vector< CountType const* > partial;
+            for( auto const& img : imageArray_ ) {
+               if( img.IsForged() ) {
+                  partial.push_back( static_cast< CountType const* >( img.Origin() ));
+               }
+            }
+            if( partial.empty() ) {
+               return;
+            }
+            // Each thread sums a contiguous range of bins over all partial histograms
+            dip::uint nBins = image_.NumberOfPixels();
+            dip::uint nThreads = GetOptimalNumberOfThreads( nBins * partial.size(), std::min( partial.size() + 1, GetNumberOfThreads() ));
+            dip::uint blockSize = div_ceil( nBins, nThreads );
+            DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+               dip::uint first = thread * blockSize;
+               dip::uint last = std::min( first + blockSize, nBins );
+               for( CountType const* src : partial ) {
+                  for( dip::uint ii = first; ii < last; ++ii ) {
+                     data[ ii ] += src[ ii ];
+                  }
+               }
+            } ));
          }
       }
    protected:
+      using SparseBins = std::unordered_map< dip::sint, CountType >;
+
+      // Increments bins in the output histogram or a thread's dense private histogram
+      struct DenseAccumulator {
+         CountType* data;
+         void Increment( dip::sint offset ) { ++data[ offset ]; }
+      };
+      // Increments bins in a thread's sparse private histogram
+      struct SparseAccumulator {
+         SparseBins& bins;
+         void Increment( dip::sint offset ) { ++bins[ offset ]; }
+      };
+
+      // Calls `func` with the accumulator for the given thread
+      template< typename F >
+      void WithAccumulator( dip::uint thread, F const& func ) {
+         if( sparse_ && ( thread > 0 )) {
+            func( SparseAccumulator{ sparseArray_[ thread - 1 ] } );
+            return;
+         }
+         Image& image = thread == 0 ? image_ : imageArray_[ thread - 1 ];
+         if( !image.IsForged() ) {
+            image.Forge();
+            image.Fill( 0 );
+//#if defined(_OPENMP)
+            // For some reason, MATLAB crashes the second time that `mdhistogram` is called,
+            // when using multi-threading. This tiny sleep prevented the crash in the past.
+            // A `std::cout <<` call also prevented the crash. However, MATLAB is crashing again.
+            // Now we are simply never calling this function multi-threaded in DIPimage. Keeping
+            // this hack here in comments for future reference.
+            // Some people say that these crashes are an issue of compatibility between OpenMP
+            // libraries (MATLAB links against Intel's they say).
+            //using namespace std::chrono_literals;
+            //std::this_thread::sleep_for(10ns);
+//#endif
+         }
+         func( DenseAccumulator{ static_cast< CountType* >( image.Origin() ) } );
+      }
+
       Image& image_;
+      IntegerArray strides_; // normal strides of `image_`
+      dip::uint nPixels_;
+      bool sparse_ = false;
       ImageArray imageArray_;
+      std::vector< SparseBins > sparseArray_;
 };
 
 template< typename TPI >
@@ -161,16 +273,18 @@ class ScalarImageHistogramLineFilter : public HistogramBaseLineFilter {
    public:
       virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override { return 6; }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
+         WithAccumulator( params.thread, [ & ]( auto accumulator ) { Accumulate( params, accumulator ); } );
+      }
+      ScalarImageHistogramLineFilter( Image& image, dip::uint nPixels, Histogram::Configuration const& configuration ) :
+            HistogramBaseLineFilter( image, nPixels ), configuration_( configuration ) {}
+   private:
+      Histogram::Configuration const& configuration_;
+
+      template< typename Accumulator >
+      void Accumulate( Framework::ScanLineFilterParameters const& params, Accumulator data ) {
          TPI const* in = static_cast< TPI const* >( params.inBuffer[ 0 ].buffer );
          auto bufferLength = params.bufferLength;
          auto inStride = params.inBuffer[ 0 ].stride;
-         Image& image = params.thread == 0 ? image_ : imageArray_[ params.thread - 1 ];
-         if( !image.IsForged() ) {
-            image.Forge();
-            image.Fill( 0 );
-         }
-         CountType* data = static_cast< CountType* >( image.Origin() );
-         // Note: `image_` strides are always normal.
          if( params.inBuffer.size() > 1 ) {
             // If there's two input buffers, we have a mask image.
             bin const* mask = static_cast< bin const* >( params.inBuffer[ 1 ].buffer );
@@ -178,7 +292,7 @@ class ScalarImageHistogramLineFilter : public HistogramBaseLineFilter {
             if( configuration_.excludeOutOfBoundValues ) {
                for( dip::uint ii = 0; ii < bufferLength; ++ii ) {
                   if( *mask && ( static_cast< dfloat >( *in ) >= configuration_.lowerBound ) && ( static_cast< dfloat >( *in ) < configuration_.upperBound )) {
-                     ++data[ configuration_.FindBin( static_cast< dfloat >( *in )) ];
+                     data.Increment( static_cast< dip::sint >( configuration_.FindBin( static_cast< dfloat >( *in ))));
                   }
                   in += inStride;
                   mask += maskStride;
@@ -186,7 +300,7 @@ class ScalarImageHistogramLineFilter : public HistogramBaseLineFilter {
             } else {
                for( dip::uint ii = 0; ii < bufferLength; ++ii ) {
                   if( *mask ) {
-                     ++data[ configuration_.FindBin( static_cast< dfloat >( *in )) ];
+                     data.Increment( static_cast< dip::sint >( configuration_.FindBin( static_cast< dfloat >( *in ))));
                   }
                   in += inStride;
                   mask += maskStride;
@@ -197,22 +311,18 @@ class ScalarImageHistogramLineFilter : public HistogramBaseLineFilter {
             if( configuration_.excludeOutOfBoundValues ) {
                for( dip::uint ii = 0; ii < bufferLength; ++ii ) {
                   if(( static_cast< dfloat >( *in ) >= configuration_.lowerBound ) && ( static_cast< dfloat >( *in ) < configuration_.upperBound )) {
-                     ++data[ configuration_.FindBin( static_cast< dfloat >( *in )) ];
+                     data.Increment( static_cast< dip::sint >( configuration_.FindBin( static_cast< dfloat >( *in ))));
                   }
                   in += inStride;
                }
             } else {
                for( dip::uint ii = 0; ii < bufferLength; ++ii ) {
-                  ++data[ configuration_.FindBin( static_cast< dfloat >( *in )) ];
+                  data.Increment( static_cast< dip::sint >( configuration_.FindBin( static_cast< dfloat >( *in ))));
                   in += inStride;
                }
             }
          }
       }
-      ScalarImageHistogramLineFilter( Image& image, Histogram::Configuration const& configuration ) :
-            HistogramBaseLineFilter( image ), configuration_( configuration ) {}
-   private:
-      Histogram::Configuration const& configuration_;
 };
 
 template< typename TPI >
@@ -222,6 +332,16 @@ class JointImageHistogramLineFilter : public HistogramBaseLineFilter {
          return ( tensorInput_ ? tensorElements : 2 ) * 6;
       }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
+         WithAccumulator( params.thread, [ & ]( auto accumulator ) { Accumulate( params, accumulator ); } );
+      }
+      JointImageHistogramLineFilter( Image& image, dip::uint nPixels, Histogram::ConfigurationArray const& configuration, bool tensorInput ) :
+            HistogramBaseLineFilter( image, nPixels ), configuration_( configuration ), tensorInput_( tensorInput ) {}
+   private:
+      Histogram::ConfigurationArray const& configuration_;
+      bool tensorInput_;
+
+      template< typename Accumulator >
+      void Accumulate( Framework::ScanLineFilterParameters const& params, Accumulator data ) {
          std::vector< TPI const* > in;
          std::vector< dip::sint > stride;
          dip::uint nDims;
@@ -245,23 +365,6 @@ class JointImageHistogramLineFilter : public HistogramBaseLineFilter {
             maskBuffer = 2;
          }
          auto bufferLength = params.bufferLength;
-         Image& image = params.thread == 0 ? image_ : imageArray_[ params.thread - 1 ];
-         if( !image.IsForged() ) {
-            image.Forge();
-            image.Fill( 0 );
-//#if defined(_OPENMP)
-            // For some reason, MATLAB crashes the second time that `mdhistogram` is called,
-            // when using multi-threading. This tiny sleep prevented the crash in the past.
-            // A `std::cout <<` call also prevented the crash. However, MATLAB is crashing again.
-            // Now we are simply never calling this function multi-threaded in DIPimage. Keeping
-            // this hack here in comments for future reference.
-            // Some people say that these crashes are an issue of compatibility between OpenMP
-            // libraries (MATLAB links against Intel's they say).
-            //using namespace std::chrono_literals;
-            //std::this_thread::sleep_for(10ns);
-//#endif
-         }
-         CountType* data = static_cast< CountType* >( image.Origin() );
          if( params.inBuffer.size() > maskBuffer ) {
             // We have a mask image.
             bin const* mask = static_cast< bin const* >( params.inBuffer[ maskBuffer ].buffer );
@@ -278,9 +381,9 @@ class JointImageHistogramLineFilter : public HistogramBaseLineFilter {
                   if( include ) {
                      dip::sint offset = 0;
                      for( dip::uint jj = 0; jj < nDims; ++jj ) {
-                        offset += image_.Stride( jj ) * configuration_[ jj ].FindBin( static_cast< dfloat >( *( in[ jj ] )));
+                        offset += strides_[ jj ] * configuration_[ jj ].FindBin( static_cast< dfloat >( *( in[ jj ] )));
                      }
-                     ++data[ offset ];
+                     data.Increment( offset );
                   }
                }
                for( dip::uint jj = 0; jj < nDims; ++jj ) {
@@ -301,9 +404,9 @@ class JointImageHistogramLineFilter : public HistogramBaseLineFilter {
                if( include ) {
                   dip::sint offset = 0;
                   for( dip::uint jj = 0; jj < nDims; ++jj ) {
-                     offset += image_.Stride( jj ) * configuration_[ jj ].FindBin( static_cast< dfloat >( *( in[ jj ] )));
+                     offset += strides_[ jj ] * configuration_[ jj ].FindBin( static_cast< dfloat >( *( in[ jj ] )));
                   }
-                  ++data[ offset ];
+                  data.Increment( offset );
                }
                for( dip::uint jj = 0; jj < nDims; ++jj ) {
                   in[ jj ] += stride[ jj ];
@@ -311,11 +414,6 @@ class JointImageHistogramLineFilter : public HistogramBaseLineFilter {
             }
          }
       }
-      JointImageHistogramLineFilter( Image& image, Histogram::ConfigurationArray const& configuration, bool tensorInput ) :
-            HistogramBaseLineFilter( image ), configuration_( configuration ), tensorInput_( tensorInput ) {}
-   private:
-      Histogram::ConfigurationArray const& configuration_;
-      bool tensorInput_;
 };
 
 } // namespace
@@ -327,16 +425,8 @@ void Histogram::ScalarImageHistogram( Image const& input, Image const& mask, His
    data_.SetSizes( { configuration.nBins } );
    data_.SetDataType( DT_COUNT );
    std::unique_ptr< HistogramBaseLineFilter >scanLineFilter;
-   DIP_OVL_NEW_REAL( scanLineFilter, ScalarImageHistogramLineFilter, ( data_, configuration ), input.DataType() );
-   Framework::ScanOptions opts;
-   if( GetNumberOfThreads() > 1 ) {
-      dip::uint parallelOperations = input.NumberOfPixels() * 6;
-      dip::uint sequentialOperations = ( GetNumberOfThreads() - 1 ) * ( data_.NumberOfPixels() * 2 + 10000 );
-      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + threadingThreshold > parallelOperations ) {
-         opts = Framework::ScanOption::NoMultiThreading; // Turn off multithreading if we'll do a lot of work to reduce.
-      }
-   }
-   DIP_STACK_TRACE_THIS( Framework::ScanSingleInput( input, mask, input.DataType(), *scanLineFilter, opts ));
+   DIP_OVL_NEW_REAL( scanLineFilter, ScalarImageHistogramLineFilter, ( data_, input.NumberOfPixels(), configuration ), input.DataType() );
+   DIP_STACK_TRACE_THIS( Framework::ScanSingleInput( input, mask, input.DataType(), *scanLineFilter, scanLineFilter->ScanOptions( 6 )));
    scanLineFilter->Reduce();
 }
 
@@ -354,16 +444,8 @@ void Histogram::TensorImageHistogram( Image const& input, Image const& mask, His
    data_.SetSizes( sizes );
    data_.SetDataType( DT_COUNT );
    std::unique_ptr< HistogramBaseLineFilter >scanLineFilter;
-   DIP_OVL_NEW_REAL( scanLineFilter, JointImageHistogramLineFilter, ( data_, configuration, true ), input.DataType() );
-   Framework::ScanOptions opts;
-   if( GetNumberOfThreads() > 1 ) {
-      dip::uint parallelOperations = input.NumberOfPixels() * ndims * 6;
-      dip::uint sequentialOperations = ( GetNumberOfThreads() - 1 ) * ( data_.NumberOfPixels() * 2 + 10000 );
-      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + threadingThreshold > parallelOperations ) {
-         opts = Framework::ScanOption::NoMultiThreading; // Turn off multithreading if we'll do a lot of work to reduce.
-      }
-   }
-   DIP_STACK_TRACE_THIS( Framework::ScanSingleInput( input, mask, input.DataType(), *scanLineFilter, opts ));
+   DIP_OVL_NEW_REAL( scanLineFilter, JointImageHistogramLineFilter, ( data_, input.NumberOfPixels(), configuration, true ), input.DataType() );
+   DIP_STACK_TRACE_THIS( Framework::ScanSingleInput( input, mask, input.DataType(), *scanLineFilter, scanLineFilter->ScanOptions( ndims * 6 )));
    scanLineFilter->Reduce();
 }
 
@@ -379,7 +461,7 @@ void Histogram::JointImageHistogram( Image const& input1, Image const& input2, I
    data_.SetDataType( DT_COUNT );
    DataType dtype = DataType::SuggestDyadicOperation( input1.DataType(), input2.DataType() );
    std::unique_ptr< HistogramBaseLineFilter >scanLineFilter;
-   DIP_OVL_NEW_REAL( scanLineFilter, JointImageHistogramLineFilter, ( data_, configuration, false ), dtype );
+   DIP_OVL_NEW_REAL( scanLineFilter, JointImageHistogramLineFilter, ( data_, input1.NumberOfPixels(), configuration, false ), dtype );
    ImageConstRefArray inar{ input1, input2 };
    DataTypeArray inBufT{ dtype, dtype };
    Image mask;
@@ -394,15 +476,7 @@ void Histogram::JointImageHistogram( Image const& input1, Image const& input2, I
       inBufT.push_back( mask.DataType() );
    }
    ImageRefArray outar{};
-   Framework::ScanOptions opts;
-   if( GetNumberOfThreads() > 1 ) {
-      dip::uint parallelOperations = input1.NumberOfPixels() * 2 * 6;
-      dip::uint sequentialOperations = ( GetNumberOfThreads() - 1 ) * ( data_.NumberOfPixels() * 2 + 10000 );
-      if( parallelOperations / GetNumberOfThreads() + sequentialOperations + threadingThreshold > parallelOperations ) {
-         opts = Framework::ScanOption::NoMultiThreading; // Turn off multithreading if we'll do a lot of work to reduce.
-      }
-   }
-   DIP_STACK_TRACE_THIS( Framework::Scan( inar, outar, inBufT, {}, {}, {}, *scanLineFilter, opts ));
+   DIP_STACK_TRACE_THIS( Framework::Scan( inar, outar, inBufT, {}, {}, {}, *scanLineFilter, scanLineFilter->ScanOptions( 2 * 6 )));
    scanLineFilter->Reduce();
 }
 
@@ -594,7 +668,9 @@ Histogram& Histogram::Smooth( FloatArray sigma ) {
 
 #ifdef DIP_CONFIG_ENABLE_DOCTEST
 #include "doctest.h"
+#include "diplib/generation.h"
 #include "diplib/random.h"
+#include "diplib/testing.h"
 
 DOCTEST_TEST_CASE( "[DIPlib] testing dip::Histogram" ) {
    dip::Image zero( {}, 1, dip::DT_SFLOAT );
@@ -715,4 +791,52 @@ DOCTEST_TEST_CASE( "[DIPlib] testing dip::Histogram" ) {
    DOCTEST_CHECK( tensorCov[ 5 ] == 0.0 ); // covariance 2nd & 3rd
 }
 
+DOCTEST_TEST_CASE( "[DIPlib] testing dip::Histogram multithreading" ) {
+   // The per-thread histograms, dense or sparse, must add up to the same result as a single-threaded computation
+   dip::Random random( 0 );
+   dip::Image img( { 300, 200 }, 3, dip::DT_UINT16 );
+   img.Fill( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 65535.0 );
+   dip::Image mask = img[ 0 ] > 20000;
+   dip::Histogram::Configuration fine( 0.0, 65536.0, dip::uint( 65536 )); // more bins than pixels: sparse
+   dip::Histogram::Configuration medium( 0.0, 65536.0, dip::uint( 256 )); // more bins than pixels in 2D: sparse
+   dip::Histogram::Configuration small( 0.0, 65536.0, dip::uint( 64 ));   // more bins than pixels in 3D: sparse
+   dip::Histogram::Configuration coarse( 0.0, 65536.0, dip::uint( 16 ));  // few bins: dense
+   auto compute = [ & ]() {
+      return std::vector< dip::Histogram >{
+            dip::Histogram( img[ 0 ], {}, fine ),
+            dip::Histogram( img[ 0 ], mask, coarse ),
+            dip::Histogram( img[ 0 ], img[ 1 ], {}, { medium, medium } ),
+            dip::Histogram( img[ 0 ], img[ 1 ], mask, { coarse, coarse } ),
+            dip::Histogram( img, {}, { coarse, coarse, coarse } ),
+            dip::Histogram( img, mask, { small, small, small } )
+      };
+   };
+   dip::testing::FourThreads fourThreads;
+   auto executor = std::make_shared< dip::testing::RecordingExecutor >();
+   dip::SetExecutor( executor );
+   dip::SetNumberOfThreads( 1 );
+   auto ref = compute();
+   dip::SetNumberOfThreads( 4 );
+   std::vector< dip::Histogram > out;
+   {
+      dip::ExecutionContext context;
+      context.threadingThreshold = 1; // go parallel even for these small images
+      dip::ScopedExecutionContext scope( context );
+      out = compute();
+   }
+   for( dip::uint ii = 0; ii < ref.size(); ++ii ) {
+      DOCTEST_CHECK( out[ ii ].Count() == ref[ ii ].Count() );
+      DOCTEST_CHECK( dip::Count( out[ ii ].GetImage() != ref[ ii ].GetImage() ) == 0 );
+   }
+#ifdef _OPENMP
+   DOCTEST_CHECK( executor->maxTasks > 1 );
+#endif
+   // A small image with many bins is not worth the per-thread histograms
+   executor->maxTasks = 0;
+   dip::Histogram tiny( img[ 0 ].At( dip::Range{ 0, 9 }, dip::Range{ 0, 9 } ), {}, fine );
+   DOCTEST_CHECK( tiny.Count() == 100 );
+   DOCTEST_CHECK( executor->maxTasks <= 1 );
+}
+
 #endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -0,0 +1,131 @@
+/*
+ * DIPlib 3.0
+ * This file defines a container for machine-specific calibrations that are loaded or measured on first use.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIP_CALIBRATION_H
+#define DIP_CALIBRATION_H
+
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+
+#include "diplib.h"
+
+namespace dip {
+namespace detail {
+
+// Returns true if the calling thread can use all threads: it is not running a `dip::ParallelRun` task, and is not
+// limited by the `dip::ExecutionContext` or `dip::SetNumberOfThreads`. Timings measured otherwise are meaningless.
+// Defined in multithreading.cpp.
+bool CanCalibrate();
+
+// Holds a calibration that is read often and set rarely. Reading doesn't take a lock: each value set is stored
+// as a new immutable snapshot. Old snapshots are kept until the `Calibration` object is destroyed (at program exit
+// for the function-local statics that use this class), so that a reader can keep using the one it got. Thus,
+// memory use grows by one `T` (a few dozen bytes) per call to `Set`, which is meant to be called a few times
+// per program, not in a loop.
+//
+// The first time the calibration is read, if the environment variable `envVar` names a file, that file is read.
+// If that fails, the calibration is measured and written to the file, but only if `CanCalibrate()`. Otherwise the
+// default values are used, and the next read tries again to measure, but doesn't read the file again. Reading,
+// writing and measuring are done by `Traits`:
+//    static bool Read( String const& filename, T& calibration );        // returns false on failure
+//    static bool Write( String const& filename, T const& calibration ); // returns false on failure
+//    static T Measure();
+// Reads from other threads while measuring (or recursive reads from `Measure`) see the default values.
+template< typename T, typename Traits >
+class Calibration {
+   public:
+      explicit Calibration( char const* envVar ) : envVar_( envVar ) {
+         snapshots_.emplace_back();
+         current_ = &snapshots_.back();
+      }
+
+      T const& Get() {
+         if( !initialized_.load( std::memory_order_acquire )) {
+            Initialize();
+         }
+         return *current_.load( std::memory_order_acquire );
+      }
+
+      // A calibration set explicitly takes precedence over the one in the file named by `envVar`.
+      void Set( T const& calibration ) {
+         std::lock_guard< std::mutex > lock( setMutex_ );
+         Store( calibration );
+      }
+
+   private:
+      char const* envVar_;
+      std::deque< T > snapshots_;
+      std::atomic< T const* > current_;
+      std::mutex setMutex_;
+      std::atomic< bool > initialized_{ false };
+      std::atomic< bool > initializing_{ false };
+      bool readFailed_ = false; // Only accessed by the thread that set `initializing_`
+
+      void Initialize() {
+         bool expected = false;
+         if( !initializing_.compare_exchange_strong( expected, true )) {
+            return; // Another thread, or this one further up the stack, is already doing this
+         }
+         try {
+            char const* filename = std::getenv( envVar_ );
+            if( !filename || ( filename[ 0 ] == '\0' )) {
+               initialized_.store( true, std::memory_order_release );
+            } else {
+               T calibration;
+               if( !readFailed_ ) {
+                  if( Traits::Read( filename, calibration )) {
+                     SetIfNotInitialized( calibration );
+                  } else {
+                     readFailed_ = true;
+                  }
+               }
+               if( readFailed_ && CanCalibrate() ) {
+                  calibration = Traits::Measure();
+                  SetIfNotInitialized( calibration );
+                  Traits::Write( filename, calibration ); // If we can't write the file, we still use the measured values
+               }
+            }
+         } catch( ... ) {
+            initializing_.store( false );
+            throw;
+         }
+         initializing_.store( false );
+      }
+
+      void SetIfNotInitialized( T const& calibration ) {
+         std::lock_guard< std::mutex > lock( setMutex_ );
+         if( !initialized_.load( std::memory_order_acquire )) {
+            Store( calibration );
+         }
+      }
+
+      // Must be called with `setMutex_` locked
+      void Store( T const& calibration ) {
+         snapshots_.push_back( calibration ); // doesn't invalidate references to the other elements
+         current_.store( &snapshots_.back(), std::memory_order_release );
+         initialized_.store( true, std::memory_order_release );
+      }
+};
+
+} // namespace detail
+} // namespace dip
+
+#endif // DIP_CALIBRATION_H
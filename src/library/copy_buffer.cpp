@@ -305,6 +305,19 @@ void CopyBuffer(
       tensorElements = 1;
       outTensorStride = 1;
    }
+   // Contiguous data without tensor reordering can use the SIMD kernels
+   if( lookUpTable.empty() && ( inStride != 0 )) {
+      dip::uint samples = 0;
+      if(( tensorElements == 1 ) && ( inStride == 1 ) && ( outStride == 1 )) {
+         samples = pixels;
+      } else if(( inTensorStride == 1 ) && ( outTensorStride == 1 ) &&
+                ( inStride == static_cast< dip::sint >( tensorElements )) && ( outStride == inStride )) {
+         samples = pixels * tensorElements;
+      }
+      if(( samples > 0 ) && CopyBufferContiguous( inBuffer, inType, outBuffer, outType, samples )) {
+         return;
+      }
+   }
    switch( inType ) {
       case dip::DT_BIN:
          CopyBufferFrom( static_cast< bin const* >( inBuffer ), inStride, inTensorStride, outBuffer, outType, outStride, outTensorStride, pixels, tensorElements, lookUpTable );
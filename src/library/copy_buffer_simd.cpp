@@ -0,0 +1,399 @@
+/*
+ * DIPlib 3.0
+ * This file contains SIMD implementations of the most common data type conversions in CopyBuffer.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <cstring>
+
+#include "diplib.h"
+#include "diplib/library/copy_buffer.h"
+
+#include "diplib/library/cpu_dispatch.h"
+
+// The kernels use GCC/Clang function attributes to compile for instruction sets that the rest of the
+// library is not compiled for. They are selected at run time depending on what the CPU supports.
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace dip {
+namespace detail {
+
+namespace {
+
+// Conversion of `n` contiguous samples
+using ConvertFunction = void ( * )( void const* in, void* out, dip::uint n );
+
+// Converts the remaining samples, identical to what `CopyBuffer` does
+template< typename inT, typename outT >
+void ConvertTail( inT const* in, outT* out, dip::uint n ) {
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      out[ ii ] = clamp_cast< outT >( in[ ii ] );
+   }
+}
+
+// The types we have kernels for
+enum class Conversion {
+   UINT8_SFLOAT,
+   UINT16_SFLOAT,
+   SINT16_SFLOAT,
+   SFLOAT_UINT8,
+   SFLOAT_UINT16,
+   SFLOAT_SINT16,
+   None
+};
+constexpr dip::uint nConversions = static_cast< dip::uint >( Conversion::None );
+
+Conversion FindConversion( DataType inType, DataType outType ) {
+   if( outType == DT_SFLOAT ) {
+      switch( inType ) {
+         case DT_UINT8: return Conversion::UINT8_SFLOAT;
+         case DT_UINT16: return Conversion::UINT16_SFLOAT;
+         case DT_SINT16: return Conversion::SINT16_SFLOAT;
+         default: return Conversion::None;
+      }
+   }
+   if( inType == DT_SFLOAT ) {
+      switch( outType ) {
+         case DT_UINT8: return Conversion::SFLOAT_UINT8;
+         case DT_UINT16: return Conversion::SFLOAT_UINT16;
+         case DT_SINT16: return Conversion::SFLOAT_SINT16;
+         default: return Conversion::None;
+      }
+   }
+   return Conversion::None;
+}
+
+using ConversionTable = std::array< ConvertFunction, nConversions >;
+
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+
+//
+// SSE4.1 kernels, 4 samples at the time
+//
+
+__attribute__(( target( "sse4.1" )))
+void Sse41_Uint8_Sfloat( void const* in, void* out, dip::uint n ) {
+   uint8 const* pin = static_cast< uint8 const* >( in );
+   sfloat* pout = static_cast< sfloat* >( out );
+   dip::uint ii = 0;
+   for( ; ii + 4 <= n; ii += 4 ) {
+      int32_t bytes;
+      std::memcpy( &bytes, pin + ii, 4 );
+      __m128i v = _mm_cvtepu8_epi32( _mm_cvtsi32_si128( bytes ));
+      _mm_storeu_ps( pout + ii, _mm_cvtepi32_ps( v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "sse4.1" )))
+void Sse41_Uint16_Sfloat( void const* in, void* out, dip::uint n ) {
+   uint16 const* pin = static_cast< uint16 const* >( in );
+   sfloat* pout = static_cast< sfloat* >( out );
+   dip::uint ii = 0;
+   for( ; ii + 4 <= n; ii += 4 ) {
+      __m128i v = _mm_cvtepu16_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( pin + ii )));
+      _mm_storeu_ps( pout + ii, _mm_cvtepi32_ps( v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "sse4.1" )))
+void Sse41_Sint16_Sfloat( void const* in, void* out, dip::uint n ) {
+   sint16 const* pin = static_cast< sint16 const* >( in );
+   sfloat* pout = static_cast< sfloat* >( out );
+   dip::uint ii = 0;
+   for( ; ii + 4 <= n; ii += 4 ) {
+      __m128i v = _mm_cvtepi16_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( pin + ii )));
+      _mm_storeu_ps( pout + ii, _mm_cvtepi32_ps( v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+// Clamps to [lower, upper] and truncates, like `clamp_cast`. NaN becomes `lower`.
+__attribute__(( target( "sse4.1" )))
+inline __m128i Sse41_ClampTruncate( __m128 v, __m128 lower, __m128 upper ) {
+   return _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( v, lower ), upper ));
+}
+
+__attribute__(( target( "sse4.1" )))
+void Sse41_Sfloat_Uint8( void const* in, void* out, dip::uint n ) {
+   sfloat const* pin = static_cast< sfloat const* >( in );
+   uint8* pout = static_cast< uint8* >( out );
+   __m128 lower = _mm_set1_ps( 0.0f );
+   __m128 upper = _mm_set1_ps( 255.0f );
+   dip::uint ii = 0;
+   for( ; ii + 4 <= n; ii += 4 ) {
+      __m128i v = Sse41_ClampTruncate( _mm_loadu_ps( pin + ii ), lower, upper );
+      v = _mm_packus_epi32( v, v );
+      v = _mm_packus_epi16( v, v );
+      int32_t bytes = _mm_cvtsi128_si32( v );
+      std::memcpy( pout + ii, &bytes, 4 );
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "sse4.1" )))
+void Sse41_Sfloat_Uint16( void const* in, void* out, dip::uint n ) {
+   sfloat const* pin = static_cast< sfloat const* >( in );
+   uint16* pout = static_cast< uint16* >( out );
+   __m128 lower = _mm_set1_ps( 0.0f );
+   __m128 upper = _mm_set1_ps( 65535.0f );
+   dip::uint ii = 0;
+   for( ; ii + 4 <= n; ii += 4 ) {
+      __m128i v = Sse41_ClampTruncate( _mm_loadu_ps( pin + ii ), lower, upper );
+      _mm_storel_epi64( reinterpret_cast< __m128i* >( pout + ii ), _mm_packus_epi32( v, v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "sse4.1" )))
+void Sse41_Sfloat_Sint16( void const* in, void* out, dip::uint n ) {
+   sfloat const* pin = static_cast< sfloat const* >( in );
+   sint16* pout = static_cast< sint16* >( out );
+   __m128 lower = _mm_set1_ps( -32768.0f );
+   __m128 upper = _mm_set1_ps( 32767.0f );
+   dip::uint ii = 0;
+   for( ; ii + 4 <= n; ii += 4 ) {
+      __m128i v = Sse41_ClampTruncate( _mm_loadu_ps( pin + ii ), lower, upper );
+      _mm_storel_epi64( reinterpret_cast< __m128i* >( pout + ii ), _mm_packs_epi32( v, v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+//
+// AVX2 kernels, 8 samples at the time
+//
+
+__attribute__(( target( "avx2" )))
+void Avx2_Uint8_Sfloat( void const* in, void* out, dip::uint n ) {
+   uint8 const* pin = static_cast< uint8 const* >( in );
+   sfloat* pout = static_cast< sfloat* >( out );
+   dip::uint ii = 0;
+   for( ; ii + 8 <= n; ii += 8 ) {
+      __m256i v = _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast< __m128i const* >( pin + ii )));
+      _mm256_storeu_ps( pout + ii, _mm256_cvtepi32_ps( v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "avx2" )))
+void Avx2_Uint16_Sfloat( void const* in, void* out, dip::uint n ) {
+   uint16 const* pin = static_cast< uint16 const* >( in );
+   sfloat* pout = static_cast< sfloat* >( out );
+   dip::uint ii = 0;
+   for( ; ii + 8 <= n; ii += 8 ) {
+      __m256i v = _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast< __m128i const* >( pin + ii )));
+      _mm256_storeu_ps( pout + ii, _mm256_cvtepi32_ps( v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "avx2" )))
+void Avx2_Sint16_Sfloat( void const* in, void* out, dip::uint n ) {
+   sint16 const* pin = static_cast< sint16 const* >( in );
+   sfloat* pout = static_cast< sfloat* >( out );
+   dip::uint ii = 0;
+   for( ; ii + 8 <= n; ii += 8 ) {
+      __m256i v = _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast< __m128i const* >( pin + ii )));
+      _mm256_storeu_ps( pout + ii, _mm256_cvtepi32_ps( v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+// Clamps to [lower, upper] and truncates, like `clamp_cast`, then packs the eight 32-bit values into eight
+// 16-bit values with saturation (which doesn't happen, as the values are already in range).
+__attribute__(( target( "avx2" )))
+inline __m128i Avx2_ClampTruncatePack( __m256 v, __m256 lower, __m256 upper, bool isSigned ) {
+   __m256i i = _mm256_cvttps_epi32( _mm256_min_ps( _mm256_max_ps( v, lower ), upper ));
+   __m128i lo = _mm256_castsi256_si128( i );
+   __m128i hi = _mm256_extracti128_si256( i, 1 );
+   return isSigned ? _mm_packs_epi32( lo, hi ) : _mm_packus_epi32( lo, hi );
+}
+
+__attribute__(( target( "avx2" )))
+void Avx2_Sfloat_Uint8( void const* in, void* out, dip::uint n ) {
+   sfloat const* pin = static_cast< sfloat const* >( in );
+   uint8* pout = static_cast< uint8* >( out );
+   __m256 lower = _mm256_set1_ps( 0.0f );
+   __m256 upper = _mm256_set1_ps( 255.0f );
+   dip::uint ii = 0;
+   for( ; ii + 8 <= n; ii += 8 ) {
+      __m128i v = Avx2_ClampTruncatePack( _mm256_loadu_ps( pin + ii ), lower, upper, false );
+      _mm_storel_epi64( reinterpret_cast< __m128i* >( pout + ii ), _mm_packus_epi16( v, v ));
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "avx2" )))
+void Avx2_Sfloat_Uint16( void const* in, void* out, dip::uint n ) {
+   sfloat const* pin = static_cast< sfloat const* >( in );
+   uint16* pout = static_cast< uint16* >( out );
+   __m256 lower = _mm256_set1_ps( 0.0f );
+   __m256 upper = _mm256_set1_ps( 65535.0f );
+   dip::uint ii = 0;
+   for( ; ii + 8 <= n; ii += 8 ) {
+      __m128i v = Avx2_ClampTruncatePack( _mm256_loadu_ps( pin + ii ), lower, upper, false );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pout + ii ), v );
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+__attribute__(( target( "avx2" )))
+void Avx2_Sfloat_Sint16( void const* in, void* out, dip::uint n ) {
+   sfloat const* pin = static_cast< sfloat const* >( in );
+   sint16* pout = static_cast< sint16* >( out );
+   __m256 lower = _mm256_set1_ps( -32768.0f );
+   __m256 upper = _mm256_set1_ps( 32767.0f );
+   dip::uint ii = 0;
+   for( ; ii + 8 <= n; ii += 8 ) {
+      __m128i v = Avx2_ClampTruncatePack( _mm256_loadu_ps( pin + ii ), lower, upper, true );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( pout + ii ), v );
+   }
+   ConvertTail( pin + ii, pout + ii, n - ii );
+}
+
+// Same order as `Conversion`
+constexpr ConversionTable sse41Kernels{{
+   Sse41_Uint8_Sfloat, Sse41_Uint16_Sfloat, Sse41_Sint16_Sfloat, Sse41_Sfloat_Uint8, Sse41_Sfloat_Uint16, Sse41_Sfloat_Sint16
+}};
+constexpr ConversionTable avx2Kernels{{
+   Avx2_Uint8_Sfloat, Avx2_Uint16_Sfloat, Avx2_Sint16_Sfloat, Avx2_Sfloat_Uint8, Avx2_Sfloat_Uint16, Avx2_Sfloat_Sint16
+}};
+
+// Picks the kernels for the instruction set selected by `GetIsaLevel()`
+ConversionTable const* Kernels() {
+   switch( GetIsaLevel() ) {
+      case IsaLevel::AVX512:
+      case IsaLevel::AVX2:
+         return &avx2Kernels;
+      case IsaLevel::SSE41:
+         return &sse41Kernels;
+      default:
+         return nullptr;
+   }
+}
+
+#else
+
+ConversionTable const* Kernels() {
+   return nullptr;
+}
+
+#endif // DIP_CONFIG_ENABLE_CPU_DISPATCH
+
+} // namespace
+
+bool CopyBufferContiguous(
+      void const* inBuffer,
+      DataType inType,
+      void* outBuffer,
+      DataType outType,
+      dip::uint samples
+) {
+   ConversionTable const* kernels = Kernels();
+   if( !kernels ) {
+      return false;
+   }
+   Conversion conversion = FindConversion( inType, outType );
+   if( conversion == Conversion::None ) {
+      return false;
+   }
+   ( *kernels )[ static_cast< dip::uint >( conversion ) ]( inBuffer, outBuffer, samples );
+   return true;
+}
+
+} // namespace detail
+} // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+
+namespace {
+
+template< typename inT, typename outT >
+bool TestConversion( std::vector< inT > const& input, dip::detail::ConversionTable const& kernels ) {
+   dip::DataType inType = dip::DataType( inT{} );
+   dip::DataType outType = dip::DataType( outT{} );
+   auto kernel = kernels[ static_cast< dip::uint >( dip::detail::FindConversion( inType, outType )) ];
+   bool correct = true;
+   // Test all lengths up to the input size, so that the tail is tested with all possible lengths
+   for( dip::uint n = 0; n <= input.size(); ++n ) {
+      std::vector< outT > output( n + 1, outT( 123 ));
+      kernel( input.data(), output.data(), n );
+      for( dip::uint ii = 0; ii < n; ++ii ) {
+         correct &= output[ ii ] == dip::clamp_cast< outT >( input[ ii ] );
+      }
+      correct &= output[ n ] == outT( 123 ); // Didn't write past the end
+   }
+   return correct;
+}
+
+void TestKernels( dip::detail::ConversionTable const& kernels ) {
+   std::vector< dip::sfloat > floats( 37 );
+   for( dip::uint ii = 0; ii < floats.size(); ++ii ) {
+      floats[ ii ] = ( static_cast< dip::sfloat >( ii ) - 10.0f ) * 1234.567f;
+   }
+   floats[ 3 ] = 254.9f;
+   floats[ 4 ] = 255.1f;
+   floats[ 5 ] = -0.5f;
+   floats[ 6 ] = std::numeric_limits< dip::sfloat >::infinity();
+   floats[ 7 ] = -std::numeric_limits< dip::sfloat >::infinity();
+   floats[ 8 ] = 65535.9f;
+   floats[ 9 ] = -32768.9f;
+   floats[ 10 ] = 32767.5f;
+   DOCTEST_CHECK( TestConversion< dip::sfloat, dip::uint8 >( floats, kernels ));
+   DOCTEST_CHECK( TestConversion< dip::sfloat, dip::uint16 >( floats, kernels ));
+   DOCTEST_CHECK( TestConversion< dip::sfloat, dip::sint16 >( floats, kernels ));
+   std::vector< dip::uint8 > uint8s( 37 );
+   std::vector< dip::uint16 > uint16s( 37 );
+   std::vector< dip::sint16 > sint16s( 37 );
+   for( dip::uint ii = 0; ii < 37; ++ii ) {
+      uint8s[ ii ] = static_cast< dip::uint8 >( ii * 7 );
+      uint16s[ ii ] = static_cast< dip::uint16 >( ii * 1777 );
+      sint16s[ ii ] = static_cast< dip::sint16 >( static_cast< dip::sint >( ii * 1777 ) - 32768 );
+   }
+   DOCTEST_CHECK( TestConversion< dip::uint8, dip::sfloat >( uint8s, kernels ));
+   DOCTEST_CHECK( TestConversion< dip::uint16, dip::sfloat >( uint16s, kernels ));
+   DOCTEST_CHECK( TestConversion< dip::sint16, dip::sfloat >( sint16s, kernels ));
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing the SIMD kernels for CopyBuffer") {
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+   dip::detail::IsaLevel level = dip::detail::GetIsaLevel();
+   if( level >= dip::detail::IsaLevel::SSE41 ) {
+      TestKernels( dip::detail::sse41Kernels );
+   }
+   if( level >= dip::detail::IsaLevel::AVX2 ) {
+      TestKernels( dip::detail::avx2Kernels );
+   }
+#endif
+   // Through `CopyBuffer`, which uses the kernels for contiguous data
+   std::vector< dip::sfloat > input{ -5.0f, 0.5f, 1.5f, 100.0f, 254.99f, 255.0f, 300.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+   std::vector< dip::uint8 > output( input.size() );
+   dip::detail::CopyBuffer( input.data(), dip::DT_SFLOAT, 1, 1, output.data(), dip::DT_UINT8, 1, 1, input.size(), 1 );
+   std::vector< dip::uint8 > expected{ 0, 0, 1, 100, 254, 255, 255, 3, 4, 5, 6 };
+   DOCTEST_CHECK( output == expected );
+   dip::detail::CopyBuffer( input.data(), dip::DT_SFLOAT, 1, 1, output.data(), dip::DT_UINT8, 1, 1, 1, input.size() );
+   DOCTEST_CHECK( output == expected );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
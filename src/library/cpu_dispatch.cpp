@@ -0,0 +1,119 @@
+/*
+ * DIPlib 3.0
+ * This file contains the detection of the instruction sets supported by the CPU.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+
+#include "diplib.h"
+#include "diplib/library/cpu_dispatch.h"
+
+namespace dip {
+
+namespace detail {
+
+namespace {
+
+IsaLevel DetectIsaLevel() {
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+   __builtin_cpu_init();
+   if( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" ) &&
+       __builtin_cpu_supports( "avx512dq" ) && __builtin_cpu_supports( "avx512vl" )) {
+      return IsaLevel::AVX512;
+   }
+   if( __builtin_cpu_supports( "avx2" )) {
+      return IsaLevel::AVX2;
+   }
+   if( __builtin_cpu_supports( "sse4.1" )) {
+      return IsaLevel::SSE41;
+   }
+#endif
+   return IsaLevel::Baseline;
+}
+
+IsaLevel SupportedIsaLevel() {
+   static IsaLevel const level = DetectIsaLevel();
+   return level;
+}
+
+std::atomic< IsaLevel >& ActiveIsaLevel() {
+   static std::atomic< IsaLevel > level{ SupportedIsaLevel() };
+   return level;
+}
+
+} // namespace
+
+IsaLevel GetIsaLevel() {
+   return ActiveIsaLevel().load( std::memory_order_relaxed );
+}
+
+IsaLevel SetIsaLevel( IsaLevel level ) {
+   if( level > SupportedIsaLevel() ) {
+      level = SupportedIsaLevel();
+   }
+   return ActiveIsaLevel().exchange( level );
+}
+
+} // namespace detail
+
+String GetActiveISA() {
+   switch( detail::GetIsaLevel() ) {
+      case detail::IsaLevel::AVX512:
+         return "AVX-512";
+      case detail::IsaLevel::AVX2:
+         return "AVX2";
+      case detail::IsaLevel::SSE41:
+         return "SSE4.1";
+      default:
+         return "baseline";
+   }
+}
+
+} // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the CPU dispatch") {
+   dip::detail::IsaLevel supported = dip::detail::GetIsaLevel();
+   dip::detail::IsaLevel previous = dip::detail::SetIsaLevel( dip::detail::IsaLevel::Baseline );
+   DOCTEST_CHECK( previous == supported );
+   DOCTEST_CHECK( dip::GetActiveISA() == "baseline" );
+   // Can't go higher than what the CPU supports
+   dip::detail::SetIsaLevel( dip::detail::IsaLevel::AVX512 );
+   DOCTEST_CHECK( dip::detail::GetIsaLevel() == supported );
+   // All versions compute the same thing
+   std::vector< dip::sfloat > in( 101 );
+   for( dip::uint ii = 0; ii < in.size(); ++ii ) {
+      in[ ii ] = static_cast< dip::sfloat >( ii ) * 0.37f;
+   }
+   std::vector< dip::sfloat > out( in.size() );
+   std::vector< dip::sfloat > ref( in.size() );
+   auto kernel = [ & ]( std::vector< dip::sfloat >& dst ) {
+      for( dip::uint ii = 0; ii < in.size(); ++ii ) {
+         dst[ ii ] = in[ ii ] * in[ ii ] - 2.0f * in[ ii ];
+      }
+   };
+   dip::detail::SetIsaLevel( dip::detail::IsaLevel::Baseline );
+   dip::detail::DispatchIsa( [ & ]() { kernel( ref ); } );
+   dip::detail::SetIsaLevel( supported );
+   dip::detail::DispatchIsa( [ & ]() { kernel( out ); } );
+   DOCTEST_CHECK( out == ref );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -23,6 +23,7 @@
 #include "diplib/pixel_table.h"
 #include "diplib/generic_iterators.h"
 #include "diplib/library/copy_buffer.h"
+#include "diplib/memory_pool.h"
 #include "diplib/multithreading.h"
 
 namespace dip {
@@ -156,7 +157,8 @@ void Full(
    }
 
    // Do we need an output buffer?
-   bool useOutBuffer = output.DataType() != outBufferType;
+   bool alignedBuffers = opts.Contains( FullOption::AlignedBuffers );
+   bool useOutBuffer = ( output.DataType() != outBufferType ) || alignedBuffers;
 
    // How many pixels in a line? How many lines?
    dip::uint lineLength = input.Size( processingDim );
@@ -170,10 +172,8 @@ void Full(
          dip::uint operations;
          DIP_STACK_TRACE_THIS( operations = nLines *
                lineFilter.GetNumberOfOperations( lineLength, input.TensorElements(), pixelTableOffsets.NumberOfPixels(), pixelTableOffsets.Runs().size() ));
-         // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
-         if( operations < threadingThreshold ) {
-            nThreads = 1;
-         }
+         // The cost model decides whether starting threads is worth while, and how many to start
+         nThreads = GetOptimalNumberOfThreads( operations, nThreads );
       }
    }
    dip::uint nLinesPerThread = div_ceil( nLines, nThreads );
@@ -221,14 +221,7 @@ void Full(
    }
 
    // Start threads, each thread makes its own buffers
-   AssertionError assertionError;
-   ParameterError parameterError;
-   RunTimeError runTimeError;
-   Error error;
-   #pragma omp parallel num_threads( static_cast< int >( nThreads ))
-   try {
-      dip::uint thread = static_cast< dip::uint >( omp_get_thread_num() );
-
+   auto threadTask = [ & ]( dip::uint thread ) {
       // Create input buffer data struct
       FullBuffer inBuffer;
       inBuffer.tensorLength = input.TensorElements();
@@ -237,13 +230,18 @@ void Full(
       inBuffer.buffer = nullptr;
 
       // Create output buffer data struct and allocate buffer if necessary
-      std::vector< uint8 > outputBuffer;
+      PoolBuffer outputBuffer;
       FullBuffer outBuffer;
       outBuffer.tensorLength = output.TensorElements();
       if( useOutBuffer ) {
          outBuffer.tensorStride = 1;
          outBuffer.stride = static_cast< dip::sint >( outBuffer.tensorLength );
-         outputBuffer.resize( lineLength * outBufferType.SizeOf() * outBuffer.tensorLength );
+         dip::uint bufferBytes = lineLength * outBufferType.SizeOf() * outBuffer.tensorLength;
+         if( alignedBuffers ) {
+            // The pool aligns the start of the buffer, we pad the end
+            bufferBytes = div_ceil( bufferBytes, bufferAlignment ) * bufferAlignment;
+         }
+         outputBuffer.resize( bufferBytes );
          outBuffer.buffer = outputBuffer.data();
       } else {
          outBuffer.tensorStride = output.TensorStride();
@@ -258,6 +256,7 @@ void Full(
             inBuffer, outBuffer, lineLength, processingDim, it.Coordinates(), pixelTableOffsets, thread
       }; // Takes inBuffer, outBuffer, it.Coordinates(), pixelTableOffsets as references
       for( dip::uint ii = 0; ( ii < nLinesPerThread ) && it; ++ii, ++it ) {
+         ThrowIfCancelled();
          inBuffer.buffer = it.InPointer();
          if( !useOutBuffer ) {
             // Point output buffer to right line in output image
@@ -280,44 +279,8 @@ void Full(
                   outBuffer.tensorLength );
          }
       }
-   } catch( dip::AssertionError const& e ) {
-      if( !assertionError.IsSet() ) {
-         assertionError = e;
-         DIP_ADD_STACK_TRACE( assertionError );
-      }
-   } catch( dip::ParameterError const& e ) {
-      if( !parameterError.IsSet() ) {
-         parameterError = e;
-         DIP_ADD_STACK_TRACE( parameterError );
-      }
-   } catch( dip::RunTimeError const& e ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = e;
-         DIP_ADD_STACK_TRACE( runTimeError );
-      }
-   } catch( dip::Error const& e ) {
-      if( !error.IsSet() ) {
-         error = e;
-         DIP_ADD_STACK_TRACE( error );
-      }
-   } catch( std::exception const& stde ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = dip::RunTimeError( stde.what() );
-         DIP_ADD_STACK_TRACE( runTimeError );
-      }
-   }
-   if( assertionError.IsSet() ) {
-      throw assertionError;
-   }
-   if( parameterError.IsSet() ) {
-      throw parameterError;
-   }
-   if( runTimeError.IsSet() ) {
-      throw runTimeError;
-   }
-   if( error.IsSet() ) {
-      throw error;
-   }
+   };
+   DIP_STACK_TRACE_THIS( ParallelRun( nThreads, threadTask ));
 }
 
 } // namespace Framework
@@ -21,6 +21,7 @@
 #include "diplib.h"
 #include "diplib/framework.h"
 #include "diplib/library/copy_buffer.h"
+#include "diplib/memory_pool.h"
 #include "diplib/multithreading.h"
 
 namespace dip {
@@ -333,10 +334,8 @@ void Scan(
          if( nThreads > 1 ) {
             dip::uint operations;
             DIP_STACK_TRACE_THIS( operations = lineLength * lineFilter.GetNumberOfOperations( nIn, nOut, ( nIn > 0 ? in[ 0 ] : out[ 0 ] ).TensorElements() ));
-            // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
-            if( operations < threadingThreshold ) {
-               nThreads = 1;
-            }
+            // The cost model decides whether starting threads is worth while, and how many to start
+            nThreads = GetOptimalNumberOfThreads( operations, nThreads );
          }
       }
 
@@ -373,10 +372,8 @@ void Scan(
          if( nThreads > 1 ) {
             dip::uint operations;
             DIP_STACK_TRACE_THIS( operations = nLines * lineLength * lineFilter.GetNumberOfOperations( nIn, nOut, ( nIn > 0 ? in[ 0 ] : out[ 0 ] ).TensorElements() ));
-            // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
-            if( operations < threadingThreshold ) {
-               nThreads = 1;
-            }
+            // The cost model decides whether starting threads is worth while, and how many to start
+            nThreads = GetOptimalNumberOfThreads( operations, nThreads );
          }
       }
 
@@ -435,14 +432,8 @@ void Scan(
    DIP_STACK_TRACE_THIS( lineFilter.SetNumberOfThreads( nThreads ));
 
    // Start threads, each thread makes its own buffers
-   AssertionError assertionError;
-   ParameterError parameterError;
-   RunTimeError runTimeError;
-   Error error;
-   #pragma omp parallel num_threads( static_cast< int >( nThreads ))
-   try {
-      dip::uint thread = static_cast< dip::uint >( omp_get_thread_num() );
-      std::vector< std::vector< uint8 >> buffers; // The outer one here is not a DimensionArray, because it won't delete() its contents
+   auto threadTask = [ & ]( dip::uint thread ) {
+      std::vector< PoolBuffer > buffers; // The outer one here is not a DimensionArray, because it won't delete() its contents
 
       // Create input buffer data structs and allocate buffers
       std::vector< ScanBuffer > inBuffers( nIn );  // We don't use DimensionArray here either, but we could
@@ -529,6 +520,7 @@ void Scan(
 
       // Loop over nLinesPerThread image lines
       for( dip::uint jj = 0; jj < nLinesPerThread ; ++jj ) {
+         ThrowIfCancelled();
 
          // Make `bufferSize` smaller if it's the last chunk in a 1D image
          if( scan1D ) {
@@ -626,44 +618,8 @@ void Scan(
             }
          }
       }
-   } catch( dip::AssertionError const& e ) {
-      if( !assertionError.IsSet() ) {
-         assertionError = e;
-         DIP_ADD_STACK_TRACE( assertionError );
-      }
-   } catch( dip::ParameterError const& e ) {
-      if( !parameterError.IsSet() ) {
-         parameterError = e;
-         DIP_ADD_STACK_TRACE( parameterError );
-      }
-   } catch( dip::RunTimeError const& e ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = e;
-         DIP_ADD_STACK_TRACE( runTimeError );
-      }
-   } catch( dip::Error const& e ) {
-      if( !error.IsSet() ) {
-         error = e;
-         DIP_ADD_STACK_TRACE( error );
-      }
-   } catch( std::exception const& stde ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = dip::RunTimeError( stde.what() );
-         DIP_ADD_STACK_TRACE( runTimeError );
-      }
-   }
-   if( assertionError.IsSet() ) {
-      throw assertionError;
-   }
-   if( parameterError.IsSet() ) {
-      throw parameterError;
-   }
-   if( runTimeError.IsSet() ) {
-      throw runTimeError;
-   }
-   if( error.IsSet() ) {
-      throw error;
-   }
+   };
+   DIP_STACK_TRACE_THIS( ParallelRun( nThreads, threadTask ));
 }
 
 } // namespace Framework
@@ -22,11 +22,36 @@
 #include "diplib/framework.h"
 #include "diplib/generic_iterators.h"
 #include "diplib/library/copy_buffer.h"
+#include "diplib/memory_pool.h"
 #include "diplib/multithreading.h"
 
 namespace dip {
 namespace Framework {
 
+namespace {
+
+// The number of bytes of one pixel in all lines of a block, see `SeparableLineFilter::FilterBlock`
+constexpr dip::uint separableBlockBytes = 128;
+static_assert( separableBlockBytes % bufferAlignment == 0, "Block buffers must be aligned" );
+static_assert( memoryPoolAlignment % bufferAlignment == 0, "Pool buffers must be aligned" );
+
+// Resizes `storage` to hold a line of `length` samples of `sampleSize` bytes, with `border` samples on either side,
+// and returns a pointer to the first sample of the line. If `aligned`, this pointer is aligned to `bufferAlignment`
+// bytes, and the end of the border is padded to a multiple of `bufferAlignment` bytes.
+uint8* ResizeLineBuffer( PoolBuffer& storage, dip::uint length, dip::uint border, dip::uint sampleSize, bool aligned ) {
+   dip::uint borderBytes = border * sampleSize;
+   dip::uint lineBytes = length * sampleSize;
+   if( !aligned ) {
+      storage.resize( lineBytes + 2 * borderBytes );
+      return storage.data() + borderBytes;
+   }
+   dip::uint offset = div_ceil( borderBytes, bufferAlignment ) * bufferAlignment;
+   storage.resize( offset + div_ceil( lineBytes + borderBytes, bufferAlignment ) * bufferAlignment );
+   return storage.data() + offset;
+}
+
+} // namespace
+
 void Separable(
       Image const& c_in,
       Image& c_out,
@@ -182,9 +207,9 @@ void Separable(
    //       - all but first pass read from output, all passes write in output
    //       - we can do this because output.DataType() == bufferType, so no precision is lost
 
-   // The intermediate image, if needed, stored here
+   // The intermediate image, if needed, stored here (with a single pass it is never needed)
    Image intermediate;
-   bool useIntermediate = output.DataType() != bufferType;
+   bool useIntermediate = ( order.size() > 1 ) && ( output.DataType() != bufferType );
    UnsignedArray intermSizes = outSizes;
    for( dip::uint ii = 1; ii < order.size(); ++ii ) { // not using the 1st dimension to be processed
       dip::uint kk = order[ ii ];
@@ -216,12 +241,10 @@ void Separable(
          }
          //std::cout << "lineLength = " << lineLength << ", nLines = " << nLines << ", operations = " << operations << std::endl;
       }
-      // Starting threads is only worth while if we'll do at least `threadingThreshold` operations
+      // The cost model decides whether starting threads is worth while, and how many to start
       //std::cout << "GetNumberOfThreads() = " << GetNumberOfThreads() << ", maxNLines = " << maxNLines << ", operations = " << operations << std::endl;
-      if( operations >= threadingThreshold ) {
-         // We can't do more threads than the max, and we can't do more threads than lines we have to process
-         nThreads = std::min( GetNumberOfThreads(), maxNLines );
-      }
+      // We can't do more threads than the max, and we can't do more threads than lines we have to process
+      nThreads = GetOptimalNumberOfThreads( operations, std::min( GetNumberOfThreads(), maxNLines ));
       // Note that we pick the number of threads according to the dimension where most threads can be used.
       // It is possible that one dimension has fewer image lines than threads we're starting. We need to deal
       // with this below.
@@ -237,269 +260,425 @@ void Separable(
    dip::uint nLinesPerThread;
    dip::uint dThreads;
 
-   // Start threads, each thread makes its own buffers
-   AssertionError assertionError;
-   ParameterError parameterError;
-   RunTimeError runTimeError;
-   Error error;
-   #pragma omp parallel num_threads( static_cast< int >( nThreads ))
-   try {
-      dip::uint thread = static_cast< dip::uint >( omp_get_thread_num() );
-
-      // The temporary buffers, if needed, will be stored here (each thread their own!)
-      std::vector< uint8 > inBufferStorage;
-      std::vector< uint8 > outBufferStorage;
-
-      // Iterate over the dimensions to be processed. This loop should not parallelized!
-      for( dip::uint rep = 0; rep < order.size(); ++rep ) {
-         dip::uint processingDim = order[ rep ];
-
-         #pragma omp master
-         {
-            // First step always reads from input, other steps read from outImage, which is either intermediate or output
-            inImage = (( rep == 0 ) ? ( input ) : ( outImage )).QuickCopy();
-            // Last step always writes to output, other steps write to intermediate or output
-            UnsignedArray sizes = inImage.Sizes();
-            outImage = (( rep == order.size() - 1 ) ? ( output ) : ( useIntermediate ? intermediate : output )).QuickCopy();
-            sizes[ processingDim ] = outSizes[ processingDim ];
-            outImage.SetSizesUnsafe( sizes );
-
-            //std::cout << "dip::Framework::Separable(), processingDim = " << processingDim << std::endl;
-            //std::cout << "   inImage.Origin() = " << inImage.Origin() << std::endl;
-            //std::cout << "   inImage.Sizes() = " << inImage.Sizes() << std::endl;
-            //std::cout << "   inImage.Strides() = " << inImage.Strides() << std::endl;
-            //std::cout << "   outImage.Origin() = " << outImage.Origin() << std::endl;
-            //std::cout << "   outImage.Sizes() = " << outImage.Sizes() << std::endl;
-            //std::cout << "   outImage.Strides() = " << outImage.Strides() << std::endl;
-
-            // Divide the image domain into nThreads chunks for split processing. The last chunk will have same or fewer
-            // image lines to process.
-            nLinesPerThread = div_ceil( inImage.NumberOfPixels() / inSizes[ processingDim ], nThreads );
-            DIP_ASSERT( nLinesPerThread == div_ceil( outImage.NumberOfPixels() / outSizes[ processingDim ], nThreads ));
-            dThreads = std::min( div_ceil( inImage.NumberOfPixels() / inSizes[ processingDim ], nLinesPerThread ), nThreads );
-            startCoords[ 0 ] = UnsignedArray( nDims, 0 );
-            for( dip::uint ii = 1; ii < dThreads; ++ii ) {
-               startCoords[ ii ] = startCoords[ ii - 1 ];
-               // To advance the iterator nLinesPerThread times, we increment it in whole-line steps.
-               dip::uint firstDim = processingDim == 0 ? 1 : 0;
-               dip::uint remaining = nLinesPerThread;
-               do {
-                  for( dip::uint dd = 0; dd < nDims; ++dd ) {
-                     if( dd == firstDim ) {
-                        dip::uint n = sizes[ dd ] - startCoords[ ii ][ dd ];
-                        if (remaining >= n) {
-                           // Rewinding, next loop iteration will increment the next coordinate
-                           remaining -= n;
-                           startCoords[ ii ][ dd ] = 0;
-                        } else {
-                           // Forward by `remaining`, then we're done.
-                           startCoords[ ii ][ dd ] += remaining;
-                           remaining = 0;
-                           break;
-                        }
-                     } else if( dd != processingDim ) {
-                        // Increment coordinate
-                        ++startCoords[ ii ][ dd ];
-                        // Check whether we reached the last pixel of the line
-                        if( startCoords[ ii ][ dd ] < sizes[ dd ] ) {
-                           break;
-                        }
-                        // Rewind, the next loop iteration will increment the next coordinate
-                        startCoords[ ii ][ dd ] = 0;
-                     }
+   // Iterate over the dimensions to be processed. This loop should not parallelized!
+   for( dip::uint rep = 0; rep < order.size(); ++rep ) {
+      dip::uint processingDim = order[ rep ];
+
+      // First step always reads from input, other steps read from outImage, which is either intermediate or output
+      inImage = (( rep == 0 ) ? ( input ) : ( outImage )).QuickCopy();
+      // Last step always writes to output, other steps write to intermediate or output
+      UnsignedArray sizes = inImage.Sizes();
+      outImage = (( rep == order.size() - 1 ) ? ( output ) : ( useIntermediate ? intermediate : output )).QuickCopy();
+      sizes[ processingDim ] = outSizes[ processingDim ];
+      outImage.SetSizesUnsafe( sizes );
+
+      //std::cout << "dip::Framework::Separable(), processingDim = " << processingDim << std::endl;
+      //std::cout << "   inImage.Origin() = " << inImage.Origin() << std::endl;
+      //std::cout << "   inImage.Sizes() = " << inImage.Sizes() << std::endl;
+      //std::cout << "   inImage.Strides() = " << inImage.Strides() << std::endl;
+      //std::cout << "   outImage.Origin() = " << outImage.Origin() << std::endl;
+      //std::cout << "   outImage.Sizes() = " << outImage.Sizes() << std::endl;
+      //std::cout << "   outImage.Strides() = " << outImage.Strides() << std::endl;
+
+      // Divide the image domain into nThreads chunks for split processing. The last chunk will have same or fewer
+      // image lines to process.
+      nLinesPerThread = div_ceil( inImage.NumberOfPixels() / inSizes[ processingDim ], nThreads );
+      DIP_ASSERT( nLinesPerThread == div_ceil( outImage.NumberOfPixels() / outSizes[ processingDim ], nThreads ));
+      dThreads = std::min( div_ceil( inImage.NumberOfPixels() / inSizes[ processingDim ], nLinesPerThread ), nThreads );
+      startCoords[ 0 ] = UnsignedArray( nDims, 0 );
+      for( dip::uint ii = 1; ii < dThreads; ++ii ) {
+         startCoords[ ii ] = startCoords[ ii - 1 ];
+         // To advance the iterator nLinesPerThread times, we increment it in whole-line steps.
+         dip::uint firstDim = processingDim == 0 ? 1 : 0;
+         dip::uint remaining = nLinesPerThread;
+         do {
+            for( dip::uint dd = 0; dd < nDims; ++dd ) {
+               if( dd == firstDim ) {
+                  dip::uint n = sizes[ dd ] - startCoords[ ii ][ dd ];
+                  if (remaining >= n) {
+                     // Rewinding, next loop iteration will increment the next coordinate
+                     remaining -= n;
+                     startCoords[ ii ][ dd ] = 0;
+                  } else {
+                     // Forward by `remaining`, then we're done.
+                     startCoords[ ii ][ dd ] += remaining;
+                     remaining = 0;
+                     break;
                   }
-               } while( remaining > 0 );
-            }
-            //for( dip::uint ii = 1; ii < nThreads; ++ii ) {
-            //   std::cout << "   startCoords[ " << ii << " ] = " << startCoords[ ii ] << std::endl;
-            //}
-         }
-         #pragma omp barrier
-
-         if( thread < dThreads ) {
-
-            // Some values to use during this iteration
-            dip::uint inLength = inSizes[ processingDim ];
-            DIP_ASSERT( inLength == inImage.Size( processingDim ));
-            dip::uint inBorder = border[ processingDim ];
-            dip::uint outLength = outSizes[ processingDim ];
-            dip::uint outBorder = opts.Contains( SeparableOption::UseOutputBorder ) ? inBorder : 0;
-
-            // Determine if we need to make a temporary buffer for this dimension
-            bool inUseBuffer = ( inImage.DataType() != bufferType ) || !lookUpTable.empty() || ( inBorder > 0 ) || opts.Contains( SeparableOption::UseInputBuffer );
-            bool outUseBuffer = ( outImage.DataType() != bufferType ) || ( outBorder > 0 );
-            if( !outUseBuffer && opts.Contains( SeparableOption::UseOutputBuffer )) {
-               // We can cheat a little here if UseOutputBuffer is given: if the samples are contiguous, there's no need to actually use the buffer.
-               outUseBuffer = !((( outImage.TensorElements() == 1 ) || ( outImage.TensorStride() == 1 ))
-                     && ( outImage.Stride( processingDim ) == static_cast< dip::sint >( outImage.TensorElements() )));
-            }
-            if( !inUseBuffer && !outUseBuffer && ( inImage.Origin() == outImage.Origin() )) {
-               // If input and output images are the same, we need to use at least one buffer!
-               inUseBuffer = !opts.Contains( SeparableOption::CanWorkInPlace );
-            }
-            bool useRealComponentOfOutput = outUseBuffer && bufferType.IsComplex() && !outImage.DataType().IsComplex()
-                                            && opts.Contains( SeparableOption::UseRealComponentOfOutput );
-
-            // Create buffer data structs and (re-)allocate buffers
-            SeparableBuffer inBuffer;
-            inBuffer.length = inLength;
-            inBuffer.border = inBorder;
-            if( inUseBuffer ) {
-               if( lookUpTable.empty() ) {
-                  inBuffer.tensorLength = inImage.TensorElements();
-               } else {
-                  inBuffer.tensorLength = lookUpTable.size();
+               } else if( dd != processingDim ) {
+                  // Increment coordinate
+                  ++startCoords[ ii ][ dd ];
+                  // Check whether we reached the last pixel of the line
+                  if( startCoords[ ii ][ dd ] < sizes[ dd ] ) {
+                     break;
+                  }
+                  // Rewind, the next loop iteration will increment the next coordinate
+                  startCoords[ ii ][ dd ] = 0;
                }
-               inBuffer.tensorStride = 1;
-               inBuffer.stride = static_cast< dip::sint >( inBuffer.tensorLength );
-               inBufferStorage.resize(( inLength + 2 * inBorder ) * bufferType.SizeOf() * inBuffer.tensorLength );
-               //std::cout << "   Using input buffer, size = " << inBufferStorage.size() << std::endl;
-               inBuffer.buffer = inBufferStorage.data() + inBorder * bufferType.SizeOf() * inBuffer.tensorLength;
-            } else {
-               inBuffer.tensorLength = inImage.TensorElements();
-               inBuffer.tensorStride = inImage.TensorStride();
-               inBuffer.stride = inImage.Stride( processingDim );
-               inBuffer.buffer = nullptr;
-               //std::cout << "   Not using input buffer\n";
             }
-            SeparableBuffer outBuffer;
-            outBuffer.length = outLength;
-            outBuffer.border = outBorder;
-            outBuffer.tensorLength = outImage.TensorElements();
-            if( outUseBuffer ) {
-               outBuffer.tensorStride = 1;
-               outBuffer.stride = static_cast< dip::sint >( outBuffer.tensorLength );
-               outBufferStorage.resize(( outLength + 2 * outBorder ) * bufferType.SizeOf() * outBuffer.tensorLength );
-               outBuffer.buffer = outBufferStorage.data() + outBorder * bufferType.SizeOf() * outBuffer.tensorLength;
-               //std::cout << "   Using output buffer, size = " << outBufferStorage.size() << std::endl;
-            } else {
-               outBuffer.tensorStride = outImage.TensorStride();
-               outBuffer.stride = outImage.Stride( processingDim );
-               outBuffer.buffer = nullptr;
-               //std::cout << "   Not using output buffer\n";
-            }
-
-            // Loop over nLinesPerThread image lines
+         } while( remaining > 0 );
+      }
+      //for( dip::uint ii = 1; ii < nThreads; ++ii ) {
+      //   std::cout << "   startCoords[ " << ii << " ] = " << startCoords[ ii ] << std::endl;
+      //}
+
+      // Start threads, each thread uses its own buffers. These come from the memory pool of the thread
+      // that runs the task, and are returned to it at the end of the task, so they are cheap to re-allocate
+      // for the next dimension.
+      auto threadTask = [ & ]( dip::uint thread ) {
+         PoolBuffer inBufferStorage;
+         PoolBuffer outBufferStorage;
+
+         // Some values to use during this iteration
+         dip::uint inLength = inSizes[ processingDim ];
+         DIP_ASSERT( inLength == inImage.Size( processingDim ));
+         dip::uint inBorder = border[ processingDim ];
+         dip::uint outLength = outSizes[ processingDim ];
+         dip::uint outBorder = opts.Contains( SeparableOption::UseOutputBorder ) ? inBorder : 0;
+
+         // The buffer types for this dimension
+         DataType inBufferType = ( rep == 0 ) && opts.Contains( SeparableOption::RealInputBuffer ) ? bufferType.Real() : bufferType;
+         DataType outBufferType = ( rep == order.size() - 1 ) && opts.Contains( SeparableOption::RealOutputBuffer ) ? bufferType.Real() : bufferType;
+
+         // Determine if we need to make a temporary buffer for this dimension
+         bool alignedBuffers = opts.Contains( SeparableOption::AlignedBuffers );
+         bool inUseBuffer = ( inImage.DataType() != inBufferType ) || !lookUpTable.empty() || ( inBorder > 0 )
+                            || opts.Contains( SeparableOption::UseInputBuffer ) || alignedBuffers;
+         bool outUseBuffer = ( outImage.DataType() != outBufferType ) || ( outBorder > 0 ) || alignedBuffers;
+         if( !outUseBuffer && opts.Contains( SeparableOption::UseOutputBuffer )) {
+            // We can cheat a little here if UseOutputBuffer is given: if the samples are contiguous, there's no need to actually use the buffer.
+            outUseBuffer = !((( outImage.TensorElements() == 1 ) || ( outImage.TensorStride() == 1 ))
+                  && ( outImage.Stride( processingDim ) == static_cast< dip::sint >( outImage.TensorElements() )));
+         }
+         if( !inUseBuffer && !outUseBuffer && ( inImage.Origin() == outImage.Origin() )) {
+            // If input and output images are the same, we need to use at least one buffer!
+            inUseBuffer = !opts.Contains( SeparableOption::CanWorkInPlace );
+         }
+         bool useRealComponentOfOutput = outUseBuffer && outBufferType.IsComplex() && !outImage.DataType().IsComplex()
+                                         && opts.Contains( SeparableOption::UseRealComponentOfOutput );
+
+         // Determine if we pass blocks of adjacent lines to the line filter. The lines in a block are adjacent
+         // along `blockDim`, which is the first dimension the iterator walks along.
+         dip::uint blockDim = processingDim == 0 ? 1 : 0;
+         bool useBlocks = lineFilter.ProcessesBlocks() && ( nDims > 1 ) && ( sizes[ blockDim ] > 1 )
+               && lookUpTable.empty() && ( inImage.TensorElements() == 1 ) && ( outImage.TensorElements() == 1 )
+               && ( std::abs( inImage.Stride( processingDim )) > 1 )
+               && ( inBufferType == bufferType ) && ( outBufferType == bufferType )
+               && !( bufferType.IsComplex() && !outImage.DataType().IsComplex() && opts.Contains( SeparableOption::UseRealComponentOfOutput ));
+         if( useBlocks ) {
+            dip::uint blockSize = std::max( separableBlockBytes / bufferType.SizeOf(), dip::uint( 1 ));
+            dip::uint bufferSizeOf = bufferType.SizeOf();
+            SeparableBuffer inBuffer{ nullptr, inLength, inBorder, static_cast< dip::sint >( blockSize ), 1, 1 };
+            inBufferStorage.resize(( inLength + 2 * inBorder ) * blockSize * bufferSizeOf );
+            inBuffer.buffer = inBufferStorage.data() + inBorder * blockSize * bufferSizeOf;
+            SeparableBuffer outBuffer{ nullptr, outLength, outBorder, static_cast< dip::sint >( blockSize ), 1, 1 };
+            outBufferStorage.resize(( outLength + 2 * outBorder ) * blockSize * bufferSizeOf );
+            outBuffer.buffer = outBufferStorage.data() + outBorder * blockSize * bufferSizeOf;
+            dip::sint inStride = inImage.Stride( processingDim ) * static_cast< dip::sint >( inImage.DataType().SizeOf() );
+            dip::sint outStride = outImage.Stride( processingDim ) * static_cast< dip::sint >( outImage.DataType().SizeOf() );
+
+            // Loop over nLinesPerThread image lines, in blocks of up to blockSize lines
             GenericJointImageIterator< 2 > it( { inImage, outImage }, processingDim );
             it.SetCoordinates( startCoords[ thread ] );
-            SeparableLineFilterParameters separableLineFilterParams{
-                  inBuffer, outBuffer, processingDim, rep, order.size(), it.Coordinates(), tensorToSpatial, thread
+            SeparableBlockFilterParameters separableBlockFilterParams{
+                  inBuffer, outBuffer, 0, processingDim, rep, order.size(), it.Coordinates(), blockDim, tensorToSpatial, thread
             }; // Takes inBuffer, outBuffer, it.Coordinates() as references
-            for( dip::uint ii = 0; ( ii < nLinesPerThread ) && it; ++ii, ++it ) {
-               // Get pointers to input and output lines
-               if( inUseBuffer ) {
+            dip::uint ii = 0;
+            while(( ii < nLinesPerThread ) && it ) {
+               ThrowIfCancelled();
+               // The lines in a block must be consecutive along `blockDim`, without the iterator wrapping around
+               dip::uint nLines = std::min( std::min( blockSize, nLinesPerThread - ii ), sizes[ blockDim ] - it.Coordinates()[ blockDim ] );
+               separableBlockFilterParams.nLines = nLines;
+               // Gather the lines into the input buffer, one pixel position at the time
+               uint8 const* inPtr = static_cast< uint8 const* >( it.InPointer() );
+               uint8* bufPtr = static_cast< uint8* >( inBuffer.buffer );
+               for( dip::uint jj = 0; jj < inLength; ++jj ) {
                   detail::CopyBuffer(
-                        it.InPointer(),
+                        inPtr,
                         inImage.DataType(),
-                        inImage.Stride( processingDim ),
-                        inImage.TensorStride(),
-                        inBuffer.buffer,
+                        inImage.Stride( blockDim ),
+                        1,
+                        bufPtr,
                         bufferType,
-                        inBuffer.stride,
-                        inBuffer.tensorStride,
-                        inLength,
-                        inBuffer.tensorLength,
-                        lookUpTable );
-                  if(( inBorder > 0 ) && ( inBuffer.stride != 0 )) {
+                        1,
+                        1,
+                        nLines,
+                        1 );
+                  inPtr += inStride;
+                  bufPtr += blockSize * bufferSizeOf;
+               }
+               if( inBorder > 0 ) {
+                  bufPtr = static_cast< uint8* >( inBuffer.buffer );
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
                      detail::ExpandBuffer(
-                           inBuffer.buffer,
+                           bufPtr,
                            bufferType,
                            inBuffer.stride,
-                           inBuffer.tensorStride,
+                           1,
                            inLength,
-                           inBuffer.tensorLength,
+                           1,
                            inBorder,
                            inBorder,
                            boundaryConditions[ processingDim ] );
+                     bufPtr += bufferSizeOf;
                   }
-               } else {
-                  inBuffer.buffer = it.InPointer();
                }
-               if( !outUseBuffer ) {
-                  outBuffer.buffer = it.OutPointer();
+
+               // Filter the block
+               lineFilter.FilterBlock( separableBlockFilterParams );
+
+               // Scatter the output buffer back to the image lines
+               uint8* outPtr = static_cast< uint8* >( it.OutPointer() );
+               bufPtr = static_cast< uint8* >( outBuffer.buffer );
+               for( dip::uint jj = 0; jj < outLength; ++jj ) {
+                  detail::CopyBuffer(
+                        bufPtr,
+                        bufferType,
+                        1,
+                        1,
+                        outPtr,
+                        outImage.DataType(),
+                        outImage.Stride( blockDim ),
+                        1,
+                        nLines,
+                        1 );
+                  outPtr += outStride;
+                  bufPtr += blockSize * bufferSizeOf;
+               }
+               ii += nLines;
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  ++it;
                }
+            }
+            return;
+         }
 
-               // Filter the line
-               lineFilter.Filter( separableLineFilterParams );
-
-               // Copy back the line from output buffer to the image
-               if( outUseBuffer ) {
-                  if( useRealComponentOfOutput ) {
-                     detail::CopyBuffer(
-                           outBuffer.buffer,
-                           bufferType.Real(),
-                           outBuffer.stride * 2,
-                           outBuffer.tensorStride * 2,
-                           it.OutPointer(),
-                           outImage.DataType(),
-                           outImage.Stride( processingDim ),
-                           outImage.TensorStride(),
-                           outLength,
-                           outBuffer.tensorLength );
-                  } else {
-                     detail::CopyBuffer(
-                           outBuffer.buffer,
-                           bufferType,
-                           outBuffer.stride,
-                           outBuffer.tensorStride,
-                           it.OutPointer(),
-                           outImage.DataType(),
-                           outImage.Stride( processingDim ),
-                           outImage.TensorStride(),
-                           outLength,
-                           outBuffer.tensorLength );
-                  }
+         // Create buffer data structs and (re-)allocate buffers
+         SeparableBuffer inBuffer;
+         inBuffer.length = inLength;
+         inBuffer.border = inBorder;
+         if( inUseBuffer ) {
+            if( lookUpTable.empty() ) {
+               inBuffer.tensorLength = inImage.TensorElements();
+            } else {
+               inBuffer.tensorLength = lookUpTable.size();
+            }
+            inBuffer.tensorStride = 1;
+            inBuffer.stride = static_cast< dip::sint >( inBuffer.tensorLength );
+            inBuffer.buffer = ResizeLineBuffer( inBufferStorage, inLength, inBorder, inBufferType.SizeOf() * inBuffer.tensorLength, alignedBuffers );
+            //std::cout << "   Using input buffer, size = " << inBufferStorage.size() << std::endl;
+         } else {
+            inBuffer.tensorLength = inImage.TensorElements();
+            inBuffer.tensorStride = inImage.TensorStride();
+            inBuffer.stride = inImage.Stride( processingDim );
+            inBuffer.buffer = nullptr;
+            //std::cout << "   Not using input buffer\n";
+         }
+         SeparableBuffer outBuffer;
+         outBuffer.length = outLength;
+         outBuffer.border = outBorder;
+         outBuffer.tensorLength = outImage.TensorElements();
+         if( outUseBuffer ) {
+            outBuffer.tensorStride = 1;
+            outBuffer.stride = static_cast< dip::sint >( outBuffer.tensorLength );
+            outBuffer.buffer = ResizeLineBuffer( outBufferStorage, outLength, outBorder, outBufferType.SizeOf() * outBuffer.tensorLength, alignedBuffers );
+            //std::cout << "   Using output buffer, size = " << outBufferStorage.size() << std::endl;
+         } else {
+            outBuffer.tensorStride = outImage.TensorStride();
+            outBuffer.stride = outImage.Stride( processingDim );
+            outBuffer.buffer = nullptr;
+            //std::cout << "   Not using output buffer\n";
+         }
+
+         // Loop over nLinesPerThread image lines
+         GenericJointImageIterator< 2 > it( { inImage, outImage }, processingDim );
+         it.SetCoordinates( startCoords[ thread ] );
+         SeparableLineFilterParameters separableLineFilterParams{
+               inBuffer, outBuffer, processingDim, rep, order.size(), it.Coordinates(), tensorToSpatial, thread
+         }; // Takes inBuffer, outBuffer, it.Coordinates() as references
+         for( dip::uint ii = 0; ( ii < nLinesPerThread ) && it; ++ii, ++it ) {
+            ThrowIfCancelled();
+            // Get pointers to input and output lines
+            if( inUseBuffer ) {
+               detail::CopyBuffer(
+                     it.InPointer(),
+                     inImage.DataType(),
+                     inImage.Stride( processingDim ),
+                     inImage.TensorStride(),
+                     inBuffer.buffer,
+                     inBufferType,
+                     inBuffer.stride,
+                     inBuffer.tensorStride,
+                     inLength,
+                     inBuffer.tensorLength,
+                     lookUpTable );
+               if(( inBorder > 0 ) && ( inBuffer.stride != 0 )) {
+                  detail::ExpandBuffer(
+                        inBuffer.buffer,
+                        inBufferType,
+                        inBuffer.stride,
+                        inBuffer.tensorStride,
+                        inLength,
+                        inBuffer.tensorLength,
+                        inBorder,
+                        inBorder,
+                        boundaryConditions[ processingDim ] );
+               }
+            } else {
+               inBuffer.buffer = it.InPointer();
+            }
+            if( !outUseBuffer ) {
+               outBuffer.buffer = it.OutPointer();
+            }
+
+            // Filter the line
+            lineFilter.Filter( separableLineFilterParams );
+
+            // Copy back the line from output buffer to the image
+            if( outUseBuffer ) {
+               if( useRealComponentOfOutput ) {
+                  detail::CopyBuffer(
+                        outBuffer.buffer,
+                        outBufferType.Real(),
+                        outBuffer.stride * 2,
+                        outBuffer.tensorStride * 2,
+                        it.OutPointer(),
+                        outImage.DataType(),
+                        outImage.Stride( processingDim ),
+                        outImage.TensorStride(),
+                        outLength,
+                        outBuffer.tensorLength );
+               } else {
+                  detail::CopyBuffer(
+                        outBuffer.buffer,
+                        outBufferType,
+                        outBuffer.stride,
+                        outBuffer.tensorStride,
+                        it.OutPointer(),
+                        outImage.DataType(),
+                        outImage.Stride( processingDim ),
+                        outImage.TensorStride(),
+                        outLength,
+                        outBuffer.tensorLength );
                }
             }
          }
+      };
+      DIP_STACK_TRACE_THIS( ParallelRun( dThreads, threadTask ));
+
+      // Clear the tensor look-up table: if it was defined, then the intermediate data now has a full matrix
+      // as tensor shape and we don't need it any more.
+      lookUpTable.clear();
+   }
+}
 
-         // Wait to start the next iteration until all threads have finished their work
-         #pragma omp barrier
+} // namespace Framework
+} // namespace dip
 
-         // Clear the tensor look-up table: if it was defined, then the intermediate data now has a full matrix
-         // as tensor shape and we don't need it any more.
-         #pragma omp master
-         lookUpTable.clear();
-      }
-   } catch( dip::AssertionError const& e ) {
-      if( !assertionError.IsSet() ) {
-         assertionError = e;
-         DIP_ADD_STACK_TRACE( assertionError );
-      }
-   } catch( dip::ParameterError const& e ) {
-      if( !parameterError.IsSet() ) {
-         parameterError = e;
-         DIP_ADD_STACK_TRACE( parameterError );
-      }
-   } catch( dip::RunTimeError const& e ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = e;
-         DIP_ADD_STACK_TRACE( runTimeError );
-      }
-   } catch( dip::Error const& e ) {
-      if( !error.IsSet() ) {
-         error = e;
-         DIP_ADD_STACK_TRACE( error );
-      }
-   } catch( std::exception const& stde ) {
-      if( !runTimeError.IsSet() ) {
-         runTimeError = dip::RunTimeError( stde.what() );
-         DIP_ADD_STACK_TRACE( runTimeError );
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/linear.h"
+#include "diplib/morphology.h"
+#include "diplib/statistics.h"
+
+namespace {
+
+// Applies `filter` along dimension 1 of `img`, where lines are processed in blocks, and along dimension 0 of
+// a transposed copy of `img`, where lines are processed one at the time, and returns the largest difference.
+template< typename F >
+dip::dfloat CompareBlocksToLines( dip::Image const& img, F const& filter ) {
+   dip::Image out1 = filter( img, 1 );
+   dip::Image imgT{ dip::UnsignedArray{ img.Size( 1 ), img.Size( 0 ), img.Size( 2 ) }, 1, img.DataType() };
+   imgT.Copy( img.QuickCopy().PermuteDimensions( { 1, 0, 2 } ));
+   dip::Image out2 = filter( imgT, 0 );
+   out2.PermuteDimensions( { 1, 0, 2 } );
+   return dip::MaximumAbs( dip::Convert( out1, dip::DT_DFLOAT ) - out2 ).As< dip::dfloat >();
+}
+
+// Computes the sum of each sample with its two neighbors, and records whether all buffers were aligned
+class NeighborSumLineFilter : public dip::Framework::SeparableLineFilter {
+   public:
+      bool aligned = true;
+      virtual void Filter( dip::Framework::SeparableLineFilterParameters const& params ) override {
+         dip::sfloat const* in = static_cast< dip::sfloat const* >( params.inBuffer.buffer );
+         dip::sfloat* out = static_cast< dip::sfloat* >( params.outBuffer.buffer );
+         aligned &= ( reinterpret_cast< dip::uint >( in ) % dip::Framework::bufferAlignment == 0 ) &&
+                    ( reinterpret_cast< dip::uint >( out ) % dip::Framework::bufferAlignment == 0 );
+         dip::sint inStride = params.inBuffer.stride;
+         dip::sint outStride = params.outBuffer.stride;
+         for( dip::uint ii = 0; ii < params.inBuffer.length; ++ii ) {
+            *out = in[ -inStride ] + *in + in[ inStride ];
+            in += inStride;
+            out += outStride;
+         }
       }
+};
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::Framework::Separable with aligned buffers") {
+   dip::Image img{ dip::UnsignedArray{ 37, 23 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 100.0 );
+   dip::Image out1;
+   dip::Image out2;
+   NeighborSumLineFilter lineFilter1;
+   dip::Framework::Separable( img, out1, dip::DT_SFLOAT, dip::DT_SFLOAT, {}, { 1 }, {}, lineFilter1,
+                              dip::Framework::SeparableOption::NoMultiThreading );
+   NeighborSumLineFilter lineFilter2;
+   dip::Framework::Separable( img, out2, dip::DT_SFLOAT, dip::DT_SFLOAT, {}, { 1 }, {}, lineFilter2,
+                              dip::Framework::SeparableOption::NoMultiThreading + dip::Framework::SeparableOption::AlignedBuffers );
+   DOCTEST_CHECK( lineFilter2.aligned );
+   DOCTEST_CHECK( dip::MaximumAbs( out1 - out2 ).As< dip::dfloat >() == 0.0 );
+   // Also when the input and output images are the same
+   dip::Framework::Separable( img, img, dip::DT_SFLOAT, dip::DT_SFLOAT, {}, { 1 }, {}, lineFilter2,
+                              dip::Framework::SeparableOption::AlignedBuffers + dip::Framework::SeparableOption::CanWorkInPlace );
+   DOCTEST_CHECK( lineFilter2.aligned );
+   DOCTEST_CHECK( dip::MaximumAbs( img - out1 ).As< dip::dfloat >() == 0.0 );
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::Framework::Separable with blocks of lines") {
+   dip::Image img{ dip::UnsignedArray{ 37, 23, 3 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 100.0 );
+
+   DOCTEST_CHECK( CompareBlocksToLines( img, []( dip::Image const& in, dip::uint dim ) {
+      dip::FloatArray sigmas( 3, 0.0 );
+      sigmas[ dim ] = 2.5;
+      return dip::GaussIIR( in, sigmas );
+   } ) < 1e-4 );
+
+   dip::OneDimensionalFilterArray filterArray( 1 );
+   for( auto const& symmetry : dip::StringArray{ "general", "even", "odd", "d-even", "d-odd" } ) {
+      filterArray[ 0 ].filter = { 0.1, -0.2, 0.3, 0.4, 0.5 };
+      filterArray[ 0 ].origin = symmetry == "general" ? 1 : -1;
+      filterArray[ 0 ].symmetry = symmetry;
+      DOCTEST_CHECK( CompareBlocksToLines( img, [ & ]( dip::Image const& in, dip::uint dim ) {
+         dip::BooleanArray process( 3, false );
+         process[ dim ] = true;
+         return dip::SeparableConvolution( in, filterArray, { "mirror" }, process );
+      } ) < 1e-4 );
    }
-   if( assertionError.IsSet() ) {
-      throw assertionError;
-   }
-   if( parameterError.IsSet() ) {
-      throw parameterError;
-   }
-   if( runTimeError.IsSet() ) {
-      throw runTimeError;
-   }
-   if( error.IsSet() ) {
-      throw error;
+
+   dip::Image img8 = dip::Convert( img, dip::DT_UINT8 );
+   for( dip::dfloat length : { 2.0, 3.0, 4.0, 7.0, 30.0 } ) {
+      for( auto const& bc : dip::StringArray{ "", "mirror" } ) {
+         DOCTEST_CHECK( CompareBlocksToLines( img8, [ & ]( dip::Image const& in, dip::uint dim ) {
+            dip::FloatArray sizes( 3, 1.0 );
+            sizes[ dim ] = length;
+            return dip::Dilation( in, { sizes, "rectangular" }, bc.empty() ? dip::StringArray{} : dip::StringArray{ bc } );
+         } ) == 0.0 );
+         DOCTEST_CHECK( CompareBlocksToLines( img8, [ & ]( dip::Image const& in, dip::uint dim ) {
+            dip::FloatArray sizes( 3, 1.0 );
+            sizes[ dim ] = length;
+            return dip::Erosion( in, { sizes, "rectangular" }, bc.empty() ? dip::StringArray{} : dip::StringArray{ bc } );
+         } ) == 0.0 );
+      }
    }
 }
 
-} // namespace Framework
-} // namespace dip
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -22,8 +22,10 @@
 #include "diplib/graph.h"
 #include "diplib/framework.h"
 #include "diplib/overload.h"
+#include "diplib/multithreading.h"
 
-#include <queue>
+#include <atomic>
+#include <numeric>
 #include <stack>
 
 namespace dip {
@@ -103,47 +105,114 @@ Graph::Graph( Image const& image, dip::uint connectivity, String const& weights
          Framework::ScanOption::NoMultiThreading + Framework::ScanOption::NeedCoordinates ));
 }
 
+namespace {
+
+// Finds the root of the tree that contains `v`, halving the path on the way
+Graph::VertexIndex FindRoot( std::vector< Graph::VertexIndex >& parent, Graph::VertexIndex v ) {
+   while( parent[ v ] != v ) {
+      parent[ v ] = parent[ parent[ v ]];
+      v = parent[ v ];
+   }
+   return v;
+}
+
+} // namespace
+
 Graph Graph::MinimumSpanningForest( std::vector< dip::uint > const& roots ) const {
 #ifdef DIP_CONFIG_ENABLE_ASSERT
    for( auto r : roots ) {
       DIP_ASSERT( r < NumberOfVertices() );
    }
 #endif
-   Graph msf( NumberOfVertices() );
-   for( dip::uint ii = 0; ii < NumberOfVertices(); ++ii ) {
+   // This is Boruvka's algorithm: in each iteration, each component (tree) finds its cheapest outgoing edge, and
+   // these edges are added to the forest, joining components. Finding the edges is done in parallel. The roots are
+   // joined into a single component before starting, as if they were connected by edges with infinitely low weight.
+   // This grows the same forest as Prim's algorithm started simultaneously from all roots would. At the end, we
+   // keep only the edges of the component that contains the roots.
+   dip::uint nVertices = NumberOfVertices();
+   dip::uint nEdges = NumberOfEdges();
+   Graph msf( nVertices );
+   for( dip::uint ii = 0; ii < nVertices; ++ii ) {
       msf.vertices_[ ii ].value = vertices_[ ii ].value;
    }
-   std::vector< bool > visited( NumberOfVertices(), false );
-   auto Comparator = [ & ]( EdgeIndex lhs, EdgeIndex rhs ){ return edges_[ lhs ].weight > edges_[ rhs ].weight; }; // NOTE! inverted order to give higher priority to lower weights
-   std::priority_queue< EdgeIndex, std::vector< EdgeIndex >, decltype( Comparator ) > queue( Comparator );
-   if( roots.empty() ) {
-      visited[ 0 ] = true;
-      for( auto index : vertices_[ 0 ].edges ) {
-         queue.push( index );
+   if( nVertices == 0 ) {
+      return msf;
+   }
+   std::vector< VertexIndex > parent( nVertices );
+   std::iota( parent.begin(), parent.end(), VertexIndex( 0 ));
+   VertexIndex root = roots.empty() ? 0 : roots[ 0 ];
+   for( auto q : roots ) {
+      q = FindRoot( parent, q );
+      if( q != root ) {
+         parent[ q ] = root;
       }
-   } else {
-      for( auto q : roots ) {
-         if( !visited[ q ] ) {
-            visited[ q ] = true;
-            for( auto index : vertices_[ q ].edges ) {
-               queue.push( index );
+   }
+   // `component[ v ]` is the root of the tree that `v` belongs to, updated at the start of each iteration
+   std::vector< VertexIndex > component( nVertices );
+   // The cheapest edge out of each component. Edges are ordered by weight, then by index, such that there are no ties
+   constexpr EdgeIndex noEdge = std::numeric_limits< EdgeIndex >::max();
+   std::unique_ptr< std::atomic< EdgeIndex >[] > cheapest( new std::atomic< EdgeIndex >[ nVertices ] );
+   auto IsCheaper = [ & ]( EdgeIndex lhs, EdgeIndex rhs ) {
+      return ( rhs == noEdge ) ||
+             ( edges_[ lhs ].weight < edges_[ rhs ].weight ) ||
+             (( edges_[ lhs ].weight == edges_[ rhs ].weight ) && ( lhs < rhs ));
+   };
+   auto UpdateCheapest = [ & ]( VertexIndex c, EdgeIndex edge ) {
+      EdgeIndex current = cheapest[ c ].load( std::memory_order_relaxed );
+      while( IsCheaper( edge, current ) && !cheapest[ c ].compare_exchange_weak( current, edge, std::memory_order_relaxed )) {}
+   };
+   dip::uint nThreads = GetOptimalNumberOfThreads( nEdges * 10 );
+   dip::uint edgesPerThread = div_ceil( nEdges, nThreads );
+   std::vector< EdgeIndex > selected;
+   while( true ) {
+      for( dip::uint ii = 0; ii < nVertices; ++ii ) {
+         component[ ii ] = FindRoot( parent, ii );
+         cheapest[ ii ].store( noEdge, std::memory_order_relaxed );
+      }
+      DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+         dip::uint first = thread * edgesPerThread;
+         dip::uint last = std::min( first + edgesPerThread, nEdges );
+         for( EdgeIndex ii = first; ii < last; ++ii ) {
+            Edge const& edge = edges_[ ii ];
+            if( !edge.IsValid() ) {
+               continue;
+            }
+            VertexIndex c0 = component[ edge.vertices[ 0 ]];
+            VertexIndex c1 = component[ edge.vertices[ 1 ]];
+            if( c0 != c1 ) {
+               UpdateCheapest( c0, ii );
+               UpdateCheapest( c1, ii );
+            }
+         }
+      } ));
+      // Join the components along their cheapest edges. Two components can select the same edge, the union-find
+      // structure makes sure we add it only once. Because there are no ties, the selected edges don't form cycles.
+      bool changed = false;
+      for( dip::uint ii = 0; ii < nVertices; ++ii ) {
+         EdgeIndex edge = cheapest[ ii ].load( std::memory_order_relaxed );
+         if( edge == noEdge ) {
+            continue;
+         }
+         VertexIndex c0 = FindRoot( parent, edges_[ edge ].vertices[ 0 ] );
+         VertexIndex c1 = FindRoot( parent, edges_[ edge ].vertices[ 1 ] );
+         if( c0 != c1 ) {
+            // Keep `root` as the root of its tree, so that it is easy to identify at the end
+            if( c1 == root ) {
+               std::swap( c0, c1 );
             }
+            parent[ c1 ] = c0;
+            selected.push_back( edge );
+            changed = true;
          }
       }
+      if( !changed ) {
+         break;
+      }
    }
-   while( !queue.empty() ) {
-      EdgeIndex edgeIndex = queue.top();
-      queue.pop();
-      VertexIndex q = edges_[ edgeIndex ].vertices[ 0 ];
-      if( visited[ q ] ) {
-         q = edges_[ edgeIndex ].vertices[ 1 ]; // try the other end then
-      }
-      if( !visited[ q ] ) {
-         visited[ q ] = true;
-         msf.AddEdgeNoCheck( edges_[ edgeIndex ] );
-         for( auto index : vertices_[ q ].edges ) {
-            queue.push( index );
-         }
+   std::sort( selected.begin(), selected.end() );
+   for( auto edge : selected ) {
+      if( FindRoot( parent, edges_[ edge ].vertices[ 0 ] ) == root ) {
+         msf.AddEdgeNoCheck( edges_[ edge ] );
       }
    }
    return msf;
@@ -174,6 +243,117 @@ void Graph::RemoveLargestEdges( dip::uint number ) {
    }
 }
 
+dfloat Graph::MinimumCut( VertexIndex source, VertexIndex sink ) {
+   DIP_THROW_IF( source >= vertices_.size(), E::INDEX_OUT_OF_RANGE );
+   DIP_THROW_IF( sink >= vertices_.size(), E::INDEX_OUT_OF_RANGE );
+   DIP_THROW_IF( source == sink, "The source and the sink must be different vertices" );
+   // Residual capacities for the two directions of each edge: `residual[ 2 * e ]` goes from `vertices[ 0 ]` to
+   // `vertices[ 1 ]`, `residual[ 2 * e + 1 ]` goes the other way. Augmenting a path by its smallest residual
+   // capacity sets that capacity to exactly 0, so we don't need a tolerance to find saturated edges.
+   std::vector< dfloat > residual( 2 * edges_.size(), 0.0 );
+   for( EdgeIndex ii = 0; ii < edges_.size(); ++ii ) {
+      if( edges_[ ii ].IsValid() ) {
+         DIP_THROW_IF( edges_[ ii ].weight < 0.0, "Edge weights must not be negative" );
+         residual[ 2 * ii ] = edges_[ ii ].weight;
+         residual[ 2 * ii + 1 ] = edges_[ ii ].weight;
+      }
+   }
+   auto Arc = [ this ]( EdgeIndex edge, VertexIndex from ) {
+      return 2 * edge + ( edges_[ edge ].vertices[ 0 ] == from ? 0 : 1 );
+   };
+   // Computes the distance from `source` to each vertex along edges with residual capacity. Returns false if
+   // `sink` cannot be reached.
+   constexpr dip::uint unreached = std::numeric_limits< dip::uint >::max();
+   std::vector< dip::uint > level( vertices_.size() );
+   std::vector< VertexIndex > queue;
+   queue.reserve( vertices_.size() );
+   auto ComputeLevels = [ & ]() {
+      std::fill( level.begin(), level.end(), unreached );
+      level[ source ] = 0;
+      queue.clear();
+      queue.push_back( source );
+      for( dip::uint head = 0; head < queue.size(); ++head ) {
+         VertexIndex v = queue[ head ];
+         for( auto edge : vertices_[ v ].edges ) {
+            VertexIndex w = OtherVertex( edge, v );
+            if(( level[ w ] == unreached ) && ( residual[ Arc( edge, v ) ] > 0.0 )) {
+               level[ w ] = level[ v ] + 1;
+               queue.push_back( w );
+            }
+         }
+      }
+      return level[ sink ] != unreached;
+   };
+   // Dinic's algorithm: in each phase, augment paths that go up one level at each step, until there are none left.
+   // The depth-first search is iterative, because paths in an image graph can be very long.
+   std::vector< dip::uint > next( vertices_.size() ); // index into `vertices_[ v ].edges` of the next edge to try
+   std::vector< EdgeIndex > path;
+   while( ComputeLevels() ) {
+      std::fill( next.begin(), next.end(), 0 );
+      path.clear();
+      VertexIndex v = source;
+      while( true ) {
+         if( v == sink ) {
+            dfloat capacity = std::numeric_limits< dfloat >::infinity();
+            VertexIndex u = source;
+            for( auto edge : path ) {
+               capacity = std::min( capacity, residual[ Arc( edge, u ) ] );
+               u = OtherVertex( edge, u );
+            }
+            // Augment the path, and continue the search from the start of the first saturated edge
+            dip::uint saturated = path.size();
+            u = source;
+            for( dip::uint ii = 0; ii < path.size(); ++ii ) {
+               dip::uint arc = Arc( path[ ii ], u );
+               residual[ arc ] -= capacity;
+               residual[ arc ^ 1u ] += capacity;
+               if(( saturated == path.size() ) && ( residual[ arc ] == 0.0 )) {
+                  saturated = ii;
+                  v = u;
+               }
+               u = OtherVertex( path[ ii ], u );
+            }
+            DIP_ASSERT( saturated < path.size() );
+            path.resize( saturated );
+            continue;
+         }
+         auto const& edges = vertices_[ v ].edges;
+         for( ; next[ v ] < edges.size(); ++next[ v ] ) {
+            EdgeIndex edge = edges[ next[ v ]];
+            VertexIndex w = OtherVertex( edge, v );
+            if(( level[ w ] == level[ v ] + 1 ) && ( residual[ Arc( edge, v ) ] > 0.0 )) {
+               break;
+            }
+         }
+         if( next[ v ] < edges.size() ) {
+            EdgeIndex edge = edges[ next[ v ]];
+            path.push_back( edge );
+            v = OtherVertex( edge, v );
+         } else {
+            // Dead end, go back one step
+            if( path.empty() ) {
+               break;
+            }
+            level[ v ] = unreached;
+            EdgeIndex edge = path.back();
+            path.pop_back();
+            v = OtherVertex( edge, v );
+            ++next[ v ];
+         }
+      }
+   }
+   // The vertices still reachable from `source` are on its side of the cut
+   dfloat cut = 0.0;
+   for( EdgeIndex ii = 0; ii < edges_.size(); ++ii ) {
+      if( edges_[ ii ].IsValid() &&
+          (( level[ edges_[ ii ].vertices[ 0 ]] == unreached ) != ( level[ edges_[ ii ].vertices[ 1 ]] == unreached ))) {
+         cut += edges_[ ii ].weight;
+         DeleteEdge( ii );
+      }
+   }
+   return cut;
+}
+
 namespace {
 
 template< typename T >
@@ -521,6 +701,10 @@ LowestCommonAncestorSolver::LowestCommonAncestorSolver( Graph const& graph )
 
 #ifdef DIP_CONFIG_ENABLE_DOCTEST
 #include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/random.h"
+#include "diplib/statistics.h"
+#include "diplib/union_find.h"
 
 DOCTEST_TEST_CASE("[DIPlib] testing dip::Graph") {
    dip::Image img( { 4, 5 }, 1, dip::DT_UINT8 );
@@ -597,4 +781,159 @@ DOCTEST_TEST_CASE("[DIPlib] testing dip::Graph") {
    DOCTEST_CHECK( graph.OtherVertex( edges2[ 0 ], 2 ) == 1 );
 }
 
+namespace {
+
+dip::dfloat TotalWeight( dip::Graph const& graph ) {
+   dip::dfloat total = 0;
+   for( auto const& edge : graph.Edges() ) {
+      if( edge.IsValid() ) {
+         total += edge.weight;
+      }
+   }
+   return total;
+}
+
+// Kruskal's algorithm, for comparison
+dip::dfloat MinimumSpanningTreeWeight( dip::Graph const& graph ) {
+   auto const& edges = graph.Edges();
+   std::vector< dip::Graph::EdgeIndex > indices( edges.size() );
+   std::iota( indices.begin(), indices.end(), dip::Graph::EdgeIndex( 0 ));
+   std::sort( indices.begin(), indices.end(), [ & ]( dip::Graph::EdgeIndex lhs, dip::Graph::EdgeIndex rhs ) {
+      return edges[ lhs ].weight < edges[ rhs ].weight;
+   } );
+   dip::SimpleUnionFind< dip::Graph::VertexIndex > regions( graph.NumberOfVertices() );
+   dip::dfloat total = 0;
+   for( auto index : indices ) {
+      if( regions.FindRoot( edges[ index ].vertices[ 0 ] ) != regions.FindRoot( edges[ index ].vertices[ 1 ] )) {
+         regions.Union( edges[ index ].vertices[ 0 ], edges[ index ].vertices[ 1 ] );
+         total += edges[ index ].weight;
+      }
+   }
+   return total;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::Graph::MinimumSpanningForest") {
+   dip::Image img( { 40, 30 }, 1, dip::DT_SFLOAT );
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 1000.0 );
+   img = dip::Convert( img, dip::DT_UINT8 ); // Creates many edges with equal weights
+   dip::Graph graph( img );
+   dip::Graph reference;
+   {
+      dip::ExecutionContext context;
+      context.maxThreads = 1;
+      dip::ScopedExecutionContext scope( context );
+      reference = graph.MinimumSpanningForest();
+   }
+   DOCTEST_CHECK( reference.CountEdges() == 40 * 30 - 1 );
+   DOCTEST_CHECK( TotalWeight( reference ) == MinimumSpanningTreeWeight( graph ));
+   dip::ExecutionContext context;
+   context.maxThreads = 4;
+   context.threadingThreshold = 1;
+   dip::ScopedExecutionContext scope( context );
+   dip::Graph msf = graph.MinimumSpanningForest();
+   DOCTEST_REQUIRE( msf.NumberOfEdges() == reference.NumberOfEdges() );
+   bool equal = true;
+   for( dip::uint ii = 0; ii < msf.NumberOfEdges(); ++ii ) {
+      equal &= msf.Edges()[ ii ].vertices == reference.Edges()[ ii ].vertices;
+   }
+   DOCTEST_CHECK( equal );
+   // Three roots: three trees
+   msf = graph.MinimumSpanningForest( { 5, 600, 1199 } );
+   DOCTEST_CHECK( msf.CountEdges() == 40 * 30 - 3 );
+   dip::SimpleUnionFind< dip::Graph::VertexIndex > trees( msf.NumberOfVertices() );
+   for( auto const& edge : msf.Edges() ) {
+      trees.Union( edge.vertices[ 0 ], edge.vertices[ 1 ] );
+   }
+   DOCTEST_CHECK( trees.FindRoot( 5 ) != trees.FindRoot( 600 ));
+   DOCTEST_CHECK( trees.FindRoot( 5 ) != trees.FindRoot( 1199 ));
+   DOCTEST_CHECK( trees.FindRoot( 600 ) != trees.FindRoot( 1199 ));
+   // Components not connected to the root are not included
+   dip::Graph disconnected( 6 );
+   disconnected.AddEdge( 0, 1, 1.0 );
+   disconnected.AddEdge( 1, 2, 2.0 );
+   disconnected.AddEdge( 0, 2, 3.0 );
+   disconnected.AddEdge( 3, 4, 1.0 );
+   disconnected.AddEdge( 4, 5, 1.0 );
+   msf = disconnected.MinimumSpanningForest();
+   DOCTEST_CHECK( msf.CountEdges() == 2 );
+   DOCTEST_CHECK( TotalWeight( msf ) == 3.0 );
+   msf = disconnected.MinimumSpanningForest( { 2, 5 } );
+   DOCTEST_CHECK( msf.CountEdges() == 4 );
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::Graph::MinimumCut") {
+   // Compare to the minimum over all partitions of a small random graph
+   dip::Random random( 0 );
+   dip::UniformRandomGenerator uniform( random );
+   constexpr dip::uint nVertices = 10;
+   for( dip::uint repeat = 0; repeat < 5; ++repeat ) {
+      dip::Graph graph( nVertices );
+      for( dip::Graph::VertexIndex v1 = 0; v1 < nVertices; ++v1 ) {
+         for( dip::Graph::VertexIndex v2 = v1 + 1; v2 < nVertices; ++v2 ) {
+            if( uniform( 0.0, 10.0 ) < 4.0 ) {
+               graph.AddEdge( v1, v2, std::round( uniform( 0.0, 10.0 )));
+            }
+         }
+      }
+      dip::dfloat expected = std::numeric_limits< dip::dfloat >::infinity();
+      for( dip::uint set = 0; set < ( 1u << nVertices ); ++set ) {
+         if((( set & 1u ) == 0 ) || (( set >> ( nVertices - 1 )) & 1u )) {
+            continue; // vertex 0 is the source, it must be in the set; the last vertex is the sink, it must not be
+         }
+         dip::dfloat cut = 0.0;
+         for( auto const& edge : graph.Edges() ) {
+            if((( set >> edge.vertices[ 0 ] ) & 1u ) != (( set >> edge.vertices[ 1 ] ) & 1u )) {
+               cut += edge.weight;
+            }
+         }
+         expected = std::min( expected, cut );
+      }
+      dip::Graph cutGraph = graph;
+      DOCTEST_CHECK( cutGraph.MinimumCut( 0, nVertices - 1 ) == expected );
+      DOCTEST_CHECK( TotalWeight( graph ) - TotalWeight( cutGraph ) == expected );
+      dip::SimpleUnionFind< dip::Graph::VertexIndex > regions( nVertices );
+      for( auto const& edge : cutGraph.Edges() ) {
+         if( edge.IsValid() ) {
+            regions.Union( edge.vertices[ 0 ], edge.vertices[ 1 ] );
+         }
+      }
+      DOCTEST_CHECK( regions.FindRoot( 0 ) != regions.FindRoot( nVertices - 1 ));
+   }
+
+   // Segment a noisy image with terminal links
+   dip::Image img( { 40, 30 }, 1, dip::DT_SFLOAT );
+   img.Fill( 20.0 );
+   img.At( dip::Range{ 10, 29 }, dip::Range{ 5, 24 } ).Fill( 80.0 );
+   dip::GaussianNoise( img, img, random, 100.0 );
+   dip::Graph graph( img, 1, "difference" );
+   for( auto const& edge : graph.Edges() ) {
+      edge.weight = 30.0 * std::exp( -edge.weight / 20.0 ); // smoothness term: low weight across large differences
+   }
+   dip::Graph::VertexIndex source = graph.AddVertex( img.NumberOfPixels() );
+   dip::Graph::VertexIndex sink = graph.AddVertex( img.NumberOfPixels() );
+   for( dip::Graph::VertexIndex v = 0; v < img.NumberOfPixels(); ++v ) {
+      dip::dfloat value = graph.VertexValue( v );
+      graph.AddEdgeNoCheck( v, source, std::abs( value - 20.0 ));  // cost of assigning `v` to the background
+      graph.AddEdgeNoCheck( v, sink, std::abs( value - 80.0 ));    // cost of assigning `v` to the foreground
+   }
+   graph.MinimumCut( source, sink );
+   dip::Image segmented( img.Sizes(), 1, dip::DT_BIN );
+   dip::bin* ptr = static_cast< dip::bin* >( segmented.Origin() );
+   for( dip::Graph::VertexIndex v = 0; v < img.NumberOfPixels(); ++v ) {
+      bool foreground = false;
+      for( auto edge : graph.EdgeIndices( v )) {
+         foreground |= graph.OtherVertex( edge, v ) == source;
+      }
+      ptr[ v ] = foreground;
+   }
+   dip::Image truth( img.Sizes(), 1, dip::DT_BIN );
+   truth.Fill( false );
+   truth.At( dip::Range{ 10, 29 }, dip::Range{ 5, 24 } ).Fill( true );
+   DOCTEST_CHECK( dip::Count( segmented != truth ) < 20 );
+}
+
 #endif // DIP_CONFIG_ENABLE_DOCTEST
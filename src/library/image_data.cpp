@@ -23,6 +23,7 @@
 #include <algorithm>
 
 #include "diplib.h"
+#include "diplib/memory_pool.h"
 
 
 namespace dip {
@@ -187,6 +188,28 @@ DataSegment AlignedAllocInterface::AllocateData(
 }
 
 
+DataSegment PoolAllocInterface::AllocateData(
+      void*& origin,
+      dip::DataType dataType,
+      UnsignedArray const& sizes,
+      IntegerArray& strides,
+      dip::Tensor const& tensor,
+      dip::sint& tensorStride
+) {
+   dip::uint size = FindNumberOfPixels( sizes ) * tensor.Elements() * dataType.SizeOf();
+   void* data = PoolAllocate( size );
+   tensorStride = 1;
+   ComputeStrides( sizes, tensor.Elements(), strides );
+   origin = data;
+   return DataSegment{ data, PoolFree };
+}
+
+PoolAllocInterface* PoolAllocInterface::GetInstance() {
+   static PoolAllocInterface ei;
+   return &ei;
+}
+
+
 // Constructor.
 CoordinatesComputer::CoordinatesComputer( UnsignedArray const& sizes, IntegerArray const& strides ) {
    dip::uint N = strides.size();
@@ -55,6 +55,9 @@ DIP_EXPORT const LibraryInformation libraryInformation{
 #ifdef DIP_CONFIG_HAS_JPEG
             ", JPEG support"
 #endif
+#ifdef DIP_CONFIG_ENABLE_CPU_DISPATCH
+            ", CPU dispatch"
+#endif
 };
 
 } // namespace dip
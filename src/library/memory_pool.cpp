@@ -0,0 +1,381 @@
+/*
+ * DIPlib 3.0
+ * This file contains the memory pool used for temporary buffers.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include "diplib.h"
+#include "diplib/memory_pool.h"
+
+namespace dip {
+
+namespace {
+
+// Size classes are powers of two, from 64 bytes to `memoryPoolMaxBlockSize`
+constexpr dip::uint minClassShift = 6;
+constexpr dip::uint nClasses = 21; // 2^6 ... 2^26
+constexpr dip::uint unpooled = nClasses;
+static_assert( dip::uint( 1 ) << ( minClassShift + nClasses - 1 ) == memoryPoolMaxBlockSize, "Size classes don't match the maximum block size" );
+
+class ThreadPool;
+
+// Stored just before the aligned pointer given to the user
+struct BlockHeader {
+   void* raw;                 // The pointer returned by `std::malloc`
+   dip::uint size;            // The usable size of the block
+   dip::uint sizeClass;       // `unpooled` for blocks that are not kept in the pool
+   ThreadPool const* owner;   // The pool of the thread that allocated the block, only compared, never dereferenced
+};
+static_assert( sizeof( BlockHeader ) <= memoryPoolAlignment, "Block header doesn't fit in the alignment padding" );
+
+dip::uint ClassSize( dip::uint sizeClass ) {
+   return dip::uint( 1 ) << ( sizeClass + minClassShift );
+}
+
+dip::uint SizeClass( dip::uint size ) {
+   if( size > memoryPoolMaxBlockSize ) {
+      return unpooled;
+   }
+   dip::uint sizeClass = 0;
+   while( ClassSize( sizeClass ) < size ) {
+      ++sizeClass;
+   }
+   return sizeClass;
+}
+
+BlockHeader* Header( void* ptr ) {
+   return reinterpret_cast< BlockHeader* >( static_cast< uint8* >( ptr ) - sizeof( BlockHeader ));
+}
+
+void* NewBlock( dip::uint size, dip::uint sizeClass, ThreadPool const* owner ) {
+   void* raw = std::malloc( size + sizeof( BlockHeader ) + memoryPoolAlignment - 1 );
+   DIP_THROW_IF( !raw, "Failed to allocate memory" );
+   dip::uint address = reinterpret_cast< dip::uint >( raw ) + sizeof( BlockHeader ) + memoryPoolAlignment - 1;
+   void* ptr = reinterpret_cast< void* >( address - address % memoryPoolAlignment );
+   *Header( ptr ) = { raw, size, sizeClass, owner };
+   return ptr;
+}
+
+void FreeBlock( void* ptr ) {
+   std::free( Header( ptr )->raw );
+}
+
+// Incremented by `ReleaseMemoryPool`, each thread empties its pool when it sees a new value
+std::atomic< dip::uint > releaseGeneration{ 0 };
+
+// Set when the calling thread's pool has been destroyed, blocks freed after that go directly to `std::free`.
+// This is a trivial type, so it is still accessible while other thread-local objects are being destroyed.
+thread_local bool poolDestroyed = false;
+
+// A counter that is written only by the thread that owns it, and can be read by any thread. Because there's
+// a single writer, incrementing it doesn't need an atomic read-modify-write operation.
+class Counter {
+   public:
+      void Add( dip::uint value ) { value_.store( value_.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed ); }
+      void Subtract( dip::uint value ) { value_.store( value_.load( std::memory_order_relaxed ) - value, std::memory_order_relaxed ); }
+      dip::uint Get() const { return value_.load( std::memory_order_relaxed ); }
+   private:
+      std::atomic< dip::uint > value_{ 0 };
+};
+
+// Statistics are kept per thread, `registry` knows all the pools so that they can be combined
+struct Registry {
+   std::mutex mutex;
+   std::vector< ThreadPool const* > pools;
+   dip::uint retiredHits = 0;    // counts from pools that have been destroyed
+   dip::uint retiredMisses = 0;
+   dip::uint resetHits = 0;      // combined counts at the time of the last `ResetMemoryPoolStatistics`
+   dip::uint resetMisses = 0;
+};
+
+Registry& GetRegistry() {
+   static Registry* registry = new Registry; // Never destroyed, threads can outlive static objects
+   return *registry;
+}
+
+class ThreadPool {
+   public:
+      ThreadPool() : generation_( releaseGeneration.load( std::memory_order_relaxed )) {
+         Registry& registry = GetRegistry();
+         std::lock_guard< std::mutex > lock( registry.mutex );
+         registry.pools.push_back( this );
+      }
+
+      ~ThreadPool() {
+         Release();
+         poolDestroyed = true;
+         Registry& registry = GetRegistry();
+         std::lock_guard< std::mutex > lock( registry.mutex );
+         registry.pools.erase( std::find( registry.pools.begin(), registry.pools.end(), this ));
+         registry.retiredHits += hits_.Get();
+         registry.retiredMisses += misses_.Get();
+      }
+
+      void* Allocate( dip::uint sizeClass ) {
+         ReleaseIfRequested();
+         auto& list = freeLists_[ sizeClass ];
+         if( list.empty() ) {
+            misses_.Add( 1 );
+            return NewBlock( ClassSize( sizeClass ), sizeClass, this );
+         }
+         void* ptr = list.back();
+         list.pop_back();
+         Uncache( sizeClass );
+         hits_.Add( 1 );
+         return ptr;
+      }
+
+      void CountMiss() {
+         misses_.Add( 1 );
+      }
+
+      // Returns false if the block was not kept. Blocks allocated by other threads are not kept, so that memory
+      // doesn't accumulate in the pool of a thread that frees what another thread allocates.
+      bool Free( void* ptr, dip::uint sizeClass ) {
+         ReleaseIfRequested();
+         if( Header( ptr )->owner != this ) {
+            return false;
+         }
+         dip::uint size = ClassSize( sizeClass );
+         if( cachedBytes_.Get() + size > memoryPoolMaxCachedBytes ) {
+            return false;
+         }
+         try {
+            freeLists_[ sizeClass ].push_back( ptr );
+         } catch( ... ) {
+            return false;
+         }
+         cachedBlocks_.Add( 1 );
+         cachedBytes_.Add( size );
+         return true;
+      }
+
+      void Release() {
+         for( dip::uint ii = 0; ii < nClasses; ++ii ) {
+            for( void* ptr : freeLists_[ ii ] ) {
+               FreeBlock( ptr );
+               Uncache( ii );
+            }
+            freeLists_[ ii ].clear();
+         }
+      }
+
+      // Statistics, can be read from any thread
+      dip::uint Hits() const { return hits_.Get(); }
+      dip::uint Misses() const { return misses_.Get(); }
+      dip::uint CachedBlocks() const { return cachedBlocks_.Get(); }
+      dip::uint CachedBytes() const { return cachedBytes_.Get(); }
+
+   private:
+      std::array< std::vector< void* >, nClasses > freeLists_;
+      dip::uint generation_;
+      Counter hits_;
+      Counter misses_;
+      Counter cachedBlocks_;
+      Counter cachedBytes_;
+
+      void ReleaseIfRequested() {
+         dip::uint generation = releaseGeneration.load( std::memory_order_relaxed );
+         if( generation != generation_ ) {
+            generation_ = generation;
+            Release();
+         }
+      }
+
+      void Uncache( dip::uint sizeClass ) {
+         cachedBlocks_.Subtract( 1 );
+         cachedBytes_.Subtract( ClassSize( sizeClass ));
+      }
+};
+
+ThreadPool& GetThreadPool() {
+   thread_local ThreadPool pool;
+   return pool;
+}
+
+// Combined hit and miss counts since the program started
+std::pair< dip::uint, dip::uint > TotalHitsAndMisses( Registry& registry ) {
+   dip::uint hits = registry.retiredHits;
+   dip::uint misses = registry.retiredMisses;
+   for( ThreadPool const* pool : registry.pools ) {
+      hits += pool->Hits();
+      misses += pool->Misses();
+   }
+   return { hits, misses };
+}
+
+} // namespace
+
+void* PoolAllocate( dip::uint size ) {
+   dip::uint sizeClass = SizeClass( size );
+   if( poolDestroyed ) {
+      return NewBlock( sizeClass == unpooled ? size : ClassSize( sizeClass ), sizeClass, nullptr );
+   }
+   ThreadPool& pool = GetThreadPool();
+   if( sizeClass == unpooled ) {
+      pool.CountMiss();
+      return NewBlock( size, unpooled, &pool );
+   }
+   return pool.Allocate( sizeClass );
+}
+
+void PoolFree( void* ptr ) noexcept {
+   if( !ptr ) {
+      return;
+   }
+   dip::uint sizeClass = Header( ptr )->sizeClass;
+   if(( sizeClass == unpooled ) || poolDestroyed || !GetThreadPool().Free( ptr, sizeClass )) {
+      FreeBlock( ptr );
+   }
+}
+
+dip::uint PoolBlockSize( void* ptr ) noexcept {
+   return ptr ? Header( ptr )->size : 0;
+}
+
+void ReleaseMemoryPool() {
+   ++releaseGeneration;
+   if( !poolDestroyed ) {
+      GetThreadPool().Release();
+   }
+}
+
+MemoryPoolStatistics GetMemoryPoolStatistics() {
+   Registry& registry = GetRegistry();
+   std::lock_guard< std::mutex > lock( registry.mutex );
+   MemoryPoolStatistics statistics;
+   auto total = TotalHitsAndMisses( registry );
+   statistics.hits = total.first - registry.resetHits;
+   statistics.misses = total.second - registry.resetMisses;
+   for( ThreadPool const* pool : registry.pools ) {
+      statistics.cachedBlocks += pool->CachedBlocks();
+      statistics.cachedBytes += pool->CachedBytes();
+   }
+   return statistics;
+}
+
+void ResetMemoryPoolStatistics() {
+   Registry& registry = GetRegistry();
+   std::lock_guard< std::mutex > lock( registry.mutex );
+   auto total = TotalHitsAndMisses( registry );
+   registry.resetHits = total.first;
+   registry.resetMisses = total.second;
+}
+
+} // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include <future>
+#include <thread>
+#include "doctest.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the memory pool") {
+   dip::ReleaseMemoryPool();
+   dip::ResetMemoryPoolStatistics();
+   dip::MemoryPoolStatistics before = dip::GetMemoryPoolStatistics();
+   void* ptr = dip::PoolAllocate( 1000 );
+   DOCTEST_CHECK( reinterpret_cast< dip::uint >( ptr ) % dip::memoryPoolAlignment == 0 );
+   std::memset( ptr, 0, 1000 );
+   dip::PoolFree( ptr );
+   dip::MemoryPoolStatistics stats = dip::GetMemoryPoolStatistics();
+   DOCTEST_CHECK( stats.misses == 1 );
+   DOCTEST_CHECK( stats.hits == 0 );
+   DOCTEST_CHECK( stats.cachedBlocks == before.cachedBlocks + 1 );
+   DOCTEST_CHECK( stats.cachedBytes == before.cachedBytes + 1024 );
+   // A block of the same size class is re-used
+   void* ptr2 = dip::PoolAllocate( 600 );
+   DOCTEST_CHECK( ptr2 == ptr );
+   stats = dip::GetMemoryPoolStatistics();
+   DOCTEST_CHECK( stats.hits == 1 );
+   DOCTEST_CHECK( stats.cachedBlocks == before.cachedBlocks );
+   DOCTEST_CHECK( dip::PoolBlockSize( ptr2 ) == 1024 );
+   // Blocks can be freed in another thread, but are not kept in that thread's pool
+   std::thread( [ & ]() { dip::PoolFree( ptr2 ); } ).join();
+   DOCTEST_CHECK( dip::GetMemoryPoolStatistics().cachedBlocks == before.cachedBlocks );
+   // Large blocks are not pooled
+   void* large = dip::PoolAllocate( dip::memoryPoolMaxBlockSize + 1 );
+   DOCTEST_CHECK( reinterpret_cast< dip::uint >( large ) % dip::memoryPoolAlignment == 0 );
+   dip::PoolFree( large );
+   DOCTEST_CHECK( dip::GetMemoryPoolStatistics().cachedBytes <= before.cachedBytes + 1024 );
+   // The buffer keeps its contents when growing
+   {
+      dip::PoolBuffer buffer;
+      buffer.resize( 10 );
+      for( dip::uint ii = 0; ii < 10; ++ii ) {
+         buffer.data()[ ii ] = static_cast< dip::uint8 >( ii );
+      }
+      buffer.resize( 5000 );
+      DOCTEST_CHECK( buffer.size() == 5000 );
+      DOCTEST_CHECK( buffer.data()[ 9 ] == 9 );
+      // The capacity is that of the size class, growing within it doesn't allocate
+      dip::uint8* data = buffer.data();
+      buffer.resize( 8192 );
+      DOCTEST_CHECK( buffer.data() == data );
+   }
+   // Images allocated with the pooled interface re-use memory
+   dip::ResetMemoryPoolStatistics();
+   for( dip::uint ii = 0; ii < 10; ++ii ) {
+      dip::Image img;
+      img.SetExternalInterface( dip::PoolAllocInterface::GetInstance() );
+      img.ReForge( { 50, 40 }, 3, dip::DT_SFLOAT );
+      img.Fill( 1.0 );
+      DOCTEST_CHECK( reinterpret_cast< dip::uint >( img.Origin() ) % dip::memoryPoolAlignment == 0 );
+   }
+   stats = dip::GetMemoryPoolStatistics();
+   DOCTEST_CHECK( stats.misses <= 1 );
+   DOCTEST_CHECK( stats.hits >= 9 );
+   dip::ReleaseMemoryPool();
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::ReleaseMemoryPool with multiple threads") {
+   // Another thread keeps a block in its pool, and releases it after we ask all threads to do so.
+   // Other threads might have blocks cached too, we only look at the change in this one thread's pool.
+   dip::ReleaseMemoryPool();
+   std::promise< void > cached;
+   std::promise< void > released;
+   std::promise< dip::uint > reallocated;
+   std::promise< void > done;
+   std::thread thread( [ & ]() {
+      dip::PoolFree( dip::PoolAllocate( 1000 ));
+      cached.set_value();
+      released.get_future().wait();
+      void* ptr = dip::PoolAllocate( 100 );
+      dip::uint size = dip::PoolBlockSize( ptr );
+      dip::PoolFree( ptr );
+      reallocated.set_value( size );
+      done.get_future().wait(); // the pool is emptied when the thread ends
+   } );
+   cached.get_future().wait();
+   dip::MemoryPoolStatistics before = dip::GetMemoryPoolStatistics();
+   dip::ReleaseMemoryPool();
+   released.set_value();
+   dip::uint size = reallocated.get_future().get();
+   dip::MemoryPoolStatistics after = dip::GetMemoryPoolStatistics();
+   done.set_value();
+   thread.join();
+   DOCTEST_CHECK( after.cachedBlocks == before.cachedBlocks );
+   DOCTEST_CHECK( after.cachedBytes == before.cachedBytes - 1024 + size );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -18,7 +18,19 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "diplib.h"
 #include "diplib/multithreading.h"
+#include "calibration.h"
 
 namespace dip {
 
@@ -26,6 +38,190 @@ namespace {
 
 dip::uint maxNumberOfThreads = static_cast< dip::uint >( omp_get_max_threads() ); // This responds to the OMP_NUM_THREADS environment variable.
 
+// The context used when none was installed
+ExecutionContext const defaultExecutionContext{};
+
+// The context installed for the current thread
+thread_local ExecutionContext const* currentExecutionContext = &defaultExecutionContext;
+
+// Set while the current thread is running a task started by `ParallelRun` with more than one thread.
+thread_local bool insideParallelTask = false;
+
+// The built-in executor: each worker has its own queue of jobs, and steals from the other workers' queues when
+// its own queue is empty. A job is a handle to a batch of tasks; whoever holds a handle keeps claiming tasks from
+// the batch until there are none left. The thread that calls `Run` claims tasks from its own batch too, so that
+// progress is guaranteed even when all workers are busy with other batches.
+class WorkStealingThreadPool : public Executor {
+   public:
+      WorkStealingThreadPool() = default;
+      WorkStealingThreadPool( WorkStealingThreadPool const& ) = delete;
+      WorkStealingThreadPool& operator=( WorkStealingThreadPool const& ) = delete;
+
+      ~WorkStealingThreadPool() override {
+         {
+            std::lock_guard< std::mutex > lock( mutex_ );
+            stop_ = true;
+         }
+         wake_.notify_all();
+         for( auto& worker : workers_ ) {
+            worker->thread.join();
+         }
+      }
+
+      void Run( dip::uint nTasks, std::function< void( dip::uint ) > const& task ) override {
+         if( nTasks == 0 ) {
+            return;
+         }
+         if( nTasks == 1 ) {
+            task( 0 );
+            return;
+         }
+         auto batch = std::make_shared< Batch >( task, nTasks );
+         {
+            std::lock_guard< std::mutex > lock( mutex_ );
+            StartWorkers( nTasks - 1 );
+            // Hand out one handle per helper we'd like, spreading them over the workers' queues
+            for( dip::uint ii = 1; ii < nTasks; ++ii ) {
+               workers_[ nextWorker_ ]->queue.push_back( batch );
+               nextWorker_ = ( nextWorker_ + 1 ) % workers_.size();
+            }
+            pending_ += nTasks - 1;
+         }
+         wake_.notify_all();
+         while( batch->RunOne() ) {}
+         batch->Wait();
+      }
+
+   private:
+      class Batch {
+         public:
+            Batch( std::function< void( dip::uint ) > const& task, dip::uint nTasks ) : task_( task ), nTasks_( nTasks ) {}
+            // Claims and runs one task, returns false if there were none left
+            bool RunOne() {
+               dip::uint ii = next_.fetch_add( 1 );
+               if( ii >= nTasks_ ) {
+                  return false;
+               }
+               task_( ii );
+               if( done_.fetch_add( 1 ) + 1 == nTasks_ ) {
+                  std::lock_guard< std::mutex > lock( mutex_ );
+                  finished_.notify_all();
+               }
+               return true;
+            }
+            // Waits until all tasks have finished
+            void Wait() {
+               std::unique_lock< std::mutex > lock( mutex_ );
+               finished_.wait( lock, [ this ]() { return done_.load() == nTasks_; } );
+            }
+         private:
+            // Note that `task_` is only used after claiming a task, and the caller of `Run` doesn't return until
+            // all tasks are finished. Handles that outlive the call never touch `task_`.
+            std::function< void( dip::uint ) > const& task_;
+            dip::uint nTasks_;
+            std::atomic< dip::uint > next_{ 0 };
+            std::atomic< dip::uint > done_{ 0 };
+            std::mutex mutex_;
+            std::condition_variable finished_;
+      };
+
+      struct Worker {
+         std::deque< std::shared_ptr< Batch >> queue;
+         std::thread thread;
+      };
+
+      std::vector< std::unique_ptr< Worker >> workers_;
+      dip::uint nextWorker_ = 0;
+      dip::uint pending_ = 0;       // number of handles in all queues
+      bool stop_ = false;
+      std::mutex mutex_;            // protects all of the above; jobs are coarse, so there is little contention
+      std::condition_variable wake_;
+
+      // Must be called with `mutex_` locked
+      void StartWorkers( dip::uint nWorkers ) {
+         while( workers_.size() < nWorkers ) {
+            workers_.emplace_back( new Worker );
+            dip::uint index = workers_.size() - 1;
+            workers_.back()->thread = std::thread( [ this, index ]() { WorkerLoop( index ); } );
+         }
+      }
+
+      // Takes a handle from the worker's own queue (newest first), or steals one from another queue (oldest first).
+      // Must be called with `mutex_` locked, and `pending_ > 0`.
+      std::shared_ptr< Batch > TakeJob( dip::uint index ) {
+         dip::uint nWorkers = workers_.size();
+         std::shared_ptr< Batch > job;
+         auto& own = workers_[ index ]->queue;
+         if( !own.empty() ) {
+            job = std::move( own.back() );
+            own.pop_back();
+         } else {
+            for( dip::uint ii = 1; ii < nWorkers; ++ii ) {
+               auto& other = workers_[ ( index + ii ) % nWorkers ]->queue;
+               if( !other.empty() ) {
+                  job = std::move( other.front() );
+                  other.pop_front();
+                  break;
+               }
+            }
+         }
+         DIP_ASSERT( job );
+         --pending_;
+         return job;
+      }
+
+      void WorkerLoop( dip::uint index ) {
+         while( true ) {
+            std::shared_ptr< Batch > job;
+            {
+               std::unique_lock< std::mutex > lock( mutex_ );
+               wake_.wait( lock, [ this ]() { return stop_ || ( pending_ > 0 ); } );
+               if( stop_ ) {
+                  return;
+               }
+               job = TakeJob( index );
+            }
+            while( job->RunOne() ) {}
+         }
+      }
+};
+
+#ifdef _OPENMP
+class OpenMPExecutorImpl : public Executor {
+   public:
+      void Run( dip::uint nTasks, std::function< void( dip::uint ) > const& task ) override {
+         // OpenMP might give us fewer threads than requested, in which case each thread runs multiple tasks
+         #pragma omp parallel num_threads( static_cast< int >( nTasks ))
+         {
+            dip::uint nThreads = static_cast< dip::uint >( omp_get_num_threads() );
+            for( dip::uint ii = static_cast< dip::uint >( omp_get_thread_num() ); ii < nTasks; ii += nThreads ) {
+               task( ii );
+            }
+         }
+      }
+};
+#else
+class OpenMPExecutorImpl : public Executor {
+   public:
+      void Run( dip::uint nTasks, std::function< void( dip::uint ) > const& task ) override {
+         for( dip::uint ii = 0; ii < nTasks; ++ii ) {
+            task( ii );
+         }
+      }
+};
+#endif
+
+std::shared_ptr< Executor > currentExecutor; // Use `std::atomic_load` and `std::atomic_store` to access this
+
+// Sets `insideParallelTask` for the lifetime of the object, restores the previous value when destroyed
+class ParallelTaskScope {
+   public:
+      ParallelTaskScope() : previous_( insideParallelTask ) { insideParallelTask = true; }
+      ~ParallelTaskScope() { insideParallelTask = previous_; }
+   private:
+      bool previous_;
+};
+
 }
 
 void SetNumberOfThreads( dip::uint nThreads ) {
@@ -37,7 +233,509 @@ void SetNumberOfThreads( dip::uint nThreads ) {
 }
 
 dip::uint GetNumberOfThreads() {
+   ExecutionContext const& context = *currentExecutionContext;
+   if( insideParallelTask && !context.allowNestedParallelism ) {
+      return 1;
+   }
+   if( context.maxThreads > 0 ) {
+      return std::min( context.maxThreads, static_cast< dip::uint >( omp_get_max_threads() ));
+   }
    return maxNumberOfThreads;
 }
 
+ScopedExecutionContext::ScopedExecutionContext( ExecutionContext const& context )
+      : context_( context ), previous_( currentExecutionContext ) {
+   currentExecutionContext = &context_;
+}
+
+ScopedExecutionContext::~ScopedExecutionContext() {
+   currentExecutionContext = previous_;
+}
+
+ExecutionContext const& GetExecutionContext() {
+   return *currentExecutionContext;
+}
+
+namespace detail {
+
+bool CanCalibrate() {
+   dip::uint maxThreads = static_cast< dip::uint >( omp_get_max_threads() );
+   return !insideParallelTask && ( currentExecutionContext->maxThreads == 0 ) &&
+          ( maxNumberOfThreads == maxThreads ) && ( maxThreads > 1 );
+}
+
+} // namespace detail
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Runs `func` `repetitions` times, and returns the shortest time in seconds
+template< typename F >
+dfloat ShortestTime( dip::uint repetitions, F const& func ) {
+   dfloat best = std::numeric_limits< dfloat >::max();
+   for( dip::uint ii = 0; ii < repetitions; ++ii ) {
+      auto start = Clock::now();
+      func();
+      best = std::min( best, std::chrono::duration< dfloat >( Clock::now() - start ).count() );
+   }
+   return best;
+}
+
+// The work we use to measure the cost of one operation: two multiply-adds per element, four independent
+// accumulators so that the loop is not latency bound. Returns a value so the compiler can't remove the loop.
+dfloat CalibrationWork( dfloat const* data, dip::uint n ) {
+   dfloat acc[ 4 ] = { 0.0, 0.0, 0.0, 0.0 };
+   for( dip::uint ii = 0; ii + 4 <= n; ii += 4 ) {
+      for( dip::uint jj = 0; jj < 4; ++jj ) {
+         acc[ jj ] = acc[ jj ] * 0.999 + data[ ii + jj ];
+      }
+   }
+   return acc[ 0 ] + acc[ 1 ] + acc[ 2 ] + acc[ 3 ];
+}
+
+// Measures the cost model parameters with the threads available to the caller
+ThreadingCalibration MeasureThreadingCalibration() {
+   ThreadingCalibration calibration;
+   dip::uint maxThreads = GetNumberOfThreads();
+   if( maxThreads > 1 ) {
+      constexpr dip::uint nElements = 1u << 16;
+      constexpr dip::uint repetitions = 20;
+      constexpr dfloat operationsPerElement = 2;
+      std::vector< dfloat > data( nElements, 1.0 );
+      std::vector< dfloat > sink( maxThreads, 0.0 );
+      // Time to process all elements in one thread gives us the time per operation
+      dfloat sequentialTime = ShortestTime( repetitions, [ & ]() {
+         sink[ 0 ] += CalibrationWork( data.data(), nElements );
+      } );
+      dfloat secondsPerOperation = sequentialTime / ( nElements * operationsPerElement );
+      // The same work split over `n` threads costs `sequentialTime / n + overhead( n )`
+      auto overhead = [ & ]( dip::uint nThreads ) {
+         dip::uint chunk = div_ceil( nElements, nThreads );
+         dfloat time = ShortestTime( repetitions, [ & ]() {
+            ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+               dip::uint first = std::min( thread * chunk, nElements );
+               dip::uint last = std::min( first + chunk, nElements );
+               sink[ thread ] += CalibrationWork( data.data() + first, last - first );
+            } );
+         } );
+         return std::max( time - sequentialTime / static_cast< dfloat >( nThreads ), 0.0 ) / secondsPerOperation;
+      };
+      overhead( maxThreads ); // Makes sure all threads are started before we measure
+      dfloat overhead2 = overhead( 2 );
+      dfloat perThreadCost = 0.0;
+      if( maxThreads > 2 ) {
+         perThreadCost = std::max(( overhead( maxThreads ) - overhead2 ) / static_cast< dfloat >( maxThreads - 2 ), 0.0 );
+      }
+      calibration.perThreadCost = perThreadCost;
+      calibration.startupCost = std::max( overhead2 - 2 * perThreadCost, 0.0 );
+   }
+   return calibration;
+}
+
+struct ThreadingCalibrationTraits {
+   static bool Read( String const& filename, ThreadingCalibration& calibration ) {
+      std::ifstream file( filename );
+      return static_cast< bool >( file >> calibration.startupCost >> calibration.perThreadCost );
+   }
+   static bool Write( String const& filename, ThreadingCalibration const& calibration ) {
+      std::ofstream file( filename );
+      return static_cast< bool >( file << calibration.startupCost << ' ' << calibration.perThreadCost << '\n' );
+   }
+   static ThreadingCalibration Measure() {
+      return MeasureThreadingCalibration();
+   }
+};
+
+// A function-local static, so that it is constructed before it is first used
+detail::Calibration< ThreadingCalibration, ThreadingCalibrationTraits >& CurrentCalibration() {
+   static detail::Calibration< ThreadingCalibration, ThreadingCalibrationTraits > calibration( "DIP_THREADING_CALIBRATION" );
+   return calibration;
+}
+
+} // namespace
+
+ThreadingCalibration CalibrateThreading( String const& filename ) {
+   ThreadingCalibration calibration = MeasureThreadingCalibration();
+   SetThreadingCalibration( calibration );
+   if( !filename.empty() ) {
+      DIP_THROW_IF( !ThreadingCalibrationTraits::Write( filename, calibration ), "Could not write threading calibration file" );
+   }
+   return calibration;
+}
+
+void LoadThreadingCalibration( String const& filename ) {
+   ThreadingCalibration calibration;
+   DIP_THROW_IF( !ThreadingCalibrationTraits::Read( filename, calibration ), "Could not read threading calibration file" );
+   SetThreadingCalibration( calibration );
+}
+
+void SetThreadingCalibration( ThreadingCalibration const& calibration ) {
+   DIP_THROW_IF(( calibration.startupCost < 0 ) || ( calibration.perThreadCost < 0 ), E::PARAMETER_OUT_OF_RANGE );
+   CurrentCalibration().Set( calibration );
+}
+
+ThreadingCalibration GetThreadingCalibration() {
+   return CurrentCalibration().Get();
+}
+
+dip::uint GetThreadingThreshold() {
+   dip::uint threshold = currentExecutionContext->threadingThreshold;
+   return threshold > 0 ? threshold : CurrentCalibration().Get().Threshold();
+}
+
+dip::uint GetOptimalNumberOfThreads( dip::uint operations, dip::uint maxThreads ) {
+   if( maxThreads == 0 ) {
+      maxThreads = GetNumberOfThreads();
+   }
+   if(( maxThreads <= 1 ) || ( operations < GetThreadingThreshold() )) {
+      return 1;
+   }
+   // Minimize `W / n + startupCost + perThreadCost * n`
+   ThreadingCalibration const& calibration = CurrentCalibration().Get();
+   if( calibration.perThreadCost <= 0 ) {
+      return maxThreads;
+   }
+   dfloat optimal = std::round( std::sqrt( static_cast< dfloat >( operations ) / calibration.perThreadCost ));
+   return clamp( static_cast< dip::uint >( optimal ), dip::uint( 2 ), maxThreads );
+}
+
+void ThrowIfCancelled() {
+   if( currentExecutionContext->IsCancelled() ) {
+      DIP_THROW_RUNTIME( E::OPERATION_CANCELLED );
+   }
+}
+
+std::shared_ptr< Executor > ThreadPoolExecutor() {
+   static std::shared_ptr< Executor > pool = std::make_shared< WorkStealingThreadPool >();
+   return pool;
+}
+
+std::shared_ptr< Executor > OpenMPExecutor() {
+   static std::shared_ptr< Executor > executor = std::make_shared< OpenMPExecutorImpl >();
+   return executor;
+}
+
+void SetExecutor( std::shared_ptr< Executor > executor ) {
+   std::atomic_store( &currentExecutor, std::move( executor ));
+}
+
+std::shared_ptr< Executor > GetExecutor() {
+   std::shared_ptr< Executor > executor = std::atomic_load( &currentExecutor );
+   return executor ? executor : ThreadPoolExecutor();
+}
+
+void ParallelRun( dip::uint nThreads, std::function< void( dip::uint thread ) > const& task ) {
+   ExecutionContext const& context = *currentExecutionContext;
+   if(( nThreads <= 1 ) || ( insideParallelTask && !context.allowNestedParallelism )) {
+      // Run inline. Exceptions are propagated directly.
+      for( dip::uint thread = 0; thread < nThreads; ++thread ) {
+         ThrowIfCancelled();
+         task( thread );
+      }
+      return;
+   }
+   AssertionError assertionError;
+   ParameterError parameterError;
+   RunTimeError runTimeError;
+   Error error;
+   std::mutex errorMutex;
+   auto wrapper = [ & ]( dip::uint thread ) {
+      ParallelTaskScope scope;
+      ScopedExecutionContext contextScope( context );
+      try {
+         ThrowIfCancelled();
+         task( thread );
+      } catch( dip::AssertionError const& e ) {
+         std::lock_guard< std::mutex > lock( errorMutex );
+         if( !assertionError.IsSet() ) {
+            assertionError = e;
+         }
+      } catch( dip::ParameterError const& e ) {
+         std::lock_guard< std::mutex > lock( errorMutex );
+         if( !parameterError.IsSet() ) {
+            parameterError = e;
+         }
+      } catch( dip::RunTimeError const& e ) {
+         std::lock_guard< std::mutex > lock( errorMutex );
+         if( !runTimeError.IsSet() ) {
+            runTimeError = e;
+         }
+      } catch( dip::Error const& e ) {
+         std::lock_guard< std::mutex > lock( errorMutex );
+         if( !error.IsSet() ) {
+            error = e;
+         }
+      } catch( std::exception const& stde ) {
+         std::lock_guard< std::mutex > lock( errorMutex );
+         if( !runTimeError.IsSet() ) {
+            runTimeError = dip::RunTimeError( stde.what() );
+         }
+      }
+   };
+   GetExecutor()->Run( nThreads, wrapper );
+   if( assertionError.IsSet() ) {
+      throw assertionError;
+   }
+   if( parameterError.IsSet() ) {
+      throw parameterError;
+   }
+   if( runTimeError.IsSet() ) {
+      throw runTimeError;
+   }
+   if( error.IsSet() ) {
+      throw error;
+   }
+}
+
 } // namespace dip
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/linear.h"
+#include "diplib/math.h"
+#include "diplib/statistics.h"
+#include "diplib/histogram.h"
+#include "diplib/regions.h"
+#include "diplib/measurement.h"
+#include "diplib/generation.h"
+#include "diplib/testing.h"
+
+namespace {
+
+class CountingExecutor : public dip::Executor {
+   public:
+      void Run( dip::uint nTasks, std::function< void( dip::uint ) > const& task ) override {
+         ++calls;
+         for( dip::uint ii = nTasks; ii > 0; --ii ) { // runs tasks in reverse order, which is allowed
+            task( ii - 1 );
+         }
+      }
+      dip::uint calls = 0;
+};
+
+} // namespace
+
+DOCTEST_TEST_CASE( "[DIPlib] testing dip::ParallelRun" ) {
+   for( auto const& executor : { dip::ThreadPoolExecutor(), dip::OpenMPExecutor() } ) {
+      dip::SetExecutor( executor );
+      DOCTEST_CHECK( dip::GetExecutor() == executor );
+      // Each task is run exactly once, nested calls run inline
+      constexpr dip::uint nTasks = 7;
+      std::vector< std::atomic< dip::uint >> counts( nTasks * nTasks );
+      dip::ParallelRun( nTasks, [ & ]( dip::uint outer ) {
+         dip::ParallelRun( nTasks, [ & ]( dip::uint inner ) {
+            ++counts[ outer * nTasks + inner ];
+         } );
+      } );
+      bool allOnce = true;
+      for( auto const& c : counts ) {
+         allOnce &= c.load() == 1;
+      }
+      DOCTEST_CHECK( allOnce );
+      // Exceptions are propagated to the caller
+      DOCTEST_CHECK_THROWS_AS( dip::ParallelRun( nTasks, []( dip::uint thread ) {
+         DIP_THROW_IF( thread == 3, dip::E::NOT_IMPLEMENTED );
+      } ), dip::ParameterError );
+   }
+   // A user-defined executor is used, but not for nested calls
+   auto counting = std::make_shared< CountingExecutor >();
+   dip::SetExecutor( counting );
+   dip::uint nested = 0;
+   dip::ParallelRun( 3, [ & ]( dip::uint ) {
+      DOCTEST_CHECK( dip::GetNumberOfThreads() == 1 );
+      dip::ParallelRun( 3, [ & ]( dip::uint ) { ++nested; } );
+   } );
+   DOCTEST_CHECK( counting->calls == 1 );
+   DOCTEST_CHECK( nested == 9 );
+   dip::SetExecutor( nullptr );
+   DOCTEST_CHECK( dip::GetExecutor() == dip::ThreadPoolExecutor() );
+}
+
+DOCTEST_TEST_CASE( "[DIPlib] testing dip::ExecutionContext" ) {
+   dip::uint nThreads = dip::GetNumberOfThreads();
+   DOCTEST_CHECK( dip::GetThreadingThreshold() == dip::defaultThreadingThreshold );
+   std::atomic< bool > cancel{ false };
+   dip::ExecutionContext context;
+   context.maxThreads = 1;
+   context.threadingThreshold = 100;
+   context.allowNestedParallelism = true;
+   context.cancelled = &cancel;
+   {
+      dip::ScopedExecutionContext scope( context );
+      DOCTEST_CHECK( dip::GetNumberOfThreads() == 1 );
+      DOCTEST_CHECK( dip::GetThreadingThreshold() == 100 );
+      {
+         // Scopes nest
+         dip::ExecutionContext inner;
+         dip::ScopedExecutionContext innerScope( inner );
+         DOCTEST_CHECK( dip::GetNumberOfThreads() == nThreads );
+         DOCTEST_CHECK( dip::GetThreadingThreshold() == dip::defaultThreadingThreshold );
+      }
+      DOCTEST_CHECK( dip::GetThreadingThreshold() == 100 );
+      // Tasks see the caller's context
+      dip::SetExecutor( dip::OpenMPExecutor() ); // guarantees the tasks run, even on a single core
+      dip::uint seenThreshold = 0;
+      dip::ParallelRun( 2, [ & ]( dip::uint thread ) {
+         if( thread == 1 ) {
+            seenThreshold = dip::GetThreadingThreshold();
+         }
+      } );
+      dip::SetExecutor( nullptr );
+      DOCTEST_CHECK( seenThreshold == 100 );
+      // Cancellation stops the frameworks
+      dip::Image img( { 50, 40 }, 1, dip::DT_SFLOAT );
+      img.Fill( 1.0 );
+      DOCTEST_CHECK_NOTHROW( dip::Gauss( img, { 2.0 } ));
+      cancel = true;
+      DOCTEST_CHECK_THROWS_AS( dip::Gauss( img, { 2.0 } ), dip::RunTimeError );
+      DOCTEST_CHECK_THROWS_AS( dip::ParallelRun( 2, []( dip::uint ) {} ), dip::RunTimeError );
+   }
+   DOCTEST_CHECK( !dip::GetExecutionContext().IsCancelled() );
+   DOCTEST_CHECK( dip::GetNumberOfThreads() == nThreads );
+}
+
+DOCTEST_TEST_CASE( "[DIPlib] testing that algorithms respect the executor and the execution context" ) {
+   dip::Random random( 0 );
+   dip::Image img( { 300, 200 }, 1, dip::DT_SFLOAT );
+   img.Fill( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 255.0 );
+   dip::Image label = dip::Label( img > 200, 2 );
+   std::vector< std::pair< char const*, std::function< void() >>> algorithms{
+         { "Projection", [ & ]() { dip::Image out = dip::Sum( img, {}, { false, true } ); } },
+         { "Label", [ & ]() { dip::Image out = dip::Label( img > 200, 2 ); } },
+         { "Histogram", [ & ]() { dip::Histogram out( img ); } },
+         { "Measure", [ & ]() { dip::MeasurementTool tool; auto out = tool.Measure( label, img, { "Mass", "Perimeter" } ); } }
+   };
+   dip::testing::FourThreads fourThreads;
+   auto executor = std::make_shared< dip::testing::RecordingExecutor >();
+   dip::SetExecutor( executor );
+   dip::ExecutionContext context;
+   context.threadingThreshold = 1; // go parallel even for this small image
+   for( auto const& algorithm : algorithms ) {
+      DOCTEST_INFO( algorithm.first );
+      {
+         // All parallel work goes through the executor
+         dip::ScopedExecutionContext scope( context );
+         executor->maxTasks = 0;
+         algorithm.second();
+#ifdef _OPENMP
+         DOCTEST_CHECK( executor->maxTasks > 1 );
+#endif
+      }
+      {
+         // The context limits the number of threads
+         dip::ExecutionContext single = context;
+         single.maxThreads = 1;
+         dip::ScopedExecutionContext scope( single );
+         executor->maxTasks = 0;
+         algorithm.second();
+         DOCTEST_CHECK( executor->maxTasks <= 1 );
+      }
+      {
+         // Within a task, the algorithm doesn't start parallel work of its own
+         dip::ScopedExecutionContext scope( context );
+         executor->calls = 0;
+         executor->maxTasks = 0;
+         dip::ParallelRun( 2, [ & ]( dip::uint ) { algorithm.second(); } );
+         DOCTEST_CHECK( executor->calls == 1 );
+         DOCTEST_CHECK( executor->maxTasks == 2 );
+      }
+   }
+}
+
+DOCTEST_TEST_CASE( "[DIPlib] testing the threading cost model" ) {
+   dip::ThreadingCalibration original = dip::GetThreadingCalibration();
+   dip::ThreadingCalibration calibration;
+   calibration.startupCost = 10000;
+   calibration.perThreadCost = 100;
+   dip::SetThreadingCalibration( calibration );
+   DOCTEST_CHECK( dip::GetThreadingThreshold() == 20400 );
+   DOCTEST_CHECK( dip::GetOptimalNumberOfThreads( 20000, 64 ) == 1 );
+   DOCTEST_CHECK( dip::GetOptimalNumberOfThreads( 40000, 64 ) == 20 );  // sqrt( 40000 / 100 )
+   DOCTEST_CHECK( dip::GetOptimalNumberOfThreads( 40000, 8 ) == 8 );
+   DOCTEST_CHECK( dip::GetOptimalNumberOfThreads( 40000, 1 ) == 1 );
+   DOCTEST_CHECK( dip::GetOptimalNumberOfThreads( 20500, 64 ) == 14 );
+   {
+      // The execution context overrides the threshold, but not the number of threads
+      dip::ExecutionContext context;
+      context.threadingThreshold = 100;
+      dip::ScopedExecutionContext scope( context );
+      DOCTEST_CHECK( dip::GetOptimalNumberOfThreads( 400, 64 ) == 2 );
+      DOCTEST_CHECK( dip::GetOptimalNumberOfThreads( 40000, 64 ) == 20 );
+   }
+   DOCTEST_CHECK_THROWS( dip::SetThreadingCalibration( { -1.0, 0.0 } ));
+   // Measuring gives sensible values, which are written to and read from file
+   dip::testing::TemporaryFile file( "dip_threading_calibration" );
+   dip::ThreadingCalibration measured = dip::CalibrateThreading( file.Path() );
+   DOCTEST_CHECK( measured.startupCost >= 0 );
+   DOCTEST_CHECK( measured.perThreadCost >= 0 );
+   dip::SetThreadingCalibration( calibration );
+   dip::LoadThreadingCalibration( file.Path() );
+   DOCTEST_CHECK( static_cast< dip::dfloat >( dip::GetThreadingCalibration().Threshold() ) ==
+                  doctest::Approx( static_cast< dip::dfloat >( measured.Threshold() )).epsilon( 1e-4 ));
+   dip::SetThreadingCalibration( original );
+}
+
+namespace {
+
+struct TestCalibrationTraits {
+   static dip::uint read;
+   static dip::uint measured;
+   static bool Read( dip::String const&, dip::dfloat& ) {
+      ++read;
+      return false;
+   }
+   static bool Write( dip::String const&, dip::dfloat const& ) { return true; }
+   static dip::dfloat Measure() {
+      ++measured;
+      return 1.0;
+   }
+};
+dip::uint TestCalibrationTraits::read = 0;
+dip::uint TestCalibrationTraits::measured = 0;
+
+} // namespace
+
+DOCTEST_TEST_CASE( "[DIPlib] testing lazy calibration" ) {
+   // The calibration is measured on first use, but not in a context with fewer threads
+#ifdef _WIN32
+   _putenv_s( "DIP_TEST_CALIBRATION", "dip_test_calibration" );
+#else
+   setenv( "DIP_TEST_CALIBRATION", "dip_test_calibration", 1 );
+#endif
+   dip::testing::FourThreads fourThreads;
+   dip::SetNumberOfThreads( 0 );
+   dip::detail::Calibration< dip::dfloat, TestCalibrationTraits > calibration( "DIP_TEST_CALIBRATION" );
+   {
+      dip::ExecutionContext context;
+      context.maxThreads = 1;
+      dip::ScopedExecutionContext scope( context );
+      DOCTEST_CHECK( calibration.Get() == 0.0 );
+   }
+   dip::SetNumberOfThreads( 1 );
+   DOCTEST_CHECK( calibration.Get() == 0.0 );
+   dip::SetNumberOfThreads( 0 );
+   dip::SetExecutor( dip::OpenMPExecutor() ); // guarantees the tasks run in parallel, even on a single core
+   std::atomic< dip::uint > calibrated{ 0 };
+   dip::ParallelRun( 2, [ & ]( dip::uint ) {
+      if( calibration.Get() != 0.0 ) {
+         ++calibrated;
+      }
+   } );
+   dip::SetExecutor( nullptr );
+   DOCTEST_CHECK( calibrated == 0 );
+   DOCTEST_CHECK( TestCalibrationTraits::measured == 0 );
+   DOCTEST_CHECK( TestCalibrationTraits::read == 1 ); // A file that couldn't be read is not read again
+#ifdef _OPENMP
+   DOCTEST_CHECK( calibration.Get() == 1.0 );
+   DOCTEST_CHECK( calibration.Get() == 1.0 );
+   DOCTEST_CHECK( TestCalibrationTraits::measured == 1 );
+#endif
+   // A calibration set explicitly is not replaced
+   dip::detail::Calibration< dip::dfloat, TestCalibrationTraits > preset( "DIP_TEST_CALIBRATION" );
+   preset.Set( 2.0 );
+   DOCTEST_CHECK( preset.Get() == 2.0 );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -0,0 +1,120 @@
+/*
+ * DIPlib 3.0
+ * This file contains unit tests for the union-find data structures.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib.h"
+#include "diplib/union_find.h"
+#include "diplib/multithreading.h"
+#include "diplib/random.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::ConcurrentUnionFind") {
+   constexpr dip::uint nElements = 20000;
+   constexpr dip::uint nTasks = 8;
+   constexpr dip::uint nUnionsPerTask = 2000;
+   dip::ExecutionContext context;
+   context.maxThreads = nTasks;
+   dip::ScopedExecutionContext scope( context );
+
+   // Random unions from many threads yield the same sets and labels as sequential unions
+   std::vector< std::vector< std::pair< dip::uint32, dip::uint32 >>> pairs( nTasks );
+   dip::Random random( 0 );
+   for( auto& list : pairs ) {
+      for( dip::uint ii = 0; ii < nUnionsPerTask; ++ii ) {
+         list.emplace_back( static_cast< dip::uint32 >( random() % nElements + 1 ), static_cast< dip::uint32 >( random() % nElements + 1 ));
+      }
+   }
+   dip::ConcurrentUnionFind< dip::uint32 > concurrent( nElements );
+   dip::ParallelRun( nTasks, [ & ]( dip::uint task ) {
+      for( auto const& p : pairs[ task ] ) {
+         concurrent.Union( p.first, p.second );
+      }
+   } );
+   dip::SimpleUnionFind< dip::uint32 > sequential( nElements );
+   for( auto const& list : pairs ) {
+      for( auto const& p : list ) {
+         sequential.Union( p.first, p.second );
+      }
+   }
+   bool sameRoots = true;
+   for( dip::uint32 ii = 1; ii <= nElements; ++ii ) {
+      sameRoots &= concurrent.FindRoot( ii ) == sequential.FindRoot( ii );
+   }
+   DOCTEST_CHECK( sameRoots );
+   dip::uint nLabels = concurrent.Relabel();
+   DOCTEST_CHECK( nLabels == sequential.Relabel() );
+   bool sameLabels = true;
+   for( dip::uint32 ii = 1; ii <= nElements; ++ii ) {
+      sameLabels &= concurrent.Label( ii ) == sequential.Label( ii );
+   }
+   DOCTEST_CHECK( sameLabels );
+
+   // Heavy contention: all threads join the same chain of elements, in different orders
+   dip::ConcurrentUnionFind< dip::uint > chain( nElements );
+   dip::ParallelRun( nTasks, [ & ]( dip::uint task ) {
+      for( dip::uint ii = task + 1; ii < nElements; ii += nTasks ) {
+         chain.Union( ii + 1, ii );
+      }
+      for( dip::uint ii = nElements - task; ii > 1; ii -= std::min( ii - 1, nTasks )) {
+         chain.Union( ii, ii - 1 );
+         chain.FindRoot( ii );
+      }
+   } );
+   bool allJoined = true;
+   for( dip::uint ii = 1; ii <= nElements; ++ii ) {
+      allJoined &= chain.FindRoot( ii ) == 1;
+   }
+   DOCTEST_CHECK( allJoined );
+   DOCTEST_CHECK( chain.Relabel() == 1 );
+
+   // Concurrent creation of elements
+   dip::ConcurrentUnionFind< dip::uint > growing( 10, 10 + nTasks * 100 );
+   std::vector< std::vector< dip::uint >> created( nTasks );
+   dip::ParallelRun( nTasks, [ & ]( dip::uint task ) {
+      for( dip::uint ii = 0; ii < 100; ++ii ) {
+         dip::uint index = growing.Create();
+         created[ task ].push_back( index );
+         growing.Union( index, created[ task ][ 0 ] );
+      }
+   } );
+   DOCTEST_CHECK( growing.Size() == 10 + nTasks * 100 );
+   std::vector< bool > seen( growing.Size() + 1, false );
+   bool unique = true;
+   for( auto const& list : created ) {
+      for( auto index : list ) {
+         unique &= ( index > 10 ) && !seen[ index ];
+         seen[ index ] = true;
+      }
+   }
+   DOCTEST_CHECK( unique );
+   DOCTEST_CHECK_THROWS( growing.Create() );
+   DOCTEST_CHECK( growing.Relabel() == 10 + nTasks );
+
+   // As many elements as the index type can represent
+   dip::ConcurrentUnionFind< dip::uint8 > full( 255 );
+   for( dip::uint ii = 2; ii < 255; ii += 2 ) {
+      full.Union( static_cast< dip::uint8 >( ii ), static_cast< dip::uint8 >( ii + 1 ));
+   }
+   DOCTEST_CHECK( full.Relabel() == 128 );
+   DOCTEST_CHECK( full.Label( 1 ) == 1 );
+   DOCTEST_CHECK( full.Label( 254 ) == 128 );
+   DOCTEST_CHECK( full.Label( 255 ) == 128 );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
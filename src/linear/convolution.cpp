@@ -26,6 +26,10 @@
 #include "diplib/framework.h"
 #include "diplib/pixel_table.h"
 #include "diplib/overload.h"
+#include "diplib/multithreading.h"
+#include "diplib/boundary.h"
+#include "diplib/library/cpu_dispatch.h"
+#include "../transform/fourier_support.h"
 
 namespace dip {
 
@@ -174,8 +178,49 @@ class SeparableConvolutionLineFilter : public Framework::SeparableLineFilter {
          static_assert( std::is_same< RealType< TPI >, RealType< TPF >>::value, "Filter type and image type don't match" );
          // If TPF is complex, so is TPI.
          static_assert( !( IsComplexType< TPF >::value && !IsComplexType< TPI >::value ), "Complex filter applied to non-complex data" );
+         // For processing blocks we use the full filter, as there is little to gain from the symmetry
+         // when the inner loop is over the lines in the block.
+         fullFilter_.resize( filter_.size() );
+         for( dip::uint ii = 0; ii < filter_.size(); ++ii ) {
+            fullFilter_[ ii ] = MakeFullFilter( filter_[ ii ] );
+         }
+      }
+      virtual bool ProcessesBlocks() override { return true; }
+      virtual void FilterBlock( Framework::SeparableBlockFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilterBlock( params ); } );
+      }
+      void DoFilterBlock( Framework::SeparableBlockFilterParameters const& params ) {
+         TPI const* in = static_cast< TPI const* >( params.inBuffer.buffer );
+         dip::uint length = params.inBuffer.length;
+         dip::sint inStride = params.inBuffer.stride;
+         TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
+         dip::sint outStride = params.outBuffer.stride;
+         dip::uint nLines = params.nLines;
+         dip::uint procDim = 0;
+         if( filter_.size() > 1 ) {
+            procDim = params.dimension;
+         }
+         std::vector< TPF > const& filter = fullFilter_[ procDim ].filter;
+         in -= static_cast< dip::sint >( fullFilter_[ procDim ].origin ) * inStride;
+         for( dip::uint ii = 0; ii < length; ++ii ) {
+            for( dip::uint jj = 0; jj < nLines; ++jj ) {
+               out[ jj ] = 0;
+            }
+            TPI const* in_t = in;
+            for( TPF f : filter ) {
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  out[ jj ] += f * in_t[ jj ];
+               }
+               in_t += inStride;
+            }
+            in += inStride;
+            out += outStride;
+         }
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilter( params ); } );
+      }
+      void DoFilter( Framework::SeparableLineFilterParameters const& params ) {
          TPI const* in = static_cast< TPI const* >( params.inBuffer.buffer );
          dip::uint length = params.inBuffer.length;
          DIP_ASSERT( params.inBuffer.stride == 1 );
@@ -293,6 +338,61 @@ class SeparableConvolutionLineFilter : public Framework::SeparableLineFilter {
       }
    private:
       InternOneDimensionalFilterArray const& filter_;
+      // The full filter, with all `filter.size` samples, and the offset of its first sample w.r.t. the output pixel
+      struct FullFilter {
+         std::vector< TPF > filter;
+         dip::uint origin;
+      };
+      std::vector< FullFilter > fullFilter_; // one for each filter in filter_
+
+      // Expands the symmetric filter representation, the result is applied the same way as in `Filter`
+      static FullFilter MakeFullFilter( InternOneDimensionalFilter const& filter ) {
+         FullFilter out{ std::vector< TPF >( filter.size ), filter.origin };
+         if( filter.size == 0 ) {
+            return out;
+         }
+         auto data = reinterpret_cast< TPF const* >( filter.filter.data() );
+         dip::uint n = filter.dataSize;
+         switch( filter.symmetry ) {
+            case FilterSymmetry::GENERAL:
+               std::copy( data, data + n, out.filter.begin() );
+               break;
+            case FilterSymmetry::EVEN:
+            case FilterSymmetry::ODD:
+            case FilterSymmetry::CONJ:
+               // Samples are stored from the center outwards, the center is at `n - 1`
+               for( dip::uint ii = 1; ii < n; ++ii ) {
+                  out.filter[ n - 1 + ii ] = data[ ii ];
+                  out.filter[ n - 1 - ii ] = Mirrored( data[ ii ], filter.symmetry );
+               }
+               out.filter[ n - 1 ] = data[ 0 ];
+               break;
+            case FilterSymmetry::D_EVEN:
+            case FilterSymmetry::D_ODD:
+            case FilterSymmetry::D_CONJ:
+               // Samples are stored from the center outwards, the center is between `n - 1` and `n`,
+               // and `Filter` reads one sample further to the left than the origin indicates
+               for( dip::uint ii = 0; ii < n; ++ii ) {
+                  out.filter[ n + ii ] = data[ ii ];
+                  out.filter[ n - 1 - ii ] = Mirrored( data[ ii ], filter.symmetry );
+               }
+               ++out.origin;
+               break;
+         }
+         return out;
+      }
+      static TPF Mirrored( TPF value, FilterSymmetry symmetry ) {
+         switch( symmetry ) {
+            case FilterSymmetry::ODD:
+            case FilterSymmetry::D_ODD:
+               return -value;
+            case FilterSymmetry::CONJ:
+            case FilterSymmetry::D_CONJ:
+               return conjugate( value );
+            default:
+               return value;
+         }
+      }
 };
 
 inline bool IsMeaninglessFilter( InternOneDimensionalFilter const& filter ) {
@@ -432,11 +532,18 @@ void ConvolveFT(
    bool outSpatial;
    DIP_STACK_TRACE_THIS( outSpatial = BooleanFromString( outRepresentation, S::SPATIAL, S::FREQUENCY ));
    bool real = true;
+   // If input, filter and output are real-valued, we need to compute only half of the frequency domain
+   bool half = inSpatial && filterSpatial && outSpatial && in.DataType().IsReal() && filter.DataType().IsReal();
+   StringSet options;
+   if( half ) {
+      options.insert( S::HALF );
+   }
+   UnsignedArray sizes = in.Sizes();
    Image inFT;
    bool reuseInFT = false;
    if( inSpatial ) {
       real &= in.DataType().IsReal();
-      DIP_STACK_TRACE_THIS( FourierTransform( in, inFT ));
+      DIP_STACK_TRACE_THIS( FourierTransform( in, inFT, options ));
       reuseInFT = true;
    } else {
       real = false;
@@ -455,10 +562,10 @@ void ConvolveFT(
    if( filterSpatial ) {
       real &= filterFT.DataType().IsReal();
       if( reuseFilterFT ) {
-         DIP_STACK_TRACE_THIS( FourierTransform( filterFT, filterFT ));
+         DIP_STACK_TRACE_THIS( FourierTransform( filterFT, filterFT, options ));
       } else {
          Image tmp;
-         DIP_STACK_TRACE_THIS( FourierTransform( filterFT, tmp ));
+         DIP_STACK_TRACE_THIS( FourierTransform( filterFT, tmp, options ));
          filterFT.swap( tmp );
          reuseFilterFT = true;
       }
@@ -482,11 +589,15 @@ void ConvolveFT(
    }
    DIP_STACK_TRACE_THIS( MultiplySampleWise( inFT, filterFT, outFT ));
    if( outSpatial ) {
-      StringSet options{ S::INVERSE };
+      options.insert( S::INVERSE );
       if( real ) {
          options.insert( S::REAL );
       }
-      DIP_STACK_TRACE_THIS( FourierTransform( outFT, out, options ));
+      if( half ) {
+         DIP_STACK_TRACE_THIS( HalfInverseFourierTransform( outFT, out, sizes, options ));
+      } else {
+         DIP_STACK_TRACE_THIS( FourierTransform( outFT, out, options ));
+      }
    }
 }
 
@@ -500,6 +611,9 @@ class GeneralConvolutionLineFilter : public Framework::FullLineFilter {
          offsets_ = pixelTable.Offsets();
       }
       virtual void Filter( Framework::FullLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilter( params ); } );
+      }
+      void DoFilter( Framework::FullLineFilterParameters const& params ) {
          TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
          dip::sint inStride = params.inBuffer.stride;
          TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
@@ -525,6 +639,201 @@ class GeneralConvolutionLineFilter : public Framework::FullLineFilter {
       std::vector< dip::sint > offsets_;
 };
 
+// Approximate costs in operations (clock cycles) per pixel, used to choose between the direct convolution and
+// the overlap-save convolution.
+constexpr dfloat directConvolutionCostPerWeight = 1.0;      // one multiply-add per filter weight per pixel
+constexpr dfloat fourierCostPerPixelPerStage = 5.0;         // per pixel per radix-2 stage, for each transform
+constexpr dfloat overlapSaveCostPerPixel = 20.0;            // copying data in and out, multiplying spectra
+constexpr dip::uint maxOverlapSaveBlockPixels = 1u << 20u;  // limits the memory used by each thread
+
+// Computes the cost of the overlap-save convolution in operations per output pixel, for blocks of size `blockSizes`.
+dfloat OverlapSaveCost(
+      UnsignedArray const& imageSizes,
+      UnsignedArray const& kernelSizes,
+      UnsignedArray const& blockSizes,
+      bool isReal
+) {
+   dfloat blockPixels = 1.0;
+   dfloat outputPixels = 1.0;
+   dfloat stages = 0.0;
+   for( dip::uint ii = 0; ii < blockSizes.size(); ++ii ) {
+      blockPixels *= static_cast< dfloat >( blockSizes[ ii ] );
+      outputPixels *= static_cast< dfloat >( std::min( blockSizes[ ii ] - kernelSizes[ ii ] + 1, imageSizes[ ii ] ));
+      stages += std::log2( static_cast< dfloat >( blockSizes[ ii ] ));
+   }
+   // Forward and inverse transform; the transform of real data costs about half as much
+   dfloat transformCost = 2.0 * fourierCostPerPixelPerStage * stages * ( isReal ? 0.5 : 1.0 );
+   return blockPixels * ( transformCost + overlapSaveCostPerPixel ) / outputPixels;
+}
+
+// Finds the block sizes that minimize the cost of the overlap-save convolution. Returns the cost.
+dfloat ChooseOverlapSaveBlockSizes(
+      UnsignedArray const& imageSizes,
+      UnsignedArray const& kernelSizes,
+      bool isReal,
+      UnsignedArray& blockSizes
+) {
+   dip::uint nDims = imageSizes.size();
+   // Candidate sizes along each dimension: a few multiples of the kernel size, and the size that fits the whole image
+   std::vector< UnsignedArray > candidates( nDims );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      dip::uint largest = OptimalFourierTransformSize( imageSizes[ ii ] + kernelSizes[ ii ] - 1 );
+      for( dip::uint factor : { 2u, 3u, 4u, 6u, 8u, 12u, 16u } ) {
+         dip::uint size = OptimalFourierTransformSize( std::max( factor * kernelSizes[ ii ], dip::uint( 8 )));
+         if( size >= largest ) {
+            break;
+         }
+         if( candidates[ ii ].empty() || ( candidates[ ii ].back() != size )) {
+            candidates[ ii ].push_back( size );
+         }
+      }
+      candidates[ ii ].push_back( largest );
+   }
+   // Try all combinations
+   dfloat bestCost = std::numeric_limits< dfloat >::infinity();
+   UnsignedArray index( nDims, 0 );
+   UnsignedArray sizes( nDims );
+   while( true ) {
+      dip::uint blockPixels = 1;
+      for( dip::uint ii = 0; ii < nDims; ++ii ) {
+         sizes[ ii ] = candidates[ ii ][ index[ ii ]];
+         blockPixels *= sizes[ ii ];
+      }
+      if( blockPixels <= maxOverlapSaveBlockPixels ) {
+         dfloat cost = OverlapSaveCost( imageSizes, kernelSizes, sizes, isReal );
+         if( cost < bestCost ) {
+            bestCost = cost;
+            blockSizes = sizes;
+         }
+      }
+      dip::uint dd = 0;
+      for( ; dd < nDims; ++dd ) {
+         if( ++index[ dd ] < candidates[ dd ].size() ) {
+            break;
+         }
+         index[ dd ] = 0;
+      }
+      if( dd == nDims ) {
+         break;
+      }
+   }
+   return bestCost;
+}
+
+// Returns true if the overlap-save convolution is cheaper than the direct convolution sum with `filter`, whose
+// image has sizes `filterSizes` (with the same dimensionality as the image). If so, `blockSizes` is set.
+bool UseOverlapSave(
+      UnsignedArray const& imageSizes,
+      Kernel const& filter,
+      UnsignedArray const& filterSizes,
+      bool isReal,
+      UnsignedArray& blockSizes
+) {
+   dfloat directCost = directConvolutionCostPerWeight * static_cast< dfloat >( filter.NumberOfPixels( imageSizes.size() ));
+   dfloat overlapSaveCost = ChooseOverlapSaveBlockSizes( imageSizes, filterSizes, isReal, blockSizes );
+   return overlapSaveCost < directCost;
+}
+
+// Computes the convolution of scalar image `in` with real-valued `filter`, using the overlap-save method: the image
+// is divided into blocks of size `blockSizes` (overlapping by the size of the filter minus one), each block is
+// convolved through the Fourier domain, and the part of the result not affected by the circular wrap-around is
+// written to `out`. The blocks are processed in parallel. `out` must be forged, with the same sizes as `in`.
+void OverlapSaveConvolution(
+      Image const& in,
+      Image const& filter,
+      Image& out,
+      BoundaryConditionArray const& bc,
+      UnsignedArray const& blockSizes,
+      DataType dtype
+) {
+   dip::uint nDims = in.Dimensionality();
+   UnsignedArray kernelSizes = filter.Sizes();
+   UnsignedArray border( nDims );
+   UnsignedArray validSizes( nDims );  // the number of output pixels computed by each block
+   UnsignedArray nBlocks( nDims );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      border[ ii ] = kernelSizes[ ii ] / 2;
+      validSizes[ ii ] = blockSizes[ ii ] - kernelSizes[ ii ] + 1;
+      nBlocks[ ii ] = div_ceil( in.Size( ii ), validSizes[ ii ] );
+   }
+   Image extended;
+   DIP_STACK_TRACE_THIS( ExtendImage( in, extended, border, bc ));
+   // The filter's origin is in its middle, the output pixel at `x` gets the filter origin at `x + border` in
+   // `extended`; the block for output pixels from `x` starts at `x + 2 * border - kernelSizes + 1`.
+   IntegerArray blockShift( nDims );
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      blockShift[ ii ] = static_cast< dip::sint >( 2 * border[ ii ] + 1 ) - static_cast< dip::sint >( kernelSizes[ ii ] );
+   }
+   // Transform the filter, padded to the block size with the origin in the corner
+   bool isReal = !dtype.IsComplex();
+   StringSet options{ S::CORNER };
+   if( isReal ) {
+      options.insert( S::HALF );
+   }
+   Image filterFT;
+   {
+      Image padded( blockSizes, 1, dtype.Real() );
+      padded.Fill( 0 );
+      RangeArray window( nDims );
+      for( dip::uint ii = 0; ii < nDims; ++ii ) {
+         window[ ii ].stop = static_cast< dip::sint >( kernelSizes[ ii ] ) - 1;
+      }
+      Image dest = padded.At( window );
+      dest.Copy( filter );
+      DIP_STACK_TRACE_THIS( FourierTransform( padded, filterFT, options ));
+   }
+   // Process the blocks
+   dip::uint totalBlocks = nBlocks.product();
+   dfloat operations = OverlapSaveCost( in.Sizes(), kernelSizes, blockSizes, isReal ) * static_cast< dfloat >( in.NumberOfPixels() );
+   dip::uint nThreads = std::min( GetOptimalNumberOfThreads( static_cast< dip::uint >( operations )), totalBlocks );
+   std::atomic< dip::uint > next{ 0 };
+   auto task = [ & ]( dip::uint ) {
+      Image block( blockSizes, 1, dtype );
+      Image blockFT;
+      Image result( blockSizes, 1, dtype );
+      for( dip::uint index = next++; index < totalBlocks; index = next++ ) {
+         ThrowIfCancelled();
+         // Find the block's location
+         RangeArray outWindow( nDims );
+         RangeArray inWindow( nDims );
+         RangeArray blockWindow( nDims );
+         RangeArray resultWindow( nDims );
+         dip::uint rest = index;
+         for( dip::uint ii = 0; ii < nDims; ++ii ) {
+            dip::uint start = ( rest % nBlocks[ ii ] ) * validSizes[ ii ];
+            rest /= nBlocks[ ii ];
+            dip::uint length = std::min( validSizes[ ii ], in.Size( ii ) - start );
+            outWindow[ ii ] = Range{ static_cast< dip::sint >( start ), static_cast< dip::sint >( start + length - 1 ) };
+            dip::sint inStart = static_cast< dip::sint >( start ) + blockShift[ ii ];
+            dip::sint inStop = std::min( inStart + static_cast< dip::sint >( blockSizes[ ii ] ),
+                                         static_cast< dip::sint >( extended.Size( ii ))) - 1;
+            inWindow[ ii ] = Range{ inStart, inStop };
+            blockWindow[ ii ] = Range{ 0, inStop - inStart };
+            dip::sint resultStart = static_cast< dip::sint >( kernelSizes[ ii ] ) - 1;
+            resultWindow[ ii ] = Range{ resultStart, resultStart + static_cast< dip::sint >( length ) - 1 };
+         }
+         // Convolve the block
+         block.Fill( 0 );
+         Image dest = block.At( blockWindow );
+         dest.Copy( extended.At( inWindow ));
+         FourierTransform( block, blockFT, options );
+         MultiplySampleWise( blockFT, filterFT, blockFT );
+         if( isReal ) {
+            HalfInverseFourierTransform( blockFT, result, blockSizes, options );
+         } else {
+            FourierTransform( blockFT, result, { S::CORNER, S::INVERSE } );
+         }
+         dest = out.At( outWindow );
+         dest.Copy( result.At( resultWindow ));
+      }
+   };
+   if( nThreads > 1 ) {
+      DIP_STACK_TRACE_THIS( ParallelRun( nThreads, task ));
+   } else {
+      DIP_STACK_TRACE_THIS( task( 0 ));
+   }
+}
+
 } // namespace
 
 void GeneralConvolution(
@@ -545,6 +854,29 @@ void GeneralConvolution(
       }
       BoundaryConditionArray bc = StringArrayToBoundaryConditionArray( boundaryCondition );
       DataType dtype = DataType::SuggestFlex( in.DataType() );
+      // For large filters, the overlap-save method is cheaper
+      if( c_filter.IsScalar() && c_filter.DataType().IsReal() && ( c_filter.Dimensionality() <= in.Dimensionality() )) {
+         Image c_filterExpanded = c_filter.QuickCopy();
+         c_filterExpanded.ExpandDimensionality( in.Dimensionality() );
+         UnsignedArray blockSizes;
+         if( UseOverlapSave( in.Sizes(), filter, c_filterExpanded.Sizes(), !dtype.IsComplex(), blockSizes )) {
+            Image c_in = in.QuickCopy();
+            PixelSize pixelSize = in.PixelSize();
+            String colorSpace = in.ColorSpace();
+            Tensor tensor = in.Tensor();
+            // If `out` is `in`, the data is not overwritten before it is read: each tensor element is copied
+            // into a boundary-extended image before its output is written
+            out.ReForge( c_in.Sizes(), c_in.TensorElements(), dtype, Option::AcceptDataTypeChange::DO_ALLOW );
+            for( dip::uint ii = 0; ii < c_in.TensorElements(); ++ii ) {
+               Image outElement = out[ ii ];
+               OverlapSaveConvolution( c_in[ ii ], c_filterExpanded, outElement, bc, blockSizes, dtype );
+            }
+            out.ReshapeTensor( tensor );
+            out.SetPixelSize( pixelSize );
+            out.SetColorSpace( colorSpace );
+            return;
+         }
+      }
       std::unique_ptr< Framework::FullLineFilter > lineFilter;
       DIP_OVL_NEW_FLEX( lineFilter, GeneralConvolutionLineFilter, (), dtype );
       Framework::Full( in, out, dtype, dtype, dtype, 1, bc, filter, *lineFilter, Framework::FullOption::AsScalarImage );
@@ -647,6 +979,40 @@ DOCTEST_TEST_CASE("[DIPlib] testing the separable convolution") {
    DOCTEST_CHECK( dip::Mean( out1 - out2 ).As< dip::dfloat >() / meanval == doctest::Approx( 0.0 ));
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the direct convolution with a non-symmetric filter") {
+   // The filter must not be applied as a correlation, compare to ConvolveFT with a periodic boundary condition
+   dip::Image img{ dip::UnsignedArray{ 40, 30 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 100.0 );
+   dip::Image filter{ dip::UnsignedArray{ 5, 3 }, 1, dip::DT_SFLOAT };
+   filter.Fill( 0 );
+   dip::UniformNoise( filter, filter, random, 0.0, 1.0 );
+   dip::UnsignedArray blockSizes;
+   DOCTEST_REQUIRE( !dip::UseOverlapSave( img.Sizes(), dip::Kernel{ filter }, filter.Sizes(), true, blockSizes ));
+   dip::Image out1 = dip::GeneralConvolution( img, filter, { "periodic" } );
+   dip::Image out2 = dip::ConvolveFT( img, filter );
+   DOCTEST_CHECK( dip::MaximumAbs( out1 - out2 ).As< dip::dfloat >() / dip::MaximumAbs( out2 ).As< dip::dfloat >() < 1e-5 );
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing the overlap-save convolution") {
+   // Large filters use the overlap-save method, compare to ConvolveFT with a periodic boundary condition
+   dip::Image img{ dip::UnsignedArray{ 70, 52 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 100.0 );
+   for( auto sizes : { dip::UnsignedArray{ 21, 17 }, dip::UnsignedArray{ 20, 16 }, dip::UnsignedArray{ 41, 5 }} ) {
+      dip::Image filter{ sizes, 1, dip::DT_SFLOAT };
+      filter.Fill( 0 );
+      dip::UniformNoise( filter, filter, random, 0.0, 1.0 );
+      dip::UnsignedArray blockSizes;
+      DOCTEST_REQUIRE( dip::UseOverlapSave( img.Sizes(), dip::Kernel{ filter }, sizes, true, blockSizes ));
+      dip::Image out1 = dip::GeneralConvolution( img, filter, { "periodic" } );
+      dip::Image out2 = dip::ConvolveFT( img, filter );
+      DOCTEST_CHECK( dip::MaximumAbs( out1 - out2 ).As< dip::dfloat >() / dip::MaximumAbs( out2 ).As< dip::dfloat >() < 1e-5 );
+   }
+}
+
 DOCTEST_TEST_CASE("[DIPlib] testing ConvolveFT") {
    dip::Image img{ dip::UnsignedArray{ 16, 8 }, 1, dip::DT_SFLOAT };
    img.Fill( 10 );
@@ -35,28 +35,15 @@ void GaussDispatch(
       StringArray const& boundaryCondition,
       dfloat truncation
 ) {
-   // If any( sigmas < 0.8 ) || any( derivativeOrder > 3 )  ==>  FT
-   // Else if any( sigmas > 10 )  ==>  IIR
-   // Else ==>  FIR
-   for( dip::uint ii = 0; ii < derivativeOrder.size(); ++ii ) { // We can't fold this loop in with the next one, the two arrays might be of different size
-      if( derivativeOrder[ ii ] > 3 ) {
-         GaussFT( in, out, sigmas, derivativeOrder, truncation ); // ignores boundaryCondition
-         return;
-      }
-   }
-   for( dip::uint ii = 0; ii < sigmas.size(); ++ii ) {
-      if(( sigmas[ ii ] < 0.8 ) && ( sigmas[ ii ] > 0.0 )) {
-         GaussFT( in, out, sigmas, derivativeOrder, truncation ); // ignores boundaryCondition
-         return;
-      }
-   }
-   for( dip::uint ii = 0; ii < sigmas.size(); ++ii ) {
-      if( sigmas[ ii ] > 10 ) {
-         GaussIIR( in, out, sigmas, derivativeOrder, boundaryCondition, {}, S::DISCRETE_TIME_FIT, truncation );
-         return;
-      }
+   String method;
+   DIP_STACK_TRACE_THIS( method = PredictGaussTimes( in, sigmas, derivativeOrder, boundaryCondition, truncation ).method );
+   if( method == "FT" ) {
+      GaussFT( in, out, sigmas, derivativeOrder, truncation ); // ignores boundaryCondition
+   } else if( method == "IIR" ) {
+      GaussIIR( in, out, sigmas, derivativeOrder, boundaryCondition, {}, S::DISCRETE_TIME_FIT, truncation );
+   } else {
+      GaussFIR( in, out, sigmas, derivativeOrder, boundaryCondition, truncation );
    }
-   GaussFIR( in, out, sigmas, derivativeOrder, boundaryCondition, truncation );
 }
 
 } // namespace
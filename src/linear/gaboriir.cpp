@@ -130,10 +130,15 @@ public:
    virtual void SetNumberOfThreads( dip::uint threads ) override {
       buffers_.resize( threads );
    }
-   virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint /*procDim*/ ) override {
-      // TODO: figure out how filter parameters affect amount of computation
-      //GaborIIRParams const& fParams = filterParams_[ procDim ];
-      return lineLength * 40;
+   virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint procDim ) override {
+      // A forward and a backward recursion over the line plus its borders, each doing one complex multiply-add
+      // (8 operations) per auto-regressive and moving-average term.
+      GaborIIRParams const& fParams = filterParams_[ procDim ];
+      auto const& orderMA = fParams.iir_order_num;
+      auto const& orderAR = fParams.iir_order_den;
+      dip::uint terms = ( orderAR[ 2 ] - orderAR[ 1 ] + 1 ) + ( orderAR[ 5 ] - orderAR[ 4 ] + 1 )
+                      + ( orderMA[ 2 ] - orderMA[ 1 ] + 1 ) + ( orderMA[ 5 ] - orderMA[ 4 ] + 1 );
+      return ( lineLength + 2 * fParams.border ) * ( 8 * terms + 4 );
    }
    virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
       dcomplex* in = static_cast< dcomplex* >(params.inBuffer.buffer);
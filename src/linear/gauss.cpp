@@ -25,6 +25,7 @@
 #include "diplib/overload.h"
 #include "diplib/transform.h"
 #include "diplib/iterators.h"
+#include "../transform/fourier_support.h"
 
 namespace dip {
 
@@ -378,18 +379,25 @@ void GaussFT(
    }
    if( sigmas.any() || order.any() ) {
       bool isreal = !in.DataType().IsComplex();
-      Image ft = FourierTransform( in );
+      UnsignedArray sizes = in.Sizes();
+      // For real-valued input, we only need half of the frequency domain, the filter is symmetric
+      StringSet opts;
+      if( isreal ) {
+         opts.emplace( S::HALF );
+      }
+      Image ft = FourierTransform( in, opts );
       DataType dtype = DataType::SuggestComplex( ft.DataType() );
       std::unique_ptr< Framework::ScanLineFilter > scanLineFilter;
-      DIP_OVL_NEW_COMPLEX( scanLineFilter, GaussFTLineFilter, ( in.Sizes(), sigmas, order, truncation ), dtype );
+      DIP_OVL_NEW_COMPLEX( scanLineFilter, GaussFTLineFilter, ( sizes, sigmas, order, truncation ), dtype );
       Framework::ScanMonadic(
             ft, ft, dtype, dtype, 1, *scanLineFilter,
             Framework::ScanOption::TensorAsSpatialDim + Framework::ScanOption::NeedCoordinates );
-      StringSet opts = { S::INVERSE };
+      opts.emplace( S::INVERSE );
       if( isreal ) {
-         opts.emplace( S::REAL );
+         HalfInverseFourierTransform( ft, out, sizes, opts );
+      } else {
+         FourierTransform( ft, out, opts );
       }
-      FourierTransform( ft, out, opts );
    } else {
       out = in;
    }
@@ -0,0 +1,476 @@
+/*
+ * DIPlib 3.0
+ * This file contains the cost model used to choose between the FIR, IIR and FT Gaussian filters.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#include "diplib.h"
+#include "diplib/linear.h"
+#include "diplib/boundary.h"
+#include "diplib/generation.h"
+#include "diplib/multithreading.h"
+#include "../library/calibration.h"
+
+namespace dip {
+
+namespace {
+
+// Accuracy limits of the FIR and IIR methods, see the documentation for `dip::Gauss`
+constexpr dfloat firMinimumSigma = 0.8;
+constexpr dfloat iirMinimumSigma = 2.0;
+constexpr dip::uint maximumDerivativeOrder = 3;
+
+// Used to translate predicted times into the operations that `dip::GetOptimalNumberOfThreads` expects,
+// this is roughly the clock rate in GHz.
+constexpr dfloat operationsPerNanosecond = 3.0;
+
+std::istream& operator>>( std::istream& stream, GaussCalibration::Costs& costs ) {
+   return stream >> costs.firPerPixel >> costs.firPerWeight >> costs.iirPerPixel >> costs.iirPerFilterOrder
+                 >> costs.ftPerPixel >> costs.ftPerPixelPerStage;
+}
+
+std::ostream& operator<<( std::ostream& stream, GaussCalibration::Costs const& costs ) {
+   return stream << costs.firPerPixel << ' ' << costs.firPerWeight << ' ' << costs.iirPerPixel << ' '
+                 << costs.iirPerFilterOrder << ' ' << costs.ftPerPixel << ' ' << costs.ftPerPixelPerStage;
+}
+
+bool ReadCalibration( String const& filename, GaussCalibration& calibration ) {
+   std::ifstream file( filename );
+   return static_cast< bool >( file >> calibration.singlePrecision >> calibration.doublePrecision
+                                    >> calibration.firParallelFraction >> calibration.iirParallelFraction
+                                    >> calibration.ftParallelFraction );
+}
+
+bool WriteCalibration( String const& filename, GaussCalibration const& calibration ) {
+   std::ofstream file( filename );
+   return static_cast< bool >( file << calibration.singlePrecision << '\n' << calibration.doublePrecision << '\n'
+                                    << calibration.firParallelFraction << ' ' << calibration.iirParallelFraction << ' '
+                                    << calibration.ftParallelFraction << '\n' );
+}
+
+// The terms of the cost model for one method: the time is `a * costA + b * costB` nanoseconds.
+struct CostTerms {
+   dfloat a = 0;
+   dfloat b = 0;
+};
+
+// Size of the FIR kernel, as computed by `MakeHalfGaussian` in gauss.cpp
+dip::uint FIRKernelHalfSize( dfloat sigma, dip::uint order, dfloat truncation ) {
+   dip::uint halfSize = clamp_cast< dip::uint >( std::ceil(( truncation + 0.5 * static_cast< dfloat >( order )) * sigma ));
+   return ( order > 2 ) ? std::max( halfSize, dip::uint( 1 )) : halfSize;
+}
+
+// Boundary extension of the IIR filter, as computed by `FillGaussIIRParams` in gaussiir.cpp
+dip::uint IIRBorder( dfloat sigma, dfloat truncation ) {
+   return std::max< dip::uint >( 5, static_cast< dip::uint >( sigma * truncation + 0.5 ));
+}
+
+// The terms are in units of pixels: `a` is the number of pixels processed, `b` is the number of
+// multiplications with a kernel weight (FIR), or pixels times filter order (IIR), or pixels times
+// radix-2 stages (FT).
+CostTerms FIRTerms( UnsignedArray const& sizes, FloatArray const& sigmas, UnsignedArray const& order, dfloat truncation ) {
+   dfloat nPixels = static_cast< dfloat >( sizes.product() );
+   CostTerms terms;
+   for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+      if(( sigmas[ ii ] > 0.0 ) && ( sizes[ ii ] > 1 )) {
+         dfloat length = static_cast< dfloat >( sizes[ ii ] );
+         dfloat halfSize = static_cast< dfloat >( FIRKernelHalfSize( sigmas[ ii ], order[ ii ], truncation ));
+         terms.a += nPixels * ( length + 2 * halfSize ) / length;
+         terms.b += nPixels * ( 2 * halfSize + 1 );
+      }
+   }
+   return terms;
+}
+
+CostTerms IIRTerms( UnsignedArray const& sizes, FloatArray const& sigmas, UnsignedArray const& order,
+                    UnsignedArray const& filterOrder, dfloat truncation ) {
+   dfloat nPixels = static_cast< dfloat >( sizes.product() );
+   CostTerms terms;
+   for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+      if(( sigmas[ ii ] > 0.0 ) && ( sizes[ ii ] > 1 )) {
+         dfloat length = static_cast< dfloat >( sizes[ ii ] );
+         dfloat border = static_cast< dfloat >( IIRBorder( sigmas[ ii ], truncation ));
+         dfloat pixels = nPixels * ( length + 2 * border ) / length;
+         dip::uint fOrder = filterOrder.empty() ? (( order[ ii ] > 2 ) ? 5 : order[ ii ] + 3 ) : filterOrder[ ii ];
+         terms.a += pixels;
+         terms.b += pixels * static_cast< dfloat >( fOrder );
+      }
+   }
+   return terms;
+}
+
+CostTerms FTTerms( UnsignedArray const& sizes ) {
+   dfloat nPixels = static_cast< dfloat >( sizes.product() );
+   dfloat stages = 0;
+   for( auto size : sizes ) {
+      if( size > 1 ) {
+         stages += std::log2( static_cast< dfloat >( size ));
+      }
+   }
+   return { nPixels, nPixels * stages };
+}
+
+// Converts the sequential time in nanoseconds into the time in seconds using the threads that the
+// algorithm will use
+dfloat ParallelTime( dfloat nanoseconds, dfloat parallelFraction ) {
+   dfloat operations = std::min( nanoseconds * operationsPerNanosecond, static_cast< dfloat >( maxint ));
+   dip::uint nThreads = GetOptimalNumberOfThreads( static_cast< dip::uint >( operations ));
+   return nanoseconds * 1e-9 * (( 1.0 - parallelFraction ) + parallelFraction / static_cast< dfloat >( nThreads ));
+}
+
+using Clock = std::chrono::steady_clock;
+
+// Runs `func` `repetitions` times, and returns the shortest time in nanoseconds
+template< typename F >
+dfloat ShortestTime( dip::uint repetitions, F const& func ) {
+   dfloat best = std::numeric_limits< dfloat >::max();
+   for( dip::uint ii = 0; ii < repetitions; ++ii ) {
+      auto start = Clock::now();
+      func();
+      best = std::min( best, std::chrono::duration< dfloat, std::nano >( Clock::now() - start ).count() );
+   }
+   return best;
+}
+
+// Finds `x` and `y` such that `x * terms1.a + y * terms1.b = time1` and `x * terms2.a + y * terms2.b = time2`.
+// Values are not allowed to be negative, which can happen with noisy timings.
+void SolveCosts( CostTerms terms1, dfloat time1, CostTerms terms2, dfloat time2, dfloat& x, dfloat& y ) {
+   dfloat det = terms1.a * terms2.b - terms1.b * terms2.a;
+   y = ( terms1.a * time2 - terms2.a * time1 ) / det;
+   x = ( time1 - y * terms1.b ) / terms1.a;
+   if( y < 0 ) {
+      y = 0;
+      x = ( time1 + time2 ) / ( terms1.a + terms2.a );
+   } else if( x < 0 ) {
+      x = 0;
+      y = ( time1 + time2 ) / ( terms1.b + terms2.b );
+   }
+}
+
+// Amdahl's law: `parallelTime = sequentialTime * (( 1 - p ) + p / nThreads )`
+dfloat ParallelFraction( dfloat sequentialTime, dfloat parallelTime, dip::uint nThreads ) {
+   dfloat p = ( 1.0 - parallelTime / sequentialTime ) / ( 1.0 - 1.0 / static_cast< dfloat >( nThreads ));
+   return clamp( p, 0.0, 1.0 );
+}
+
+// Measures the cost model parameters with the threads available to the caller
+GaussCalibration MeasureGaussCalibration() {
+   GaussCalibration calibration;
+   constexpr dip::uint repetitions = 3;
+   UnsignedArray sizes{ 256, 256 };
+   FloatArray sigmasSmall{ 1.0, 0.0 };
+   FloatArray sigmasLarge{ 8.0, 0.0 };
+   FloatArray sigmasIIR{ 5.0, 0.0 };
+   UnsignedArray order{ 0, 0 };
+   UnsignedArray ftSizesSmall{ 64, 64 };
+   UnsignedArray ftSizesLarge{ 512, 512 };
+   Random random( 0 );
+   Image out;
+   dip::uint maxThreads = GetNumberOfThreads();
+   dfloat firSequential = 0;
+   dfloat iirSequential = 0;
+   dfloat ftSequential = 0;
+   {
+      ExecutionContext context = GetExecutionContext();
+      context.maxThreads = 1;
+      ScopedExecutionContext scope( context );
+      for( DataType dataType : { DT_SFLOAT, DT_DFLOAT } ) {
+         GaussCalibration::Costs& costs = dataType == DT_SFLOAT ? calibration.singlePrecision : calibration.doublePrecision;
+         Image img( sizes, 1, dataType );
+         img.Fill( 0 );
+         UniformNoise( img, img, random );
+         // FIR: two kernel sizes along one dimension
+         dfloat firSmall = ShortestTime( repetitions, [ & ]() { GaussFIR( img, out, sigmasSmall, order ); } );
+         dfloat firLarge = ShortestTime( repetitions, [ & ]() { GaussFIR( img, out, sigmasLarge, order ); } );
+         SolveCosts( FIRTerms( sizes, sigmasSmall, order, 3 ), firSmall,
+                     FIRTerms( sizes, sigmasLarge, order, 3 ), firLarge,
+                     costs.firPerPixel, costs.firPerWeight );
+         // IIR: two filter orders along one dimension
+         dfloat iirSmall = ShortestTime( repetitions, [ & ]() { GaussIIR( img, out, sigmasIIR, order, {}, { 3 } ); } );
+         dfloat iirLarge = ShortestTime( repetitions, [ & ]() { GaussIIR( img, out, sigmasIIR, order, {}, { 5 } ); } );
+         SolveCosts( IIRTerms( sizes, sigmasIIR, order, { 3u, 3u }, 3 ), iirSmall,
+                     IIRTerms( sizes, sigmasIIR, order, { 5u, 5u }, 3 ), iirLarge,
+                     costs.iirPerPixel, costs.iirPerFilterOrder );
+         // FT: two image sizes
+         Image small( ftSizesSmall, 1, dataType );
+         small.Fill( 0 );
+         UniformNoise( small, small, random );
+         Image large( ftSizesLarge, 1, dataType );
+         large.Fill( 0 );
+         UniformNoise( large, large, random );
+         dfloat ftSmall = ShortestTime( repetitions, [ & ]() { GaussFT( small, out ); } );
+         dfloat ftLarge = ShortestTime( repetitions, [ & ]() { GaussFT( large, out ); } );
+         SolveCosts( FTTerms( ftSizesSmall ), ftSmall, FTTerms( ftSizesLarge ), ftLarge,
+                     costs.ftPerPixel, costs.ftPerPixelPerStage );
+         if( dataType == DT_SFLOAT ) {
+            firSequential = firLarge;
+            iirSequential = iirLarge;
+            ftSequential = ftLarge;
+         }
+      }
+   }
+   if( maxThreads > 1 ) {
+      // Repeat the single-precision timings with all threads
+      Image img( sizes, 1, DT_SFLOAT );
+      img.Fill( 0 );
+      UniformNoise( img, img, random );
+      Image large( ftSizesLarge, 1, DT_SFLOAT );
+      large.Fill( 0 );
+      UniformNoise( large, large, random );
+      dfloat firParallel = ShortestTime( repetitions, [ & ]() { GaussFIR( img, out, sigmasLarge, order ); } );
+      dfloat iirParallel = ShortestTime( repetitions, [ & ]() { GaussIIR( img, out, sigmasIIR, order, {}, { 5 } ); } );
+      dfloat ftParallel = ShortestTime( repetitions, [ & ]() { GaussFT( large, out ); } );
+      calibration.firParallelFraction = ParallelFraction( firSequential, firParallel, maxThreads );
+      calibration.iirParallelFraction = ParallelFraction( iirSequential, iirParallel, maxThreads );
+      calibration.ftParallelFraction = ParallelFraction( ftSequential, ftParallel, maxThreads );
+   }
+   return calibration;
+}
+
+struct GaussCalibrationTraits {
+   static bool Read( String const& filename, GaussCalibration& calibration ) {
+      return ReadCalibration( filename, calibration );
+   }
+   static bool Write( String const& filename, GaussCalibration const& calibration ) {
+      return WriteCalibration( filename, calibration );
+   }
+   static GaussCalibration Measure() {
+      return MeasureGaussCalibration();
+   }
+};
+
+// A function-local static, so that it is constructed before it is first used
+detail::Calibration< GaussCalibration, GaussCalibrationTraits >& CurrentCalibration() {
+   static detail::Calibration< GaussCalibration, GaussCalibrationTraits > calibration( "DIP_GAUSS_CALIBRATION" );
+   return calibration;
+}
+
+} // namespace
+
+GaussCalibration CalibrateGauss( String const& filename ) {
+   GaussCalibration calibration = MeasureGaussCalibration();
+   SetGaussCalibration( calibration );
+   if( !filename.empty() ) {
+      DIP_THROW_IF( !WriteCalibration( filename, calibration ), "Could not write Gauss calibration file" );
+   }
+   return calibration;
+}
+
+void LoadGaussCalibration( String const& filename ) {
+   GaussCalibration calibration;
+   DIP_THROW_IF( !ReadCalibration( filename, calibration ), "Could not read Gauss calibration file" );
+   SetGaussCalibration( calibration );
+}
+
+void SetGaussCalibration( GaussCalibration const& calibration ) {
+   for( auto const* costs : { &calibration.singlePrecision, &calibration.doublePrecision } ) {
+      DIP_THROW_IF(( costs->firPerPixel < 0 ) || ( costs->firPerWeight < 0 ) || ( costs->iirPerPixel < 0 ) ||
+                   ( costs->iirPerFilterOrder < 0 ) || ( costs->ftPerPixel < 0 ) || ( costs->ftPerPixelPerStage < 0 ),
+                   E::PARAMETER_OUT_OF_RANGE );
+   }
+   for( dfloat fraction : { calibration.firParallelFraction, calibration.iirParallelFraction, calibration.ftParallelFraction } ) {
+      DIP_THROW_IF(( fraction < 0 ) || ( fraction > 1 ), E::PARAMETER_OUT_OF_RANGE );
+   }
+   CurrentCalibration().Set( calibration );
+}
+
+GaussCalibration GetGaussCalibration() {
+   return CurrentCalibration().Get();
+}
+
+GaussTimes PredictGaussTimes(
+      Image const& in,
+      FloatArray sigmas,
+      UnsignedArray derivativeOrder,
+      StringArray const& boundaryCondition,
+      dfloat truncation
+) {
+   dip::uint nDims = in.Dimensionality();
+   DIP_START_STACK_TRACE
+      ArrayUseParameter( sigmas, nDims, 1.0 );
+      ArrayUseParameter( derivativeOrder, nDims, dip::uint( 0 ));
+   DIP_END_STACK_TRACE
+   if( truncation <= 0.0 ) {
+      truncation = 3;   // Default truncation
+   }
+   UnsignedArray const& sizes = in.Sizes();
+   // Which methods are accurate enough?
+   bool firAccurate = true;
+   bool iirAccurate = true;
+   bool ftAccurate = true;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      if( derivativeOrder[ ii ] > maximumDerivativeOrder ) {
+         firAccurate = false;
+         iirAccurate = false;
+      }
+      if(( sigmas[ ii ] > 0.0 ) && ( sizes[ ii ] > 1 )) {
+         if( sigmas[ ii ] < firMinimumSigma ) {
+            firAccurate = false;
+         }
+         if( sigmas[ ii ] < iirMinimumSigma ) {
+            iirAccurate = false;
+         }
+      } else if(( derivativeOrder[ ii ] > 0 ) && ( sizes[ ii ] > 1 )) {
+         // The FIR and IIR methods don't process this dimension, the FT method computes the derivative
+         ftAccurate = false;
+      }
+   }
+   if( firAccurate ) {
+      // The FT method imposes a periodic boundary condition, we use it only if that is what was asked for
+      BoundaryConditionArray bc;
+      DIP_STACK_TRACE_THIS( bc = StringArrayToBoundaryConditionArray( boundaryCondition ));
+      if( bc.empty() ) {
+         ftAccurate = false;
+      }
+      for( auto b : bc ) {
+         if( b != BoundaryCondition::PERIODIC ) {
+            ftAccurate = false;
+         }
+      }
+   } else {
+      ftAccurate = true; // It's the only option left
+   }
+   // Predict the times
+   GaussCalibration calibration = GetGaussCalibration();
+   DataType dataType = DataType::SuggestFlex( in.DataType() );
+   GaussCalibration::Costs const& costs = dataType.IsA( DataType::Class_DFloat + DataType::Class_DComplex )
+                                          ? calibration.doublePrecision : calibration.singlePrecision;
+   dfloat channels = static_cast< dfloat >( in.TensorElements() ) * ( dataType.IsComplex() ? 2.0 : 1.0 );
+   constexpr dfloat infinity = std::numeric_limits< dfloat >::infinity();
+   GaussTimes times;
+   times.fir = infinity;
+   times.iir = infinity;
+   times.ft = infinity;
+   if( firAccurate ) {
+      CostTerms terms = FIRTerms( sizes, sigmas, derivativeOrder, truncation );
+      times.fir = ParallelTime( channels * ( costs.firPerPixel * terms.a + costs.firPerWeight * terms.b ),
+                                calibration.firParallelFraction );
+   }
+   if( iirAccurate ) {
+      CostTerms terms = IIRTerms( sizes, sigmas, derivativeOrder, {}, truncation );
+      times.iir = ParallelTime( channels * ( costs.iirPerPixel * terms.a + costs.iirPerFilterOrder * terms.b ),
+                                calibration.iirParallelFraction );
+   }
+   if( ftAccurate ) {
+      CostTerms terms = FTTerms( sizes );
+      times.ft = ParallelTime( channels * ( costs.ftPerPixel * terms.a + costs.ftPerPixelPerStage * terms.b ),
+                               calibration.ftParallelFraction );
+   }
+   // Pick the fastest, preferring FIR in case of a tie (e.g. when nothing needs to be processed)
+   times.method = "FIR";
+   dfloat best = times.fir;
+   if( times.iir < best ) {
+      times.method = "IIR";
+      best = times.iir;
+   }
+   if( times.ft < best ) {
+      times.method = "FT";
+   }
+   return times;
+}
+
+} // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/statistics.h"
+#include "diplib/testing.h"
+
+namespace {
+
+// Restores the global calibration when the test ends, also if it fails
+class RestoreGaussCalibration {
+   public:
+      RestoreGaussCalibration() : original_( dip::GetGaussCalibration() ) {}
+      ~RestoreGaussCalibration() { dip::SetGaussCalibration( original_ ); }
+   private:
+      dip::GaussCalibration original_;
+};
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing the Gauss method selection") {
+   RestoreGaussCalibration restore;
+   dip::Image img;
+   img.SetSizes( { 256, 256 } );
+   img.SetDataType( dip::DT_SFLOAT );
+   // Accuracy rules
+   DOCTEST_CHECK( dip::PredictGaussTimes( img, { 0.5 } ).method == "FT" );
+   DOCTEST_CHECK( dip::PredictGaussTimes( img, { 2.0 }, { 4 } ).method == "FT" );
+   DOCTEST_CHECK( std::isinf( dip::PredictGaussTimes( img, { 1.0 } ).iir ));
+   DOCTEST_CHECK( std::isinf( dip::PredictGaussTimes( img, { 1.0 } ).ft ));
+   DOCTEST_CHECK( std::isfinite( dip::PredictGaussTimes( img, { 1.0 }, { 0 }, { "periodic" } ).ft ));
+   DOCTEST_CHECK( std::isinf( dip::PredictGaussTimes( img, { 1.0, 0.0 }, { 0, 1 }, { "periodic" } ).ft ));
+   // With the default calibration, the FIR method is used for small sigmas, the IIR method for large ones
+   dip::SetGaussCalibration( {} );
+   DOCTEST_CHECK( dip::PredictGaussTimes( img, { 2.0 } ).method == "FIR" );
+   DOCTEST_CHECK( dip::PredictGaussTimes( img, { 20.0 } ).method == "IIR" );
+   dip::GaussTimes times = dip::PredictGaussTimes( img, { 5.0 }, { 0 }, { "periodic" } );
+   DOCTEST_CHECK( times.fir < times.iir );
+   DOCTEST_CHECK( times.fir < times.ft );
+   // The times scale with the number of pixels and channels
+   dip::Image img2;
+   img2.SetSizes( { 256, 512 } );
+   img2.SetTensorSizes( 3 );
+   img2.SetDataType( dip::DT_SFLOAT );
+   dip::ExecutionContext context;
+   context.maxThreads = 1;
+   {
+      dip::ScopedExecutionContext scope( context );
+      DOCTEST_CHECK( dip::PredictGaussTimes( img2, { 5.0 } ).fir == doctest::Approx( 6 * dip::PredictGaussTimes( img, { 5.0 } ).fir ).epsilon( 0.01 ));
+   }
+   // A calibration that makes the FT method cheap
+   dip::GaussCalibration calibration;
+   calibration.singlePrecision.ftPerPixel = 0.01;
+   calibration.singlePrecision.ftPerPixelPerStage = 0.001;
+   dip::SetGaussCalibration( calibration );
+   DOCTEST_CHECK( dip::PredictGaussTimes( img, { 5.0 }, { 0 }, { "periodic" } ).method == "FT" );
+   DOCTEST_CHECK( dip::PredictGaussTimes( img, { 5.0 } ).method == "FIR" );
+   img.SetDataType( dip::DT_DFLOAT ); // uses the double precision costs
+   DOCTEST_CHECK( dip::PredictGaussTimes( img, { 5.0 }, { 0 }, { "periodic" } ).method == "FIR" );
+   // Errors
+   calibration.singlePrecision.iirPerPixel = -1.0;
+   DOCTEST_CHECK_THROWS( dip::SetGaussCalibration( calibration ));
+   // Reading the calibration, in the format that `dip::CalibrateGauss` writes (we don't time anything here)
+   dip::testing::TemporaryFile file( "dip_gauss_calibration" );
+   DOCTEST_CHECK_THROWS( dip::LoadGaussCalibration( file.Path() ));
+   {
+      std::ofstream stream( file.Path() );
+      stream << "1 2 3 4 5 6\n1.5 2.5 3.5 4.5 5.5 6.5\n0.5 0.6 0.7\n";
+   }
+   dip::LoadGaussCalibration( file.Path() );
+   calibration = dip::GetGaussCalibration();
+   DOCTEST_CHECK( calibration.singlePrecision.firPerWeight == 2.0 );
+   DOCTEST_CHECK( calibration.singlePrecision.ftPerPixelPerStage == 6.0 );
+   DOCTEST_CHECK( calibration.doublePrecision.firPerPixel == 1.5 );
+   DOCTEST_CHECK( calibration.iirParallelFraction == 0.6 );
+   dip::SetGaussCalibration( {} );
+   // The "best" method gives the same result as the method it picks
+   img = dip::Image( { 64, 48 }, 1, dip::DT_SFLOAT );
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random );
+   dip::Image out = dip::Gauss( img, { 3.0 }, { 1 } );
+   dip::String method = dip::PredictGaussTimes( img, { 3.0 }, { 1 } ).method;
+   DOCTEST_CHECK( dip::MaximumAbs( out - dip::Gauss( img, { 3.0 }, { 1 }, method )).As< dip::dfloat >() == 0.0 );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -447,10 +447,13 @@ class GaussIIRLineFilter : public Framework::SeparableLineFilter {
       virtual void SetNumberOfThreads( dip::uint threads ) override {
          buffers_.resize( threads );
       }
-      virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint /*procDim*/ ) override {
-         // TODO: figure out how filter parameters affect amount of computation
-         //GaussIIRParams const& fParams = filterParams_[ procDim ];
-         return lineLength * 40;
+      virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint procDim ) override {
+         // A forward and a backward recursion over the line plus its borders, each doing one multiply-add per
+         // filter order, plus a few operations per pixel for the loads, stores and the moving-average part.
+         GaussIIRParams const& fParams = filterParams_[ procDim ];
+         dip::uint order = std::max( fParams.iir_order_den[ 0 ], fParams.iir_order_num[ 0 ] ) +
+                           std::max( fParams.iir_order_den[ 3 ], fParams.iir_order_num[ 3 ] );
+         return ( lineLength + 2 * fParams.border ) * ( 2 * order + 6 );
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
          dfloat* in = static_cast< dfloat* >( params.inBuffer.buffer );
@@ -711,6 +714,128 @@ class GaussIIRLineFilter : public Framework::SeparableLineFilter {
             p2[ ii ] = val;
          }
       }
+      virtual bool ProcessesBlocks() override { return true; }
+      virtual void FilterBlock( Framework::SeparableBlockFilterParameters const& params ) override {
+         // Same recursions as in `Filter`, without the unrolled special cases, but with the inner loops over
+         // the lines in the block.
+         dip::uint stride = static_cast< dip::uint >( params.inBuffer.stride );
+         DIP_ASSERT( params.outBuffer.stride == params.inBuffer.stride );
+         dip::uint nLines = params.nLines;
+         GaussIIRParams const& fParams = filterParams_[ params.dimension ];
+         DIP_ASSERT( fParams.border == params.inBuffer.border );
+         dfloat const* p0 = static_cast< dfloat* >( params.inBuffer.buffer ) - fParams.border * stride;
+         dfloat* out = static_cast< dfloat* >( params.outBuffer.buffer ) - fParams.border * stride;
+         dip::uint length = params.inBuffer.length + fParams.border * 2;
+
+         auto const& a1 = fParams.a1;
+         auto const& a2 = fParams.a2;
+         auto const& b1 = fParams.b1;
+         auto const& b2 = fParams.b2;
+         dfloat c = ( fParams.cc );
+         auto const& orderMA = fParams.iir_order_num;
+         auto const& orderAR = fParams.iir_order_den;
+         dip::uint order1 = std::max( orderAR[ 0 ], orderMA[ 0 ] );
+         dip::uint order2 = std::max( orderAR[ 3 ], orderMA[ 3 ] );
+         bool copy_forward = ( orderMA[ 0 ] == 0 ) && ( a1[ 0 ] == 1.0 );
+         bool copy_backward = ( orderMA[ 3 ] == 0 ) && ( a2[ 0 ] == 1.0 );
+         dfloat norm1 = 1.0 + b1[ 1 ] + b1[ 2 ] + b1[ 3 ] + b1[ 4 ] + b1[ 5 ];
+         dfloat norm2 = 1.0 + b2[ 1 ] + b2[ 2 ] + b2[ 3 ] + b2[ 4 ] + b2[ 5 ];
+
+         // The intermediate and output lines have `order` samples of history before the start of the recursion
+         std::vector< dfloat >& buffer = buffers_[ params.thread ];
+         buffer.resize(( 2 * length + order1 + order2 ) * stride ); // won't do anything if buffer is already of correct size.
+         dfloat* p1 = buffer.data() + order1 * stride;
+         dfloat* p2 = p1 + length * stride;
+
+         // Recursive forward scan
+         dip::uint ii = 0;
+         for( dip::uint jj = 0; jj < nLines; ++jj ) {
+            dfloat val = 0.0;
+            for( dip::uint kk = orderMA[ 1 ]; kk <= orderMA[ 2 ]; ++kk ) {
+               val += a1[ kk ] * p0[ ( orderMA[ 2 ] - kk ) * stride + jj ];
+            }
+            val /= norm1;
+            for( dip::uint kk = 1; kk <= order1; ++kk ) {
+               ( p1 - kk * stride )[ jj ] = val;
+            }
+            if( !copy_forward ) {
+               for( dip::uint kk = 0; kk < order1; ++kk ) {
+                  p1[ kk * stride + jj ] = val;
+               }
+            }
+         }
+         if( !copy_forward ) {
+            ii = order1;
+         }
+         for( ; ii < length; ++ii ) {
+            dfloat* dst = p1 + ii * stride;
+            if( copy_forward ) {
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] = p0[ ii * stride + jj ];
+               }
+            } else {
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] = 0.0;
+               }
+               for( dip::uint kk = orderMA[ 1 ]; kk <= orderMA[ 2 ]; ++kk ) {
+                  dfloat const* src = p0 + ( ii - kk ) * stride;
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                     dst[ jj ] += a1[ kk ] * src[ jj ];
+                  }
+               }
+            }
+            for( dip::uint kk = orderAR[ 1 ]; kk <= orderAR[ 2 ]; ++kk ) {
+               dfloat const* src = dst - kk * stride;
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] -= b1[ kk ] * src[ jj ];
+               }
+            }
+         }
+
+         // Recursive backward scan
+         for( dip::uint jj = 0; jj < nLines; ++jj ) {
+            dfloat val = 0.0;
+            for( dip::uint kk = orderMA[ 4 ]; kk <= orderMA[ 5 ]; ++kk ) {
+               val += a2[ kk ] * p1[ ( length - 1 - orderMA[ 5 ] + kk ) * stride + jj ];
+            }
+            val *= c / norm2;
+            for( dip::uint kk = 0; kk < order2; ++kk ) {
+               p2[ ( length + kk ) * stride + jj ] = val;
+            }
+            if( !copy_backward ) {
+               for( dip::uint kk = 0; kk < order2; ++kk ) {
+                  p2[ ( length - 1 - kk ) * stride + jj ] = val;
+               }
+            }
+         }
+         ii = copy_backward ? length : length - order2;
+         while( ii > 0 ) {
+            --ii;
+            dfloat* dst = p2 + ii * stride;
+            if( copy_backward ) {
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] = c * p1[ ii * stride + jj ];
+               }
+            } else {
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] = 0.0;
+               }
+               for( dip::uint kk = orderMA[ 4 ]; kk <= orderMA[ 5 ]; ++kk ) {
+                  dfloat const* src = p1 + ( ii + kk ) * stride;
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                     dst[ jj ] += c * a2[ kk ] * src[ jj ];
+                  }
+               }
+            }
+            for( dip::uint kk = orderAR[ 4 ]; kk <= orderAR[ 5 ]; ++kk ) {
+               dfloat const* src = dst + kk * stride;
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] -= b2[ kk ] * src[ jj ];
+               }
+            }
+         }
+         std::copy( p2, p2 + length * stride, out );
+      }
    private:
       std::vector< GaussIIRParams > const& filterParams_; // one of each dimension
       std::vector< std::vector< dfloat >> buffers_; // one for each thread
@@ -22,9 +22,35 @@
 #include "diplib/framework.h"
 #include "diplib/overload.h"
 #include "diplib/saturated_arithmetic.h"
+#include "diplib/library/cpu_dispatch.h"
 
 namespace dip {
 
+namespace {
+
+// A `Framework::VariadicScanLineFilter` whose loop is compiled for each of the instruction sets supported by
+// `detail::DispatchIsa`, and that selects the one to use at run time.
+template< dip::uint N, typename TPI, typename F >
+class DispatchedScanLineFilter : public Framework::VariadicScanLineFilter< N, TPI, F > {
+   public:
+      using Framework::VariadicScanLineFilter< N, TPI, F >::VariadicScanLineFilter;
+      virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { Framework::VariadicScanLineFilter< N, TPI, F >::Filter( params ); } );
+      }
+};
+
+template< typename TPI, typename F >
+std::unique_ptr< Framework::ScanLineFilter > NewDispatchedMonadicScanLineFilter( F const& func, dip::uint cost = 1 ) {
+   return static_cast< std::unique_ptr< Framework::ScanLineFilter >>( new DispatchedScanLineFilter< 1, TPI, F >( func, cost ));
+}
+
+template< typename TPI, typename F >
+std::unique_ptr< Framework::ScanLineFilter > NewDispatchedDyadicScanLineFilter( F const& func, dip::uint cost = 1 ) {
+   return static_cast< std::unique_ptr< Framework::ScanLineFilter >>( new DispatchedScanLineFilter< 2, TPI, F >( func, cost ));
+}
+
+} // namespace
+
 //
 void Add(
       Image const& lhs,
@@ -33,7 +59,7 @@ void Add(
       DataType dt
 ) {
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
-   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
          []( auto its ) { return dip::saturated_add( *its[ 0 ], *its[ 1 ] ); }
    ), dt );
    DIP_STACK_TRACE_THIS( Framework::ScanDyadic( lhs, rhs, out, dt, dt, *scanLineFilter ));
@@ -47,7 +73,7 @@ void Subtract(
       DataType dt
 ) {
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
-   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
          []( auto its ) { return dip::saturated_sub( *its[ 0 ], *its[ 1 ] ); }
    ), dt );
    DIP_STACK_TRACE_THIS( Framework::ScanDyadic( lhs, rhs, out, dt, dt, *scanLineFilter ));
@@ -359,7 +385,7 @@ void MultiplySampleWise(
       DataType dt
 ) {
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
-   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
          []( auto its ) { return dip::saturated_mul( *its[ 0 ], *its[ 1 ] ); }
    ), dt );
    DIP_STACK_TRACE_THIS( Framework::ScanDyadic( lhs, rhs, out, dt, dt, *scanLineFilter ));
@@ -373,7 +399,7 @@ void MultiplyConjugate(
 ) {
    if( rhs.DataType().IsComplex() && dt.IsComplex() ) {
       std::unique_ptr< Framework::ScanLineFilter > scanLineFilter;
-      DIP_OVL_CALL_ASSIGN_COMPLEX( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+      DIP_OVL_CALL_ASSIGN_COMPLEX( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
             []( auto its ) { return dip::saturated_mul( *its[ 0 ], std::conj( *its[ 1 ] )); }, 4
       ), dt );
       DIP_STACK_TRACE_THIS( Framework::ScanDyadic( lhs, rhs, out, dt, dt, *scanLineFilter ));
@@ -390,7 +416,7 @@ void Divide(
       DataType dt
 ) {
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
-   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
          []( auto its ) { return dip::saturated_div( *its[ 0 ], *its[ 1 ] ); }
    ), dt );
    DIP_STACK_TRACE_THIS( Framework::ScanDyadic( lhs, rhs, out, dt, dt, *scanLineFilter ));
@@ -408,7 +434,7 @@ void SafeDivide(
       return;
    }
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
-   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
          []( auto its ) { return dip::saturated_safediv( *its[ 0 ], *its[ 1 ] ); }
    ), dt );
    DIP_STACK_TRACE_THIS( Framework::ScanDyadic( lhs, rhs, out, dt, dt, *scanLineFilter ));
@@ -423,11 +449,11 @@ void Modulo(
 ) {
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
    if( dt.IsFloat() ) {
-      DIP_OVL_CALL_ASSIGN_FLOAT( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+      DIP_OVL_CALL_ASSIGN_FLOAT( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
             []( auto its ) { return std::fmod( *its[ 0 ], *its[ 1 ] ); }
       ), dt );
    } else {
-      DIP_OVL_CALL_ASSIGN_INTEGER( scanLineFilter, Framework::NewDyadicScanLineFilter, (
+      DIP_OVL_CALL_ASSIGN_INTEGER( scanLineFilter, NewDispatchedDyadicScanLineFilter, (
             []( auto its ) { return static_cast< decltype( *its[ 0 ] ) >( *its[ 0 ] % *its[ 1 ] ); }
       ), dt );
    }
@@ -474,7 +500,7 @@ void Invert(
 ) {
    DataType dt = in.DataType();
    std::unique_ptr< Framework::ScanLineFilter >scanLineFilter;
-   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, Framework::NewMonadicScanLineFilter, (
+   DIP_OVL_CALL_ASSIGN_ALL( scanLineFilter, NewDispatchedMonadicScanLineFilter, (
          []( auto its ) { return saturated_inv( *its[ 0 ] ); }
    ), dt );
    DIP_STACK_TRACE_THIS( Framework::ScanMonadic( in, out, dt, dt, 1, *scanLineFilter, Framework::ScanOption::TensorAsSpatialDim ));
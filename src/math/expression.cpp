@@ -0,0 +1,534 @@
+/*
+ * DIPlib 3.0
+ * This file contains the implementation of deferred evaluation of image arithmetic.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <limits>
+#include <map>
+
+#include "diplib.h"
+#include "diplib/expression.h"
+#include "diplib/framework.h"
+
+namespace dip {
+
+namespace {
+
+using Operation = Expression::Operation;
+using Node = Expression::Node;
+
+bool IsComparison( Operation operation ) {
+   switch( operation ) {
+      case Operation::Equal:
+      case Operation::NotEqual:
+      case Operation::Lesser:
+      case Operation::Greater:
+      case Operation::NotGreater:
+      case Operation::NotLesser:
+         return true;
+      default:
+         return false;
+   }
+}
+
+// The range of values of an integer or binary data type
+struct Range {
+   dfloat lowest;
+   dfloat max;
+};
+
+Range DataTypeRange( DataType dt ) {
+   switch( dt ) {
+      case DT_BIN:    return { 0.0, 1.0 };
+      case DT_UINT8:  return { 0.0, static_cast< dfloat >( std::numeric_limits< uint8 >::max() ) };
+      case DT_SINT8:  return { static_cast< dfloat >( std::numeric_limits< sint8 >::lowest() ), static_cast< dfloat >( std::numeric_limits< sint8 >::max() ) };
+      case DT_UINT16: return { 0.0, static_cast< dfloat >( std::numeric_limits< uint16 >::max() ) };
+      case DT_SINT16: return { static_cast< dfloat >( std::numeric_limits< sint16 >::lowest() ), static_cast< dfloat >( std::numeric_limits< sint16 >::max() ) };
+      case DT_UINT32: return { 0.0, static_cast< dfloat >( std::numeric_limits< uint32 >::max() ) };
+      case DT_SINT32: return { static_cast< dfloat >( std::numeric_limits< sint32 >::lowest() ), static_cast< dfloat >( std::numeric_limits< sint32 >::max() ) };
+      case DT_UINT64: return { 0.0, static_cast< dfloat >( std::numeric_limits< uint64 >::max() ) };
+      case DT_SINT64: return { static_cast< dfloat >( std::numeric_limits< sint64 >::lowest() ), static_cast< dfloat >( std::numeric_limits< sint64 >::max() ) };
+      default:
+         DIP_THROW( E::DATA_TYPE_NOT_SUPPORTED );
+   }
+}
+
+// An operand of an instruction: either an input buffer or a temporary buffer
+struct Operand {
+   bool isInput;
+   dip::uint index;
+};
+
+// One operation on a chunk of pixels. The result goes into temporary buffer `result`, or into the output buffer
+// for the last instruction.
+struct Instruction {
+   Operation operation;
+   Operand lhs;
+   Operand rhs;
+   dip::uint result;
+   DataType dataType;      // The data type of the result, determines the saturation
+   DataType lhsDataType;   // The data type of the first operand
+};
+
+// Compiles the expression tree into a list of instructions. Leaf nodes become inputs to the scan framework.
+class Compiler {
+   public:
+      std::vector< Instruction > program;
+      ImageConstRefArray inputs;
+      dip::uint nTemporaries = 0;
+
+      Operand Compile( Node const& node ) {
+         if( node.operation == Operation::Image ) {
+            auto it = inputIndex_.find( &node );
+            if( it != inputIndex_.end() ) {
+               return { true, it->second };
+            }
+            dip::uint index = inputs.size();
+            inputs.push_back( node.image );
+            inputIndex_.emplace( &node, index );
+            return { true, index };
+         }
+         Instruction instruction{ node.operation, Compile( *node.lhs ), { true, 0 }, 0, node.dataType, node.lhs->dataType };
+         if( node.rhs ) {
+            instruction.rhs = Compile( *node.rhs );
+         }
+         // Temporary buffers are used only once, we can re-use those of the operands
+         if( !instruction.lhs.isInput ) {
+            instruction.result = instruction.lhs.index;
+         } else if( node.rhs && !instruction.rhs.isInput ) {
+            instruction.result = instruction.rhs.index;
+         } else {
+            instruction.result = nTemporaries++;
+         }
+         program.push_back( instruction );
+         return { false, instruction.result };
+      }
+
+   private:
+      std::map< Node const*, dip::uint > inputIndex_;
+};
+
+template< typename T >
+dfloat RealPart( T value ) { return static_cast< dfloat >( value ); }
+template< typename T >
+dfloat RealPart( std::complex< T > value ) { return static_cast< dfloat >( value.real() ); }
+
+template< typename T >
+T Truncate( T value ) { return std::trunc( value ); }
+template< typename T >
+std::complex< T > Truncate( std::complex< T > value ) { return std::trunc( value.real() ); }
+
+template< typename T >
+T Clamp( T value, T lowest, T max ) { return std::isnan( value ) ? max : clamp( value, lowest, max ); }
+template< typename T >
+std::complex< T > Clamp( std::complex< T > value, std::complex< T > lowest, std::complex< T > max ) {
+   return Clamp( value.real(), lowest.real(), max.real() );
+}
+
+template< typename T >
+T AbsValue( T value ) { return std::abs( value ); }
+
+// Applies `func` to each sample of the chunk
+template< typename T, typename F >
+void Monadic( T const* in, dip::sint inStride, T* out, dip::sint outStride, dip::uint n, F func ) {
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      *out = func( *in );
+      in += inStride;
+      out += outStride;
+   }
+}
+template< typename T, typename F >
+void Dyadic( T const* lhs, dip::sint lhsStride, T const* rhs, dip::sint rhsStride, T* out, dip::sint outStride, dip::uint n, F func ) {
+   for( dip::uint ii = 0; ii < n; ++ii ) {
+      *out = func( *lhs, *rhs );
+      lhs += lhsStride;
+      rhs += rhsStride;
+      out += outStride;
+   }
+}
+
+template< typename T >
+class ExpressionLineFilter : public Framework::ScanLineFilter {
+   public:
+      // The number of pixels processed at once, such that the temporary buffers stay in the cache
+      static constexpr dip::uint chunkSize = 256;
+
+      ExpressionLineFilter( std::vector< Instruction > const& program, dip::uint nTemporaries )
+            : program_( program ), nTemporaries_( nTemporaries ) {}
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         buffers_.resize( threads );
+      }
+      virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override {
+         dip::uint operations = 0;
+         for( auto const& instruction : program_ ) {
+            switch( instruction.operation ) {
+               case Operation::Sqrt:
+               case Operation::Exp:
+               case Operation::Ln:
+               case Operation::Sin:
+               case Operation::Cos:
+                  operations += 20;
+                  break;
+               default:
+                  operations += 2;
+                  break;
+            }
+         }
+         return operations;
+      }
+      virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
+         std::vector< T >& buffer = buffers_[ params.thread ];
+         buffer.resize( std::max( nTemporaries_, dip::uint( 1 )) * chunkSize );
+         dip::uint bufferLength = params.bufferLength;
+         for( dip::uint offset = 0; offset < bufferLength; offset += chunkSize ) {
+            dip::uint n = std::min( chunkSize, bufferLength - offset );
+            auto Pointer = [ & ]( Operand const& operand, dip::sint& stride ) -> T* {
+               if( operand.isInput ) {
+                  stride = params.inBuffer[ operand.index ].stride;
+                  return static_cast< T* >( params.inBuffer[ operand.index ].buffer ) + static_cast< dip::sint >( offset ) * stride;
+               }
+               stride = 1;
+               return buffer.data() + operand.index * chunkSize;
+            };
+            for( dip::uint ii = 0; ii < program_.size(); ++ii ) {
+               Instruction const& instruction = program_[ ii ];
+               dip::sint lhsStride;
+               dip::sint rhsStride = 0;
+               dip::sint outStride;
+               T const* lhs = Pointer( instruction.lhs, lhsStride );
+               T const* rhs = Pointer( instruction.rhs, rhsStride );
+               T* out;
+               if( ii == program_.size() - 1 ) {
+                  outStride = params.outBuffer[ 0 ].stride;
+                  out = static_cast< T* >( params.outBuffer[ 0 ].buffer ) + static_cast< dip::sint >( offset ) * outStride;
+               } else {
+                  out = Pointer( { false, instruction.result }, outStride );
+               }
+               Apply( instruction, lhs, lhsStride, rhs, rhsStride, out, outStride, n );
+            }
+         }
+      }
+
+   private:
+      std::vector< Instruction > const& program_;
+      dip::uint nTemporaries_;
+      std::vector< std::vector< T >> buffers_; // one for each thread
+
+      static void Apply( Instruction const& instruction, T const* lhs, dip::sint lhsStride, T const* rhs, dip::sint rhsStride,
+                         T* out, dip::sint outStride, dip::uint n ) {
+         DataType dt = instruction.dataType;
+         bool isInteger = dt.IsA( DataType::Class_IntOrBin );
+         switch( instruction.operation ) {
+            case Operation::Add:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return a + b; } );
+               break;
+            case Operation::Subtract:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return a - b; } );
+               break;
+            case Operation::Multiply:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return a * b; } );
+               break;
+            case Operation::Divide:
+               if( dt.IsBinary() ) {
+                  // Binary division is equivalent to OR NOT, see `dip::saturated_div`
+                  Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T(( a != T( 0 )) || ( b == T( 0 ))); } );
+               } else if( isInteger ) {
+                  Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return Truncate( a / b ); } );
+               } else {
+                  Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return a / b; } );
+               }
+               break;
+            case Operation::Equal:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T( a == b ); } );
+               break;
+            case Operation::NotEqual:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T( a != b ); } );
+               break;
+            case Operation::Lesser:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T( RealPart( a ) < RealPart( b )); } );
+               break;
+            case Operation::Greater:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T( RealPart( a ) > RealPart( b )); } );
+               break;
+            case Operation::NotGreater:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T( RealPart( a ) <= RealPart( b )); } );
+               break;
+            case Operation::NotLesser:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T( RealPart( a ) >= RealPart( b )); } );
+               break;
+            case Operation::And:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T(( a != T( 0 )) && ( b != T( 0 ))); } );
+               break;
+            case Operation::Or:
+               Dyadic( lhs, lhsStride, rhs, rhsStride, out, outStride, n, []( T a, T b ) { return T(( a != T( 0 )) || ( b != T( 0 ))); } );
+               break;
+            case Operation::Negate:
+               if( dt.IsBinary() ) {
+                  Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return T( a == T( 0 )); } );
+               } else if( dt.IsUnsigned() ) {
+                  // Unsigned integers invert by subtracting from the max value, see `dip::saturated_inv`
+                  T max = T( static_cast< FloatType< T >>( DataTypeRange( dt ).max ));
+                  Monadic( lhs, lhsStride, out, outStride, n, [ max ]( T a ) { return max - a; } );
+               } else {
+                  Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return -a; } );
+               }
+               break;
+            case Operation::Not:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return T( a == T( 0 )); } );
+               break;
+            case Operation::Abs:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return T( AbsValue( a )); } );
+               break;
+            case Operation::Sqrt:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return std::sqrt( a ); } );
+               break;
+            case Operation::Square:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return a * a; } );
+               break;
+            case Operation::Exp:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return std::exp( a ); } );
+               break;
+            case Operation::Ln:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return std::log( a ); } );
+               break;
+            case Operation::Sin:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return std::sin( a ); } );
+               break;
+            case Operation::Cos:
+               Monadic( lhs, lhsStride, out, outStride, n, []( T a ) { return std::cos( a ); } );
+               break;
+            default:
+               DIP_THROW( E::NOT_IMPLEMENTED ); // This will never happen
+         }
+         // Saturate results of integer and binary type, as the eager operations do
+         if( isInteger && !IsComparison( instruction.operation )) {
+            Range range = DataTypeRange( dt );
+            T lowest = T( static_cast< FloatType< T >>( range.lowest ));
+            T max = T( static_cast< FloatType< T >>( range.max ));
+            Monadic( out, outStride, out, outStride, n, [ lowest, max ]( T a ) { return Clamp( a, lowest, max ); } );
+         }
+      }
+};
+
+template< typename T >
+std::unique_ptr< Framework::ScanLineFilter > NewExpressionLineFilter( std::vector< Instruction > const& program, dip::uint nTemporaries ) {
+   return std::unique_ptr< Framework::ScanLineFilter >( new ExpressionLineFilter< T >( program, nTemporaries ));
+}
+
+// Determines the floating-point type in which the expression is computed: complex if any operand is complex,
+// double precision if any operand has more precision than a single-precision float can represent.
+void ComputeType( Node const& node, bool& isComplex, bool& isDouble ) {
+   DataType dt = node.dataType;
+   isComplex |= dt.IsComplex();
+   isDouble |= ( dt == DT_DFLOAT ) || ( dt == DT_DCOMPLEX ) || ( dt.IsInteger() && ( dt.SizeOf() >= 4 ));
+   if( node.lhs ) {
+      ComputeType( *node.lhs, isComplex, isDouble );
+   }
+   if( node.rhs ) {
+      ComputeType( *node.rhs, isComplex, isDouble );
+   }
+}
+
+} // namespace
+
+Expression::Expression( Operation operation, Expression const& in ) {
+   dip::DataType inType = in.DataType();
+   dip::DataType dt;
+   switch( operation ) {
+      case Operation::Negate:
+         dt = inType;
+         break;
+      case Operation::Not:
+         // `dip::Not` is a bit-wise operation on integer images, we only do the logical one
+         DIP_THROW_IF( !inType.IsBinary(), E::IMAGE_NOT_BINARY );
+         dt = DT_BIN;
+         break;
+      case Operation::Abs:
+         dt = inType.IsSigned() ? dip::DataType::SuggestAbs( inType ) : inType;
+         break;
+      case Operation::Sqrt:
+      case Operation::Square:
+      case Operation::Exp:
+      case Operation::Ln:
+      case Operation::Sin:
+      case Operation::Cos:
+         DIP_THROW_IF( inType.IsBinary(), E::DATA_TYPE_NOT_SUPPORTED );
+         dt = dip::DataType::SuggestFlex( inType );
+         break;
+      default:
+         DIP_THROW_INVALID_FLAG( "operation" );
+   }
+   node_ = std::make_shared< Node const >( Node{ operation, dt, in.node_->tensorElements, {}, in.node_, nullptr } );
+}
+
+Expression::Expression( Operation operation, Expression const& lhs, Expression const& rhs ) {
+   dip::DataType lhsType = lhs.DataType();
+   dip::DataType rhsType = rhs.DataType();
+   dip::uint lhsTensorElements = lhs.node_->tensorElements;
+   dip::uint rhsTensorElements = rhs.node_->tensorElements;
+   DIP_THROW_IF(( lhsTensorElements != rhsTensorElements ) && ( lhsTensorElements != 1 ) && ( rhsTensorElements != 1 ), E::NTENSORELEM_DONT_MATCH );
+   dip::DataType dt;
+   switch( operation ) {
+      case Operation::Multiply:
+         // `dip::Multiply` does a matrix multiplication, which we cannot do sample-wise
+         DIP_THROW_IF(( lhsTensorElements > 1 ) && ( rhsTensorElements > 1 ), "Cannot multiply two tensor images with deferred evaluation" );
+         // fallthrough
+      case Operation::Add:
+      case Operation::Subtract:
+      case Operation::Divide:
+         dt = dip::DataType::SuggestArithmetic( lhsType, rhsType );
+         break;
+      case Operation::Lesser:
+      case Operation::Greater:
+      case Operation::NotGreater:
+      case Operation::NotLesser:
+         DIP_THROW_IF( lhsType.IsComplex() || rhsType.IsComplex(), E::DATA_TYPE_NOT_SUPPORTED );
+         // fallthrough
+      case Operation::Equal:
+      case Operation::NotEqual:
+         dt = DT_BIN;
+         break;
+      case Operation::And:
+      case Operation::Or:
+         DIP_THROW_IF( !lhsType.IsBinary() || !rhsType.IsBinary(), E::IMAGE_NOT_BINARY );
+         dt = DT_BIN;
+         break;
+      default:
+         DIP_THROW_INVALID_FLAG( "operation" );
+   }
+   node_ = std::make_shared< Node const >( Node{ operation, dt, std::max( lhsTensorElements, rhsTensorElements ), {}, lhs.node_, rhs.node_ } );
+}
+
+void Expression::Evaluate( Image& out ) const {
+   if( node_->operation == Operation::Image ) {
+      out = node_->image;
+      return;
+   }
+   Compiler compiler;
+   compiler.Compile( *node_ );
+   bool isComplex = false;
+   bool isDouble = false;
+   ComputeType( *node_, isComplex, isDouble );
+   dip::DataType bufferType = isComplex ? ( isDouble ? DT_DCOMPLEX : DT_SCOMPLEX ) : ( isDouble ? DT_DFLOAT : DT_SFLOAT );
+   std::unique_ptr< Framework::ScanLineFilter > lineFilter;
+   switch( bufferType ) {
+      case DT_SFLOAT:
+         lineFilter = NewExpressionLineFilter< sfloat >( compiler.program, compiler.nTemporaries );
+         break;
+      case DT_DFLOAT:
+         lineFilter = NewExpressionLineFilter< dfloat >( compiler.program, compiler.nTemporaries );
+         break;
+      case DT_SCOMPLEX:
+         lineFilter = NewExpressionLineFilter< scomplex >( compiler.program, compiler.nTemporaries );
+         break;
+      default: // DT_DCOMPLEX
+         lineFilter = NewExpressionLineFilter< dcomplex >( compiler.program, compiler.nTemporaries );
+         break;
+   }
+   ImageRefArray outar{ out };
+   DIP_STACK_TRACE_THIS( Framework::Scan( compiler.inputs, outar, DataTypeArray( compiler.inputs.size(), bufferType ),
+                                          { bufferType }, { node_->dataType }, { 1 }, *lineFilter,
+                                          Framework::ScanOption::TensorAsSpatialDim ));
+}
+
+} // namespace dip
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/math.h"
+#include "diplib/generation.h"
+#include "diplib/statistics.h"
+#include "diplib/multithreading.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::Expression") {
+   dip::uint nThreads = dip::GetNumberOfThreads();
+   dip::SetNumberOfThreads( 4 );
+   dip::ExecutionContext context;
+   context.threadingThreshold = 1;
+   dip::ScopedExecutionContext scope( context );
+   dip::Image a( { 60, 41 }, 1, dip::DT_SFLOAT );
+   dip::Image b( { 60, 41 }, 1, dip::DT_SFLOAT );
+   a.Fill( 0 );
+   b.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( a, a, random, 0.5, 100.0 );
+   dip::UniformNoise( b, b, random, 0.5, 100.0 );
+
+   // Floating-point arithmetic
+   dip::Image out = dip::Expression( a ) * b + a / 2;
+   dip::Image ref = a * b + a / 2;
+   DOCTEST_CHECK( out.DataType() == ref.DataType() );
+   DOCTEST_CHECK( dip::MaximumAbs( out - ref ).As< dip::dfloat >() < 1e-3 );
+   out = dip::Sqrt( dip::Square( dip::Expression( a ) - b )) - dip::Abs( dip::Expression( b ) - a );
+   DOCTEST_CHECK( dip::MaximumAbs( out ).As< dip::dfloat >() < 1e-3 );
+   out = dip::Exp( dip::Ln( dip::Expression( a ))) + dip::Sin( dip::Expression( b )) * dip::Sin( dip::Expression( b ))
+         + dip::Cos( dip::Expression( b )) * dip::Cos( dip::Expression( b )) - a;
+   DOCTEST_CHECK( dip::MaximumAbs( out - 1 ).As< dip::dfloat >() < 1e-3 );
+
+   // Comparisons and logical operators
+   out = ( dip::Expression( a ) > b ) | ( dip::Expression( a ) == 3.0 );
+   DOCTEST_CHECK( out.DataType() == dip::DT_BIN );
+   DOCTEST_CHECK( dip::Count( out != (( a > b ) | ( a == 3.0 ))) == 0 );
+   out = ( !( dip::Expression( a ) <= b )) & ( dip::Expression( b ) >= 1.0 );
+   DOCTEST_CHECK( dip::Count( out != (( a > b ) & ( b >= 1.0 ))) == 0 );
+
+   // Integer saturation happens after each operation
+   dip::Image c = dip::Convert( a, dip::DT_UINT8 );
+   dip::Image d = dip::Convert( b, dip::DT_UINT8 );
+   out = ( dip::Expression( c ) * d ) / 3 - d;
+   ref = ( c * d ) / 3 - d;
+   DOCTEST_CHECK( out.DataType() == ref.DataType() );
+   DOCTEST_CHECK( dip::Count( out != ref ) == 0 );
+   out = -dip::Expression( c );
+   DOCTEST_CHECK( dip::Count( out != -c ) == 0 );
+   dip::Image e = dip::Convert( a - 50, dip::DT_SINT8 );
+   out = -( dip::Expression( e ) * 3 ) + dip::Abs( dip::Expression( e ));
+   ref = -( e * 3 ) + dip::Abs( e );
+   DOCTEST_CHECK( out.DataType() == ref.DataType() );
+   DOCTEST_CHECK( dip::Count( out != ref ) == 0 );
+
+   // Binary arithmetic
+   dip::Image f = a > 50;
+   dip::Image g = b > 50;
+   out = dip::Expression( f ) + g - ( dip::Expression( f ) * g );
+   ref = f + g - ( f * g );
+   DOCTEST_CHECK( out.DataType() == dip::DT_BIN );
+   DOCTEST_CHECK( dip::Count( out != ref ) == 0 );
+
+   // Tensor images and singleton expansion
+   dip::Image t( { 60, 1 }, 3, dip::DT_SFLOAT );
+   t.Fill( 0 );
+   dip::UniformNoise( t, t, random, 0.0, 10.0 );
+   out = dip::Expression( a ) * t - t;
+   ref = a * t - t;
+   DOCTEST_CHECK( out.TensorElements() == 3 );
+   DOCTEST_CHECK( out.Sizes() == ref.Sizes() );
+   DOCTEST_CHECK( dip::MaximumAbs( out - ref ).As< dip::dfloat >() < 1e-3 );
+   DOCTEST_CHECK_THROWS( dip::Expression( t ) * t );
+   DOCTEST_CHECK_THROWS( dip::Expression( a ) & b );
+
+   // Evaluating into an existing image
+   out = dip::Image( { 60, 41 }, 1, dip::DT_SFLOAT );
+   out.Protect();
+   ( dip::Expression( c ) + 1.5 ).Evaluate( out );
+   DOCTEST_CHECK( out.DataType() == dip::DT_SFLOAT );
+   DOCTEST_CHECK( dip::MaximumAbs( out - ( c + 1.5 )).As< dip::dfloat >() < 1e-3 );
+   dip::SetNumberOfThreads( nThreads );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
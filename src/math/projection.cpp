@@ -24,6 +24,7 @@
 #include "diplib/framework.h"
 #include "diplib/overload.h"
 #include "diplib/iterators.h"
+#include "diplib/multithreading.h"
 #include "diplib/library/copy_buffer.h"
 
 namespace dip {
@@ -37,10 +38,74 @@ class ProjectionScanFunction {
       virtual void Project( Image const& in, Image const& mask, void* out, dip::uint thread ) = 0;
       // The derived class can define this function if it needs this information ahead of time.
       virtual void SetNumberOfThreads( dip::uint /*threads*/ ) {}
+      // The derived class can define this function to indicate how expensive it is to process a sub-image with
+      // `nPixels` pixels. The default assumes one operation per pixel.
+      virtual dip::uint GetNumberOfOperations( dip::uint nPixels ) { return nPixels; }
+      // If the projection over the full image can be computed by combining results computed over sub-images,
+      // the derived class should return true here, and define `ProjectPartial` and `MergePartial`. In that case,
+      // `ProjectPartial` will be called once by each thread with a different sub-image, and `MergePartial` once
+      // after all threads have finished, to write the combined result to `out`.
+      virtual bool CanMergePartial() { return false; }
+      virtual void ProjectPartial( Image const& /*in*/, Image const& /*mask*/, dip::uint /*thread*/ ) {}
+      virtual void MergePartial( void* /*out*/ ) {}
       // A virtual destructor guarantees that we can destroy a derived class by a pointer to base
       virtual ~ProjectionScanFunction() {}
 };
 
+// A base class for projections that accumulate a `State` object over the pixels of a sub-image, and then compute
+// the result from that state. These projections can be computed in parallel over the full image, as two states
+// can be combined.
+template< typename State >
+class ProjectionAccumulatingFunction : public ProjectionScanFunction {
+   public:
+      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+         State state = InitialState();
+         Accumulate( in, mask, state );
+         Finalize( state, out );
+      }
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         partial_.assign( threads, InitialState() );
+      }
+      virtual bool CanMergePartial() override { return true; }
+      virtual void ProjectPartial( Image const& in, Image const& mask, dip::uint thread ) override {
+         State state = InitialState(); // accumulate into a local variable to avoid false sharing
+         Accumulate( in, mask, state );
+         partial_[ thread ] = state;
+      }
+      virtual void MergePartial( void* out ) override {
+         State state = partial_[ 0 ];
+         for( dip::uint ii = 1; ii < partial_.size(); ++ii ) {
+            Combine( state, partial_[ ii ] );
+         }
+         Finalize( state, out );
+      }
+   protected:
+      // The state before any pixels have been accumulated.
+      virtual State InitialState() { return State{}; }
+      // Adds the pixels in `in` (optionally masked by `mask`) to `state`.
+      virtual void Accumulate( Image const& in, Image const& mask, State& state ) = 0;
+      // Adds `other` to `state`.
+      virtual void Combine( State& state, State const& other ) = 0;
+      // Writes the result to `out`, which must be cast to the requested `outImageType`.
+      virtual void Finalize( State const& state, void* out ) = 0;
+   private:
+      std::vector< State > partial_;
+};
+
+// Returns the start position for each of the `nThreads` chunks of `nPixels / nThreads` pixels in an image of sizes `sizes`.
+std::vector< UnsignedArray > ComputeStartPositions( UnsignedArray const& sizes, dip::uint nPixelsPerThread, dip::uint nThreads ) {
+   std::vector< UnsignedArray > startCoords( nThreads );
+   for( dip::uint ii = 0; ii < nThreads; ++ii ) {
+      dip::uint index = ii * nPixelsPerThread;
+      startCoords[ ii ].resize( sizes.size() );
+      for( dip::uint dd = 0; dd < sizes.size(); ++dd ) {
+         startCoords[ ii ][ dd ] = index % sizes[ dd ];
+         index /= sizes[ dd ];
+      }
+   }
+   return startCoords;
+}
+
 void ProjectionScan(
       Image const& c_in,
       Image const& c_mask,
@@ -131,16 +196,72 @@ void ProjectionScan(
    }
 
    // Do we need to loop at all?
-   if( process.all() ) {
+   if( outSizes.product() == 1 ) {
       //std::cout << "Projection framework: no need to loop!\n";
-      function.SetNumberOfThreads( 1 );
+      input.Squeeze(); // we want to make sure that function.Project() won't be looping over singleton dimensions
+      if( hasMask ) {
+         mask.Squeeze(); // keep in sync with input.
+      }
+      inSizes = input.Sizes();
+      nDims = inSizes.size();
+
+      // Determine the number of threads we'll be using. We split the image along its largest dimension.
+      dip::uint nThreads = 1;
+      dip::uint splitDim = 0;
+      if( function.CanMergePartial() && ( nDims > 0 )) {
+         for( dip::uint ii = 1; ii < nDims; ++ii ) {
+            if( inSizes[ ii ] > inSizes[ splitDim ] ) {
+               splitDim = ii;
+            }
+         }
+         nThreads = std::min( GetNumberOfThreads(), inSizes[ splitDim ] );
+         if( nThreads > 1 ) {
+            dip::uint operations;
+            DIP_STACK_TRACE_THIS( operations = function.GetNumberOfOperations( input.NumberOfPixels() ));
+            // The cost model decides whether starting threads is worth while, and how many to start
+            nThreads = GetOptimalNumberOfThreads( operations, nThreads );
+         }
+      }
+
+      Image outBuffer;
+      void* outPtr = output.Origin();
       if( output.DataType() != outImageType ) {
-         Image outBuffer( {}, 1, outImageType ); // a single sample
-         function.Project( input, mask, outBuffer.Origin(), 0 );
+         outBuffer = Image( {}, 1, outImageType ); // a single sample
+         outPtr = outBuffer.Origin();
+      }
+
+      if( nThreads == 1 ) {
+         function.SetNumberOfThreads( 1 );
+         DIP_STACK_TRACE_THIS( function.Project( input, mask, outPtr, 0 ));
+      } else {
+         // Each thread projects a slab of the image, the results are merged afterwards
+         dip::uint slabSize = div_ceil( inSizes[ splitDim ], nThreads );
+         nThreads = div_ceil( inSizes[ splitDim ], slabSize );
+         DIP_STACK_TRACE_THIS( function.SetNumberOfThreads( nThreads ));
+         DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+            dip::uint start = thread * slabSize;
+            UnsignedArray slabSizes = inSizes;
+            slabSizes[ splitDim ] = std::min( slabSize, inSizes[ splitDim ] - start );
+            Image slabIn;
+            slabIn.CopyProperties( input );
+            slabIn.SetSizes( slabSizes );
+            slabIn.SetOriginUnsafe( input.Origin() );
+            slabIn.ShiftOriginUnsafe( static_cast< dip::sint >( start ) * input.Stride( splitDim ));
+            Image slabMask;
+            if( hasMask ) {
+               slabMask.CopyProperties( mask );
+               slabMask.SetSizes( slabSizes );
+               slabMask.SetOriginUnsafe( mask.Origin() );
+               slabMask.ShiftOriginUnsafe( static_cast< dip::sint >( start ) * mask.Stride( splitDim ));
+            }
+            function.ProjectPartial( slabIn, slabMask, thread );
+         } ));
+         DIP_STACK_TRACE_THIS( function.MergePartial( outPtr ));
+      }
+
+      if( outPtr != output.Origin() ) {
          detail::CopyBuffer( outBuffer.Origin(), outBuffer.DataType(), 1, 1,
                              output.Origin(), output.DataType(), 1, 1, 1, 1 );
-      } else {
-         function.Project( input, mask, output.Origin(), 0 );
       }
       return;
    }
@@ -148,12 +269,6 @@ void ProjectionScan(
    // Can we treat the images as if they were 1D?
    // TODO: This is an opportunity for improving performance if the non-processing dimensions in in, mask and out have the same layout and simple stride
 
-   // TODO: Determine the number of threads we'll be using. The size of the data has an influence. As is the number of sub-images that we can generate
-   function.SetNumberOfThreads( 1 );
-
-   // TODO: Start threads, each thread makes its own temp image.
-   dip::uint thread = 0;
-
    // Create view over input image, that spans the processing dimensions
    Image tempIn;
    tempIn.CopyProperties( input );
@@ -196,58 +311,87 @@ void ProjectionScan(
    nDims = jj;
    tempOut.SetSizes( outSizes );
    tempOut.SetOriginUnsafe( output.Origin());
-   // Create a temporary output buffer, to collect a single sample in the data type requested by the calling function
-   bool useOutputBuffer = false;
-   Image outBuffer;
-   if( output.DataType() != outImageType ) {
-      // We need a temporary space for the output sample also, because `function.Project` expects `outImageType`.
-      outBuffer.SetDataType( outImageType );
-      outBuffer.Forge(); // By default it's a single sample.
-      useOutputBuffer = true;
+   bool useOutputBuffer = output.DataType() != outImageType;
+
+   // Determine the number of threads we'll be using. The output pixels are divided into equal-sized chunks.
+   dip::uint nOutPixels = outSizes.product();
+   dip::uint nThreads = std::min( GetNumberOfThreads(), nOutPixels );
+   if( nThreads > 1 ) {
+      dip::uint operations;
+      DIP_STACK_TRACE_THIS( operations = nOutPixels * function.GetNumberOfOperations( procSizes.product() ));
+      // The cost model decides whether starting threads is worth while, and how many to start
+      nThreads = GetOptimalNumberOfThreads( operations, nThreads );
    }
+   dip::uint nPixelsPerThread = div_ceil( nOutPixels, nThreads );
+   nThreads = div_ceil( nOutPixels, nPixelsPerThread );
+   std::vector< UnsignedArray > startCoords = ComputeStartPositions( outSizes, nPixelsPerThread, nThreads );
+   DIP_STACK_TRACE_THIS( function.SetNumberOfThreads( nThreads ));
+
+   // Start threads, each thread makes its own temp images
+   DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+      UnsignedArray position = startCoords[ thread ];
+      dip::uint nPixels = std::min( nPixelsPerThread, nOutPixels - thread * nPixelsPerThread );
+
+      // Views over input, mask and output images, shifted to the first pixel this thread processes
+      Image threadIn = tempIn.QuickCopy();
+      Image threadMask;
+      if( hasMask ) {
+         threadMask = tempMask.QuickCopy();
+      }
+      Image threadOut = tempOut.QuickCopy();
+      for( dip::uint dd = 0; dd < nDims; ++dd ) {
+         dip::sint pos = static_cast< dip::sint >( position[ dd ] );
+         threadIn.ShiftOriginUnsafe( pos * inStride[ dd ] );
+         if( hasMask ) {
+            threadMask.ShiftOriginUnsafe( pos * maskStride[ dd ] );
+         }
+         threadOut.ShiftOriginUnsafe( pos * outStride[ dd ] );
+      }
 
-   // Iterate over the pixels in the output image. For each, we create a view in the input image.
-   UnsignedArray position( nDims, 0 );
-   for( ;; ) {
-
-      // Do the thing
+      // Create a temporary output buffer, to collect a single sample in the data type requested by the calling function
+      Image outBuffer;
       if( useOutputBuffer ) {
-         function.Project( tempIn, tempMask, outBuffer.Origin(), thread );
-         // Copy data from output buffer to output image
-         detail::CopyBuffer( outBuffer.Origin(), outBuffer.DataType(), 1, 1,
-                             tempOut.Origin(), tempOut.DataType(), 1, 1, 1, 1 );
-      } else {
-         function.Project( tempIn, tempMask, tempOut.Origin(), thread );
+         // We need a temporary space for the output sample also, because `function.Project` expects `outImageType`.
+         outBuffer.SetDataType( outImageType );
+         outBuffer.Forge(); // By default it's a single sample.
       }
 
-      // Next output pixel
-      dip::uint dd;
-      for( dd = 0; dd < nDims; dd++ ) {
-         ++position[ dd ];
-         tempIn.ShiftOriginUnsafe( inStride[ dd ] );
-         if( hasMask ) {
-            tempMask.ShiftOriginUnsafe( maskStride[ dd ] );
-         }
-         tempOut.ShiftOriginUnsafe( outStride[ dd ] );
-         // Check whether we reached the last pixel of the line
-         if( position[ dd ] != outSizes[ dd ] ) {
-            break;
+      // Iterate over the pixels in the output image. For each, we create a view in the input image.
+      for( dip::uint kk = 0; kk < nPixels; ++kk ) {
+
+         // Do the thing
+         if( useOutputBuffer ) {
+            function.Project( threadIn, threadMask, outBuffer.Origin(), thread );
+            // Copy data from output buffer to output image
+            detail::CopyBuffer( outBuffer.Origin(), outBuffer.DataType(), 1, 1,
+                                threadOut.Origin(), threadOut.DataType(), 1, 1, 1, 1 );
+         } else {
+            function.Project( threadIn, threadMask, threadOut.Origin(), thread );
          }
-         // Rewind along this dimension
-         tempIn.ShiftOriginUnsafe( -inStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
-         if( hasMask ) {
-            tempMask.ShiftOriginUnsafe( -maskStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+
+         // Next output pixel
+         for( dip::uint dd = 0; dd < nDims; dd++ ) {
+            ++position[ dd ];
+            threadIn.ShiftOriginUnsafe( inStride[ dd ] );
+            if( hasMask ) {
+               threadMask.ShiftOriginUnsafe( maskStride[ dd ] );
+            }
+            threadOut.ShiftOriginUnsafe( outStride[ dd ] );
+            // Check whether we reached the last pixel of the line
+            if( position[ dd ] != outSizes[ dd ] ) {
+               break;
+            }
+            // Rewind along this dimension
+            threadIn.ShiftOriginUnsafe( -inStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+            if( hasMask ) {
+               threadMask.ShiftOriginUnsafe( -maskStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+            }
+            threadOut.ShiftOriginUnsafe( -outStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
+            position[ dd ] = 0;
+            // Continue loop to increment along next dimension
          }
-         tempOut.ShiftOriginUnsafe( -outStride[ dd ] * static_cast< dip::sint >( position[ dd ] ));
-         position[ dd ] = 0;
-         // Continue loop to increment along next dimension
-      }
-      if( dd == nDims ) {
-         break;            // We're done!
       }
-   }
-
-   // TODO: End threads.
+   } ));
 }
 
 } // namespace
@@ -255,11 +399,19 @@ void ProjectionScan(
 
 namespace {
 
+// The state for projections that compute a sum and the number of pixels summed over
+template< typename T >
+struct SumAndCount {
+   T sum = 0;
+   dip::uint n = 0;
+};
+
 template< typename TPI, bool ComputeMean_ >
-class ProjectionSumMean : public ProjectionScanFunction {
+class ProjectionSumMean : public ProjectionAccumulatingFunction< SumAndCount< FlexType< TPI >>> {
       using TPO = FlexType< TPI >;
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+      using State = SumAndCount< TPO >;
+   protected:
+      virtual void Accumulate( Image const& in, Image const& mask, State& state ) override {
          dip::uint n = 0;
          TPO sum = 0;
          if( mask.IsForged() ) {
@@ -283,11 +435,19 @@ class ProjectionSumMean : public ProjectionScanFunction {
                n = in.NumberOfPixels();
             }
          }
+         state.sum += sum;
+         state.n += n;
+      }
+      virtual void Combine( State& state, State const& other ) override {
+         state.sum += other.sum;
+         state.n += other.n;
+      }
+      virtual void Finalize( State const& state, void* out ) override {
          if( ComputeMean_ ) {
-            *static_cast< TPO* >( out ) = ( n > 0 ) ? ( sum / static_cast< FloatType< TPI >>( n ))
-                                                    : ( sum );
+            *static_cast< TPO* >( out ) = ( state.n > 0 ) ? ( state.sum / static_cast< FloatType< TPI >>( state.n ))
+                                                          : ( state.sum );
          } else {
-            *static_cast< TPO* >( out ) = sum;
+            *static_cast< TPO* >( out ) = state.sum;
          }
       }
 };
@@ -299,10 +459,11 @@ template< typename TPI >
 using ProjectionMean = ProjectionSumMean< TPI, true >;
 
 template< typename TPI >
-class ProjectionMeanDirectional : public ProjectionScanFunction {
+class ProjectionMeanDirectional : public ProjectionAccumulatingFunction< DirectionalStatisticsAccumulator > {
    public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
-         DirectionalStatisticsAccumulator acc;
+      virtual dip::uint GetNumberOfOperations( dip::uint nPixels ) override { return 40 * nPixels; }
+   protected:
+      virtual void Accumulate( Image const& in, Image const& mask, DirectionalStatisticsAccumulator& acc ) override {
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
             it.OptimizeAndFlatten();
@@ -318,6 +479,11 @@ class ProjectionMeanDirectional : public ProjectionScanFunction {
                acc.Push( static_cast< dfloat >( *it ));
             } while( ++it );
          }
+      }
+      virtual void Combine( DirectionalStatisticsAccumulator& acc, DirectionalStatisticsAccumulator const& other ) override {
+         acc += other;
+      }
+      virtual void Finalize( DirectionalStatisticsAccumulator const& acc, void* out ) override {
          *static_cast< FloatType< TPI >* >( out ) = static_cast< FloatType< TPI >>( acc.Mean() ); // Is the same as FlexType< TPI > because TPI is not complex here.
       }
 };
@@ -356,10 +522,16 @@ void Sum(
 namespace {
 
 template< typename TPI, bool ComputeMean_  >
-class ProjectionProductGeomMean : public ProjectionScanFunction {
+class ProjectionProductGeomMean : public ProjectionAccumulatingFunction< SumAndCount< FlexType< TPI >>> {
       using TPO = FlexType< TPI >;
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+      using State = SumAndCount< TPO >; // `sum` is used to hold the product
+   protected:
+      virtual State InitialState() override {
+         State state;
+         state.sum = 1.0;
+         return state;
+      }
+      virtual void Accumulate( Image const& in, Image const& mask, State& state ) override {
          dip::uint n = 0;
          TPO product = 1.0;
          if( mask.IsForged() ) {
@@ -383,11 +555,19 @@ class ProjectionProductGeomMean : public ProjectionScanFunction {
                n = in.NumberOfPixels();
             }
          }
+         state.sum *= product;
+         state.n += n;
+      }
+      virtual void Combine( State& state, State const& other ) override {
+         state.sum *= other.sum;
+         state.n += other.n;
+      }
+      virtual void Finalize( State const& state, void* out ) override {
          if( ComputeMean_ ) {
-            *static_cast< TPO* >( out ) = ( n > 0 ) ? ( std::pow( product, 1 / static_cast< FloatType< TPO >>( n )))
-                                                    : ( product );
+            *static_cast< TPO* >( out ) = ( state.n > 0 ) ? ( std::pow( state.sum, 1 / static_cast< FloatType< TPO >>( state.n )))
+                                                          : ( state.sum );
          } else {
-            *static_cast< TPO* >( out ) = product;
+            *static_cast< TPO* >( out ) = state.sum;
          }
       }
 };
@@ -420,10 +600,11 @@ void Product(
 namespace {
 
 template< typename TPI, bool ComputeMean_ >
-class ProjectionSumMeanAbs : public ProjectionScanFunction {
+class ProjectionSumMeanAbs : public ProjectionAccumulatingFunction< SumAndCount< FloatType< TPI >>> {
       using TPO = FlexType< TPI >;
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+      using State = SumAndCount< FloatType< TPI >>;
+   protected:
+      virtual void Accumulate( Image const& in, Image const& mask, State& state ) override {
          dip::uint n = 0;
          FloatType< TPI > sum = 0;
          if( mask.IsForged() ) {
@@ -447,11 +628,19 @@ class ProjectionSumMeanAbs : public ProjectionScanFunction {
                n = in.NumberOfPixels();
             }
          }
+         state.sum += sum;
+         state.n += n;
+      }
+      virtual void Combine( State& state, State const& other ) override {
+         state.sum += other.sum;
+         state.n += other.n;
+      }
+      virtual void Finalize( State const& state, void* out ) override {
          if( ComputeMean_ ) {
-            *static_cast< TPO* >( out ) = ( n > 0 ) ? ( sum / static_cast< FloatType< TPI >>( n ))
-                                                    : ( sum );
+            *static_cast< TPO* >( out ) = ( state.n > 0 ) ? ( state.sum / static_cast< FloatType< TPI >>( state.n ))
+                                                          : ( state.sum );
          } else {
-            *static_cast< TPO* >( out ) = sum;
+            *static_cast< TPO* >( out ) = state.sum;
          }
       }
 };
@@ -497,10 +686,11 @@ void SumAbs(
 namespace {
 
 template< typename TPI, bool ComputeMean_ >
-class ProjectionSumMeanSquare : public ProjectionScanFunction {
+class ProjectionSumMeanSquare : public ProjectionAccumulatingFunction< SumAndCount< FlexType< TPI >>> {
       using TPO = FlexType< TPI >;
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+      using State = SumAndCount< TPO >;
+   protected:
+      virtual void Accumulate( Image const& in, Image const& mask, State& state ) override {
          dip::uint n = 0;
          TPO sum = 0;
          if( mask.IsForged() ) {
@@ -526,11 +716,19 @@ class ProjectionSumMeanSquare : public ProjectionScanFunction {
                n = in.NumberOfPixels();
             }
          }
+         state.sum += sum;
+         state.n += n;
+      }
+      virtual void Combine( State& state, State const& other ) override {
+         state.sum += other.sum;
+         state.n += other.n;
+      }
+      virtual void Finalize( State const& state, void* out ) override {
          if( ComputeMean_ ) {
-            *static_cast< TPO* >( out ) = ( n > 0 ) ? ( sum / static_cast< FloatType< TPI >>( n ))
-                                                    : ( sum );
+            *static_cast< TPO* >( out ) = ( state.n > 0 ) ? ( state.sum / static_cast< FloatType< TPI >>( state.n ))
+                                                          : ( state.sum );
          } else {
-            *static_cast< TPO* >( out ) = sum;
+            *static_cast< TPO* >( out ) = state.sum;
          }
       }
 };
@@ -576,11 +774,12 @@ void SumSquare(
 namespace {
 
 template< typename TPI, bool ComputeMean_ >
-class ProjectionSumMeanSquareModulus : public ProjectionScanFunction {
+class ProjectionSumMeanSquareModulus : public ProjectionAccumulatingFunction< SumAndCount< FloatType< TPI >>> {
       // TPI is a complex type.
       using TPO = FloatType< TPI >;
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+      using State = SumAndCount< TPO >;
+   protected:
+      virtual void Accumulate( Image const& in, Image const& mask, State& state ) override {
          dip::uint n = 0;
          TPO sum = 0;
          if( mask.IsForged() ) {
@@ -608,11 +807,19 @@ class ProjectionSumMeanSquareModulus : public ProjectionScanFunction {
                n = in.NumberOfPixels();
             }
          }
+         state.sum += sum;
+         state.n += n;
+      }
+      virtual void Combine( State& state, State const& other ) override {
+         state.sum += other.sum;
+         state.n += other.n;
+      }
+      virtual void Finalize( State const& state, void* out ) override {
          if( ComputeMean_ ) {
-            *static_cast< TPO* >( out ) = ( n > 0 ) ? ( sum / static_cast< TPO >( n ))
-                                                    : ( sum );
+            *static_cast< TPO* >( out ) = ( state.n > 0 ) ? ( state.sum / static_cast< TPO >( state.n ))
+                                                          : ( state.sum );
          } else {
-            *static_cast< TPO* >( out ) = sum;
+            *static_cast< TPO* >( out ) = state.sum;
          }
       }
 };
@@ -658,11 +865,12 @@ void SumSquareModulus(
 namespace {
 
 template< typename TPI, typename ACC >
-class ProjectionVariance : public ProjectionScanFunction {
+class ProjectionVariance : public ProjectionAccumulatingFunction< ACC > {
    public:
       ProjectionVariance( bool computeStD ) : computeStD_( computeStD ) {}
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
-         ACC acc;
+      virtual dip::uint GetNumberOfOperations( dip::uint nPixels ) override { return 4 * nPixels; }
+   protected:
+      virtual void Accumulate( Image const& in, Image const& mask, ACC& acc ) override {
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
             it.OptimizeAndFlatten();
@@ -678,6 +886,11 @@ class ProjectionVariance : public ProjectionScanFunction {
                acc.Push( static_cast< dfloat >( *it ));
             } while( ++it );
          }
+      }
+      virtual void Combine( ACC& acc, ACC const& other ) override {
+         acc += other;
+      }
+      virtual void Finalize( ACC const& acc, void* out ) override {
          *static_cast< FloatType< TPI >* >( out ) = clamp_cast< FloatType< TPI >>(
                computeStD_ ? acc.StandardDeviation() : acc.Variance() );
       }
@@ -760,10 +973,11 @@ struct MinComputer {
 };
 
 template< typename TPI, typename Computer >
-class ProjectionMaxMin : public ProjectionScanFunction {
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
-         TPI res = Computer::init_value;
+class ProjectionMaxMin : public ProjectionAccumulatingFunction< TPI > {
+   protected:
+      virtual TPI InitialState() override { return Computer::init_value; }
+      virtual void Accumulate( Image const& in, Image const& mask, TPI& state ) override {
+         TPI res = state;
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
             it.OptimizeAndFlatten();
@@ -779,7 +993,13 @@ class ProjectionMaxMin : public ProjectionScanFunction {
                res = Computer::compare( res, *it );
             } while( ++it );
          }
-         *static_cast< TPI* >( out ) = res;
+         state = res;
+      }
+      virtual void Combine( TPI& state, TPI const& other ) override {
+         state = Computer::compare( state, other );
+      }
+      virtual void Finalize( TPI const& state, void* out ) override {
+         *static_cast< TPI* >( out ) = state;
       }
 };
 
@@ -824,11 +1044,12 @@ void Minimum(
 namespace {
 
 template< typename TPI, typename Computer >
-class ProjectionMaxMinAbs : public ProjectionScanFunction {
+class ProjectionMaxMinAbs : public ProjectionAccumulatingFunction< AbsType< TPI >> {
       using TPO = AbsType< TPI >;
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
-         TPO res = Computer::init_value;
+   protected:
+      virtual TPO InitialState() override { return Computer::init_value; }
+      virtual void Accumulate( Image const& in, Image const& mask, TPO& state ) override {
+         TPO res = state;
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
             it.OptimizeAndFlatten();
@@ -844,7 +1065,13 @@ class ProjectionMaxMinAbs : public ProjectionScanFunction {
                res = Computer::compare( res, static_cast< TPO >( std::abs( *it )));
             } while( ++it );
          }
-         *static_cast< TPO* >( out ) = res;
+         state = res;
+      }
+      virtual void Combine( TPO& state, TPO const& other ) override {
+         state = Computer::compare( state, other );
+      }
+      virtual void Finalize( TPO const& state, void* out ) override {
+         *static_cast< TPO* >( out ) = state;
       }
 };
 
@@ -979,6 +1206,10 @@ class ProjectionPercentile : public ProjectionScanFunction {
       void SetNumberOfThreads( dip::uint threads ) override {
          buffer_.resize( threads );
       }
+      virtual dip::uint GetNumberOfOperations( dip::uint nPixels ) override {
+         // Copying plus `std::nth_element`, which is linear on average
+         return 4 * nPixels;
+      }
    private:
       std::vector< std::vector< TPI >> buffer_;
       dfloat percentile_;
@@ -1021,9 +1252,10 @@ void MedianAbsoluteDeviation(
 namespace {
 
 template< typename TPI >
-class ProjectionAll : public ProjectionScanFunction {
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+class ProjectionAll : public ProjectionAccumulatingFunction< bin > {
+   protected:
+      virtual bin InitialState() override { return true; }
+      virtual void Accumulate( Image const& in, Image const& mask, bin& state ) override {
          bool all = true;
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
@@ -1044,7 +1276,13 @@ class ProjectionAll : public ProjectionScanFunction {
                }
             } while( ++it );
          }
-         *static_cast< bin* >( out ) = all;
+         state = state && all;
+      }
+      virtual void Combine( bin& state, bin const& other ) override {
+         state = state && other;
+      }
+      virtual void Finalize( bin const& state, void* out ) override {
+         *static_cast< bin* >( out ) = state;
       }
 };
 
@@ -1064,9 +1302,10 @@ void All(
 namespace {
 
 template< typename TPI >
-class ProjectionAny : public ProjectionScanFunction {
-   public:
-      virtual void Project( Image const& in, Image const& mask, void* out, dip::uint ) override {
+class ProjectionAny : public ProjectionAccumulatingFunction< bin > {
+   protected:
+      virtual bin InitialState() override { return false; }
+      virtual void Accumulate( Image const& in, Image const& mask, bin& state ) override {
          bool any = false;
          if( mask.IsForged() ) {
             JointImageIterator< TPI, bin > it( { in, mask } );
@@ -1087,7 +1326,13 @@ class ProjectionAny : public ProjectionScanFunction {
                }
             } while( ++it );
          }
-         *static_cast< bin* >( out ) = any;
+         state = state || any;
+      }
+      virtual void Combine( bin& state, bin const& other ) override {
+         state = state || other;
+      }
+      virtual void Finalize( bin const& state, void* out ) override {
+         *static_cast< bin* >( out ) = state;
       }
 };
 
@@ -1438,6 +1683,37 @@ DOCTEST_TEST_CASE("[DIPlib] testing the projection functions") {
    // Using a view
    out = dip::Maximum( img.At( mask ));
    DOCTEST_CHECK( out.At( 0, 0, 0 ) == dip::Image::Pixel( { 4, 2, 3 } )); // not {4,3,4}
+
+   // Large enough images to be processed in multiple threads (if available)
+   img = dip::Image{ dip::UnsignedArray{ 200, 150, 10 }, 1, dip::DT_UINT16 };
+   img.Fill( 1 );
+   img.At( 10, 20, 5 ) = 1000;
+   img.At( 190, 140, 2 ) = 0;
+   out = dip::Sum( img );
+   DOCTEST_CHECK( out.As< dip::dfloat >() == doctest::Approx( 200.0 * 150.0 * 10.0 + 998.0 ));
+   out = dip::Maximum( img );
+   DOCTEST_CHECK( out.As< dip::uint16 >() == 1000 );
+   out = dip::Minimum( img );
+   DOCTEST_CHECK( out.As< dip::uint16 >() == 0 );
+   out = dip::Maximum( img, {}, { false, false, true } );
+   DOCTEST_CHECK( out.Sizes() == dip::UnsignedArray{ 200, 150, 1 } );
+   DOCTEST_CHECK( out.At( 10, 20, 0 ) == 1000 );
+   DOCTEST_CHECK( out.At( 11, 20, 0 ) == 1 );
+   DOCTEST_CHECK( out.At( 199, 149, 0 ) == 1 );
+   out = dip::Percentile( img, {}, 20.0, { false, false, true } );
+   DOCTEST_CHECK( out.At( 10, 20, 0 ) == 1 );
+   DOCTEST_CHECK( out.At( 190, 140, 0 ) == 1 );
+   out = dip::Minimum( img, {}, { false, false, true } );
+   DOCTEST_CHECK( out.At( 190, 140, 0 ) == 0 );
+   mask = dip::Image{ img.Sizes(), 1, dip::DT_BIN };
+   mask.Fill( 1 );
+   mask.At( 10, 20, 5 ) = 0;
+   out = dip::Mean( img, mask );
+   DOCTEST_CHECK( out.As< dip::dfloat >() == doctest::Approx(( 200.0 * 150.0 * 10.0 - 2.0 ) / ( 200.0 * 150.0 * 10.0 - 1.0 )));
+   out = dip::Any( img == 1000 );
+   DOCTEST_CHECK( out.As< bool >() );
+   out = dip::All( img, mask );
+   DOCTEST_CHECK( !out.As< bool >() );
 }
 
 #endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -27,6 +27,8 @@ class FeatureBendingEnergy : public ChainCodeBased {
    public:
       FeatureBendingEnergy() : ChainCodeBased( { "BendingEnergy", "Bending energy of object perimeter (chain-code method, 2D)", false } ) {};
 
+      virtual bool CanMeasureInParallel() const override { return true; }
+
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint ) override {
          ValueInformationArray out( 1 );
          PhysicalQuantity pq = label.PixelSize( 0 );
@@ -23,9 +23,19 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureCartesianBox : public LineBased {
+struct MinMaxCoord {
+   dip::uint min = std::numeric_limits< dip::uint >::max();
+   dip::uint max = 0;
+   MinMaxCoord& operator+=( MinMaxCoord const& other ) {
+      min = std::min( min, other.min );
+      max = std::max( max, other.max );
+      return *this;
+   }
+};
+
+class FeatureCartesianBox : public ParallelLineBased< MinMaxCoord > {
    public:
-      FeatureCartesianBox() : LineBased( { "CartesianBox", "Cartesian box size of the object in all dimensions", false } ) {};
+      FeatureCartesianBox() : ParallelLineBased( { "CartesianBox", "Cartesian box size of the object in all dimensions", false } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint nObjects ) override {
          nD_ = label.Dimensionality();
@@ -47,13 +57,15 @@ class FeatureCartesianBox : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat >, // unused
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< MinMaxCoord >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't need to fetch the data pointer again
          LabelType objectID = 0;
          MinMaxCoord* data = nullptr;
@@ -65,7 +77,7 @@ class FeatureCartesianBox : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second * nD_ ] );
+                     data = &( accumulators[ it->second * nD_ ] );
                      for( dip::uint ii = 0; ii < nD_; ii++ ) {
                         data[ ii ].min = std::min( data[ ii ].min, coordinates[ ii ] );
                         data[ ii ].max = std::max( data[ ii ].max, coordinates[ ii ] );
@@ -101,13 +113,9 @@ class FeatureCartesianBox : public LineBased {
       }
 
    private:
-      struct MinMaxCoord {
-         dip::uint min = std::numeric_limits< dip::uint >::max();
-         dip::uint max = 0;
-      };
       dip::uint nD_;
       FloatArray scales_;
-      std::vector< MinMaxCoord > data_; // size of this array is nObjects * nD_. Index as data_[ objectIndex * nD_ ]
+      // data_: size of this array is nObjects * nD_. Index as data_[ objectIndex * nD_ ]
 };
 
 
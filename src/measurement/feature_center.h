@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureCenter : public LineBased {
+class FeatureCenter : public ParallelLineBased< dfloat > {
    public:
-      FeatureCenter() : LineBased( { "Center", "Coordinates of the geometric mean of the object", false } ) {};
+      FeatureCenter() : ParallelLineBased( { "Center", "Coordinates of the geometric mean of the object", false } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint nObjects ) override {
          nD_ = label.Dimensionality();
@@ -47,13 +47,15 @@ class FeatureCenter : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat >,
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< dfloat >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          dfloat* data = nullptr;
@@ -65,7 +67,7 @@ class FeatureCenter : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second * ( nD_ + 1 ) ] );
+                     data = &( accumulators[ it->second * ( nD_ + 1 ) ] );
                   }
                }
                if( data ) {
@@ -101,7 +103,7 @@ class FeatureCenter : public LineBased {
    private:
       dip::uint nD_;
       FloatArray scales_;
-      std::vector< dfloat > data_; // size of this array is nObjects * ( nD_ + 1 ). Index as data_[ objectIndex * ( nD_ + 1 ) ]
+      // data_: size of this array is nObjects * ( nD_ + 1 ). Index as data_[ objectIndex * ( nD_ + 1 ) ]
 };
 
 
@@ -27,6 +27,8 @@ class FeatureCircularity : public PolygonBased {
    public:
       FeatureCircularity() : PolygonBased( { "Circularity", "Circularity of the object (2D)", false } ) {};
 
+      virtual bool CanMeasureInParallel() const override { return true; }
+
       virtual ValueInformationArray Initialize( Image const&, Image const&, dip::uint ) override {
          ValueInformationArray out( 1 );
          out[ 0 ].name = "";
@@ -27,6 +27,8 @@ class FeatureConvexPerimeter : public ConvexHullBased {
    public:
       FeatureConvexPerimeter() : ConvexHullBased( { "ConvexPerimeter", "Perimeter of the convex hull (2D)", false } ) {};
 
+      virtual bool CanMeasureInParallel() const override { return true; }
+
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint ) override {
          ValueInformationArray out( 1 );
          out[ 0 ].name = "";
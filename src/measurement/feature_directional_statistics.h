@@ -24,9 +24,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureDirectionalStatistics : public LineBased {
+class FeatureDirectionalStatistics : public ParallelLineBased< DirectionalStatisticsAccumulator > {
    public:
-      FeatureDirectionalStatistics() : LineBased( { "DirectionalStatistics", "Directional mean and standard deviation of object intensity", true } ) {};
+      FeatureDirectionalStatistics() : ParallelLineBased( { "DirectionalStatistics", "Directional mean and standard deviation of object intensity", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& /*label*/, Image const& grey, dip::uint nObjects ) override {
          DIP_THROW_IF( !grey.IsScalar(), E::IMAGE_NOT_SCALAR );
@@ -38,13 +38,15 @@ class FeatureDirectionalStatistics : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< DirectionalStatisticsAccumulator >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          DirectionalStatisticsAccumulator* data = nullptr;
@@ -56,7 +58,7 @@ class FeatureDirectionalStatistics : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -79,7 +81,6 @@ class FeatureDirectionalStatistics : public LineBased {
       }
 
    private:
-      std::vector< DirectionalStatisticsAccumulator > data_;
 };
 
 
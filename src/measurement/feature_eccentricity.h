@@ -26,6 +26,8 @@ class FeatureEccentricity : public PolygonBased {
    public:
       FeatureEccentricity() : PolygonBased( { "Eccentricity", "Aspect ratio of best fit ellipse (2D)", false } ) {};
 
+      virtual bool CanMeasureInParallel() const override { return true; }
+
       virtual ValueInformationArray Initialize( Image const&, Image const&, dip::uint ) override {
          ValueInformationArray out( 1 );
          out[ 0 ].name = "";
@@ -26,6 +26,8 @@ class FeatureEllipseVariance : public PolygonBased {
    public:
       FeatureEllipseVariance() : PolygonBased( { "EllipseVariance", "Distance to best fit ellipse (2D)", false } ) {};
 
+      virtual bool CanMeasureInParallel() const override { return true; }
+
       virtual ValueInformationArray Initialize( Image const&, Image const&, dip::uint ) override {
          ValueInformationArray out( 1 );
          out[ 0 ].name = "";
@@ -27,6 +27,8 @@ class FeatureFeret : public ConvexHullBased {
    public:
       FeatureFeret() : ConvexHullBased( { "Feret", "Maximum and minimum object diameters (2D)", false } ) {};
 
+      virtual bool CanMeasureInParallel() const override { return true; }
+
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint ) override {
          ValueInformationArray out( 5 );
          PhysicalQuantity pq = label.PixelSize( 0 );
@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureGravity : public LineBased {
+class FeatureGravity : public ParallelLineBased< dfloat > {
    public:
-      FeatureGravity() : LineBased( { "Gravity", "Coordinates of the center-of-mass of the grey-value object", true } ) {};
+      FeatureGravity() : ParallelLineBased( { "Gravity", "Coordinates of the center-of-mass of the grey-value object", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const& grey, dip::uint nObjects ) override {
          DIP_THROW_IF( !grey.IsScalar(), E::IMAGE_NOT_SCALAR );
@@ -48,13 +48,15 @@ class FeatureGravity : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< dfloat >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          dfloat* data = nullptr;
@@ -66,7 +68,7 @@ class FeatureGravity : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second * ( nD_ + 1 ) ] );
+                     data = &( accumulators[ it->second * ( nD_ + 1 ) ] );
                   }
                }
                if( data ) {
@@ -103,7 +105,7 @@ class FeatureGravity : public LineBased {
    private:
       dip::uint nD_;
       FloatArray scales_;
-      std::vector< dfloat > data_; // size of this array is nObjects * ( nD_ + 1 ). Index as data_[ objectIndex * ( nD_ + 1 ) ]
+      // data_: size of this array is nObjects * ( nD_ + 1 ). Index as data_[ objectIndex * ( nD_ + 1 ) ]
 };
 
 
@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureGreyMu : public LineBased {
+class FeatureGreyMu : public ParallelLineBased< MomentAccumulator > {
    public:
-      FeatureGreyMu() : LineBased( { "GreyMu", "Elements of the grey-weighted inertia tensor", true } ) {};
+      FeatureGreyMu() : ParallelLineBased( { "GreyMu", "Elements of the grey-weighted inertia tensor", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const& grey, dip::uint nObjects ) override {
          DIP_THROW_IF( !grey.IsScalar(), E::IMAGE_NOT_SCALAR );
@@ -65,13 +65,15 @@ class FeatureGreyMu : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< MomentAccumulator >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          MomentAccumulator* data = nullptr;
@@ -84,7 +86,7 @@ class FeatureGreyMu : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -113,7 +115,6 @@ class FeatureGreyMu : public LineBased {
    private:
       dip::uint nD_;       // number of dimensions (2 or 3).
       FloatArray scales_;  // nOut values.
-      std::vector< MomentAccumulator > data_; // size of this array is nObjects.
 };
 
 
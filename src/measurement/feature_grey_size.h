@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureGreySize : public LineBased {
+class FeatureGreySize : public ParallelLineBased< dfloat > {
    public:
-      FeatureGreySize() : LineBased( { "GreySize", "Mass of object (sum of intensities times size of a pixel)", true } ) {};
+      FeatureGreySize() : ParallelLineBased( { "GreySize", "Mass of object (sum of intensities times size of a pixel)", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const& grey, dip::uint nObjects ) override {
          nTensor_ = grey.TensorElements();
@@ -54,13 +54,15 @@ class FeatureGreySize : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< dfloat >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't need to fetch the data pointer again
          LabelType objectID = 0;
          dfloat* data = nullptr;
@@ -72,7 +74,7 @@ class FeatureGreySize : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -100,7 +102,6 @@ class FeatureGreySize : public LineBased {
    private:
       dfloat scale_;
       dip::uint nTensor_;
-      std::vector< dfloat > data_;
 };
 
 
@@ -23,17 +23,18 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureMaxPos : public LineBased {
+class FeatureMaxPos : public ParallelLineBased< dfloat > {
    public:
-      FeatureMaxPos() : LineBased( { "MaxPos", "Position of pixel with maximum intensity", true } ) {};
+      FeatureMaxPos() : ParallelLineBased( { "MaxPos", "Position of pixel with maximum intensity", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const& grey, dip::uint nObjects ) override {
          DIP_THROW_IF( !grey.IsScalar(), E::IMAGE_NOT_SCALAR );
          nD_ = label.Dimensionality();
-         pos_.clear();
          data_.clear();
-         pos_.resize( nObjects * nD_, 0 );
-         data_.resize( nObjects, -infinity );
+         data_.resize( nObjects * ( nD_ + 1 ), 0 );
+         for( dip::uint ii = 0; ii < nObjects; ++ii ) {
+            data_[ ii * ( nD_ + 1 ) ] = -infinity;
+         }
          scales_.resize( nD_ );
          ValueInformationArray out( nD_ );
          for( dip::uint ii = 0; ii < nD_; ++ii ) {
@@ -50,16 +51,17 @@ class FeatureMaxPos : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< dfloat >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
-         dip::uint* pos = nullptr;
          dfloat* data = nullptr;
          do {
             if( *label > 0 ) {
@@ -67,17 +69,15 @@ class FeatureMaxPos : public LineBased {
                   objectID = *label;
                   auto it = objectIndices.find( objectID );
                   if( it == objectIndices.end() ) {
-                     pos = nullptr;
                      data = nullptr;
                   } else {
-                     pos = &( pos_[ it->second * nD_ ] );
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second * ( nD_ + 1 ) ] );
                   }
                }
-               if( data && ( *data < *grey )) {
-                  *data = *grey;
+               if( data && ( data[ 0 ] < *grey )) {
+                  data[ 0 ] = *grey;
                   for( dip::uint ii = 0; ii < nD_; ++ii ) {
-                     pos[ ii ] = coordinates[ ii ];
+                     data[ ii + 1 ] = static_cast< dfloat >( coordinates[ ii ] );
                   }
                }
             }
@@ -87,15 +87,13 @@ class FeatureMaxPos : public LineBased {
       }
 
       virtual void Finish( dip::uint objectIndex, Measurement::ValueIterator output ) override {
-         dip::uint* pos = &( pos_[ objectIndex * nD_ ] );
+         dfloat* data = &( data_[ objectIndex * ( nD_ + 1 ) ] );
          for( dip::uint ii = 0; ii < nD_; ++ii ) {
-            output[ ii ] = static_cast< dfloat >( pos[ ii ] ) * scales_[ ii ];
+            output[ ii ] = data[ ii + 1 ] * scales_[ ii ];
          }
       }
 
       virtual void Cleanup() override {
-         pos_.clear();
-         pos_.shrink_to_fit();
          data_.clear();
          data_.shrink_to_fit();
       }
@@ -103,8 +101,16 @@ class FeatureMaxPos : public LineBased {
    private:
       dip::uint nD_;
       FloatArray scales_;
-      std::vector< dip::uint > pos_; // size of this array is nObjects. Index as data_[ objectIndex ]
-      std::vector< dfloat > data_; // size of this array is nObjects * nD_. Index as data_[ objectIndex * nD_ ]
+      // data_: size of this array is nObjects * ( nD_ + 1 ). The maximum value for each object is followed by its coordinates
+
+      virtual void Merge( std::vector< dfloat >& data, std::vector< dfloat > const& partial ) override {
+         // Threads processed the image in order, on a tie we keep the value found by the earlier thread
+         for( dip::uint ii = 0; ii < data.size(); ii += nD_ + 1 ) {
+            if( data[ ii ] < partial[ ii ] ) {
+               std::copy_n( partial.begin() + static_cast< dip::sint >( ii ), nD_ + 1, data.begin() + static_cast< dip::sint >( ii ));
+            }
+         }
+      }
 };
 
 
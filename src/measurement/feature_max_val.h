@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureMaxVal : public LineBased {
+class FeatureMaxVal : public ParallelLineBased< dfloat > {
    public:
-      FeatureMaxVal() : LineBased( { "MaxVal", "Maximum object intensity", true } ) {};
+      FeatureMaxVal() : ParallelLineBased( { "MaxVal", "Maximum object intensity", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& /*label*/, Image const& grey, dip::uint nObjects ) override {
          nTensor_ = grey.TensorElements();
@@ -42,13 +42,15 @@ class FeatureMaxVal : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< dfloat >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          dfloat* data = nullptr;
@@ -60,7 +62,7 @@ class FeatureMaxVal : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -87,7 +89,12 @@ class FeatureMaxVal : public LineBased {
 
    private:
       dip::uint nTensor_;
-      std::vector< dfloat > data_;
+
+      virtual void Merge( std::vector< dfloat >& data, std::vector< dfloat > const& partial ) override {
+         for( dip::uint ii = 0; ii < data.size(); ++ii ) {
+            data[ ii ] = std::max( data[ ii ], partial[ ii ] );
+         }
+      }
 };
 
 
@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureMaximum : public LineBased {
+class FeatureMaximum : public ParallelLineBased< dip::uint > {
    public:
-      FeatureMaximum() : LineBased( { "Maximum", "Maximum coordinates of the object", false } ) {};
+      FeatureMaximum() : ParallelLineBased( { "Maximum", "Maximum coordinates of the object", false } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint nObjects ) override {
          nD_ = label.Dimensionality();
@@ -47,13 +47,15 @@ class FeatureMaximum : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat >, // unused
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< dip::uint >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't need to fetch the data pointer again
          LabelType objectID = 0;
          dip::uint* data = nullptr;
@@ -65,7 +67,7 @@ class FeatureMaximum : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second * nD_ ] );
+                     data = &( accumulators[ it->second * nD_ ] );
                      for( dip::uint ii = 0; ii < nD_; ++ii ) {
                         data[ ii ] = std::max( data[ ii ], coordinates[ ii ] );
                      }
@@ -96,7 +98,13 @@ class FeatureMaximum : public LineBased {
    private:
       dip::uint nD_;
       FloatArray scales_;
-      std::vector< dip::uint > data_; // size of this array is nObjects * nD_. Index as data_[ objectIndex * nD_ ]
+      // data_: size of this array is nObjects * nD_. Index as data_[ objectIndex * nD_ ]
+
+      virtual void Merge( std::vector< dip::uint >& data, std::vector< dip::uint > const& partial ) override {
+         for( dip::uint ii = 0; ii < data.size(); ++ii ) {
+            data[ ii ] = std::max( data[ ii ], partial[ ii ] );
+         }
+      }
 };
 
 
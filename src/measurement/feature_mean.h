@@ -23,9 +23,19 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureMean : public LineBased {
+struct MeanAccumulator {
+   dfloat sum = 0;
+   dip::uint number = 0;
+   MeanAccumulator& operator+=( MeanAccumulator const& other ) {
+      sum += other.sum;
+      number += other.number;
+      return *this;
+   }
+};
+
+class FeatureMean : public ParallelLineBased< MeanAccumulator > {
    public:
-      FeatureMean() : LineBased( { "Mean", "Mean object intensity", true } ) {};
+      FeatureMean() : ParallelLineBased( { "Mean", "Mean object intensity", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& /*label*/, Image const& grey, dip::uint nObjects ) override {
          nTensor_ = grey.TensorElements();
@@ -42,16 +52,18 @@ class FeatureMean : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< MeanAccumulator >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
-         Data* data = nullptr;
+         MeanAccumulator* data = nullptr;
          do {
             if( *label > 0 ) {
                if( *label != objectID ) {
@@ -60,7 +72,7 @@ class FeatureMean : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second * nTensor_ ] );
+                     data = &( accumulators[ it->second * nTensor_ ] );
                   }
                }
                if( data ) {
@@ -75,7 +87,7 @@ class FeatureMean : public LineBased {
       }
 
       virtual void Finish( dip::uint objectIndex, Measurement::ValueIterator output ) override {
-         Data* data = &data_[ objectIndex * nTensor_ ];
+         MeanAccumulator* data = &data_[ objectIndex * nTensor_ ];
          for( dip::uint ii = 0; ii < nTensor_; ++ii ) {
             output[ ii ] = ( data[ ii ].number != 0 ) ? ( data[ ii ].sum / static_cast< dfloat >( data[ ii ].number )) : ( 0.0 );
          }
@@ -87,12 +99,7 @@ class FeatureMean : public LineBased {
       }
 
    private:
-      struct Data {
-         dfloat sum = 0;
-         dip::uint number = 0;
-      };
       dip::uint nTensor_;
-      std::vector< Data > data_;
 };
 
 
@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureMu : public LineBased {
+class FeatureMu : public ParallelLineBased< MomentAccumulator > {
    public:
-      FeatureMu() : LineBased( { "Mu", "Elements of the inertia tensor", false } ) {};
+      FeatureMu() : ParallelLineBased( { "Mu", "Elements of the inertia tensor", false } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint nObjects ) override {
          nD_ = label.Dimensionality();
@@ -64,13 +64,15 @@ class FeatureMu : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat >,
             UnsignedArray coordinates,
             dip::uint dimension,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< MomentAccumulator >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          MomentAccumulator* data = nullptr;
@@ -83,7 +85,7 @@ class FeatureMu : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -111,7 +113,6 @@ class FeatureMu : public LineBased {
    private:
       dip::uint nD_;       // number of dimensions (2 or 3).
       FloatArray scales_;  // nOut values.
-      std::vector< MomentAccumulator > data_; // size of this array is nObjects.
 };
 
 
@@ -27,6 +27,8 @@ class FeatureRadius : public PolygonBased {
    public:
       FeatureRadius() : PolygonBased( { "Radius", "Statistics on radius of object (2D)", false } ) {};
 
+      virtual bool CanMeasureInParallel() const override { return true; }
+
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint ) override {
          ValueInformationArray out( 4 );
          PhysicalQuantity pq = label.PixelSize( 0 );
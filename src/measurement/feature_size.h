@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureSize : public LineBased {
+class FeatureSize : public ParallelLineBased< dip::uint > {
    public:
-      FeatureSize() : LineBased( { "Size", "Number of object pixels", false } ) {};
+      FeatureSize() : ParallelLineBased( { "Size", "Number of object pixels", false } ) {};
 
       virtual ValueInformationArray Initialize( Image const& label, Image const&, dip::uint nObjects ) override {
          data_.clear();
@@ -59,13 +59,15 @@ class FeatureSize : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat >, // unused
             UnsignedArray, // unused
             dip::uint, // unused
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< dip::uint >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't need to fetch the data pointer again
          LabelType objectID = 0;
          dip::uint* data = nullptr;
@@ -77,7 +79,7 @@ class FeatureSize : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -98,7 +100,6 @@ class FeatureSize : public LineBased {
 
    private:
       dfloat scale_;
-      std::vector< dip::uint > data_;
 };
 
 
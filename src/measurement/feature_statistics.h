@@ -24,9 +24,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureStatistics : public LineBased {
+class FeatureStatistics : public ParallelLineBased< StatisticsAccumulator > {
    public:
-      FeatureStatistics() : LineBased( { "Statistics", "Mean, standard deviation, skewness and excess kurtosis of object intensity", true } ) {};
+      FeatureStatistics() : ParallelLineBased( { "Statistics", "Mean, standard deviation, skewness and excess kurtosis of object intensity", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& /*label*/, Image const& grey, dip::uint nObjects ) override {
          DIP_THROW_IF( !grey.IsScalar(), E::IMAGE_NOT_SCALAR );
@@ -40,13 +40,15 @@ class FeatureStatistics : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< StatisticsAccumulator >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          StatisticsAccumulator* data = nullptr;
@@ -58,7 +60,7 @@ class FeatureStatistics : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -83,7 +85,6 @@ class FeatureStatistics : public LineBased {
       }
 
    private:
-      std::vector< StatisticsAccumulator > data_;
 };
 
 
@@ -23,9 +23,9 @@ namespace dip {
 namespace Feature {
 
 
-class FeatureStandardDeviation : public LineBased {
+class FeatureStandardDeviation : public ParallelLineBased< FastVarianceAccumulator > {
    public:
-      FeatureStandardDeviation() : LineBased( { "StandardDeviation", "Standard deviation of object intensity", true } ) {};
+      FeatureStandardDeviation() : ParallelLineBased( { "StandardDeviation", "Standard deviation of object intensity", true } ) {};
 
       virtual ValueInformationArray Initialize( Image const& /*label*/, Image const& grey, dip::uint nObjects ) override {
          nTensor_ = grey.TensorElements();
@@ -42,13 +42,15 @@ class FeatureStandardDeviation : public LineBased {
          return out;
       }
 
-      virtual void ScanLine(
+      virtual void ScanLinePartial(
             LineIterator< LabelType > label,
             LineIterator< dfloat > grey,
             UnsignedArray /*coordinates*/,
             dip::uint /*dimension*/,
-            ObjectIdToIndexMap const& objectIndices
+            ObjectIdToIndexMap const& objectIndices,
+            dip::uint thread
       ) override {
+         std::vector< FastVarianceAccumulator >& accumulators = Accumulators( thread );
          // If new objectID is equal to previous one, we don't to fetch the data pointer again
          LabelType objectID = 0;
          FastVarianceAccumulator* data = nullptr;
@@ -60,7 +62,7 @@ class FeatureStandardDeviation : public LineBased {
                   if( it == objectIndices.end() ) {
                      data = nullptr;
                   } else {
-                     data = &( data_[ it->second ] );
+                     data = &( accumulators[ it->second ] );
                   }
                }
                if( data ) {
@@ -87,7 +89,6 @@ class FeatureStandardDeviation : public LineBased {
 
    private:
       dip::uint nTensor_;
-      std::vector< FastVarianceAccumulator > data_;
 };
 
 
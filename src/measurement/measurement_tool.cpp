@@ -24,6 +24,9 @@
 #include "diplib/chain_code.h"
 #include "diplib/framework.h"
 #include "diplib/regions.h"
+#include "diplib/multithreading.h"
+
+#include "parallel_line_based.h"
 
 // FEATURES:
 // Size
@@ -129,6 +132,23 @@ MeasurementTool::MeasurementTool() {
    Register( new Feature::FeatureGreyDimensionsEllipsoid );
 }
 
+namespace Feature {
+
+void LineBased::ScanLinePartial(
+      LineIterator< LabelType > label,
+      LineIterator< dfloat > grey,
+      UnsignedArray coordinates,
+      dip::uint dimension,
+      ObjectIdToIndexMap const& objectIndices,
+      dip::uint thread
+) {
+   ( void )thread;
+   DIP_ASSERT( thread == 0 );
+   ScanLine( label, grey, std::move( coordinates ), dimension, objectIndices );
+}
+
+} // namespace Feature
+
 using LineBasedFeatureArray = std::vector< Feature::LineBased* >;
 using FeatureArray = std::vector< Feature::Base* >;
 
@@ -139,7 +159,17 @@ namespace {
 // that we call here are not overloaded.
 class MeasureLineFilter : public Framework::ScanLineFilter {
    public:
-      // not defining GetNumberOfOperations(), always called in a single thread
+      virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override {
+         return 5 * features.size();
+      }
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         // Only called with `threads > 1` if all features can scan in parallel
+         for( auto const& feature : features ) {
+            if( feature->CanScanInParallel() ) {
+               feature->SetNumberOfThreads( threads );
+            }
+         }
+      }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          LineIterator< LabelType > label(
                static_cast< LabelType* >( params.inBuffer[ 0 ].buffer ),
@@ -158,7 +188,7 @@ class MeasureLineFilter : public Framework::ScanLineFilter {
          for( auto const& feature : features ) {
             // NOTE! params.dimension here works as long as params.tensorToSpatial is false.
             // As is now, MeasurementTool::Measure only works with scalar images, so we don't need to test here.
-            feature->ScanLine( label, grey, params.position, params.dimension, objectIndices );
+            feature->ScanLinePartial( label, grey, params.position, params.dimension, objectIndices, params.thread );
          }
       }
       MeasureLineFilter( LineBasedFeatureArray const& features, ObjectIdToIndexMap const& objectIndices ) :
@@ -271,10 +301,32 @@ Measurement MeasurementTool::Measure(
       }
       ImageRefArray outar{};
 
-      // Do the scan, which calls dip::Feature::LineBased::ScanLine()
+      // Can we scan the image in parallel?
+      Framework::ScanOptions opts = Framework::ScanOption::NeedCoordinates;
+      bool parallel = std::all_of( lineBasedFeatures.begin(), lineBasedFeatures.end(),
+                                   []( Feature::LineBased* feature ){ return feature->CanScanInParallel(); } );
+      if( parallel && ( GetNumberOfThreads() > 1 )) {
+         // Turn off multithreading if we'll do a lot of work merging the partial results.
+         dip::uint parallelOperations = label.NumberOfPixels() * 5 * lineBasedFeatures.size();
+         dip::uint sequentialOperations = ( GetNumberOfThreads() - 1 ) * measurement.NumberOfObjects() * 2 * lineBasedFeatures.size();
+         if( parallelOperations / GetNumberOfThreads() + sequentialOperations + GetThreadingThreshold() > parallelOperations ) {
+            parallel = false;
+         }
+      }
+      if( !parallel ) {
+         opts += Framework::ScanOption::NoMultiThreading;
+      }
+
+      // Do the scan, which calls dip::Feature::LineBased::ScanLinePartial()
       MeasureLineFilter functor{ lineBasedFeatures, measurement.ObjectIndices() };
-      Framework::Scan( inar, outar, inBufT, {}, {}, {}, functor,
-            Framework::ScanOption::NoMultiThreading + Framework::ScanOption::NeedCoordinates );
+      Framework::Scan( inar, outar, inBufT, {}, {}, {}, functor, opts );
+
+      // Call dip::Feature::LineBased::MergePartial()
+      if( parallel ) {
+         for( auto const& feature : lineBasedFeatures ) {
+            feature->MergePartial();
+         }
+      }
 
       // Call dip::Feature::LineBased::Finish()
       for( auto const& feature : lineBasedFeatures ) {
@@ -299,30 +351,57 @@ Measurement MeasurementTool::Measure(
    // Let the chaincode based functions do their work
    if( doChaincodeBased || doPolygonBased || doConvHullBased ) {
       ChainCodeArray chainCodeArray = GetImageChainCodes( label, measurement.Objects(), connectivity );
-      auto itCC = chainCodeArray.begin();
-      auto itObj = measurement.FirstObject(); // these two arrays are ordered the same way
-      do {
-         Polygon polygon;
-         ConvexHull convexHull;
-         if( doPolygonBased || doConvHullBased ) {
-            polygon = itCC->Polygon();
+      // Find the feature columns, the chain code array is ordered the same way as the measurement objects
+      std::vector< Feature::Base* > objectFeatures;
+      std::vector< dip::uint > objectFeatureColumns;
+      for( auto const& feature : featureArray ) {
+         if(( feature->type == Feature::Type::CHAINCODE_BASED ) ||
+            ( feature->type == Feature::Type::POLYGON_BASED ) ||
+            ( feature->type == Feature::Type::CONVEXHULL_BASED )) {
+            objectFeatures.push_back( feature );
+            objectFeatureColumns.push_back( measurement.ValueIndex( feature->information.name ));
          }
-         if( doConvHullBased ) {
-            convexHull = polygon.ConvexHull();
+      }
+      Measurement::ValueIterator data = measurement.Data();
+      dip::sint stride = measurement.Stride();
+      dip::uint nObjects = chainCodeArray.size();
+      // Objects are processed in parallel if all features allow it, the cost per object is on the order of the
+      // number of chain code elements
+      bool parallel = std::all_of( objectFeatures.begin(), objectFeatures.end(),
+                                   []( Feature::Base* feature ){ return feature->CanMeasureInParallel(); } );
+      dip::uint nThreads = parallel ? GetNumberOfThreads() : 1;
+      if( nThreads > 1 ) {
+         dip::uint operations = 0;
+         for( auto const& cc : chainCodeArray ) {
+            operations += ( cc.codes.size() + 10 ) * objectFeatures.size() * ( doConvHullBased ? 10 : 2 );
          }
-         for( auto const& feature : featureArray ) {
-            if( feature->type == Feature::Type::CHAINCODE_BASED ) {
-               auto cell = itObj[ feature->information.name ];
-               dynamic_cast< Feature::ChainCodeBased* >( feature )->Measure( *itCC, cell.data() );
-            } else if( feature->type == Feature::Type::POLYGON_BASED ) {
-               auto cell = itObj[ feature->information.name ];
-               dynamic_cast< Feature::PolygonBased* >( feature )->Measure( polygon, cell.data() );
-            } else if( feature->type == Feature::Type::CONVEXHULL_BASED ) {
-               auto cell = itObj[ feature->information.name ];
-               dynamic_cast< Feature::ConvexHullBased* >( feature )->Measure( convexHull, cell.data() );
+         nThreads = std::min( GetOptimalNumberOfThreads( operations, nThreads ), nObjects );
+      }
+      DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+         for( dip::uint ii = thread; ii < nObjects; ii += nThreads ) {
+            ChainCode const& chainCode = chainCodeArray[ ii ];
+            Polygon polygon;
+            ConvexHull convexHull;
+            if( doPolygonBased || doConvHullBased ) {
+               polygon = chainCode.Polygon();
+            }
+            if( doConvHullBased ) {
+               convexHull = polygon.ConvexHull();
+            }
+            Measurement::ValueIterator row = data + static_cast< dip::sint >( ii ) * stride;
+            for( dip::uint jj = 0; jj < objectFeatures.size(); ++jj ) {
+               Feature::Base* feature = objectFeatures[ jj ];
+               Measurement::ValueIterator cell = row + objectFeatureColumns[ jj ];
+               if( feature->type == Feature::Type::CHAINCODE_BASED ) {
+                  dynamic_cast< Feature::ChainCodeBased* >( feature )->Measure( chainCode, cell );
+               } else if( feature->type == Feature::Type::POLYGON_BASED ) {
+                  dynamic_cast< Feature::PolygonBased* >( feature )->Measure( polygon, cell );
+               } else { // feature->type == Feature::Type::CONVEXHULL_BASED
+                  dynamic_cast< Feature::ConvexHullBased* >( feature )->Measure( convexHull, cell );
+               }
             }
          }
-      } while( ++itCC, ++itObj );
+      } ));
    }
 
    // Let the composite functions do their work
@@ -347,3 +426,97 @@ Measurement MeasurementTool::Measure(
 }
 
 } // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/testing.h"
+
+namespace {
+
+// A user-defined feature that only overrides `ScanLine`
+class CountPixels : public dip::Feature::LineBased {
+   public:
+      CountPixels() : LineBased( { "CountPixels", "Number of object pixels", false } ) {};
+      dip::Feature::ValueInformationArray Initialize( dip::Image const&, dip::Image const&, dip::uint nObjects ) override {
+         data_.assign( nObjects, 0 );
+         return dip::Feature::ValueInformationArray( 1 );
+      }
+      void ScanLine(
+            dip::LineIterator< dip::LabelType > label,
+            dip::LineIterator< dip::dfloat >,
+            dip::UnsignedArray,
+            dip::uint,
+            dip::ObjectIdToIndexMap const& objectIndices
+      ) override {
+         do {
+            auto it = objectIndices.find( *label );
+            if( it != objectIndices.end() ) {
+               ++data_[ it->second ];
+            }
+         } while( ++label );
+      }
+      void Finish( dip::uint objectIndex, dip::Measurement::ValueIterator output ) override {
+         *output = static_cast< dip::dfloat >( data_[ objectIndex ] );
+      }
+   private:
+      std::vector< dip::uint > data_;
+};
+
+// A user-defined feature that is not thread-safe
+class PolygonArea : public dip::Feature::PolygonBased {
+   public:
+      PolygonArea() : PolygonBased( { "PolygonArea", "Area of the polygon", false } ) {};
+      dip::Feature::ValueInformationArray Initialize( dip::Image const&, dip::Image const&, dip::uint ) override {
+         return dip::Feature::ValueInformationArray( 1 );
+      }
+      void Measure( dip::Polygon const& polygon, dip::Measurement::ValueIterator output ) override {
+         *output = polygon.Area();
+      }
+};
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::MeasurementTool::Measure with multiple threads") {
+   // Using integer grey values, such that sums are exact and don't depend on the order of accumulation
+   dip::Random random( 0 );
+   dip::Image grey{ dip::UnsignedArray{ 400, 300 }, 1, dip::DT_SFLOAT };
+   grey.Fill( 0 );
+   dip::UniformNoise( grey, grey, random, 0.0, 20.0 );
+   grey = dip::Convert( grey, dip::DT_UINT8 );
+   dip::Image label = dip::Label( grey > 12, 2 );
+   dip::StringArray features{ "Size", "Mass", "Mean", "StandardDeviation", "MaxVal", "MinPos", "MaxPos",
+                              "CartesianBox", "Center", "Gravity", "Mu", "Perimeter", "Feret", "ConvexArea" };
+   dip::MeasurementTool tool;
+   dip::testing::FourThreads fourThreads;
+   auto executor = std::make_shared< dip::testing::RecordingExecutor >();
+   dip::SetExecutor( executor );
+   dip::SetNumberOfThreads( 1 );
+   dip::Measurement ref = tool.Measure( label, grey, features );
+   DOCTEST_CHECK( executor->maxTasks <= 1 );
+   dip::SetNumberOfThreads( 4 );
+   dip::Measurement msr = tool.Measure( label, grey, features );
+   DOCTEST_REQUIRE( msr.DataSize() == ref.DataSize() );
+   dip::uint nDifferent = 0;
+   for( dip::uint ii = 0; ii < ref.DataSize(); ++ii ) {
+      if( msr.Data()[ ii ] != ref.Data()[ ii ] ) {
+         ++nDifferent;
+      }
+   }
+   DOCTEST_CHECK( nDifferent == 0 );
+#ifdef _OPENMP
+   DOCTEST_CHECK( executor->maxTasks > 1 );
+#endif
+
+   // User-defined features that don't opt in are never called in parallel
+   tool.Register( new CountPixels );
+   tool.Register( new PolygonArea );
+   executor->maxTasks = 0;
+   dip::Measurement user = tool.Measure( label, {}, { "CountPixels", "PolygonArea", "Size" } );
+   DOCTEST_CHECK( executor->maxTasks <= 1 );
+   DOCTEST_CHECK( user[ "CountPixels" ][ 1 ][ 0 ] == ref[ "Size" ][ 1 ][ 0 ] );
+   DOCTEST_CHECK( user[ "Size" ][ 5 ][ 0 ] == ref[ "Size" ][ 5 ][ 0 ] );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
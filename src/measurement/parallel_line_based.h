@@ -0,0 +1,77 @@
+/*
+ * DIPlib 3.0
+ * This file defines a base class for line-based measurement features that can scan in parallel
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+namespace dip {
+namespace Feature {
+
+
+// A line-based feature that accumulates into `data_`, an array of `T`. When the image is scanned in parallel,
+// each thread other than thread 0 accumulates into a copy of `data_` as it was after `Initialize`. These copies
+// are combined into `data_` with `Merge`, in thread order. Derived classes override `ScanLinePartial`, using
+// `Accumulators( thread )` to obtain the array to accumulate into.
+template< typename T >
+class ParallelLineBased : public LineBased {
+   public:
+      explicit ParallelLineBased( Information const& information ) : LineBased( information ) {};
+
+      virtual void ScanLine(
+            LineIterator< LabelType > label,
+            LineIterator< dfloat > grey,
+            UnsignedArray coordinates,
+            dip::uint dimension,
+            ObjectIdToIndexMap const& objectIndices
+      ) override final {
+         ScanLinePartial( label, grey, std::move( coordinates ), dimension, objectIndices, 0 );
+      }
+
+      virtual bool CanScanInParallel() const override final { return true; }
+
+      virtual void SetNumberOfThreads( dip::uint nThreads ) override final {
+         partial_.assign( nThreads - 1, data_ );
+      }
+
+      virtual void MergePartial() override final {
+         for( auto const& partial : partial_ ) {
+            Merge( data_, partial );
+         }
+         partial_.clear();
+      }
+
+   protected:
+      // Combines the accumulators of a later thread, `partial`, into `data`. The default adds them together.
+      virtual void Merge( std::vector< T >& data, std::vector< T > const& partial ) {
+         for( dip::uint ii = 0; ii < data.size(); ++ii ) {
+            data[ ii ] += partial[ ii ];
+         }
+      }
+
+      std::vector< T >& Accumulators( dip::uint thread ) {
+         return thread == 0 ? data_ : partial_[ thread - 1 ];
+      }
+
+      std::vector< T > data_;
+
+   private:
+      std::vector< std::vector< T >> partial_; // accumulators for threads 1 and up
+};
+
+
+} // namespace feature
+} // namespace dip
@@ -18,6 +18,8 @@
  * limitations under the License.
  */
 
+#include <atomic>
+
 #include "diplib.h"
 #include "diplib/microscopy.h"
 #include "diplib/generation.h"
@@ -1066,14 +1068,12 @@ void SimulatedAttenuation(
    dip::sint depth = static_cast< dip::sint >( fIn.Size( 2 ));
    dip::uint rad = 2 * static_cast< dip::uint >( zxratio * static_cast< dfloat >( depth - 1 ) * std::tan( theta )) + 1;
 
-#ifdef _OPENMP
    dip::uint nThreads = std::min( GetNumberOfThreads(), fIn.Size( 2 ) /* ==depth */ );
-#endif
-   #pragma omp parallel num_threads( static_cast< int >( nThreads ))
-   {
+   std::atomic< dip::sint > nextZ{ 1 }; // Slices are handed out one at a time, deeper ones are more expensive
+   auto threadTask = [ & ]( dip::uint /*thread*/ ) {
       FloatArray cosine( rad * rad );
-      #pragma omp for schedule( dynamic, 1 )
-      for( dip::sint z = 1; z < depth; ++z ) {
+      for( dip::sint z = nextZ++; z < depth; z = nextZ++ ) {
+         ThrowIfCancelled();
          dip::sint radius;
          sfloat norm_cos, norm_cossq;
          std::tie( radius, norm_cos, norm_cossq ) = AttSimDrawLightCone( cosine, zxratio, theta, z );
@@ -1113,7 +1113,8 @@ void SimulatedAttenuation(
             }
          }
       }
-   }
+   };
+   ParallelRun( nThreads, threadTask );
    // Copy data over to `out` if `out` wasn't DT_SFLOAT
    if( fOut.Origin() != out.Origin() ) {
       out.Copy( fOut );
@@ -877,6 +877,8 @@ void BasicMorphology(
 #include "doctest.h"
 #include "diplib/statistics.h"
 #include "diplib/iterators.h"
+#include "diplib/generation.h"
+#include "diplib/testing.h"
 
 DOCTEST_TEST_CASE("[DIPlib] testing the basic morphological filters") {
    dip::Image in( { 64, 41 }, 1, dip::DT_UINT8 );
@@ -1091,11 +1093,31 @@ DOCTEST_TEST_CASE("[DIPlib] testing the basic morphological filters") {
    DOCTEST_CHECK( out.At( 32, 20 ) == pval );
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing morphology with a mirrored grey-value structuring element") {
+   dip::Image img{ dip::UnsignedArray{ 40, 30 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 100.0 );
+   dip::Image weights{ dip::UnsignedArray{ 5, 3 }, 1, dip::DT_SFLOAT };
+   weights.Fill( 0 );
+   dip::UniformNoise( weights, weights, random, 0.0, 20.0 );
+   // Mirroring the SE is the same as mirroring its weights image (odd sizes, so the origin doesn't shift)
+   dip::StructuringElement se = weights;
+   se.Mirror();
+   dip::Image flipped = weights.QuickCopy();
+   flipped.Mirror();
+   dip::Image out1 = dip::Dilation( img, se );
+   dip::Image out2 = dip::Dilation( img, dip::StructuringElement( flipped ));
+   DOCTEST_CHECK( dip::testing::CompareImages( out1, out2, dip::Option::CompareImagesMode::EXACT ));
+   // The opening mirrors the SE for its second step, it must be anti-extensive and idempotent
+   dip::Image opened = dip::Opening( img, se );
+   DOCTEST_CHECK( dip::Count( opened > img + 1e-3 ) == 0 ); // allow for rounding errors
+   DOCTEST_CHECK( dip::testing::CompareImages( dip::Opening( opened, se ), opened, dip::Option::CompareImagesMode::APPROX, 1e-4 ));
+}
+
 #ifdef _OPENMP
 
 #include "diplib/multithreading.h"
-#include "diplib/generation.h"
-#include "diplib/testing.h"
 
 DOCTEST_TEST_CASE("[DIPlib] testing the full framework under multithreading") {
 
@@ -0,0 +1,606 @@
+/*
+ * DIPlib 3.0
+ * This file contains the definition for dip::ComponentTree.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "diplib.h"
+#include "diplib/component_tree.h"
+#include "diplib/neighborlist.h"
+#include "diplib/multithreading.h"
+#include "diplib/overload.h"
+
+namespace dip {
+
+constexpr ComponentTree::NodeIndex ComponentTree::NOT_IN_TREE;
+
+namespace {
+
+constexpr dip::uint NONE = ComponentTree::NOT_IN_TREE;
+
+// Calls `function( paddedIndex, index )` for each pixel in the planes [`first`,`last`) along the last dimension of
+// an image of sizes `sizes`. `index` is the pixel's linear index, `paddedIndex` is the linear index of the same pixel
+// in an image with a one-pixel border, which has normal strides `paddedStrides`.
+template< typename F >
+void ForEachPixel( UnsignedArray const& sizes, IntegerArray const& paddedStrides, dip::uint first, dip::uint last, F const& function ) {
+   dip::uint nDims = sizes.size();
+   if( nDims == 1 ) {
+      for( dip::uint ii = first; ii < last; ++ii ) {
+         function( ii + 1, ii );
+      }
+      return;
+   }
+   if( first >= last ) {
+      return;
+   }
+   dip::uint index = first * ( sizes.product() / sizes.back() );
+   UnsignedArray coords( nDims, 0 );
+   coords.back() = first;
+   for( ;; ) {
+      dip::uint paddedIndex = 0;
+      for( dip::uint ii = 0; ii < nDims; ++ii ) {
+         paddedIndex += ( coords[ ii ] + 1 ) * static_cast< dip::uint >( paddedStrides[ ii ] );
+      }
+      for( dip::uint ii = 0; ii < sizes[ 0 ]; ++ii, ++paddedIndex, ++index ) {
+         function( paddedIndex, index );
+      }
+      dip::uint ii;
+      for( ii = 1; ii < nDims; ++ii ) {
+         ++( coords[ ii ] );
+         if( coords[ ii ] < sizes[ ii ] ) {
+            break;
+         }
+         coords[ ii ] = 0;
+      }
+      if(( ii == nDims ) || ( coords.back() >= last )) {
+         break;
+      }
+   }
+}
+
+// Builds the component tree in the padded index space. `parent` is the parent of each pixel, which is either a pixel
+// at a lower level (for a level root, the pixel that represents the node), or the level root of the pixel's node.
+// Pixels outside the image or the mask have `NONE` as parent.
+template< typename TPI >
+class ComponentTreeBuilder {
+   public:
+      ComponentTreeBuilder( dip::uint nPixels, IntegerArray const& neighborOffsets, bool maxTree )
+            : grey_( nPixels ), parent_( nPixels, NONE ), zpar_( nPixels, NONE ),
+              neighborOffsets_( neighborOffsets ), maxTree_( maxTree ) {}
+
+      // Copies the image values for the given planes into the padded image, and collects the pixels within the mask
+      void CollectPixels(
+            TPI const* in, bin const* mask, UnsignedArray const& sizes, IntegerArray const& paddedStrides,
+            dip::uint first, dip::uint last, std::vector< dip::uint >& pixels
+      ) {
+         ForEachPixel( sizes, paddedStrides, first, last, [ & ]( dip::uint paddedIndex, dip::uint index ) {
+            grey_[ paddedIndex ] = in[ index ];
+            if( !mask || mask[ index ] ) {
+               pixels.push_back( paddedIndex );
+            }
+         } );
+         std::sort( pixels.begin(), pixels.end(), [ this ]( dip::uint a, dip::uint b ) { return LeafFirst( a, b ); } );
+      }
+
+      // Builds the tree for the pixels in `pixels`, which are all in the padded index range [`begin`,`end`)
+      void BuildSlab( std::vector< dip::uint > const& pixels, dip::uint begin, dip::uint end ) {
+         for( dip::uint p : pixels ) {
+            parent_[ p ] = p;
+            zpar_[ p ] = p;
+            for( dip::sint o : neighborOffsets_ ) {
+               dip::uint n = static_cast< dip::uint >( static_cast< dip::sint >( p ) + o );
+               if(( n < begin ) || ( n >= end ) || ( zpar_[ n ] == NONE )) {
+                  continue; // Not yet processed, or outside the slab, or outside the mask
+               }
+               dip::uint r = FindRoot( n );
+               if( r != p ) {
+                  parent_[ r ] = p;
+                  zpar_[ r ] = p;
+               }
+            }
+         }
+         // Canonicalize: make each pixel point to a level root
+         for( auto it = pixels.rbegin(); it != pixels.rend(); ++it ) {
+            dip::uint q = parent_[ *it ];
+            if( grey_[ parent_[ q ]] == grey_[ q ] ) {
+               parent_[ *it ] = parent_[ q ];
+            }
+         }
+      }
+
+      // Merges the trees on either side of the plane starting at padded index `boundary`
+      void MergeSlabs( dip::uint boundary, dip::uint planeStride ) {
+         for( dip::uint p = boundary; p < boundary + planeStride; ++p ) {
+            if( parent_[ p ] == NONE ) {
+               continue;
+            }
+            for( dip::sint o : neighborOffsets_ ) {
+               dip::uint n = static_cast< dip::uint >( static_cast< dip::sint >( p ) + o );
+               if(( n < boundary ) && ( n + planeStride >= boundary ) && ( parent_[ n ] != NONE )) {
+                  Connect( p, n );
+               }
+            }
+         }
+      }
+
+      // Merges two lists of pixels sorted with `LeafFirst`
+      void MergeLists( std::vector< dip::uint >& a, std::vector< dip::uint >& b ) {
+         std::vector< dip::uint > out( a.size() + b.size() );
+         std::merge( a.begin(), a.end(), b.begin(), b.end(), out.begin(),
+                     [ this ]( dip::uint a, dip::uint b ) { return LeafFirst( a, b ); } );
+         a.swap( out );
+         b.clear();
+         b.shrink_to_fit();
+      }
+
+      // Finds the level root for `p`, which is the pixel that represents its node
+      dip::uint LevelRoot( dip::uint p ) const {
+         for( ;; ) {
+            dip::uint q = parent_[ p ];
+            if(( q == p ) || ( grey_[ q ] != grey_[ p ] )) {
+               return p;
+            }
+            p = q;
+         }
+      }
+
+      dip::uint Parent( dip::uint p ) const {
+         return parent_[ p ];
+      }
+
+      TPI Grey( dip::uint p ) const {
+         return grey_[ p ];
+      }
+
+      // The `zpar_` array is no longer needed after the tree is built, we use it to store the node index for each
+      // level root
+      std::vector< dip::uint >& NodeIndices() {
+         return zpar_;
+      }
+
+   private:
+      std::vector< TPI > grey_;
+      std::vector< dip::uint > parent_;
+      std::vector< dip::uint > zpar_;
+      IntegerArray const& neighborOffsets_;
+      bool maxTree_;
+
+      // True if grey value `a` is further from the root than `b`
+      bool Above( TPI a, TPI b ) const {
+         return maxTree_ ? a > b : a < b;
+      }
+
+      // Sort order for pixels, leaves first. Ties are sorted by index to make the order independent of how the
+      // image was divided into slabs.
+      bool LeafFirst( dip::uint a, dip::uint b ) const {
+         return Above( grey_[ a ], grey_[ b ] ) || (( grey_[ a ] == grey_[ b ] ) && ( a < b ));
+      }
+
+      dip::uint FindRoot( dip::uint p ) {
+         while( zpar_[ p ] != p ) {
+            zpar_[ p ] = zpar_[ zpar_[ p ]];
+            p = zpar_[ p ];
+         }
+         return p;
+      }
+
+      // Connects the branches of the trees that contain `x` and `y`, which are neighbors in different slabs
+      void Connect( dip::uint x, dip::uint y ) {
+         x = LevelRoot( x );
+         y = LevelRoot( y );
+         if( Above( grey_[ y ], grey_[ x ] )) {
+            std::swap( x, y );
+         }
+         while(( x != y ) && ( y != NONE )) {
+            // `x` is at the same level as `y` or further from the root
+            dip::uint z = parent_[ x ] == x ? NONE : LevelRoot( parent_[ x ] );
+            if(( z != NONE ) && !Above( grey_[ y ], grey_[ z ] )) {
+               x = z;
+            } else {
+               // `y` goes in between `x` and its parent `z`
+               parent_[ x ] = y;
+               x = y;
+               y = z;
+            }
+         }
+      }
+};
+
+template< typename TPI >
+void BuildComponentTree(
+      Image const& in,
+      Image const& mask,
+      IntegerArray const& paddedStrides,
+      dip::uint nPaddedPixels,
+      IntegerArray const& neighborOffsets,
+      bool maxTree,
+      std::vector< ComponentTree::NodeIndex >& nodeParent,
+      std::vector< dfloat >& nodeLevel,
+      std::vector< ComponentTree::NodeIndex >& pixelNode
+) {
+   UnsignedArray const& sizes = in.Sizes();
+   dip::uint nDims = sizes.size();
+   dip::uint nPlanes = sizes.back();
+   dip::uint planeStride = static_cast< dip::uint >( paddedStrides[ nDims - 1 ] );
+   TPI const* inPtr = static_cast< TPI const* >( in.Origin() );
+   bin const* maskPtr = mask.IsForged() ? static_cast< bin const* >( mask.Origin() ) : nullptr;
+   ComponentTreeBuilder< TPI > builder( nPaddedPixels, neighborOffsets, maxTree );
+
+   // Each thread builds the tree for a slab of the image
+   dip::uint nThreads = GetOptimalNumberOfThreads( in.NumberOfPixels() * neighborOffsets.size(),
+                                                   std::min( GetNumberOfThreads(), nPlanes ));
+   std::vector< std::vector< dip::uint >> slabPixels( nThreads );
+   auto FirstPlane = [ & ]( dip::uint slab ) {
+      return slab * nPlanes / nThreads;
+   };
+   DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+      dip::uint first = FirstPlane( thread );
+      dip::uint last = FirstPlane( thread + 1 );
+      builder.CollectPixels( inPtr, maskPtr, sizes, paddedStrides, first, last, slabPixels[ thread ] );
+      builder.BuildSlab( slabPixels[ thread ], ( first + 1 ) * planeStride, ( last + 1 ) * planeStride );
+   } ));
+
+   // Merge neighboring slabs pairwise; merges at the same step touch disjoint sets of pixels
+   for( dip::uint step = 1; step < nThreads; step *= 2 ) {
+      dip::uint nMerges = ( nThreads - step + 2 * step - 1 ) / ( 2 * step );
+      DIP_STACK_TRACE_THIS( ParallelRun( nMerges, [ & ]( dip::uint merge ) {
+         dip::uint slab = merge * 2 * step;
+         builder.MergeSlabs( ( FirstPlane( slab + step ) + 1 ) * planeStride, planeStride );
+         builder.MergeLists( slabPixels[ slab ], slabPixels[ slab + step ] );
+      } ));
+   }
+   std::vector< dip::uint > const& pixels = slabPixels[ 0 ];
+
+   // Number the nodes such that parents come before their children
+   std::vector< dip::uint >& nodeIndex = builder.NodeIndices();
+   std::fill( nodeIndex.begin(), nodeIndex.end(), NONE );
+   nodeParent.clear();
+   nodeLevel.clear();
+   for( auto it = pixels.rbegin(); it != pixels.rend(); ++it ) {
+      dip::uint r = builder.LevelRoot( *it );
+      if( nodeIndex[ r ] == NONE ) {
+         nodeIndex[ r ] = nodeParent.size();
+         dip::uint p = builder.Parent( r );
+         nodeParent.push_back( p == r ? nodeIndex[ r ] : nodeIndex[ builder.LevelRoot( p ) ] );
+         nodeLevel.push_back( static_cast< dfloat >( builder.Grey( r )));
+      }
+   }
+
+   // Assign each pixel to its node
+   pixelNode.resize( in.NumberOfPixels() );
+   DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+      ForEachPixel( sizes, paddedStrides, FirstPlane( thread ), FirstPlane( thread + 1 ),
+                    [ & ]( dip::uint paddedIndex, dip::uint index ) {
+         pixelNode[ index ] = builder.Parent( paddedIndex ) == NONE
+                              ? NONE
+                              : nodeIndex[ builder.LevelRoot( paddedIndex ) ];
+      } );
+   } ));
+}
+
+template< typename TPI >
+void FilterComponentTree(
+      std::vector< dfloat > const& outLevel,
+      std::vector< ComponentTree::NodeIndex > const& pixelNode,
+      Image const& excluded,
+      Image& out
+) {
+   std::vector< TPI > value( outLevel.size() );
+   for( dip::uint ii = 0; ii < outLevel.size(); ++ii ) {
+      value[ ii ] = clamp_cast< TPI >( outLevel[ ii ] );
+   }
+   TPI const* excludedPtr = excluded.IsForged() ? static_cast< TPI const* >( excluded.Origin() ) : nullptr;
+   TPI* outPtr = static_cast< TPI* >( out.Origin() );
+   dip::uint nPixels = pixelNode.size();
+   dip::uint nThreads = GetOptimalNumberOfThreads( nPixels );
+   ParallelRun( nThreads, [ & ]( dip::uint thread ) {
+      dip::uint end = ( thread + 1 ) * nPixels / nThreads;
+      for( dip::uint ii = thread * nPixels / nThreads; ii < end; ++ii ) {
+         ComponentTree::NodeIndex node = pixelNode[ ii ];
+         outPtr[ ii ] = node == NONE ? excludedPtr[ ii ] : value[ node ];
+      }
+   } );
+}
+
+} // namespace
+
+ComponentTree::ComponentTree(
+      Image const& in,
+      Image const& c_mask,
+      dip::uint connectivity,
+      String const& polarity
+) {
+   DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
+   DIP_THROW_IF( !in.IsScalar(), E::IMAGE_NOT_SCALAR );
+   DIP_THROW_IF( !in.DataType().IsReal() && !in.DataType().IsBinary(), E::DATA_TYPE_NOT_SUPPORTED );
+   dip::uint nDims = in.Dimensionality();
+   DIP_THROW_IF( nDims < 1, E::DIMENSIONALITY_NOT_SUPPORTED );
+   DIP_THROW_IF( connectivity > nDims, E::ILLEGAL_CONNECTIVITY );
+   DIP_STACK_TRACE_THIS( maxTree_ = BooleanFromString( polarity, S::OPENING, S::CLOSING ));
+   sizes_ = in.Sizes();
+   dataType_ = in.DataType();
+   pixelSize_ = in.PixelSize();
+
+   // The algorithm indexes all images by their linear index, we need normal strides
+   DataType greyType = dataType_.IsBinary() ? DT_UINT8 : dataType_;
+   Image grey = in.QuickCopy();
+   if(( grey.DataType() != greyType ) || !grey.HasNormalStrides() ) {
+      grey = Image( sizes_, 1, greyType );
+      grey.Copy( in );
+   }
+   Image mask;
+   if( c_mask.IsForged() ) {
+      mask = c_mask.QuickCopy();
+      DIP_START_STACK_TRACE
+         mask.CheckIsMask( sizes_, Option::AllowSingletonExpansion::DO_ALLOW, Option::ThrowException::DO_THROW );
+         mask.ExpandSingletonDimensions( sizes_ );
+      DIP_END_STACK_TRACE
+      if( !mask.HasNormalStrides() ) {
+         Image tmp( sizes_, 1, DT_BIN );
+         tmp.Copy( mask );
+         mask = tmp;
+      }
+      // Pixels outside the mask are copied from the input when filtering
+      excluded_ = Image( sizes_, 1, dataType_ );
+      excluded_.Copy( in );
+   }
+
+   // The tree is built on an image with a one-pixel border, such that neighbors never fall outside the image
+   UnsignedArray paddedSizes = sizes_;
+   IntegerArray paddedStrides( nDims );
+   dip::uint nPaddedPixels = 1;
+   for( dip::uint ii = 0; ii < nDims; ++ii ) {
+      paddedSizes[ ii ] += 2;
+      paddedStrides[ ii ] = static_cast< dip::sint >( nPaddedPixels );
+      nPaddedPixels *= paddedSizes[ ii ];
+   }
+   NeighborList neighbors( { Metric::TypeCode::CONNECTED, connectivity }, nDims );
+   IntegerArray neighborOffsets = neighbors.ComputeOffsets( paddedStrides );
+
+   DIP_OVL_CALL_REAL( BuildComponentTree, ( grey, mask, paddedStrides, nPaddedPixels, neighborOffsets, maxTree_,
+                                           parent_, level_, pixelNode_ ), greyType );
+
+   ownArea_.assign( parent_.size(), 0 );
+   for( NodeIndex node : pixelNode_ ) {
+      if( node != NOT_IN_TREE ) {
+         ++( ownArea_[ node ] );
+      }
+   }
+}
+
+std::vector< dip::uint > ComponentTree::Area() const {
+   std::vector< dip::uint > area = ownArea_;
+   for( dip::uint ii = area.size(); ii-- > 0; ) {
+      if( !IsRoot( ii )) {
+         area[ parent_[ ii ]] += area[ ii ];
+      }
+   }
+   return area;
+}
+
+std::vector< dfloat > ComponentTree::Volume() const {
+   std::vector< dip::uint > area = ownArea_;
+   std::vector< dfloat > sum( area.size() );
+   for( dip::uint ii = 0; ii < area.size(); ++ii ) {
+      sum[ ii ] = static_cast< dfloat >( area[ ii ] ) * level_[ ii ];
+   }
+   std::vector< dfloat > volume( area.size() );
+   for( dip::uint ii = area.size(); ii-- > 0; ) {
+      dfloat parentLevel = level_[ parent_[ ii ]];
+      volume[ ii ] = std::abs( sum[ ii ] - static_cast< dfloat >( area[ ii ] ) * parentLevel );
+      if( !IsRoot( ii )) {
+         area[ parent_[ ii ]] += area[ ii ];
+         sum[ parent_[ ii ]] += sum[ ii ];
+      }
+   }
+   return volume;
+}
+
+std::vector< dfloat > ComponentTree::Contrast() const {
+   std::vector< dfloat > extreme = level_;
+   std::vector< dfloat > contrast( extreme.size() );
+   for( dip::uint ii = extreme.size(); ii-- > 0; ) {
+      dip::uint parent = parent_[ ii ];
+      contrast[ ii ] = std::abs( extreme[ ii ] - level_[ parent ] );
+      if( !IsRoot( ii )) {
+         extreme[ parent ] = maxTree_ ? std::max( extreme[ parent ], extreme[ ii ] )
+                                      : std::min( extreme[ parent ], extreme[ ii ] );
+      }
+   }
+   return contrast;
+}
+
+std::vector< ComponentTree::BoundingBox > ComponentTree::BoundingBoxes() const {
+   dip::uint nDims = sizes_.size();
+   std::vector< BoundingBox > boxes( parent_.size(), BoundingBox{ sizes_, UnsignedArray( nDims, 0 ) } );
+   UnsignedArray coords( nDims, 0 );
+   for( NodeIndex node : pixelNode_ ) {
+      if( node != NOT_IN_TREE ) {
+         BoundingBox& box = boxes[ node ];
+         for( dip::uint jj = 0; jj < nDims; ++jj ) {
+            box.topLeft[ jj ] = std::min( box.topLeft[ jj ], coords[ jj ] );
+            box.bottomRight[ jj ] = std::max( box.bottomRight[ jj ], coords[ jj ] );
+         }
+      }
+      for( dip::uint jj = 0; jj < nDims; ++jj ) {
+         ++( coords[ jj ] );
+         if( coords[ jj ] < sizes_[ jj ] ) {
+            break;
+         }
+         coords[ jj ] = 0;
+      }
+   }
+   for( dip::uint ii = boxes.size(); ii-- > 0; ) {
+      if( !IsRoot( ii )) {
+         BoundingBox& box = boxes[ parent_[ ii ]];
+         for( dip::uint jj = 0; jj < nDims; ++jj ) {
+            box.topLeft[ jj ] = std::min( box.topLeft[ jj ], boxes[ ii ].topLeft[ jj ] );
+            box.bottomRight[ jj ] = std::max( box.bottomRight[ jj ], boxes[ ii ].bottomRight[ jj ] );
+         }
+      }
+   }
+   return boxes;
+}
+
+void ComponentTree::Filter( std::vector< bool > const& keep, Image& out ) const {
+   DIP_THROW_IF( keep.size() != parent_.size(), E::ARRAY_PARAMETER_WRONG_LENGTH );
+   // The level for each node after filtering; parents are processed before their children
+   std::vector< dfloat > outLevel( parent_.size() );
+   for( dip::uint ii = 0; ii < outLevel.size(); ++ii ) {
+      outLevel[ ii ] = ( keep[ ii ] || IsRoot( ii )) ? level_[ ii ] : outLevel[ parent_[ ii ]];
+   }
+   DIP_STACK_TRACE_THIS( out.ReForge( sizes_, 1, dataType_, Option::AcceptDataTypeChange::DO_ALLOW ));
+   Image tmp = out.QuickCopy();
+   if(( tmp.DataType() != dataType_ ) || !tmp.HasNormalStrides() ) {
+      tmp = Image( sizes_, 1, dataType_ );
+   }
+   DIP_OVL_CALL_NONCOMPLEX( FilterComponentTree, ( outLevel, pixelNode_, excluded_, tmp ), dataType_ );
+   if( !tmp.IsIdenticalView( out )) {
+      out.Copy( tmp );
+   }
+   out.SetPixelSize( pixelSize_ );
+}
+
+} // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/morphology.h"
+#include "diplib/analysis.h"
+#include "diplib/binary.h"
+#include "diplib/generation.h"
+#include "diplib/math.h"
+#include "diplib/testing.h"
+#include "diplib/random.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::ComponentTree") {
+   // A small 1D image where we can compute the tree by hand
+   dip::Image img( { 7 }, 1, dip::DT_UINT8 );
+   dip::uint8* ptr = static_cast< dip::uint8* >( img.Origin() );
+   dip::uint8 values[] = { 0, 2, 2, 0, 5, 1, 0 };
+   std::copy( values, values + 7, ptr );
+   dip::ComponentTree tree( img );
+   DOCTEST_REQUIRE( tree.NumberOfNodes() == 4 );
+   dip::ComponentTree::NodeIndex root = tree.PixelNode( 0 );
+   dip::ComponentTree::NodeIndex plateau = tree.PixelNode( 1 );
+   dip::ComponentTree::NodeIndex hill = tree.PixelNode( 5 );
+   dip::ComponentTree::NodeIndex peak = tree.PixelNode( 4 );
+   DOCTEST_CHECK( tree.IsRoot( root ));
+   DOCTEST_CHECK( tree.PixelNode( 2 ) == plateau );
+   DOCTEST_CHECK( tree.Parent( plateau ) == root );
+   DOCTEST_CHECK( tree.Parent( hill ) == root );
+   DOCTEST_CHECK( tree.Parent( peak ) == hill );
+   DOCTEST_CHECK( tree.Level( peak ) == 5 );
+   auto area = tree.Area();
+   DOCTEST_CHECK( area[ root ] == 7 );
+   DOCTEST_CHECK( area[ plateau ] == 2 );
+   DOCTEST_CHECK( area[ hill ] == 2 );
+   DOCTEST_CHECK( area[ peak ] == 1 );
+   auto volume = tree.Volume();
+   DOCTEST_CHECK( volume[ root ] == 10 );
+   DOCTEST_CHECK( volume[ plateau ] == 4 );
+   DOCTEST_CHECK( volume[ hill ] == 6 );
+   DOCTEST_CHECK( volume[ peak ] == 4 );
+   auto contrast = tree.Contrast();
+   DOCTEST_CHECK( contrast[ root ] == 5 );
+   DOCTEST_CHECK( contrast[ plateau ] == 2 );
+   DOCTEST_CHECK( contrast[ hill ] == 5 );
+   DOCTEST_CHECK( contrast[ peak ] == 4 );
+   auto boxes = tree.BoundingBoxes();
+   DOCTEST_CHECK( boxes[ root ].topLeft[ 0 ] == 0 );
+   DOCTEST_CHECK( boxes[ root ].bottomRight[ 0 ] == 6 );
+   DOCTEST_CHECK( boxes[ hill ].topLeft[ 0 ] == 4 );
+   DOCTEST_CHECK( boxes[ hill ].bottomRight[ 0 ] == 5 );
+   std::vector< bool > keep( 4, true );
+   keep[ peak ] = false;
+   dip::Image out = tree.Filter( keep );
+   DOCTEST_CHECK( out.DataType() == dip::DT_UINT8 );
+   DOCTEST_CHECK( out.At( 4 ) == 1 );
+   DOCTEST_CHECK( out.At( 1 ) == 2 );
+
+   // A random image, the tree must not depend on the number of threads used to build it
+   dip::Image grey( { 61, 47, 5 }, 1, dip::DT_SFLOAT );
+   grey.Fill( 0 );
+   dip::Random random( 0 );
+   dip::UniformNoise( grey, grey, random, 0, 8 );
+   grey = dip::Floor( grey );
+   dip::Image mask = grey != 3;
+   dip::ComponentTree sequential( grey, mask, 2 );
+   dip::ExecutionContext context;
+   context.maxThreads = 4;
+   context.threadingThreshold = 1;
+   {
+      dip::ScopedExecutionContext scope( context );
+      dip::ComponentTree parallel( grey, mask, 2 );
+      DOCTEST_REQUIRE( parallel.NumberOfNodes() == sequential.NumberOfNodes() );
+      bool sameTree = true;
+      for( dip::uint ii = 0; ii < sequential.NumberOfNodes(); ++ii ) {
+         sameTree &= parallel.Parent( ii ) == sequential.Parent( ii );
+         sameTree &= parallel.Level( ii ) == sequential.Level( ii );
+      }
+      for( dip::uint ii = 0; ii < grey.NumberOfPixels(); ++ii ) {
+         sameTree &= parallel.PixelNode( ii ) == sequential.PixelNode( ii );
+      }
+      DOCTEST_CHECK( sameTree );
+      DOCTEST_CHECK( parallel.Area() == sequential.Area() );
+   }
+
+   // The area filter equals the supremum of the binary area openings of all threshold sets
+   dip::uint filterSize = 20;
+   area = sequential.Area();
+   keep.resize( area.size() );
+   for( dip::uint ii = 0; ii < area.size(); ++ii ) {
+      keep[ ii ] = area[ ii ] >= filterSize;
+   }
+   out = sequential.Filter( keep );
+   dip::Image expected = grey.Copy();
+   expected.At( mask ) = 0;
+   for( dip::sint t = 1; t < 8; ++t ) {
+      dip::Image set = dip::BinaryAreaOpening(( grey >= t ) & mask, filterSize, 2 );
+      expected.At( set ) = t;
+   }
+   DOCTEST_CHECK( dip::testing::CompareImages( out, expected ));
+
+   // The min-tree is the dual of the max-tree
+   dip::ComponentTree minTree( grey, {}, 1, dip::S::CLOSING );
+   dip::ComponentTree maxTree( -grey, {}, 1, dip::S::OPENING );
+   DOCTEST_CHECK( minTree.Area() == maxTree.Area() );
+   DOCTEST_CHECK( minTree.Volume() == maxTree.Volume() );
+
+   // The area granulometry filters a single tree at each scale
+   dip::Distribution granulometry = dip::Granulometry( grey, {}, { 1.5, 2, 3, 5, 10 }, "area" );
+   bool increasing = true;
+   for( dip::uint ii = 1; ii < granulometry.Size(); ++ii ) {
+      increasing &= granulometry[ ii ].Y() >= granulometry[ ii - 1 ].Y();
+   }
+   DOCTEST_CHECK( increasing );
+   DOCTEST_CHECK( granulometry[ 0 ].Y() >= 0.0 );
+   DOCTEST_CHECK( granulometry[ 4 ].Y() <= 1.0 );
+
+   // With a mask, only the area of an object within the mask counts
+   dip::Image square( { 32, 32 }, 1, dip::DT_UINT8 );
+   square.Fill( 0 );
+   square.At( dip::Range{ 10, 19 }, dip::Range{ 10, 19 } ) = 100; // area 100
+   dip::Image left = dip::CreateXCoordinate( square.Sizes(), { "corner" } ) < 15; // cuts the square to area 50
+   granulometry = dip::Granulometry( square, left, { 5, 8 }, "area" );
+   DOCTEST_CHECK( granulometry[ 0 ].Y() == doctest::Approx( 0.0 ));
+   DOCTEST_CHECK( granulometry[ 1 ].Y() == doctest::Approx( 1.0 ));
+   granulometry = dip::Granulometry( square, {}, { 5, 8 }, "area" );
+   DOCTEST_CHECK( granulometry[ 1 ].Y() == doctest::Approx( 0.0 ));
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
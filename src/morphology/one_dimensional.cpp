@@ -26,6 +26,7 @@
 #include "diplib/framework.h"
 #include "diplib/overload.h"
 #include "diplib/library/copy_buffer.h"
+#include "diplib/library/cpu_dispatch.h"
 
 namespace dip {
 
@@ -57,21 +58,109 @@ class DilationErosionLineFilter : public Framework::SeparableLineFilter {
       DilationErosionLineFilter( UnsignedArray const& filterLengths, Mirror mirror, dip::uint maxSize ) :
             filterLengths_( filterLengths ), mirror_( mirror == Mirror::YES ), maxSize_( maxSize ) {}
       virtual void SetNumberOfThreads( dip::uint threads ) override {
-         bool needBuffers = false;
-         for( dip::uint ii = 0; ii < filterLengths_.size(); ++ii ) {
-            if( filterLengths_[ ii ] > 3 ) {
-               needBuffers = true;
-               break;
-            }
-         }
-         if( needBuffers ) {
-            buffers_.resize( threads );
-         }
+         // Buffers are needed for filterLength > 3, and when processing blocks
+         buffers_.resize( threads );
       }
       virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint ) override {
          return lineLength * 6; // 3 comparisons, 3 iterations
       }
+      virtual bool ProcessesBlocks() override { return true; }
+      virtual void FilterBlock( Framework::SeparableBlockFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilterBlock( params ); } );
+      }
+      void DoFilterBlock( Framework::SeparableBlockFilterParameters const& params ) {
+         // The same computation as `Filter`, but written for an extended input line (past the edges by `left` and
+         // `right` pixels), such that all lines in the block take the same code path and the inner loops are over
+         // the lines. Without margin, the extended line repeats the edge pixels, which yields the same result as
+         // `Filter`.
+         TPI const* in = static_cast< TPI const* >( params.inBuffer.buffer );
+         dip::uint length = params.inBuffer.length;
+         dip::uint stride = static_cast< dip::uint >( params.inBuffer.stride );
+         TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
+         DIP_ASSERT( params.outBuffer.stride == params.inBuffer.stride );
+         dip::uint nLines = params.nLines;
+         dip::uint filterLength = filterLengths_[ params.dimension ];
+         dip::uint margin = params.inBuffer.border; // margin == filterLength/2 || margin == 0
+         bool hasMargin = margin == filterLength / 2;
+         dip::uint left = filterLength / 2; // The number of pixels on the left side of the filter
+         dip::uint right = filterLength - 1 - left; // The number of pixels on the right side
+         if( mirror_ ) {
+            std::swap( left, right );
+         }
+         // Pointer to the pixel `index - left` of each line in the block
+         auto extendedLine = [ & ]( dip::uint index ) -> TPI const* {
+            dip::sint pos = static_cast< dip::sint >( index ) - static_cast< dip::sint >( left );
+            if( !hasMargin ) {
+               pos = clamp( pos, dip::sint( 0 ), static_cast< dip::sint >( length ) - 1 );
+            }
+            return in + pos * static_cast< dip::sint >( stride );
+         };
+         if( filterLength <= 3 ) {
+            // Brute-force computation
+            for( dip::uint ii = 0; ii < length; ++ii ) {
+               TPI* dst = out + ii * stride;
+               TPI const* src = extendedLine( ii );
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] = src[ jj ];
+               }
+               for( dip::uint kk = 1; kk < filterLength; ++kk ) {
+                  src = extendedLine( ii + kk );
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                     dst[ jj ] = OP::max( dst[ jj ], src[ jj ] );
+                  }
+               }
+            }
+         } else {
+            // Van Herk algorithm, with blocks of size filterLength starting at the beginning of the extended line
+            dip::uint extendedLength = length + filterLength - 1;
+            std::vector< TPI >& buffer = buffers_[ params.thread ];
+            buffer.resize( 2 * extendedLength * stride ); // does nothing if already correct size
+            TPI* forwardBuffer = buffer.data();
+            TPI* backwardBuffer = forwardBuffer + extendedLength * stride;
+            for( dip::uint ii = 0; ii < extendedLength; ++ii ) {
+               TPI* dst = forwardBuffer + ii * stride;
+               TPI const* src = extendedLine( ii );
+               if( ii % filterLength == 0 ) {
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                     dst[ jj ] = src[ jj ];
+                  }
+               } else {
+                  TPI const* prev = dst - stride;
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                     dst[ jj ] = OP::max( prev[ jj ], src[ jj ] );
+                  }
+               }
+            }
+            for( dip::uint ii = extendedLength; ii > 0; ) {
+               --ii;
+               TPI* dst = backwardBuffer + ii * stride;
+               TPI const* src = extendedLine( ii );
+               if(( ii % filterLength == filterLength - 1 ) || ( ii == extendedLength - 1 )) {
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                     dst[ jj ] = src[ jj ];
+                  }
+               } else {
+                  TPI const* prev = dst + stride;
+                  for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                     dst[ jj ] = OP::max( prev[ jj ], src[ jj ] );
+                  }
+               }
+            }
+            // The filter at output pixel `ii` covers the extended line from `ii` to `ii + filterLength - 1`
+            for( dip::uint ii = 0; ii < length; ++ii ) {
+               TPI* dst = out + ii * stride;
+               TPI const* fwd = forwardBuffer + ( ii + filterLength - 1 ) * stride;
+               TPI const* bwd = backwardBuffer + ii * stride;
+               for( dip::uint jj = 0; jj < nLines; ++jj ) {
+                  dst[ jj ] = OP::max( fwd[ jj ], bwd[ jj ] );
+               }
+            }
+         }
+      }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilter( params ); } );
+      }
+      void DoFilter( Framework::SeparableLineFilterParameters const& params ) {
          TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
          dip::uint length = params.inBuffer.length;
          dip::sint inStride = params.inBuffer.stride;
@@ -316,6 +405,9 @@ class PeriodicDilationErosionLineFilter : public Framework::SeparableLineFilter
          return lineLength * 6; // 3 comparisons, 3 iterations
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilter( params ); } );
+      }
+      void DoFilter( Framework::SeparableLineFilterParameters const& params ) {
          TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
          dip::uint length = params.inBuffer.length;
          dip::sint inStride = params.inBuffer.stride;
@@ -608,9 +700,20 @@ class OpeningClosingLineFilter : public Framework::SeparableLineFilter {
          }
       }
       virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint ) override {
-         return lineLength * 6; // TODO: determine correct number of operations
+         if( filterLength_ == 2 ) {
+            return lineLength * 3;  // two comparisons and a copy per pixel
+         }
+         if( filterLength_ == 3 ) {
+            return lineLength * 6;  // five comparisons and a copy per pixel
+         }
+         // Morard's algorithm: each pixel, including the border, is pushed on and popped off the stack once,
+         // with a few comparisons each time
+         return ( lineLength + filterLength_ ) * 12;
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilter( params ); } );
+      }
+      void DoFilter( Framework::SeparableLineFilterParameters const& params ) {
          TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
          dip::uint length = params.inBuffer.length;
          dip::sint inStride = params.inBuffer.stride;
@@ -815,6 +918,9 @@ class OpeningClosingLineFilter : public Framework::SeparableLineFilter {
                 dilation_.GetNumberOfOperations( lineLength, 0, 0, 0 );
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilter( params ); } );
+      }
+      void DoFilter( Framework::SeparableLineFilterParameters const& params ) {
          dip::uint length = params.inBuffer.length;
          dip::uint margin = params.inBuffer.border;
          if( filterLength_ > 3 ) {
@@ -961,6 +1067,9 @@ class PeriodicOpeningClosingLineFilter : public Framework::SeparableLineFilter {
                 dilation_.GetNumberOfOperations( lineLength, 0, 0, 0 );
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
+         detail::DispatchIsa( [ & ]() { DoFilter( params ); } );
+      }
+      void DoFilter( Framework::SeparableLineFilterParameters const& params ) {
          dip::uint length = params.inBuffer.length;
          dip::uint margin = params.inBuffer.border;
          std::vector< TPI >& buffer = buffer_[ params.thread ];
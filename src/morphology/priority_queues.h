@@ -0,0 +1,248 @@
+/*
+ * DIPlib 3.0
+ * This file defines priority queues used by dip::Watershed and similar functions.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIP_PRIORITY_QUEUES_H
+#define DIP_PRIORITY_QUEUES_H
+
+#include <array>
+#include <cstring>
+#include <queue>
+#include <type_traits>
+
+#include "diplib.h"
+
+namespace dip {
+
+// The priority queues here all hold pixel offsets, sorted by a pixel value of type `TPI`. They all have the
+// same interface:
+//
+//    PriorityQueue( bool lowFirst );              // if `lowFirst`, smaller values are popped first
+//    bool Empty() const;
+//    void Push( TPI value, dip::sint offset );
+//    dip::sint Pop();                             // removes the top element and returns its offset
+//
+// Elements with the same value are popped in the order in which they were pushed (FIFO).
+//
+// Use `PixelPriorityQueue< TPI, monotone >` to get the most efficient queue for a given data type. Set
+// `monotone` if values pushed onto the queue never come before the value last popped, this allows using
+// a radix heap for larger data types.
+
+
+// A binary heap, works with any data type and for any push order. O(log n) push and pop.
+template< typename TPI >
+class DIP_NO_EXPORT HeapPriorityQueue {
+   public:
+      explicit HeapPriorityQueue( bool lowFirst ) : queue_( Comparator{ lowFirst } ) {}
+
+      bool Empty() const {
+         return queue_.empty();
+      }
+
+      void Push( TPI value, dip::sint offset ) {
+         queue_.push( Item{ value, order_++, offset } );
+      }
+
+      dip::sint Pop() {
+         dip::sint offset = queue_.top().offset;
+         queue_.pop();
+         return offset;
+      }
+
+   private:
+      struct Item {
+         TPI value;              // pixel value - used for sorting
+         dip::uint insertOrder;  // order of insertion - used for sorting
+         dip::sint offset;       // offset into image
+      };
+      struct Comparator {
+         bool lowFirst;
+         bool operator()( Item const& a, Item const& b ) const {
+            // NOTE comparison on insertOrder! It's always "low first"
+            return ( lowFirst ? ( a.value > b.value ) : ( a.value < b.value )) ||
+                   (( a.value == b.value ) && ( a.insertOrder > b.insertOrder ));
+         }
+      };
+      std::priority_queue< Item, std::vector< Item >, Comparator > queue_;
+      dip::uint order_ = 0;
+};
+
+
+// True for the types that `BucketPriorityQueue` can handle
+template< typename TPI >
+struct IsSmallIntegerType {
+   static constexpr bool value = ( std::is_integral< TPI >::value || std::is_same< TPI, bin >::value ) && ( sizeof( TPI ) <= 2 );
+};
+
+// A hierarchical queue (bucket queue): one FIFO for each possible value. Only for binary, 8 and 16-bit integer types.
+// O(1) push and pop, values can be pushed in any order.
+template< typename TPI >
+class DIP_NO_EXPORT BucketPriorityQueue {
+      static_assert( IsSmallIntegerType< TPI >::value, "BucketPriorityQueue is only for binary, 8 and 16-bit integer types" );
+      static constexpr dip::uint nBuckets = dip::uint( 1 ) << ( sizeof( TPI ) * 8 );
+   public:
+      explicit BucketPriorityQueue( bool lowFirst ) : buckets_( nBuckets ), lowFirst_( lowFirst ) {}
+
+      bool Empty() const {
+         return size_ == 0;
+      }
+
+      void Push( TPI value, dip::sint offset ) {
+         dip::uint index = Index( value );
+         buckets_[ index ].items.push_back( offset );
+         current_ = std::min( current_, index );
+         ++size_;
+      }
+
+      dip::sint Pop() {
+         DIP_ASSERT( size_ > 0 );
+         while( buckets_[ current_ ].IsEmpty() ) {
+            buckets_[ current_ ].Clear();
+            ++current_;
+         }
+         --size_;
+         return buckets_[ current_ ].Pop();
+      }
+
+   private:
+      struct Bucket {
+         std::vector< dip::sint > items;
+         dip::uint head = 0;
+         bool IsEmpty() const { return head == items.size(); }
+         dip::sint Pop() { return items[ head++ ]; }
+         void Clear() { items.clear(); head = 0; } // keeps the allocated memory for re-use
+      };
+      std::vector< Bucket > buckets_;
+      dip::uint current_ = nBuckets; // All buckets before this one are empty
+      dip::uint size_ = 0;
+      bool lowFirst_;
+
+      dip::uint Index( TPI value ) const {
+         dip::uint index = static_cast< dip::uint >( static_cast< dip::sint >( value ) - static_cast< dip::sint >( std::numeric_limits< TPI >::lowest() ));
+         return lowFirst_ ? index : nBuckets - 1 - index;
+      }
+};
+
+
+// A radix heap: buckets for keys that differ from the last popped key in bit `b`, with `b` counted from the most
+// significant bit. Amortized O(log C) per element (with C the range of the values), but in practice much
+// cheaper than a binary heap because elements are only moved when buckets are split. For any data type.
+// Values must be pushed monotonically: pushing a value that comes before the last popped value is allowed, but
+// the element is then treated as if it had the last popped value.
+template< typename TPI >
+class DIP_NO_EXPORT RadixHeapPriorityQueue {
+      using KeyType = typename std::conditional< ( sizeof( TPI ) <= 4 ), uint32, uint64 >::type;
+      static constexpr dip::uint nBits = sizeof( KeyType ) * 8;
+   public:
+      explicit RadixHeapPriorityQueue( bool lowFirst ) : lowFirst_( lowFirst ) {}
+
+      bool Empty() const {
+         return size_ == 0;
+      }
+
+      void Push( TPI value, dip::sint offset ) {
+         KeyType key = std::max( Key( value ), last_ );
+         buckets_[ BucketIndex( key ) ].push_back( Item{ key, offset } );
+         ++size_;
+      }
+
+      dip::sint Pop() {
+         DIP_ASSERT( size_ > 0 );
+         if( head_ == buckets_[ 0 ].size() ) {
+            buckets_[ 0 ].clear();
+            head_ = 0;
+            // Find the first non-empty bucket, and redistribute its elements over the lower buckets
+            dip::uint ii = 1;
+            while( buckets_[ ii ].empty() ) {
+               ++ii;
+            }
+            last_ = buckets_[ ii ][ 0 ].key;
+            for( auto const& item : buckets_[ ii ] ) {
+               last_ = std::min( last_, item.key );
+            }
+            // Items in this bucket are in insertion order, and end up in lower buckets in the same order
+            for( auto const& item : buckets_[ ii ] ) {
+               buckets_[ BucketIndex( item.key ) ].push_back( item );
+            }
+            buckets_[ ii ].clear();
+         }
+         --size_;
+         return buckets_[ 0 ][ head_++ ].offset;
+      }
+
+   private:
+      struct Item {
+         KeyType key;
+         dip::sint offset;
+      };
+      std::array< std::vector< Item >, nBits + 1 > buckets_;
+      dip::uint head_ = 0;    // Index into `buckets_[ 0 ]`, the elements before it have been popped
+      KeyType last_ = 0;      // The last popped key, all elements in the queue have a key equal or larger
+      dip::uint size_ = 0;
+      bool lowFirst_;
+
+      // Maps a value to an unsigned integer key, preserving order (reversed if `!lowFirst_`).
+      KeyType Key( TPI value ) const {
+         KeyType key = OrderedKey( value );
+         return lowFirst_ ? key : static_cast< KeyType >( ~key );
+      }
+      template< typename T = TPI, typename std::enable_if_t< std::is_floating_point< T >::value, int > = 0 >
+      static KeyType OrderedKey( T value ) {
+         KeyType bits;
+         std::memcpy( &bits, &value, sizeof( bits ));
+         constexpr KeyType signBit = KeyType( 1 ) << ( nBits - 1 );
+         return ( bits & signBit ) ? static_cast< KeyType >( ~bits ) : static_cast< KeyType >( bits | signBit );
+      }
+      template< typename T = TPI, typename std::enable_if_t< !std::is_floating_point< T >::value, int > = 0 >
+      static KeyType OrderedKey( T value ) {
+         return static_cast< KeyType >( static_cast< KeyType >( value ) - static_cast< KeyType >( std::numeric_limits< T >::lowest() ));
+      }
+
+      // The bucket is given by the position of the highest bit in which `key` differs from `last_`.
+      dip::uint BucketIndex( KeyType key ) const {
+         KeyType diff = key ^ last_;
+         if( diff == 0 ) {
+            return 0;
+         }
+#if defined(__GNUC__) || defined(__clang__)
+         return sizeof( KeyType ) <= 4
+                ? 32 - static_cast< dip::uint >( __builtin_clz( static_cast< unsigned int >( diff )))
+                : 64 - static_cast< dip::uint >( __builtin_clzll( static_cast< unsigned long long >( diff )));
+#else
+         dip::uint index = 0;
+         while( diff != 0 ) {
+            diff >>= 1;
+            ++index;
+         }
+         return index;
+#endif
+      }
+};
+
+
+// Selects the most appropriate priority queue for the given data type
+template< typename TPI, bool monotone >
+using PixelPriorityQueue = typename std::conditional<
+      IsSmallIntegerType< TPI >::value,
+      BucketPriorityQueue< TPI >,
+      typename std::conditional< monotone, RadixHeapPriorityQueue< TPI >, HeapPriorityQueue< TPI >>::type
+>::type;
+
+} // namespace dip
+
+#endif // DIP_PRIORITY_QUEUES_H
@@ -18,8 +18,6 @@
  * limitations under the License.
  */
 
-#include <queue>
-
 #include "diplib.h"
 #include "diplib/morphology.h"
 #include "diplib/math.h"
@@ -28,25 +26,12 @@
 #include "diplib/iterators.h"
 #include "diplib/overload.h"
 #include "watershed_support.h"
+#include "priority_queues.h"
 
 namespace dip {
 
 namespace {
 
-template< typename TPI >
-struct Qitem {
-   TPI value;              // pixel value - used for sorting
-   dip::sint offset;       // offset into `done` image
-};
-template< typename TPI >
-bool QitemComparator_LowFirst( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return a.value > b.value;
-}
-template< typename TPI >
-bool QitemComparator_HighFirst ( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return a.value < b.value;
-}
-
 template< typename TPI >
 void MorphologicalReconstructionInternal(
       Image const& c_in,
@@ -59,8 +44,9 @@ void MorphologicalReconstructionInternal(
       Image const& c_minval,
       bool dilation
 ) {
-   auto QitemComparator = dilation ? QitemComparator_HighFirst< TPI > : QitemComparator_LowFirst< TPI >;
-   std::priority_queue< Qitem< TPI >, std::vector< Qitem< TPI >>, decltype( QitemComparator ) > Q( QitemComparator );
+   // Values pushed are never beyond the value of the pixel being processed, so the queue is monotone.
+   // Offsets pushed are those of `done`, so we can test it fast.
+   PixelPriorityQueue< TPI, true > Q( !dilation );
 
    dip::uint nNeigh = neighborList.Size();
    UnsignedArray const& imsz = c_in.Sizes();
@@ -79,7 +65,7 @@ void MorphologicalReconstructionInternal(
             it.template Sample< 2 >() = false;
          }
          if( it.Out() > minval ) {
-            Q.push( Qitem< TPI >{ it.Out(), it.template Offset< 2 >() } ); // offset pushed is that of `done`, so we can test it fast.
+            Q.Push( it.Out(), it.template Offset< 2 >() );
             //std::cout << " - Pushed " << it.Out();
          }
       } while( ++it );
@@ -92,7 +78,7 @@ void MorphologicalReconstructionInternal(
             it.template Sample< 2 >() = false;
          }
          if( it.Out() < minval ) {
-            Q.push( Qitem< TPI >{ it.Out(), it.template Offset< 2 >() } ); // offset pushed is that of `done`, so we can test it fast.
+            Q.Push( it.Out(), it.template Offset< 2 >() );
             //std::cout << " - Pushed " << it.Out();
          }
       } while( ++it );
@@ -104,9 +90,8 @@ void MorphologicalReconstructionInternal(
    bin* done = static_cast< bin* >( c_done.Origin() );
    auto coordinatesComputer = c_done.OffsetToCoordinatesComputer();
    BooleanArray skipar( nNeigh );
-   while( !Q.empty() ) {
-      dip::sint offsetDone = Q.top().offset;
-      Q.pop();
+   while( !Q.Empty() ) {
+      dip::sint offsetDone = Q.Pop();
       UnsignedArray coords = coordinatesComputer( offsetDone );
       dip::sint offsetIn = c_in.Offset( coords );
       dip::sint offsetOut = c_out.Offset( coords );
@@ -123,7 +108,7 @@ void MorphologicalReconstructionInternal(
                   if( out[ offsetOut + neighborOffsetsOut[ jj ]] < newval ) {
                      out[ offsetOut + neighborOffsetsOut[ jj ]] = newval;
                      // Add the updated neighbours to the heap
-                     Q.push( Qitem< TPI >{ newval, offsetDone + neighborOffsetsDone[ jj ] } );
+                     Q.Push( newval, offsetDone + neighborOffsetsDone[ jj ] );
                      //std::cout << " - Pushed " << newval;
                   }
                } else {
@@ -131,7 +116,7 @@ void MorphologicalReconstructionInternal(
                   if( out[ offsetOut + neighborOffsetsOut[ jj ]] > newval ) {
                      out[ offsetOut + neighborOffsetsOut[ jj ]] = newval;
                      // Add the updated neighbours to the heap
-                     Q.push( Qitem< TPI >{ newval, offsetDone + neighborOffsetsDone[ jj ] } );
+                     Q.Push( newval, offsetDone + neighborOffsetsDone[ jj ] );
                      //std::cout << " - Pushed " << newval;
                   }
                }
@@ -38,6 +38,7 @@
 #include "diplib/union_find.h"
 #include "diplib/graph.h"
 #include "watershed_support.h"
+#include "priority_queues.h"
 
 namespace dip {
 
@@ -407,27 +408,12 @@ inline bool PixelHasDownhillForegroundNeighbor(
    return false;
 }
 
-template< typename TPI >
-struct Qitem {
-   TPI value;              // pixel value - used for sorting
-   dip::uint insertOrder;  // order of insertion - used for sorting
-   dip::sint offset;       // offset into labels image
-};
-template< typename TPI >
-bool QitemComparator_LowFirst( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return ( a.value > b.value ) || (( a.value == b.value ) && ( a.insertOrder > b.insertOrder )); // NOTE comparison on insertOrder! It's always "low first"
-}
-template< typename TPI >
-bool QitemComparator_HighFirst ( Qitem< TPI > const& a, Qitem< TPI > const& b ) {
-   return ( a.value < b.value ) || (( a.value == b.value ) && ( a.insertOrder > b.insertOrder )); // NOTE comparison on insertOrder! It's always "low first"
-}
-
 template< typename TPI, typename QType >
 inline void EnqueueNeighbors(
       TPI* grey, LabelType* labels, BooleanArray const& useNeighbor,
       dip::sint offsetGrey, dip::sint offsetLabels,
       IntegerArray const& neighborOffsetsGrey, IntegerArray const& neighborOffsetsLabels,
-      QType& Q, dip::uint& order, bool lowFirst, bool uphillOnly
+      QType& Q, bool lowFirst, bool uphillOnly
 ) {
    for( dip::uint jj = 0; jj < useNeighbor.size(); ++jj ) {
       if( useNeighbor[ jj ] ) {
@@ -435,7 +421,7 @@ inline void EnqueueNeighbors(
          if( labels[ neighOffset ] == 0 ) {
             TPI nVal = grey[ offsetGrey + neighborOffsetsGrey[ jj ]];
             if( !uphillOnly || ( lowFirst ? grey[ offsetGrey ] < nVal : grey[ offsetGrey ] > nVal )) {
-               Q.push( Qitem< TPI >{ nVal, order++, neighOffset } );
+               Q.Push( nVal, neighOffset );
                labels[ neighOffset ] = PIXEL_ON_STACK;
             }
          }
@@ -464,15 +450,14 @@ void SeededWatershedInternal(
                                             : std::numeric_limits< TPI >::lowest() );
    WatershedRegionList< TPI, decltype( AddRegions ) > regions( numlabs, defaultRegion, AddRegions );
 
-   auto QitemComparator = lowFirst ? QitemComparator_LowFirst< TPI > : QitemComparator_HighFirst< TPI >;
-   std::priority_queue< Qitem< TPI >, std::vector< Qitem< TPI >>, decltype( QitemComparator ) > Q( QitemComparator );
+   // Neighbors can have a value lower than the pixel being processed, so the queue is not monotone
+   PixelPriorityQueue< TPI, false > Q( lowFirst );
 
    dip::uint nNeigh = neighborOffsetsLabels.size();
    UnsignedArray const& imsz = c_grey.Sizes();
 
    // Walk over the entire image & put all the background border pixels on the heap
    JointImageIterator< TPI, LabelType > it( { c_grey, c_labels } );
-   dip::uint order = 0;
    do {
       LabelType lab = it.template Sample< 1 >();
       if( lab == 0 ) {
@@ -488,7 +473,7 @@ void SeededWatershedInternal(
              : PixelHasForegroundNeighbor( it.template Pointer< 1 >(),
                                            neighborList, neighborOffsetsLabels,
                                            it.Coordinates(), imsz, onEdge )) {
-            Q.push( Qitem< TPI >{ it.template Sample< 0 >(), order++, it.template Offset< 1 >() } );
+            Q.Push( it.template Sample< 0 >(), it.template Offset< 1 >() );
             it.template Sample< 1 >() = PIXEL_ON_STACK;
          }
       } else if( lab <= numlabs ) {
@@ -502,9 +487,8 @@ void SeededWatershedInternal(
    auto coordinatesComputer = c_labels.OffsetToCoordinatesComputer();
    NeighborLabels neighborLabels;
    BooleanArray useNeighbor( nNeigh );
-   while( !Q.empty() ) {
-      dip::sint offsetLabels = Q.top().offset;
-      Q.pop();
+   while( !Q.Empty() ) {
+      dip::sint offsetLabels = Q.Pop();
       UnsignedArray coords = coordinatesComputer( offsetLabels );
       bool onEdge = c_grey.IsOnEdge( coords ); // TODO: label edge pixels (use upper bit?) such that we don't need to do compute this
       dip::sint offsetGrey = c_grey.Offset( coords );
@@ -536,7 +520,7 @@ void SeededWatershedInternal(
             AddPixel( regions, lab, grey[ offsetGrey ], lowFirst );
             // Add all unprocessed neighbors to heap
             EnqueueNeighbors( grey, labels, useNeighbor, offsetGrey, offsetLabels,
-                              neighborOffsetsGrey, neighborOffsetsLabels, Q, order, lowFirst, uphillOnly );
+                              neighborOffsetsGrey, neighborOffsetsLabels, Q, lowFirst, uphillOnly );
             break;
          }
          default: {
@@ -557,7 +541,7 @@ void SeededWatershedInternal(
                AddPixel( regions, lab, grey[ offsetGrey ], lowFirst );
                // Add all unprocessed neighbors to heap
                EnqueueNeighbors( grey, labels, useNeighbor, offsetGrey, offsetLabels,
-                                 neighborOffsetsGrey, neighborOffsetsLabels, Q, order, lowFirst, uphillOnly );
+                                 neighborOffsetsGrey, neighborOffsetsLabels, Q, lowFirst, uphillOnly );
             } else {
                // Else don't merge
                if( noGaps ) {
@@ -585,7 +569,7 @@ void SeededWatershedInternal(
                      AddPixel( regions, bestLab, grey[ offsetGrey ], lowFirst );
                      // Add all unprocessed neighbors to heap
                      EnqueueNeighbors( grey, labels, useNeighbor, offsetGrey, offsetLabels,
-                                       neighborOffsetsGrey, neighborOffsetsLabels, Q, order, lowFirst, uphillOnly );
+                                       neighborOffsetsGrey, neighborOffsetsLabels, Q, lowFirst, uphillOnly );
                   }
                } else {
                   // Set as watershed label (so it won't be considered again)
@@ -1183,3 +1167,58 @@ void StochasticWatershed(
 }
 
 } // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/random.h"
+
+namespace {
+
+template< typename TPI, typename QueueType >
+bool PriorityQueueMatchesHeap( bool lowFirst, bool monotone ) {
+   dip::Random random( 0 );
+   dip::UniformRandomGenerator generator( random );
+   dip::HeapPriorityQueue< TPI > reference( lowFirst );
+   QueueType queue( lowFirst );
+   std::vector< TPI > values;
+   TPI last = lowFirst ? std::numeric_limits< TPI >::lowest() : std::numeric_limits< TPI >::max();
+   for( dip::uint ii = 0; ii < 10000; ++ii ) {
+      if( generator( 0.0, 1.0 ) < 0.55 ) {
+         TPI value = static_cast< TPI >( std::floor( generator( 0.0, 100.0 )));
+         if( monotone ) {
+            value = lowFirst ? std::max( value, last ) : std::min( value, last );
+         }
+         reference.Push( value, static_cast< dip::sint >( values.size() ));
+         queue.Push( value, static_cast< dip::sint >( values.size() ));
+         values.push_back( value );
+      } else if( !reference.Empty() ) {
+         dip::sint offset = reference.Pop();
+         if( queue.Pop() != offset ) {
+            return false;
+         }
+         last = values[ static_cast< dip::uint >( offset ) ];
+      }
+   }
+   while( !reference.Empty() ) {
+      if( queue.Empty() || ( queue.Pop() != reference.Pop() )) {
+         return false;
+      }
+   }
+   return queue.Empty();
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing the priority queues") {
+   // All queues must pop elements in the same order as the heap, including ties, which are popped in FIFO order
+   DOCTEST_CHECK( PriorityQueueMatchesHeap< dip::uint8, dip::BucketPriorityQueue< dip::uint8 >>( true, false ));
+   DOCTEST_CHECK( PriorityQueueMatchesHeap< dip::uint8, dip::BucketPriorityQueue< dip::uint8 >>( false, false ));
+   DOCTEST_CHECK( PriorityQueueMatchesHeap< dip::sint16, dip::BucketPriorityQueue< dip::sint16 >>( true, false ));
+   DOCTEST_CHECK( PriorityQueueMatchesHeap< dip::sint32, dip::RadixHeapPriorityQueue< dip::sint32 >>( true, true ));
+   DOCTEST_CHECK( PriorityQueueMatchesHeap< dip::sint32, dip::RadixHeapPriorityQueue< dip::sint32 >>( false, true ));
+   DOCTEST_CHECK( PriorityQueueMatchesHeap< dip::sfloat, dip::RadixHeapPriorityQueue< dip::sfloat >>( true, true ));
+   DOCTEST_CHECK( PriorityQueueMatchesHeap< dip::dfloat, dip::RadixHeapPriorityQueue< dip::dfloat >>( false, true ));
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -29,7 +29,6 @@ namespace dip {
 
 namespace {
 
-// TODO: an 8 or 16-bit specialization could use the moving histogram technique
 template< typename TPI >
 class RankLineFilter : public Framework::FullLineFilter {
    public:
@@ -65,12 +64,153 @@ class RankLineFilter : public Framework::FullLineFilter {
             out += outStride;
          }
       }
-   private:
+   protected:
       dip::sint rank_;
+   private:
       std::vector< std::vector< TPI >> buffers_;
       std::vector< dip::sint > offsets_;
 };
 
+// A histogram over all possible values of an 8 or 16-bit integer type, allowing for O(1) insertion and removal
+// of values, and fast lookup of the value with a given rank. The histogram has two levels: coarse bins each
+// summarize `fineWidth` fine bins, such that finding a rank requires looking at only a few coarse bins (the
+// position of the last lookup is remembered, and for a sliding window it changes little from pixel to pixel)
+// and at most `fineWidth` fine bins.
+template< typename TPI >
+class RankHistogram {
+      static constexpr dip::uint nBits = sizeof( TPI ) * 8;
+      static constexpr dip::uint coarseShift = nBits / 2;
+      static constexpr dip::uint nFine = dip::uint( 1 ) << nBits;
+      static constexpr dip::uint nCoarse = dip::uint( 1 ) << ( nBits - coarseShift );
+   public:
+      static constexpr dip::uint fineWidth = dip::uint( 1 ) << coarseShift;
+
+      RankHistogram() : fine_( nFine, 0 ), coarse_( nCoarse, 0 ) {}
+
+      void Add( TPI value ) {
+         dip::uint index = Index( value );
+         ++fine_[ index ];
+         index >>= coarseShift;
+         ++coarse_[ index ];
+         if( index < current_ ) {
+            ++below_;
+         }
+      }
+
+      void Remove( TPI value ) {
+         dip::uint index = Index( value );
+         --fine_[ index ];
+         index >>= coarseShift;
+         --coarse_[ index ];
+         if( index < current_ ) {
+            --below_;
+         }
+      }
+
+      // Returns the value with rank `rank` (0-based), `rank` must be smaller than the number of values in the histogram.
+      TPI Rank( dip::uint rank ) {
+         while( below_ + coarse_[ current_ ] <= rank ) {
+            below_ += coarse_[ current_ ];
+            ++current_;
+         }
+         while( below_ > rank ) {
+            --current_;
+            below_ -= coarse_[ current_ ];
+         }
+         dip::uint count = below_;
+         dip::uint index = current_ << coarseShift;
+         while(( count += fine_[ index ] ) <= rank ) {
+            ++index;
+         }
+         return static_cast< TPI >( static_cast< dip::sint >( index ) + static_cast< dip::sint >( std::numeric_limits< TPI >::lowest() ));
+      }
+
+   private:
+      std::vector< dip::uint32 > fine_;
+      std::vector< dip::uint > coarse_;
+      dip::uint current_ = 0; // The coarse bin where we found the last rank
+      dip::uint below_ = 0;   // The number of values in coarse bins below `current_`
+
+      static dip::uint Index( TPI value ) {
+         return static_cast< dip::uint >( static_cast< dip::sint >( value ) - static_cast< dip::sint >( std::numeric_limits< TPI >::lowest() ));
+      }
+};
+
+// For 8 and 16-bit integer types: uses a sliding histogram (Huang, Perreault & Hebert), updated along the line
+// by removing the first pixel and adding the pixel past the end of each pixel table run, which makes the cost
+// per pixel independent of the kernel size. Falls back to the `RankLineFilter` algorithm for small kernels.
+template< typename TPI >
+class HistogramRankLineFilter : public RankLineFilter< TPI > {
+   public:
+      HistogramRankLineFilter( dip::uint rank ) : RankLineFilter< TPI >( rank ) {}
+      void SetNumberOfThreads( dip::uint threads, PixelTableOffsets const& pixelTable ) override {
+         // Let's determine how to process the neighborhood. We compare costs for a typical line length
+         constexpr dip::uint lineLength = 256;
+         dip::uint nKernelPixels = pixelTable.NumberOfPixels();
+         dip::uint nRuns = pixelTable.Runs().size();
+         useHistogram_ = HistogramOperations( lineLength, nKernelPixels, nRuns )
+                         < RankLineFilter< TPI >::GetNumberOfOperations( lineLength, 1, nKernelPixels, nRuns );
+         if( useHistogram_ ) {
+            histograms_.resize( threads );
+         } else {
+            RankLineFilter< TPI >::SetNumberOfThreads( threads, pixelTable );
+         }
+      }
+      virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint nTensorElements, dip::uint nKernelPixels, dip::uint nRuns ) override {
+         return std::min( HistogramOperations( lineLength, nKernelPixels, nRuns ),
+                          RankLineFilter< TPI >::GetNumberOfOperations( lineLength, nTensorElements, nKernelPixels, nRuns ));
+      }
+      virtual void Filter( Framework::FullLineFilterParameters const& params ) override {
+         if( !useHistogram_ ) {
+            RankLineFilter< TPI >::Filter( params );
+            return;
+         }
+         TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
+         dip::sint inStride = params.inBuffer.stride;
+         TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
+         dip::sint outStride = params.outBuffer.stride;
+         dip::uint length = params.bufferLength;
+         PixelTableOffsets const& pixelTable = params.pixelTable;
+         dip::uint rank = static_cast< dip::uint >( this->rank_ );
+         if( !histograms_[ params.thread ] ) {
+            histograms_[ params.thread ] = std::make_unique< RankHistogram< TPI >>();
+         }
+         RankHistogram< TPI >& histogram = *histograms_[ params.thread ];
+         // Fill the histogram with the neighborhood of the first pixel
+         for( auto it = pixelTable.begin(); !it.IsAtEnd(); ++it ) {
+            histogram.Add( in[ *it ] );
+         }
+         for( dip::uint ii = 0; ; ) {
+            *out = histogram.Rank( rank );
+            if( ++ii == length ) {
+               break;
+            }
+            // Slide the neighborhood one pixel along the line
+            for( auto const& run : pixelTable.Runs() ) {
+               histogram.Remove( in[ run.offset ] );
+               histogram.Add( in[ run.offset + static_cast< dip::sint >( run.length ) * inStride ] );
+            }
+            in += inStride;
+            out += outStride;
+         }
+         // Empty the histogram for the next line, this is cheaper than clearing all bins
+         for( auto it = pixelTable.begin(); !it.IsAtEnd(); ++it ) {
+            histogram.Remove( in[ *it ] );
+         }
+      }
+   private:
+      bool useHistogram_ = false;
+      std::vector< std::unique_ptr< RankHistogram< TPI >>> histograms_; // allocated by each thread, on first use
+
+      static dip::uint HistogramOperations( dip::uint lineLength, dip::uint nKernelPixels, dip::uint nRuns ) {
+         return 4 * nKernelPixels                        // filling and emptying the histogram
+                + lineLength * (
+                     4 * nRuns                           // updating the histogram
+                     + RankHistogram< TPI >::fineWidth   // finding the rank
+                     + 8 );                              // finding the coarse bin
+      }
+};
+
 void ComputeRankFilter(
       Image const& in,
       Image& out,
@@ -81,7 +221,23 @@ void ComputeRankFilter(
    DIP_START_STACK_TRACE
       DataType dtype = in.DataType();
       std::unique_ptr< Framework::FullLineFilter > lineFilter;
-      DIP_OVL_NEW_NONCOMPLEX( lineFilter, RankLineFilter, ( rank ), dtype );
+      switch( dtype ) {
+         case DT_UINT8:
+            lineFilter = std::make_unique< HistogramRankLineFilter< uint8 >>( rank );
+            break;
+         case DT_SINT8:
+            lineFilter = std::make_unique< HistogramRankLineFilter< sint8 >>( rank );
+            break;
+         case DT_UINT16:
+            lineFilter = std::make_unique< HistogramRankLineFilter< uint16 >>( rank );
+            break;
+         case DT_SINT16:
+            lineFilter = std::make_unique< HistogramRankLineFilter< sint16 >>( rank );
+            break;
+         default:
+            DIP_OVL_NEW_NONCOMPLEX( lineFilter, RankLineFilter, ( rank ), dtype );
+            break;
+      }
       Framework::Full( in, out, dtype, dtype, dtype, 1, bc, kernel, *lineFilter, Framework::FullOption::AsScalarImage );
    DIP_END_STACK_TRACE
 }
@@ -149,3 +305,40 @@ void PercentileFilter(
 }
 
 } // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/generation.h"
+#include "diplib/statistics.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing the sliding histogram rank filter") {
+   // The histogram method is used for 8 and 16-bit integer images with larger kernels, we compare to the
+   // results of the sorting method, which is used for floating-point images.
+   dip::Random random( 0 );
+   dip::Image img{ dip::UnsignedArray{ 64, 49 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::UniformNoise( img, img, random, 0.0, 255.0 );
+   img = dip::Convert( img, dip::DT_UINT8 );
+   dip::Image ref = dip::MedianFilter( dip::Convert( img, dip::DT_SFLOAT ), dip::Kernel{ dip::FloatArray{ 15, 11 }, "rectangular" }, { "mirror" } );
+   dip::Image out = dip::MedianFilter( img, dip::Kernel{ dip::FloatArray{ 15, 11 }, "rectangular" }, { "mirror" } );
+   DOCTEST_CHECK( out.DataType() == dip::DT_UINT8 );
+   DOCTEST_CHECK( dip::Count( out != ref ) == 0 );
+   ref = dip::PercentileFilter( dip::Convert( img, dip::DT_SFLOAT ), 20.0, dip::Kernel{ dip::FloatArray{ 9, 15 }, "rectangular" }, { "mirror" } );
+   out = dip::PercentileFilter( img, 20.0, dip::Kernel{ dip::FloatArray{ 9, 15 }, "rectangular" }, { "mirror" } );
+   DOCTEST_CHECK( dip::Count( out != ref ) == 0 );
+   ref = dip::MedianFilter( dip::Convert( img, dip::DT_SFLOAT ), dip::Kernel{ 21.0, "elliptic" }, { "mirror" } );
+   out = dip::MedianFilter( img, dip::Kernel{ 21.0, "elliptic" }, { "mirror" } );
+   DOCTEST_CHECK( dip::Count( out != ref ) == 0 );
+
+   img = dip::Image{ dip::UnsignedArray{ 20, 17, 12 }, 1, dip::DT_SFLOAT };
+   img.Fill( 0 );
+   dip::UniformNoise( img, img, random, -30000.0, 30000.0 );
+   img = dip::Convert( img, dip::DT_SINT16 );
+   ref = dip::MedianFilter( dip::Convert( img, dip::DT_SFLOAT ), dip::Kernel{ 7.0, "rectangular" }, { "mirror" } );
+   out = dip::MedianFilter( img, dip::Kernel{ 7.0, "rectangular" }, { "mirror" } );
+   DOCTEST_CHECK( out.DataType() == dip::DT_SINT16 );
+   DOCTEST_CHECK( dip::Count( out != ref ) == 0 );
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
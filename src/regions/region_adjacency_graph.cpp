@@ -17,6 +17,9 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <queue>
 
 #include "diplib.h"
@@ -25,17 +28,49 @@
 #include "diplib/union_find.h"
 #include "diplib/lookup_table.h"
 #include "diplib/framework.h"
+#include "diplib/multithreading.h"
 #include "diplib/overload.h"
 
 namespace dip {
 
 namespace {
 
+// A boundary between the regions `vertices[ 0 ]` and `vertices[ 1 ]`, with `vertices[ 0 ] < vertices[ 1 ]`,
+// that is `count` pixels long.
+struct BoundaryCount {
+   std::array< dip::uint, 2 > vertices;
+   dip::uint count;
+};
+using BoundaryList = std::vector< BoundaryCount >;
+
+constexpr dip::uint noBoundary = std::numeric_limits< dip::uint >::max();
+
+// Adds to `list` a boundary pixel between `label1` and `label2`. `last` is the index into `list` of the boundary
+// previously added along the same direction; consecutive pixels on an image line often separate the same two
+// regions, in which case we only need to increment the count.
+inline void AddBoundaryPixel( BoundaryList& list, dip::uint& last, dip::uint label1, dip::uint label2 ) {
+   if( label1 > label2 ) {
+      std::swap( label1, label2 );
+   }
+   if(( last != noBoundary ) && ( list[ last ].vertices[ 0 ] == label1 ) && ( list[ last ].vertices[ 1 ] == label2 )) {
+      ++list[ last ].count;
+      return;
+   }
+   last = list.size();
+   list.push_back( { { label1, label2 }, 1 } );
+}
+
 template< typename TPI >
 class TouchingRegionAdjacencyGraphLineFilter : public Framework::ScanLineFilter {
    public:
-      TouchingRegionAdjacencyGraphLineFilter( Graph& graph, std::vector< dfloat >& boundaryLength, UnsignedArray const& sizes, IntegerArray const& strides )
-            : graph_( graph ), boundaryLength_( boundaryLength ), sizes_( sizes ), strides_( strides ) {}
+      TouchingRegionAdjacencyGraphLineFilter( std::vector< BoundaryList >& boundaries, UnsignedArray const& sizes, IntegerArray const& strides )
+            : boundaries_( boundaries ), sizes_( sizes ), strides_( strides ) {}
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         boundaries_.resize( threads );
+      }
+      virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override {
+         return 3 * sizes_.size();
+      }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          // We iterate from 0 to N-1.
          // We look in directions in which we're not the last line.
@@ -50,31 +85,30 @@ class TouchingRegionAdjacencyGraphLineFilter : public Framework::ScanLineFilter
          for( dip::uint jj = 0; jj < nDims; ++jj ) {
             process[ jj ] = params.position[ jj ] < ( sizes_[ jj ] - 1 );
          }
-         // Add to graph_ links to each of the *forward* neighbors (i.e. those that you can reach by incrementing
-         // one of the coordinates). The other neighbors are already linked to when those neighbors were processed
+         BoundaryList& list = boundaries_[ params.thread ];
+         UnsignedArray last( nDims, noBoundary );
+         // Record the boundaries with each of the *forward* neighbors (i.e. those that you can reach by incrementing
+         // one of the coordinates). The other neighbors are already recorded when those neighbors were processed
          for( dip::uint ii = 0; ii < length; ++ii, in += stride ) {
-            DoPixel( in, nDims, process );
+            DoPixel( in, nDims, process, list, last );
          }
          // Do the same for the last pixel on the line
          process[ dim ] = false;
-         DoPixel( in, nDims, process );
+         DoPixel( in, nDims, process, list, last );
       }
    private:
-      Graph& graph_;
-      std::vector< dfloat >& boundaryLength_;
+      std::vector< BoundaryList >& boundaries_;
       UnsignedArray const& sizes_;
       IntegerArray const& strides_;
 
-      void DoPixel( TPI const* in, dip::uint nDims, BooleanArray const& process ) {
+      void DoPixel( TPI const* in, dip::uint nDims, BooleanArray const& process, BoundaryList& list, UnsignedArray& last ) {
          dip::uint label = static_cast< dip::uint >( in[ 0 ] );
          if( label == 0 ) { return; }
          for( dip::uint jj = 0; jj < nDims; ++jj ) {
             if( process[ jj ] ) {
                dip::uint neighborLabel = static_cast< dip::uint >( in[ strides_[ jj ]] );
                if(( neighborLabel != 0 ) && ( neighborLabel != label )) {
-                  graph_.AddEdgeSumWeight( label, neighborLabel, 1 ); // Add 1 to the weight, this is the count of boundary pixels
-                  boundaryLength_[ label ] += 1;
-                  boundaryLength_[ neighborLabel ] += 1;
+                  AddBoundaryPixel( list, last[ jj ], label, neighborLabel );
                }
             }
          }
@@ -84,8 +118,14 @@ class TouchingRegionAdjacencyGraphLineFilter : public Framework::ScanLineFilter
 template< typename TPI >
 class WatershedRegionAdjacencyGraphLineFilter : public Framework::ScanLineFilter {
    public:
-      WatershedRegionAdjacencyGraphLineFilter( Graph& graph, std::vector< dfloat >& boundaryLength, UnsignedArray const& sizes, IntegerArray const& strides )
-            : graph_( graph ), boundaryLength_( boundaryLength ), sizes_( sizes ), strides_( strides ) {}
+      WatershedRegionAdjacencyGraphLineFilter( std::vector< BoundaryList >& boundaries, UnsignedArray const& sizes, IntegerArray const& strides )
+            : boundaries_( boundaries ), sizes_( sizes ), strides_( strides ) {}
+      virtual void SetNumberOfThreads( dip::uint threads ) override {
+         boundaries_.resize( threads );
+      }
+      virtual dip::uint GetNumberOfOperations( dip::uint, dip::uint, dip::uint ) override {
+         return 3 * sizes_.size();
+      }
       virtual void Filter( Framework::ScanLineFilterParameters const& params ) override {
          // We iterate from 1 to N-1.
          // We look in directions in which we're not the first or last line.
@@ -100,37 +140,36 @@ class WatershedRegionAdjacencyGraphLineFilter : public Framework::ScanLineFilter
          for( dip::uint jj = 0; jj < nDims; ++jj ) {
             process[ jj ] = ( params.position[ jj ] > 0 ) && ( params.position[ jj ] < ( sizes_[ jj ] - 1 ));
          }
-         // Here we add to graph_ links from a label to the left to one on the right of the current pixel.
+         BoundaryList& list = boundaries_[ params.thread ];
+         UnsignedArray last( nDims, noBoundary );
+         // Here we record boundaries between a label to the left and one on the right of the current pixel.
          // But only if the current pixel is a background pixel.
          // First for the first pixel on the line
          process[ dim ] = false;
-         DoPixel( in, nDims, process );
+         DoPixel( in, nDims, process, list, last );
          in += stride;
          // Now for the bulk of the line
          process[ dim ] = true;
          for( dip::uint ii = 1; ii < length; ++ii, in += stride ) {
-            DoPixel( in, nDims, process );
+            DoPixel( in, nDims, process, list, last );
          }
          // And finally for the last pixel of the line
          process[ dim ] = false;
-         DoPixel( in, nDims, process );
+         DoPixel( in, nDims, process, list, last );
       }
    private:
-      Graph& graph_;
-      std::vector< dfloat >& boundaryLength_;
+      std::vector< BoundaryList >& boundaries_;
       UnsignedArray const& sizes_;
       IntegerArray const& strides_;
 
-      void DoPixel( TPI const* in, dip::uint nDims, BooleanArray const& process ) {
+      void DoPixel( TPI const* in, dip::uint nDims, BooleanArray const& process, BoundaryList& list, UnsignedArray& last ) {
          if( in[ 0 ] == 0 ) {
             for( dip::uint jj = 0; jj < nDims; ++jj ) {
                if( process[ jj ] ) {
                   dip::uint label1 = static_cast< dip::uint >( in[ -strides_[ jj ]] );
                   dip::uint label2 = static_cast< dip::uint >( in[ strides_[ jj ]] );
                   if(( label1 > 0 ) && ( label2 > 0 ) && ( label1 != label2 )) {
-                     graph_.AddEdgeSumWeight( label1, label2, 1 ); // Add 1 to the weight, this is the count of boundary pixels
-                     boundaryLength_[ label1 ] += 1;
-                     boundaryLength_[ label2 ] += 1;
+                     AddBoundaryPixel( list, last[ jj ], label1, label2 );
                   }
                }
             }
@@ -138,6 +177,57 @@ class WatershedRegionAdjacencyGraphLineFilter : public Framework::ScanLineFilter
       }
 };
 
+// Merges the boundary lists collected by each of the threads, and adds an edge to `graph` for each pair of
+// neighboring regions, with the boundary length in pixels as weight. The vertex range is split into buckets,
+// each bucket is collected, sorted and merged by a separate thread. Edges are added in order of vertex indices,
+// so the graph doesn't depend on the number of threads used.
+void AddBoundariesToGraph( std::vector< BoundaryList >& boundaries, Graph& graph, std::vector< dfloat >& boundaryLength ) {
+   dip::uint nVertices = graph.NumberOfVertices();
+   dip::uint nBoundaries = 0;
+   for( auto const& list : boundaries ) {
+      nBoundaries += list.size();
+   }
+   // Sorting costs about log2(n) operations per element
+   dip::uint nBuckets = GetOptimalNumberOfThreads( nBoundaries * 20, std::min( GetNumberOfThreads(), nVertices ));
+   dip::uint bucketSize = div_ceil( nVertices, nBuckets );
+   std::vector< BoundaryList > buckets( nBuckets );
+   DIP_STACK_TRACE_THIS( ParallelRun( nBuckets, [ & ]( dip::uint bucket ) {
+      dip::uint first = bucket * bucketSize;
+      dip::uint last = std::min( first + bucketSize, nVertices );
+      BoundaryList& out = buckets[ bucket ];
+      for( auto const& list : boundaries ) {
+         for( auto const& boundary : list ) {
+            if(( boundary.vertices[ 0 ] >= first ) && ( boundary.vertices[ 0 ] < last )) {
+               out.push_back( boundary );
+            }
+         }
+      }
+      std::sort( out.begin(), out.end(), []( BoundaryCount const& a, BoundaryCount const& b ) {
+         return a.vertices < b.vertices;
+      } );
+      // Merge duplicates, summing their counts
+      dip::uint nOut = 0;
+      for( dip::uint ii = 0; ii < out.size(); ++ii ) {
+         if(( nOut > 0 ) && ( out[ nOut - 1 ].vertices == out[ ii ].vertices )) {
+            out[ nOut - 1 ].count += out[ ii ].count;
+         } else {
+            out[ nOut ] = out[ ii ];
+            ++nOut;
+         }
+      }
+      out.resize( nOut );
+   } ));
+   boundaries.clear();
+   for( auto const& bucket : buckets ) {
+      for( auto const& boundary : bucket ) {
+         dfloat count = static_cast< dfloat >( boundary.count );
+         graph.AddEdgeNoCheck( boundary.vertices[ 0 ], boundary.vertices[ 1 ], count );
+         boundaryLength[ boundary.vertices[ 0 ]] += count;
+         boundaryLength[ boundary.vertices[ 1 ]] += count;
+      }
+   }
+}
+
 Graph RegionAdjacencyGraphInternal( Image const& label, String const& mode, std::vector< dfloat >& boundaryLength ) {
    DIP_THROW_IF( !label.IsForged(), E::IMAGE_NOT_FORGED );
    DIP_THROW_IF( !label.IsScalar(), E::IMAGE_NOT_SCALAR );
@@ -148,14 +238,16 @@ Graph RegionAdjacencyGraphInternal( Image const& label, String const& mode, std:
    dip::uint nVertices = dip::Maximum( label ).As< dip::uint >() + 1;
    Graph graph( nVertices );
    boundaryLength.resize( nVertices, 0 );
+   // Each thread collects the boundaries it sees in its own list, these are merged afterwards
+   std::vector< BoundaryList > boundaries( 1 );
    std::unique_ptr< Framework::ScanLineFilter > lineFilter;
    if( touching ) {
-      DIP_OVL_NEW_UINT( lineFilter, TouchingRegionAdjacencyGraphLineFilter, ( graph, boundaryLength, label.Sizes(), label.Strides() ), label.DataType() );
+      DIP_OVL_NEW_UINT( lineFilter, TouchingRegionAdjacencyGraphLineFilter, ( boundaries, label.Sizes(), label.Strides() ), label.DataType() );
    } else {
-      DIP_OVL_NEW_UINT( lineFilter, WatershedRegionAdjacencyGraphLineFilter, ( graph, boundaryLength, label.Sizes(), label.Strides() ), label.DataType() );
+      DIP_OVL_NEW_UINT( lineFilter, WatershedRegionAdjacencyGraphLineFilter, ( boundaries, label.Sizes(), label.Strides() ), label.DataType() );
    }
-   DIP_STACK_TRACE_THIS( Framework::ScanSingleInput( label, {}, label.DataType(), *lineFilter,
-                                                     Framework::ScanOption::NoMultiThreading + Framework::ScanOption::NeedCoordinates ));
+   DIP_STACK_TRACE_THIS( Framework::ScanSingleInput( label, {}, label.DataType(), *lineFilter, Framework::ScanOption::NeedCoordinates ));
+   DIP_STACK_TRACE_THIS( AddBoundariesToGraph( boundaries, graph, boundaryLength ));
    return graph;
 }
 
@@ -211,3 +303,59 @@ void Relabel( Image const& label, Image& out, Graph const& graph ) {
 }
 
 } // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+
+DOCTEST_TEST_CASE("[DIPlib] testing dip::RegionAdjacencyGraph") {
+   dip::Image small( { 3, 3 }, 1, dip::DT_UINT8 );
+   small.At( 0, 0 ) = 1; small.At( 1, 0 ) = 1; small.At( 2, 0 ) = 2;
+   small.At( 0, 1 ) = 1; small.At( 1, 1 ) = 1; small.At( 2, 1 ) = 2;
+   small.At( 0, 2 ) = 3; small.At( 1, 2 ) = 3; small.At( 2, 2 ) = 3;
+   dip::Graph graph = dip::RegionAdjacencyGraph( small, "touching" );
+   DOCTEST_REQUIRE( graph.NumberOfEdges() == 3 );
+   auto const& edges = graph.Edges();
+   DOCTEST_CHECK( edges[ 0 ].vertices[ 0 ] == 1 );
+   DOCTEST_CHECK( edges[ 0 ].vertices[ 1 ] == 2 );
+   DOCTEST_CHECK( edges[ 0 ].weight == doctest::Approx( 1.0 / 3.0 ));
+   DOCTEST_CHECK( edges[ 1 ].vertices[ 0 ] == 1 );
+   DOCTEST_CHECK( edges[ 1 ].vertices[ 1 ] == 3 );
+   DOCTEST_CHECK( edges[ 1 ].weight == doctest::Approx( 1.0 / 3.0 ));
+   DOCTEST_CHECK( edges[ 2 ].vertices[ 0 ] == 2 );
+   DOCTEST_CHECK( edges[ 2 ].vertices[ 1 ] == 3 );
+   DOCTEST_CHECK( edges[ 2 ].weight == doctest::Approx( 2.0 / 3.0 ));
+
+   // A grid of rectangular regions, with some background lines; the graph must not depend on the number of threads
+   dip::Image label( { 120, 90 }, 1, dip::DT_UINT16 );
+   for( dip::uint y = 0; y < 90; ++y ) {
+      for( dip::uint x = 0; x < 120; ++x ) {
+         bool background = ( x % 13 == 0 ) || ( y % 11 == 0 );
+         label.At( x, y ) = background ? 0 : ( x / 7 ) + 18 * ( y / 5 ) + 1;
+      }
+   }
+   for( auto mode : { "touching", "watershed" } ) {
+      dip::Graph reference;
+      {
+         dip::ExecutionContext context;
+         context.maxThreads = 1;
+         dip::ScopedExecutionContext scope( context );
+         reference = dip::RegionAdjacencyGraph( label, mode );
+      }
+      dip::ExecutionContext context;
+      context.maxThreads = 4;
+      context.threadingThreshold = 1;
+      dip::ScopedExecutionContext scope( context );
+      graph = dip::RegionAdjacencyGraph( label, mode );
+      DOCTEST_REQUIRE( graph.NumberOfEdges() == reference.NumberOfEdges() );
+      DOCTEST_CHECK( graph.NumberOfEdges() > 50 );
+      bool equal = true;
+      for( dip::uint ii = 0; ii < graph.NumberOfEdges(); ++ii ) {
+         equal &= graph.Edges()[ ii ].vertices == reference.Edges()[ ii ].vertices;
+         equal &= graph.Edges()[ ii ].weight == reference.Edges()[ ii ].weight;
+      }
+      DOCTEST_CHECK( equal );
+   }
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -26,12 +26,16 @@
 #include "diplib/multithreading.h"
 #include "diplib/geometry.h"
 #include "diplib/math.h"
+#include "fourier_support.h"
 
 #ifdef DIP_CONFIG_HAS_FFTW
    #ifdef _WIN32
       #define NOMINMAX // windows.h must not define min() and max(), which conflict with std::min() and std::max()
    #endif
    #include "fftw3api.h"
+   #include <map>
+   #include <mutex>
+   #include <tuple>
 #endif
 
 namespace dip {
@@ -42,13 +46,102 @@ namespace {
 constexpr BoundaryCondition DFT_PADDING_MODE = BoundaryCondition::ZERO_ORDER_EXTRAPOLATE; // Is this the least damaging boundary condition?
 constexpr BoundaryCondition IDFT_PADDING_MODE = BoundaryCondition::ADD_ZEROS;
 
+// Estimated number of operations for the Fourier transform of one line of `length` samples. A real-to-complex or
+// complex-to-real transform costs about half as much as a complex-to-complex one.
+dip::uint FourierTransformLineOperations( dip::uint length, bool realValued ) {
+   dip::uint operations = 5 * length * static_cast< dip::uint >( std::round( std::log2( length )));
+   return realValued ? operations : 2 * operations;
+}
+
 
 #ifdef DIP_CONFIG_HAS_FFTW
 
+// Note that these helpers, and the plan cache below, are in the anonymous namespace: they are shared by the
+// line filters and the wisdom functions in this file, but are not visible outside it.
+
 // FFTW documentation specifies 16-byte alignment required for SIMD implementations:
 // http://www.fftw.org/fftw3_doc/SIMD-alignment-and-fftw_005fmalloc.html#SIMD-alignment-and-fftw_005fmalloc
 constexpr dip::uint FFTW_MAX_ALIGN_REQUIRED = 16;
 
+bool IsAligned( void const* source, void const* destination ) {
+   return ( reinterpret_cast< dip::uint >( source ) % FFTW_MAX_ALIGN_REQUIRED == 0 ) &&
+          ( reinterpret_cast< dip::uint >( destination ) % FFTW_MAX_ALIGN_REQUIRED == 0 );
+}
+
+// The FFTW planner is not thread safe, all calls to the planner and the wisdom functions must hold this mutex.
+std::mutex& FFTWPlannerMutex() {
+   static std::mutex mutex;
+   return mutex;
+}
+
+enum class FFTWPlanType : uint8 { C2C, R2C, C2R };
+
+// A process-wide cache of FFTW plans. Plans are created the first time they are requested, and kept until the
+// program ends. Executing a plan is thread safe, so the plans can be shared by all threads.
+template< typename T >
+class FFTWPlanCache {
+   public:
+      using plan = typename fftwapidef< T >::plan;
+      using complex = typename fftwapidef< T >::complex;
+
+      // Returns the plan for the given configuration, creating it if necessary. This function is thread safe.
+      // The real-to-complex and complex-to-real plans are always out of place.
+      static plan Get( dip::uint size, FFTWPlanType type, bool inverse, bool inplace, bool aligned ) {
+         DIP_ASSERT(( type == FFTWPlanType::C2C ) || !inplace );
+         static FFTWPlanCache cache;
+         Key key{ size, type, inverse, inplace, aligned };
+         std::lock_guard< std::mutex > lock( FFTWPlannerMutex() );
+         auto it = cache.plans_.find( key );
+         if( it == cache.plans_.end() ) {
+            it = cache.plans_.emplace( key, CreatePlan( size, type, inverse, inplace, aligned )).first;
+         }
+         return it->second;
+      }
+
+      ~FFTWPlanCache() {
+         for( auto& p : plans_ ) {
+            fftwapidef< T >::destroy_plan( p.second );
+         }
+      }
+
+   private:
+      using Key = std::tuple< dip::uint, FFTWPlanType, bool, bool, bool >;
+      std::map< Key, plan > plans_;
+
+      static plan CreatePlan( dip::uint size, FFTWPlanType type, bool inverse, bool inplace, bool aligned ) {
+         // FFTW_MEASURE is almost always faster than FFTW_ESTIMATE, only for very trivial sizes it's not.
+         // The aligned plan is used when the buffers given to `Apply` are aligned, which they are when
+         // the Separable framework is called with `SeparableOption::AlignedBuffers` and there is no padding.
+         // The unaligned plan is the fallback for the other cases, we don't spend time measuring it.
+         unsigned flags = aligned ? FFTW_MEASURE : ( FFTW_ESTIMATE | FFTW_UNALIGNED );
+         int sz = static_cast< int >( size );
+         // Allocate temporary arrays just for planning. `fftw_malloc` returns arrays with the alignment that
+         // FFTW's SIMD code needs.
+         plan out;
+         if( type == FFTWPlanType::C2C ) {
+            complex* in = static_cast< complex* >( fftwapidef< T >::malloc( size * sizeof( complex )));
+            complex* res = inplace ? in : static_cast< complex* >( fftwapidef< T >::malloc( size * sizeof( complex )));
+            out = fftwapidef< T >::plan_dft_1d( sz, in, res, inverse ? FFTW_BACKWARD : FFTW_FORWARD, flags );
+            if( !inplace ) {
+               fftwapidef< T >::free( res );
+            }
+            fftwapidef< T >::free( in );
+         } else {
+            T* real = static_cast< T* >( fftwapidef< T >::malloc( size * sizeof( T )));
+            complex* cmplx = static_cast< complex* >( fftwapidef< T >::malloc(( size / 2 + 1 ) * sizeof( complex )));
+            if( type == FFTWPlanType::C2R ) {
+               out = fftwapidef< T >::plan_dft_c2r_1d( sz, cmplx, real, flags );
+            } else {
+               out = fftwapidef< T >::plan_dft_r2c_1d( sz, real, cmplx, flags );
+            }
+            fftwapidef< T >::free( cmplx );
+            fftwapidef< T >::free( real );
+         }
+         DIP_THROW_IF( !out, "FFTW failed to create a plan" );
+         return out;
+      }
+};
+
 // This is the equivalent of dip::DFT, but encapsulating FFTW functionality
 template< typename T >
 class FFTW {
@@ -59,63 +152,20 @@ class FFTW {
       FFTW() = default;
 
       /// \brief Equivalent to calling `Initialize()` on a default-initialized object.
-      FFTW( dip::uint size, bool inverse ) : inverse_( inverse ) { this->Initialize( size, inverse ); }
-
-      ~FFTW() {
-         Destroy();
-      }
-
-      // Prevent copying
-      FFTW( FFTW const& ) = delete;
-      FFTW operator=( FFTW const& ) = delete;
-
-      // Allow moving
-      FFTW( FFTW&& other ) noexcept {
-         nfft_ = other.nfft_;
-         inverse_ = other.inverse_;
-         plan_ = other.plan_;
-         other.plan_ = nullptr;
-      }
-      FFTW operator=( FFTW&& other ) noexcept {
-         Destroy();
-         nfft_ = other.nfft_;
-         inverse_ = other.inverse_;
-         plan_ = other.plan_;
-         other.plan_ = nullptr;
-      }
+      FFTW( dip::uint size, bool inverse ) { this->Initialize( size, inverse ); }
 
       /// \brief Re-configure a `%FFTW` object to the given transform size and direction.
       ///
-      /// Note that this is not a trivial operation.
-      ///
-      /// This function is not thread safe, as it calls the FFTW planner.
+      /// Plans are taken from a process-wide cache, the FFTW planner is only called the first time
+      /// a configuration is used. This function is thread safe.
       ///
       /// If `inplace` is `true`, then `Apply` expects `source` and `destination` to be
       /// the same.
       void Initialize( dip::uint size, bool inverse, bool inplace = false ) {
-         Destroy();
          nfft_ = size;
          inverse_ = inverse;
-         int sign = inverse ? FFTW_BACKWARD : FFTW_FORWARD;
-         std::vector< std::complex< T >> in( size ); // allocate temporary arrays just for planning...
-         if( inplace ) {
-            plan_ = fftwapidef< T >::plan_dft_1d(
-                  static_cast< int >( size ),
-                  reinterpret_cast< complex* >( in.data() ),
-                  reinterpret_cast< complex* >( in.data() ),
-                  sign, FFTW_MEASURE | FFTW_UNALIGNED);
-         } else {
-            std::vector< std::complex< T >> out( size ); // allocate temporary arrays just for planning...
-            plan_ = fftwapidef< T >::plan_dft_1d(
-                  static_cast< int >( size ),
-                  reinterpret_cast< complex* >( in.data() ),
-                  reinterpret_cast< complex* >( out.data() ),
-                  sign, FFTW_MEASURE | FFTW_UNALIGNED);
-         }
-         // FFTW_MEASURE is almost always faster than FFTW_ESTIMATE, only for very trivial sizes it's not.
-         // TODO: Remove FFTW_UNALIGNED by ensuring that the buffers are 16-byte aligned.
-         //       This requires aligning buffers created by the Separable framework.
-         // TODO: Separable framework needs an option for 16-byte boundary aligned buffers.
+         plan_ = FFTWPlanCache< T >::Get( size, FFTWPlanType::C2C, inverse, inplace, false );
+         alignedPlan_ = FFTWPlanCache< T >::Get( size, FFTWPlanType::C2C, inverse, inplace, true );
       }
 
       /// \brief Apply the transform that the `%FFTW` object is configured for.
@@ -129,13 +179,14 @@ class FFTW {
       /// `scale` is a real scalar that the output values are multiplied by. It is typically set to `1/size` for
       /// the inverse transform, and 1 for the forward transform.
       ///
-      /// This function is thread-safe, as opposed to `Initialse()`.
+      /// This function is thread-safe.
       void Apply(
             std::complex< T >* source,
             std::complex< T >* destination,
             T scale
       ) const {
-         fftwapidef< T >::execute_dft( plan_, reinterpret_cast< complex* >( source ), reinterpret_cast< complex* >( destination ));
+         fftwapidef< T >::execute_dft( IsAligned( source, destination ) ? alignedPlan_ : plan_,
+                                       reinterpret_cast< complex* >( source ), reinterpret_cast< complex* >( destination ));
          if( scale != 1.0 ) {
             for( std::complex< T >* ptr = destination; ptr < destination + nfft_; ++ptr ) {
                *ptr *= scale;
@@ -152,14 +203,74 @@ class FFTW {
    private:
       dip::uint nfft_ = 0;
       bool inverse_ = false;
-      typename fftwapidef< T >::plan plan_ = nullptr;
+      typename fftwapidef< T >::plan plan_ = nullptr;        // for unaligned buffers, owned by FFTWPlanCache
+      typename fftwapidef< T >::plan alignedPlan_ = nullptr; // for buffers aligned to FFTW_MAX_ALIGN_REQUIRED bytes
+};
+
+// This is the equivalent of dip::RDFT, but encapsulating FFTW functionality
+template< typename T >
+class RFFTW {
+   public:
+      using complex = typename fftwapidef< T >::complex;
+
+      /// \brief A default-initialized `%RFFTW` object is useless. Call `Initialize` to make it useful.
+      RFFTW() = default;
+
+      /// \brief Re-configure a `%RFFTW` object to the given transform size and direction.
+      ///
+      /// The forward transform is real-to-complex, the inverse transform is complex-to-real. The complex
+      /// data has `size/2+1` elements.
+      ///
+      /// Plans are taken from a process-wide cache, the FFTW planner is only called the first time
+      /// a configuration is used. This function is thread safe.
+      void Initialize( dip::uint size, bool inverse ) {
+         nfft_ = size;
+         inverse_ = inverse;
+         FFTWPlanType type = inverse ? FFTWPlanType::C2R : FFTWPlanType::R2C;
+         plan_ = FFTWPlanCache< T >::Get( size, type, inverse, false, false );
+         alignedPlan_ = FFTWPlanCache< T >::Get( size, type, inverse, false, true );
+      }
+
+      /// \brief Apply the forward (real-to-complex) transform. `destination` has `TransformSize/2+1` elements.
+      ///
+      /// This function is thread-safe.
+      void Apply( T* source, std::complex< T >* destination, T scale ) const {
+         DIP_ASSERT( !inverse_ );
+         fftwapidef< T >::execute_dft_r2c( IsAligned( source, destination ) ? alignedPlan_ : plan_,
+                                           source, reinterpret_cast< complex* >( destination ));
+         if( scale != 1.0 ) {
+            for( std::complex< T >* ptr = destination; ptr < destination + nfft_ / 2 + 1; ++ptr ) {
+               *ptr *= scale;
+            }
+         }
+      }
 
-      void Destroy() {
-         if( plan_ ) {
-            fftwapidef< T >::destroy_plan( plan_ );
-            plan_ = nullptr;
+      /// \brief Apply the inverse (complex-to-real) transform. `source` has `TransformSize/2+1` elements, and
+      /// is overwritten.
+      ///
+      /// This function is thread-safe.
+      void Apply( std::complex< T >* source, T* destination, T scale ) const {
+         DIP_ASSERT( inverse_ );
+         fftwapidef< T >::execute_dft_c2r( IsAligned( source, destination ) ? alignedPlan_ : plan_,
+                                           reinterpret_cast< complex* >( source ), destination );
+         if( scale != 1.0 ) {
+            for( T* ptr = destination; ptr < destination + nfft_; ++ptr ) {
+               *ptr *= scale;
+            }
          }
       }
+
+      /// \brief Returns true if this represents an inverse transform, false for a forward transform.
+      bool IsInverse() const { return inverse_; }
+
+      /// \brief Returns the size that the transform is configured for. If not configured, returns 0.
+      dip::uint TransformSize() const { return plan_ ? nfft_ : 0; }
+
+   private:
+      dip::uint nfft_ = 0;
+      bool inverse_ = false;
+      typename fftwapidef< T >::plan plan_ = nullptr;        // for unaligned buffers, owned by FFTWPlanCache
+      typename fftwapidef< T >::plan alignedPlan_ = nullptr; // for buffers aligned to FFTW_MAX_ALIGN_REQUIRED bytes
 };
 
 #endif
@@ -202,14 +313,14 @@ static void ShiftCenterToCorner( TPI* data, dip::uint length ) { // ifftshift
 }
 
 template< typename TPI >
-static void ShiftCornerToCenterHalfLine( TPI* data, dip::uint length ) { // ifftshift, but for a half-line only
-   bool isOdd = length & 1u;
+static void ShiftCornerToCenterHalfLine( TPI* data, dip::uint length ) { // fftshift, but for a half-line only
    length /= 2;  // the central pixel, the last value in the line that we'll use
    dip::uint jj = ( length + 1 ) / 2;  // the number of swaps
    for( dip::uint ii = 0; ii < jj; ++ii ) {
       std::swap( data[ ii ], data[ length - ii ] );
    }
-   for( dip::uint ii = 1; ii < ( length + isOdd ); ++ii ) {
+   // The values now represent the negative frequencies, we get these through the conjugate symmetry
+   for( dip::uint ii = 0; ii < length; ++ii ) {
       data[ ii ] = std::conj( data[ ii ] );
    }
 }
@@ -266,7 +377,7 @@ class C2C_DFT_LineFilter : public Framework::SeparableLineFilter {
          for( dip::uint ii = 0; ii < outSize.size(); ++ii ) {
             if( process[ ii ] ) {
 #ifdef DIP_CONFIG_HAS_FFTW
-               // FFTW re-uses plans internally
+               // Plans are cached, initializing a second dimension of the same size is cheap
                fftw_[ ii ].Initialize( outSize[ ii ], inverse );
 #else
                bool found = false;
@@ -292,7 +403,7 @@ class C2C_DFT_LineFilter : public Framework::SeparableLineFilter {
 #endif
       }
       virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint ) override {
-         return 10 * lineLength * static_cast< dip::uint >( std::round( std::log2( lineLength )));
+         return FourierTransformLineOperations( lineLength, false );
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
 #ifdef DIP_CONFIG_HAS_FFTW
@@ -355,15 +466,17 @@ class C2C_DFT_LineFilter : public Framework::SeparableLineFilter {
 
 // TPI is either scomplex or dcomplex.
 // This will always only be called for a single dimension.
-// Input buffer is actually complex-valued too. TODO: make it real-valued, and call FFTW's R2C function.
+// The input buffer is real-valued, the output buffer holds the non-redundant half of the spectrum.
 template< typename TPI >
 class R2C_DFT_LineFilter : public Framework::SeparableLineFilter {
    public:
-      R2C_DFT_LineFilter( dip::uint outSize, bool corner ) : shift_( !corner ) {
+      using TPIf = FloatType< TPI >;
+      R2C_DFT_LineFilter( dip::uint transformSize, bool corner, dfloat scale )
+            : scale_( static_cast< TPIf >( scale )), shift_( !corner ) {
 #ifdef DIP_CONFIG_HAS_FFTW
-         fftw_.Initialize( outSize, false );
+         fftw_.Initialize( transformSize, false );
 #else
-         dft_.Initialize( outSize, false );
+         dft_.Initialize( transformSize, false );
 #endif
       }
       virtual void SetNumberOfThreads( dip::uint threads ) override {
@@ -374,7 +487,7 @@ class R2C_DFT_LineFilter : public Framework::SeparableLineFilter {
 #endif
       }
       virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint ) override {
-         return 10 * lineLength * static_cast< dip::uint >( std::round( std::log2( lineLength )));
+         return FourierTransformLineOperations( lineLength, true );
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
 #ifdef DIP_CONFIG_HAS_FFTW
@@ -387,13 +500,13 @@ class R2C_DFT_LineFilter : public Framework::SeparableLineFilter {
 #endif
          dip::uint border = params.inBuffer.border;
          DIP_ASSERT( params.inBuffer.length + 2 * border >= length );
-         DIP_ASSERT( params.outBuffer.length == length );
+         DIP_ASSERT( params.outBuffer.length == length / 2 + 1 );
          if( !( params.inBuffer.length & 1u ) && ( length & 1u )) {
             // When padding from an even-sized array to an odd-sized array, we pad one fewer element to the left
             // In other cases we pad evenly or we pad one fewer element to the right.
             --border;
          }
-         TPI* in = static_cast< TPI* >( params.inBuffer.buffer ) - border;
+         TPIf* in = static_cast< TPIf* >( params.inBuffer.buffer ) - border;
          TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
          if( shift_ ) {
             ShiftCenterToCorner( in, length );
@@ -403,9 +516,9 @@ class R2C_DFT_LineFilter : public Framework::SeparableLineFilter {
             // We copy the padded border as well, extending it appropriately
          }
 #ifdef DIP_CONFIG_HAS_FFTW
-         fftw_.Apply( in, out, 1 );
+         fftw_.Apply( in, out, scale_ );
 #else
-         dft_.Apply( in, out, buffers_[ params.thread ].data(), 1 );
+         dft_.Apply( in, out, buffers_[ params.thread ].data(), scale_ );
 #endif
          if( shift_ ) {
             ShiftCornerToCenterHalfLine( out, length );
@@ -414,98 +527,78 @@ class R2C_DFT_LineFilter : public Framework::SeparableLineFilter {
 
    private:
 #ifdef DIP_CONFIG_HAS_FFTW
-      FFTW< FloatType< TPI >> fftw_;
+      RFFTW< TPIf > fftw_;
 #else
-      DFT< FloatType< TPI >> dft_;
+      RDFT< TPIf > dft_;
       std::vector< std::vector< TPI >> buffers_; // one for each thread
 #endif
+      TPIf scale_;
       bool shift_;
 };
 
 // TPI is either scomplex or dcomplex.
 // This will always only be called for a single dimension.
+// The input buffer holds the non-redundant half of the spectrum, the output buffer is real-valued.
 template< typename TPI >
 class C2R_IDFT_LineFilter : public Framework::SeparableLineFilter {
    public:
-      C2R_IDFT_LineFilter( dip::uint outSize, dip::uint inSize, bool corner ) : shift_( !corner ), inSize_( inSize ) {
+      using TPIf = FloatType< TPI >;
+      C2R_IDFT_LineFilter( dip::uint outSize, dip::uint inSize, bool corner, dfloat scale )
+            : scale_( static_cast< TPIf >( scale )), shift_( !corner ), inSize_( inSize ) {
 #ifdef DIP_CONFIG_HAS_FFTW
-         fftw_.Initialize( outSize, true, true );
+         fftw_.Initialize( outSize, true );
 #else
          dft_.Initialize( outSize, true );
 #endif
       }
       virtual void SetNumberOfThreads( dip::uint threads ) override {
-#ifdef DIP_CONFIG_HAS_FFTW
-         ( void )threads;
-#else
          buffers_.resize( threads );
-#endif
       }
       virtual dip::uint GetNumberOfOperations( dip::uint lineLength, dip::uint, dip::uint, dip::uint ) override {
-         return 10 * lineLength * static_cast< dip::uint >( std::round( std::log2( lineLength )));
+         return FourierTransformLineOperations( lineLength, true );
       }
       virtual void Filter( Framework::SeparableLineFilterParameters const& params ) override {
 #ifdef DIP_CONFIG_HAS_FFTW
          dip::uint length = fftw_.TransformSize();
+         dip::uint bufferSize = length / 2 + 1;
 #else
          dip::uint length = dft_.TransformSize();
+         dip::uint bufferSize = length / 2 + 1 + dft_.BufferSize();
 #endif
          DIP_ASSERT(( inSize_ / 2 + 1 ) == params.inBuffer.length );
          DIP_ASSERT( length >= inSize_ );
          DIP_ASSERT( params.outBuffer.length == length );
-         TPI* in = static_cast< TPI* >( params.inBuffer.buffer );
-         TPI* out = static_cast< TPI* >( params.outBuffer.buffer );
-#ifdef DIP_CONFIG_HAS_FFTW
-         TPI* tmp = out;
-#else
-         buffers_[ params.thread ].resize( length + dft_.BufferSize() );
-         TPI* tmp = buffers_[ params.thread ].data(); // we need an additional buffer: `in` is too short, and the DFT routine cannot work in-place in general (only for specific lengths)
-         TPI* buffer = tmp + length;
-#endif
-         dip::uint firstSample = 0;
-         dip::uint start = params.inBuffer.length;
-         dip::uint end = 0;
+         TPI const* in = static_cast< TPI const* >( params.inBuffer.buffer );
+         TPIf* out = static_cast< TPIf* >( params.outBuffer.buffer );
+         // We need an additional buffer: `in` is too short if we pad, and we need to change the origin
+         if( buffers_[ params.thread ].size() != bufferSize ) {
+            buffers_[ params.thread ].resize( bufferSize );
+         }
+         TPI* half = buffers_[ params.thread ].data(); // The frequencies 0 through `length/2`
          if( shift_ ) {
-            // Rightmost input sample is central output sample: `params.inBuffer.length-1` ==> `length/2`
-            firstSample = length / 2 - params.inBuffer.length + 1;
-            start -= 1;                         // the last value is the 0 frequency, don't copy it
-            end = ( inSize_ & 1u ) ? 0 : 1;     // for even-sized buffer, the first value is not to be copied.
+            // Rightmost input sample is the 0 frequency, the input holds the negative frequencies. We get the
+            // positive ones through the conjugate symmetry.
+            dip::uint last = params.inBuffer.length - 1;
+            for( dip::uint ii = 0; ii < last; ++ii ) {
+               half[ ii ] = std::conj( in[ last - ii ] );
+            }
+            half[ last ] = std::conj( in[ 0 ] );
+            if( !( inSize_ & 1u ) && ( length > inSize_ )) {
+               // For even-sized input, the first input sample is the negative Nyquist frequency, which has no
+               // positive counterpart; when padding the spectrum, it's no longer at the Nyquist frequency.
+               half[ last ] *= TPIf( 0.5 );
+            }
+            // Pad the spectrum by adding zeros (IDFT_PADDING_MODE = BoundaryCondition::ADD_ZEROS)
+            std::fill( half + last + 1, half + length / 2 + 1, TPI( 0 ));
          } else {
-            // Leftmost input sample is leftmost output sample, but we never pad in this case
+            // Leftmost input sample is the 0 frequency, but we never pad in this case
             DIP_ASSERT( length == inSize_ );
-            //firstSample = 0;
-            start -= ( inSize_ & 1u ) ? 0 : 1;  // for even-sized buffer, the last value is not to be copied.
-            end = 1;                            // the first value is the 0 frequency, don't copy it
-         }
-         TPI* outPtr = tmp;
-         // Pad the output array by adding zeros (IDFT_PADDING_MODE = BoundaryCondition::ADD_ZEROS)
-         for( dip::uint ii = 0; ii < firstSample; ++ii ) {
-            *outPtr = 0;
-            ++outPtr;
-         }
-         // Copy the data from in to the left half of out
-         for( dip::uint ii = 0; ii < params.inBuffer.length; ++ii ) {
-            *outPtr = in[ ii ];
-            ++outPtr;
-         }
-         // Copy the complex conjugated data from in to the right half of out
-         for( dip::uint ii = start; ii > end; ) {      // loop excludes start, includes end!
-            --ii;
-            *outPtr = std::conj( in[ ii ] );
-            ++outPtr;
-         }
-         // Pad the output array by adding zeros (IDFT_PADDING_MODE = BoundaryCondition::ADD_ZEROS)
-         while( outPtr < tmp + length ) {
-            *outPtr = 0;
-            ++outPtr;
-         }
-         if( shift_ ) {
-            ShiftCenterToCorner( tmp, length );
+            std::copy( in, in + length / 2 + 1, half );
          }
 #ifdef DIP_CONFIG_HAS_FFTW
-         fftw_.Apply( out, out, 1 ); // note that tmp == out
+         fftw_.Apply( half, out, scale_ );
 #else
-         dft_.Apply( tmp, out, buffer, 1 );
+         dft_.Apply( half, out, half + length / 2 + 1, scale_ );
 #endif
          if( shift_ ) {
             ShiftCornerToCenter( out, length );
@@ -514,11 +607,12 @@ class C2R_IDFT_LineFilter : public Framework::SeparableLineFilter {
 
    private:
 #ifdef DIP_CONFIG_HAS_FFTW
-      FFTW< FloatType< TPI >> fftw_;
+      RFFTW< TPIf > fftw_;
 #else
-      DFT< FloatType< TPI >> dft_;
-      std::vector< std::vector< TPI >> buffers_; // one for each thread
+      RDFT< TPIf > dft_;
 #endif
+      std::vector< std::vector< TPI >> buffers_; // one for each thread
+      TPIf scale_;
       bool shift_;
       dip::uint inSize_;
 };
@@ -555,18 +649,21 @@ void DFT_C2C_compute(
       Framework::Separable( in, out, dtype, dtype, process, border, bc, *lineFilter,
                             Framework::SeparableOption::UseInputBuffer +   // input stride is always 1
                             Framework::SeparableOption::UseOutputBuffer +  // output stride is always 1
+                            Framework::SeparableOption::AlignedBuffers +   // allows FFTW to use SIMD code
                             Framework::SeparableOption::DontResizeOutput + // output is potentially larger than input, if padding with zeros
                             Framework::SeparableOption::AsScalarImage      // each tensor element processed separately
       );
    DIP_END_STACK_TRACE
 }
 
-// Computes a 1D real-to-complex DFT. Potentially computes only the redundant part (if using FFTW).
+// Computes a 1D real-to-complex DFT, producing only the non-redundant half of the spectrum.
 void DFT_R2C_1D_compute(
       Image const& in,     // real-valued
-      Image& out,          // the first half of the image is filled in, pixels 0 through size/2+1
+      Image& out,          // complex-valued, already forged, with `length/2+1` pixels along `dimension`
       dip::uint dimension, // dimension along which to compute
-      bool corner          // where to put the origin
+      dip::uint length,    // the transform size along `dimension`
+      bool corner,         // where to put the origin
+      dfloat scale
 ) {
    DIP_ASSERT( in.IsForged() );
    DIP_ASSERT( out.IsForged() );
@@ -574,12 +671,13 @@ void DFT_R2C_1D_compute(
    DIP_ASSERT( out.DataType().IsComplex() );
    dip::uint nDims = in.Dimensionality();
    DIP_ASSERT( dimension < nDims );
+   DIP_ASSERT( out.Size( dimension ) == length / 2 + 1 );
    // Find parameters for separable framework
    DataType dtype = out.DataType();
    BooleanArray process( nDims, false );
    process[ dimension ] = true;
    UnsignedArray border( nDims, 0 );
-   border[ dimension ] = div_ceil< dip::uint >( out.Size( dimension ) - in.Size( dimension ), 2 );
+   border[ dimension ] = div_ceil< dip::uint >( length - in.Size( dimension ), 2 );
    BoundaryConditionArray bc{ DFT_PADDING_MODE };
 
    DIP_START_STACK_TRACE
@@ -590,12 +688,14 @@ void DFT_R2C_1D_compute(
       dip::Image tmp = out.At( window );
       // Get callback function
       std::unique_ptr< Framework::SeparableLineFilter > lineFilter;
-      DIP_OVL_NEW_COMPLEX( lineFilter, R2C_DFT_LineFilter, ( tmp.Size( dimension ), corner ), dtype );
+      DIP_OVL_NEW_COMPLEX( lineFilter, R2C_DFT_LineFilter, ( length, corner, scale ), dtype );
       Framework::Separable( in, tmp, dtype, dtype, process, border, bc, *lineFilter,
                             Framework::SeparableOption::UseInputBuffer +   // input stride is always 1
                             Framework::SeparableOption::UseOutputBuffer +  // output stride is always 1
-                            Framework::SeparableOption::DontResizeOutput + // output is potentially larger than input, if padding with zeros
-                            Framework::SeparableOption::AsScalarImage      // each tensor element processed separately
+                            Framework::SeparableOption::AlignedBuffers +   // allows FFTW to use SIMD code
+                            Framework::SeparableOption::DontResizeOutput + // output size differs from input size
+                            Framework::SeparableOption::AsScalarImage +    // each tensor element processed separately
+                            Framework::SeparableOption::RealInputBuffer    // the input buffer is real-valued
       );
       // Extend computed data into output regions outside the window (boundary extension)
       DIP_STACK_TRACE_THIS( ExtendRegion( out, window, bc ));
@@ -653,22 +753,25 @@ void DFT_R2C_1D_finalize(
    }
    DIP_STACK_TRACE_THIS( right.Copy( left ));
    Conjugate( right, right );
-   right = img.At( rightWindow );
-   DIP_STACK_TRACE_THIS( MirrorInPlace( right, flip ));
+   if( flip.any() ) {
+      right = img.At( rightWindow );
+      DIP_STACK_TRACE_THIS( MirrorInPlace( right, flip ));
+   }
 }
 
 // Copies the left half of the input image, and applies boundary extension for C2C dimensions
 void IDFT_C2R_1D_prepare(
-      Image const& in,     // real- or complex-valued, only half of it is used
+      Image const& in,     // real- or complex-valued, only half of it is used (it might be only this half)
       Image& out,          // half-sized copy of data, can be modified -- Note that the Sizes array of this image are expected to be set to the expected output size of the FT
       dip::uint dimension, // dimension along which to compute
+      dip::uint length,    // number of samples of the full spectrum along `dimension`
       bool corner
 ) {
    DIP_ASSERT( in.IsForged() );
    dip::uint nDims = in.Dimensionality();
    DIP_ASSERT( dimension < nDims );
    UnsignedArray outSize = out.Sizes(); // NOTE!!! we're reading  the sizes from `out`, but then modifying them
-   outSize[ dimension ] = in.Size( dimension ) / 2 + 1;
+   outSize[ dimension ] = length / 2 + 1;
    DIP_STACK_TRACE_THIS( out.ReForge( outSize, in.TensorElements(), DataType::SuggestComplex( in.DataType() )));
    RangeArray inWindow( nDims );
    inWindow[ dimension ] = { 0, static_cast< dip::sint >( outSize[ dimension ] - 1 ) };
@@ -687,7 +790,8 @@ void IDFT_C2R_1D_compute(
       Image& out,          // real-valued, already forged and with the right sizes
       dip::uint dimension, // dimension along which to compute -- same value passed to IDFT_C2R_1D_prepare()!
       dip::uint length,    // number of samples of the original input image along `dimension`. `in.Size(dimension)==length/2+1`
-      bool corner          // where to put the origin -- same value passed to IDFT_C2R_1D_prepare()!
+      bool corner,         // where to put the origin -- same value passed to IDFT_C2R_1D_prepare()!
+      dfloat scale
 ) {
    DIP_ASSERT( in.IsForged() );
    DIP_ASSERT( out.IsForged() );
@@ -712,24 +816,27 @@ void IDFT_C2R_1D_compute(
    DIP_START_STACK_TRACE
       // Get callback function
       std::unique_ptr< Framework::SeparableLineFilter > lineFilter;
-      DIP_OVL_NEW_COMPLEX( lineFilter, C2R_IDFT_LineFilter, ( out.Size( dimension ), length, corner ), dtype );
+      DIP_OVL_NEW_COMPLEX( lineFilter, C2R_IDFT_LineFilter, ( out.Size( dimension ), length, corner, scale ), dtype );
       Framework::Separable( in, out, dtype, outType, process, border, bc, *lineFilter,
                             Framework::SeparableOption::UseInputBuffer +   // input stride is always 1
                             Framework::SeparableOption::UseOutputBuffer +  // output stride is always 1
+                            Framework::SeparableOption::AlignedBuffers +   // allows FFTW to use SIMD code
                             Framework::SeparableOption::DontResizeOutput + // output is larger than input
                             Framework::SeparableOption::AsScalarImage +    // each tensor element processed separately
-                            Framework::SeparableOption::UseRealComponentOfOutput // the buffers are complex-valued, don't cast to real using abs(), but using real().
+                            Framework::SeparableOption::RealOutputBuffer   // the output buffer is real-valued
       );
    DIP_END_STACK_TRACE
 }
 
-} // namespace
-
-void FourierTransform(
+// Computes the Fourier transform as documented for `dip::FourierTransform`. For the inverse of a "half" transform,
+// `halfLength` is the number of samples along the halved dimension of the spatial-domain image. If it is 0, the
+// length is presumed even, unless `out` is protected and has an odd size along that dimension.
+void FourierTransformInternal(
       Image const& in,
       Image& out,
       StringSet const& options,
-      BooleanArray process
+      BooleanArray process,
+      dip::uint halfLength
 ) {
    DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
    dip::uint nDims = in.Dimensionality();
@@ -740,6 +847,7 @@ void FourierTransform(
    bool fast = false; // pad the image to a "nice" size?
    bool corner = false;
    bool symmetric = false;
+   bool half = false; // only half of the frequency domain is represented?
    for( auto const& option : options ) {
       if( option == S::INVERSE ) {
          inverse = true;
@@ -751,16 +859,19 @@ void FourierTransform(
          corner = true;
       } else if( option == S::SYMMETRIC ) {
          symmetric = true;
+      } else if( option == S::HALF ) {
+         half = true;
       } else {
          DIP_THROW_INVALID_FLAG( option );
       }
    }
    if( inverse ) {
       // If the output is protected and real-valued, compute a real-valued inverse transform
-      realOutput |= out.IsProtected() && !out.DataType().IsComplex();
+      realOutput |= half || ( out.IsProtected() && !out.DataType().IsComplex() );
       DIP_THROW_IF( fast && corner, "Cannot use 'corner', 'fast' and 'inverse' together" ); // TODO: figure out how to properly pad "fast"+"inverse"+"corner"...
    } else {
       DIP_THROW_IF( realOutput, "Cannot use 'real' without 'inverse' option" );
+      DIP_THROW_IF( half && in.DataType().IsComplex(), "Cannot use 'half' with a complex-valued input image" );
    }
    bool realInput = !inverse && !in.DataType().IsComplex(); // forward transform starting with real-valued data?
    DIP_ASSERT( !( realOutput && realInput )); // can't do real-to-real DFT.
@@ -773,9 +884,30 @@ void FourierTransform(
    dip::uint nProcDims = process.count();
    DIP_THROW_IF( nProcDims == 0, "Zero dimensions selected for processing" );
 
+   // With "half", the frequency domain is halved along the first dimension processed
+   dip::uint halfDimension = 0;
+   while( !process[ halfDimension ] ) {
+      ++halfDimension;
+   }
+   // Determine the sizes of the (full) input
+   UnsignedArray inSize = in.Sizes();
+   if( half && inverse ) {
+      // The input image has `size/2+1` pixels along `halfDimension`. If the caller didn't give us `size`, we presume
+      // it to be even, unless the output image is protected and has an odd size.
+      dip::uint size = halfLength;
+      if( size == 0 ) {
+         size = 2 * ( inSize[ halfDimension ] - 1 );
+         if(( size == 0 ) || ( out.IsProtected() && ( out.Dimensionality() == nDims ) && ( out.Size( halfDimension ) == size + 1 ))) {
+            ++size;
+         }
+      }
+      DIP_THROW_IF( size / 2 + 1 != inSize[ halfDimension ], E::SIZES_DONT_MATCH );
+      inSize[ halfDimension ] = size;
+   }
+
    // Determine output size and scaling
    dip::uint longestDimension = 0;
-   UnsignedArray outSize = in.Sizes();
+   UnsignedArray outSize = inSize;
    dfloat scale = 1.0;
    for( dip::uint ii = 0; ii < nDims; ++ii ) {
       if( process[ ii ] ) {
@@ -800,68 +932,68 @@ void FourierTransform(
 
    // Do the processing
    Image const in_copy = in; // Preserve input in case *in == *out
-   if( realInput && nProcDims > 1 ) {
-      // Real-to-complex transform, but only if more than one dimension is processed
+   if( realInput ) {
+      // Real-to-complex transform
 
+      // One dimension we process with the R2C function, which produces only half of the frequency domain
+      dip::uint r2cDimension = half ? halfDimension : longestDimension;
+      UnsignedArray halfSize = outSize;
+      halfSize[ r2cDimension ] = outSize[ r2cDimension ] / 2 + 1;
       // Create complex-valued output, all processing happens in here
-      DIP_STACK_TRACE_THIS( out.ReForge( outSize, in_copy.TensorElements(), DataType::SuggestComplex( in.DataType() ), Option::AcceptDataTypeChange::DO_ALLOW ));
+      DIP_STACK_TRACE_THIS( out.ReForge( half ? halfSize : outSize, in_copy.TensorElements(), DataType::SuggestComplex( in.DataType() ), Option::AcceptDataTypeChange::DO_ALLOW ));
       DIP_THROW_IF( !out.DataType().IsComplex(), "Cannot compute Fourier Transform in real-valued output" );
       Image tmp = out.QuickCopy();
+      if( !half ) {
+         // Make window over half the image
+         RangeArray window( nDims );
+         window[ r2cDimension ].stop = static_cast< dip::sint >( halfSize[ r2cDimension ] - 1 );
+         DIP_STACK_TRACE_THIS( tmp = tmp.At( window ));
+      }
       tmp.Protect(); // make sure it won't be reforged by the framework function.
-      // One dimension we process with the R2C function
-      DIP_STACK_TRACE_THIS( DFT_R2C_1D_compute( in_copy, tmp, longestDimension, corner ));
-      // Make window over half the image
-      RangeArray window( nDims );
-      window[ longestDimension ].stop = static_cast< dip::sint >( tmp.Size( longestDimension ) / 2 );
-      dip::Image tmp2;
-      DIP_STACK_TRACE_THIS( tmp2 = tmp.At( window ));
-      tmp2.Protect();
       // Compute other dimensions in place (it is this step where we do the normalization)
-      process[ longestDimension ] = false;
-      DIP_STACK_TRACE_THIS( DFT_C2C_compute( tmp2, tmp2, process, inverse, corner, scale ));
-      // Copy data to other half of image
-      DIP_STACK_TRACE_THIS( DFT_R2C_1D_finalize( tmp, process, longestDimension, corner ));
+      process[ r2cDimension ] = false;
+      bool otherDimensions = process.any();
+      DIP_STACK_TRACE_THIS( DFT_R2C_1D_compute( in_copy, tmp, r2cDimension, outSize[ r2cDimension ], corner, otherDimensions ? 1.0 : scale ));
+      if( otherDimensions ) {
+         DIP_STACK_TRACE_THIS( DFT_C2C_compute( tmp, tmp, process, inverse, corner, scale ));
+      }
+      if( !half ) {
+         // Copy data to other half of image
+         tmp.Protect( false );
+         tmp = out.QuickCopy();
+         DIP_STACK_TRACE_THIS( DFT_R2C_1D_finalize( tmp, process, r2cDimension, corner ));
+      }
+      process[ r2cDimension ] = true;
 
-   } else if( realOutput && nProcDims > 1 ) {
-      // Complex-to-real transform, but only if more than one dimension is processed
+   } else if( realOutput ) {
+      // Complex-to-real transform
 
       // Make a complex-valued copy of about half of the input
+      dip::uint c2rDimension = half ? halfDimension : longestDimension;
       Image tmp;
       tmp.SetSizes( outSize );
-      dip::uint longestDimSize = in_copy.Size( longestDimension );
-      DIP_STACK_TRACE_THIS( IDFT_C2R_1D_prepare( in_copy, tmp, longestDimension, corner )); // Note that tmp now has `longestDimSize/2+1` pixels along `longestDimension`.
+      DIP_STACK_TRACE_THIS( IDFT_C2R_1D_prepare( in_copy, tmp, c2rDimension, inSize[ c2rDimension ], corner )); // Note that tmp now has `inSize/2+1` pixels along `c2rDimension`.
       // Do the complex-to-complex transform in all but one dimension, in-place (it is this step where we do the normalization)
-      process[ longestDimension ] = false;
-      DIP_STACK_TRACE_THIS( DFT_C2C_compute( tmp, tmp, process, inverse, corner, scale ));
+      process[ c2rDimension ] = false;
+      bool otherDimensions = process.any();
+      if( otherDimensions ) {
+         DIP_STACK_TRACE_THIS( DFT_C2C_compute( tmp, tmp, process, inverse, corner, scale ));
+      }
+      process[ c2rDimension ] = true;
       // Create real-valued output image
       DIP_STACK_TRACE_THIS( out.ReForge( outSize, tmp.TensorElements(), tmp.DataType().Real(), Option::AcceptDataTypeChange::DO_ALLOW ));
       // Do the complex-to-real transform in the remaining dimension
-      DIP_STACK_TRACE_THIS( IDFT_C2R_1D_compute( tmp, out, longestDimension, longestDimSize, corner ));
+      DIP_STACK_TRACE_THIS( IDFT_C2R_1D_compute( tmp, out, c2rDimension, inSize[ c2rDimension ], corner, otherDimensions ? 1.0 : scale ));
 
    } else {
-      // Plain old complex-to-complex transform, or 1D transform
-      // In the 1D case, using the C2R or R2C machinery above yields little or no benefit, so we don't use it.
+      // Plain old complex-to-complex transform
 
       // Create complex-valued output, all processing happens in there
-      Image tmp;
-      if( realOutput ) {
-         DIP_STACK_TRACE_THIS( tmp.ReForge( outSize, in_copy.TensorElements(), DataType::SuggestComplex( in.DataType() )));
-      } else {
-         DIP_STACK_TRACE_THIS( out.ReForge( outSize, in_copy.TensorElements(), DataType::SuggestComplex( in.DataType() ), Option::AcceptDataTypeChange::DO_ALLOW ));
-         tmp = out.QuickCopy();
-      }
+      DIP_STACK_TRACE_THIS( out.ReForge( outSize, in_copy.TensorElements(), DataType::SuggestComplex( in.DataType() ), Option::AcceptDataTypeChange::DO_ALLOW ));
+      Image tmp = out.QuickCopy();
       // Compute transform
       tmp.Protect(); // make sure it won't be reforged by the framework function.
       DIP_STACK_TRACE_THIS( DFT_C2C_compute( in_copy, tmp, process, inverse, corner, scale ));
-      tmp.Protect( false );
-      // Create real-valued output if necessary
-      if( realOutput ) { // Could happen if nProcDims==1
-         tmp = tmp.Real();
-         if(( out.DataType() != tmp.DataType() ) && ( !out.IsProtected() )) {
-            out.Strip(); // Avoid accidental data conversion.
-         }
-         DIP_STACK_TRACE_THIS( out.Copy( tmp ));
-      }
 
    }
 
@@ -872,7 +1004,7 @@ void FourierTransform(
    PixelSize pixelSize = in_copy.PixelSize();
    for( dip::uint ii = 0; ii < nDims; ++ii ) {
       if( process[ ii ] ) {
-         pixelSize.Scale( ii, static_cast< dfloat >( out.Size( ii )));
+         pixelSize.Scale( ii, static_cast< dfloat >( outSize[ ii ] ));
          pixelSize.Invert( ii );
       }
    }
@@ -885,6 +1017,88 @@ void FourierTransform(
    }
 }
 
+} // namespace
+
+void FourierTransform(
+      Image const& in,
+      Image& out,
+      StringSet const& options,
+      BooleanArray process
+) {
+   FourierTransformInternal( in, out, options, std::move( process ), 0 );
+}
+
+void HalfInverseFourierTransform(
+      Image const& in,
+      Image& out,
+      UnsignedArray const& sizes,
+      StringSet options,
+      BooleanArray process
+) {
+   DIP_THROW_IF( !in.IsForged(), E::IMAGE_NOT_FORGED );
+   dip::uint nDims = in.Dimensionality();
+   DIP_THROW_IF( sizes.size() != nDims, E::ARRAY_PARAMETER_WRONG_LENGTH );
+   if( process.empty() ) {
+      process.resize( nDims, true );
+   } else {
+      DIP_THROW_IF( process.size() != nDims, E::ARRAY_PARAMETER_WRONG_LENGTH );
+   }
+   DIP_THROW_IF( !process.any(), "Zero dimensions selected for processing" );
+   dip::uint halfDimension = 0;
+   while( !process[ halfDimension ] ) {
+      ++halfDimension;
+   }
+   options.insert( S::INVERSE );
+   options.insert( S::HALF );
+   FourierTransformInternal( in, out, options, std::move( process ), sizes[ halfDimension ] );
+}
+
+
+void FourierTransform(
+      ImageConstRefArray const& in,
+      ImageRefArray& out,
+      StringSet const& options,
+      BooleanArray const& process
+) {
+   dip::uint nImages = in.size();
+   DIP_THROW_IF( out.size() != nImages, E::ARRAY_SIZES_DONT_MATCH );
+   if( nImages == 0 ) {
+      return;
+   }
+   UnsignedArray const& sizes = in[ 0 ].get().Sizes();
+   for( auto const& img : in ) {
+      DIP_THROW_IF( !img.get().IsForged(), E::IMAGE_NOT_FORGED );
+      DIP_THROW_IF( img.get().Sizes() != sizes, E::SIZES_DONT_MATCH );
+   }
+   // Estimate the cost of transforming one image, as the line filters do. A forward transform of real-valued
+   // data and an inverse transform with real-valued output ("half" implies "real") use the cheaper real-valued
+   // line transforms.
+   bool realValued = ( options.count( S::REAL ) > 0 ) || ( options.count( S::HALF ) > 0 ) ||
+                     (( options.count( S::INVERSE ) == 0 ) && !in[ 0 ].get().DataType().IsComplex() );
+   dip::uint nPixels = sizes.product() * in[ 0 ].get().TensorElements();
+   dip::uint operations = 0;
+   for( dip::uint ii = 0; ii < sizes.size(); ++ii ) {
+      if( process.empty() || (( ii < process.size() ) && process[ ii ] )) {
+         operations += ( nPixels / sizes[ ii ] ) * FourierTransformLineOperations( sizes[ ii ], realValued );
+      }
+   }
+   dip::uint maxThreads = GetNumberOfThreads();
+   dip::uint nThreads = std::min( GetOptimalNumberOfThreads( operations * nImages ), nImages );
+   if(( nThreads <= 1 ) || ( GetOptimalNumberOfThreads( operations ) >= maxThreads )) {
+      // Each image is large enough to use all threads, or there is not enough work to use multiple threads
+      for( dip::uint ii = 0; ii < nImages; ++ii ) {
+         DIP_STACK_TRACE_THIS( FourierTransform( in[ ii ].get(), out[ ii ].get(), options, process ));
+      }
+      return;
+   }
+   // Transform different images in parallel, each task takes the next image that hasn't been started yet
+   std::atomic< dip::uint > next{ 0 };
+   DIP_STACK_TRACE_THIS( ParallelRun( nThreads, [ & ]( dip::uint ) {
+      for( dip::uint ii = next++; ii < nImages; ii = next++ ) {
+         FourierTransform( in[ ii ].get(), out[ ii ].get(), options, process );
+      }
+   } ));
+}
 
 dip::uint OptimalFourierTransformSize( dip::uint size ) {
    // OpenCV's optimal size can be factorized into small primes: 2, 3, and 5.
@@ -895,6 +1109,63 @@ dip::uint OptimalFourierTransformSize( dip::uint size ) {
    return size;
 }
 
+#ifdef DIP_CONFIG_HAS_FFTW
+namespace {
+
+void AppendWisdomCharacter( char c, void* data ) {
+   static_cast< String* >( data )->push_back( c );
+}
+
+} // namespace
+#endif
+
+String FFTWisdomExport() {
+#ifdef DIP_CONFIG_HAS_FFTW
+   String wisdom;
+   std::lock_guard< std::mutex > lock( FFTWPlannerMutex() );
+   fftwapidef< double >::export_wisdom( &AppendWisdomCharacter, &wisdom );
+   fftwapidef< float >::export_wisdom( &AppendWisdomCharacter, &wisdom );
+   return wisdom;
+#else
+   return {};
+#endif
+}
+
+bool FFTWisdomImport( String const& wisdom ) {
+#ifdef DIP_CONFIG_HAS_FFTW
+   // `wisdom` contains one parenthesized expression for each precision; we import each one separately.
+   std::lock_guard< std::mutex > lock( FFTWPlannerMutex() );
+   bool success = false;
+   dip::uint depth = 0;
+   dip::uint start = 0;
+   for( dip::uint ii = 0; ii < wisdom.size(); ++ii ) {
+      if( wisdom[ ii ] == '(' ) {
+         if( depth == 0 ) {
+            start = ii;
+         }
+         ++depth;
+      } else if( wisdom[ ii ] == ')' ) {
+         if( depth == 0 ) {
+            return false;
+         }
+         --depth;
+         if( depth == 0 ) {
+            String expression = wisdom.substr( start, ii - start + 1 );
+            if( !fftwapidef< double >::import_wisdom_from_string( expression.c_str() ) &&
+                !fftwapidef< float >::import_wisdom_from_string( expression.c_str() )) {
+               return false;
+            }
+            success = true;
+         }
+      }
+   }
+   return success && ( depth == 0 );
+#else
+   ( void )wisdom;
+   return false;
+#endif
+}
+
 
 } // namespace dip
 
@@ -952,6 +1223,32 @@ DOCTEST_TEST_CASE("[DIPlib] testing the DFT function") {
    DOCTEST_CHECK( doctest::Approx( dotest< float >( 97, true )) == 0 ); // prime
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the DFT table cache") {
+   std::size_t nfft = 105;
+   std::vector< std::complex< double >> inbuf( nfft );
+   for( std::size_t ii = 0; ii < nfft; ++ii ) {
+      inbuf[ ii ] = { std::cos( static_cast< double >( ii )), std::sin( static_cast< double >( ii * ii )) };
+   }
+   dip::DFT< double > dft( nfft, false );
+   std::vector< std::complex< double >> buffer( dft.BufferSize() );
+   std::vector< std::complex< double >> expected( nfft );
+   dft.Apply( inbuf.data(), expected.data(), buffer.data(), 1.0 );
+   // Objects of the same size share their tables
+   dip::DFT< double > other( nfft, true );
+   DOCTEST_CHECK( other.BufferSize() == dft.BufferSize() );
+   // Use many different sizes, so that unused tables are evicted from the cache; `dft` must still work
+   for( std::size_t size = 1; size < 200; ++size ) {
+      dip::DFT< double > tmp( size, false );
+      DOCTEST_CHECK( tmp.TransformSize() == size );
+   }
+   std::vector< std::complex< double >> outbuf( nfft );
+   dft.Apply( inbuf.data(), outbuf.data(), buffer.data(), 1.0 );
+   DOCTEST_CHECK( outbuf == expected );
+   dft.Initialize( nfft, false );
+   dft.Apply( inbuf.data(), outbuf.data(), buffer.data(), 1.0 );
+   DOCTEST_CHECK( outbuf == expected );
+}
+
 #ifdef DIP_CONFIG_HAS_FFTW
 
 template< typename T >
@@ -983,26 +1280,76 @@ T dotest_FFTW( std::size_t nfft, bool inverse ) {
    return static_cast< T >( std::sqrt( difpower / totalpower )); // Root mean square error
 }
 
+// Compares the real-to-complex transform to the complex-to-complex one, and checks that the complex-to-real
+// transform inverts it. If `aligned` is false, the buffers are not aligned, to test the plans for unaligned data.
+template< typename T >
+T dotest_RFFTW( std::size_t nfft, bool aligned ) {
+   dip::RFFTW< T > forward;
+   forward.Initialize( nfft, false );
+   dip::RFFTW< T > inverse;
+   inverse.Initialize( nfft, true );
+   dip::FFTW< T > reference( nfft, false );
+   std::vector< T > inbuf( nfft + 1 );
+   std::vector< std::complex< T >> halfbuf( nfft / 2 + 1 );
+   std::vector< T > outbuf( nfft + 1 );
+   T* in = inbuf.data() + ( aligned ? 0 : 1 );
+   T* out = outbuf.data() + ( aligned ? 0 : 1 );
+   std::vector< std::complex< T >> refin( nfft );
+   std::vector< std::complex< T >> refout( nfft );
+   dip::Random random;
+   for( std::size_t k = 0; k < nfft; ++k ) {
+      in[ k ] = static_cast< T >( random() ) / static_cast< T >( random.max() ) - T( 0.5 );
+      refin[ k ] = in[ k ];
+   }
+   forward.Apply( in, halfbuf.data(), T( 1 ));
+   reference.Apply( refin.data(), refout.data(), T( 1 ));
+   T error = 0;
+   for( std::size_t k = 0; k < nfft / 2 + 1; ++k ) {
+      error = std::max( error, std::abs( halfbuf[ k ] - refout[ k ] ));
+   }
+   inverse.Apply( halfbuf.data(), out, T( 1 ) / static_cast< T >( nfft ));
+   for( std::size_t k = 0; k < nfft; ++k ) {
+      error = std::max( error, std::abs( out[ k ] - in[ k ] ));
+   }
+   return error;
+}
+
 DOCTEST_TEST_CASE("[DIPlib] testing the FFTW integration") {
    // Test a few different sizes that have all different radixes.
-   DOCTEST_CHECK( doctest::Approx( dotest< float >( 32, false )) == 0 );
-   DOCTEST_CHECK( doctest::Approx( dotest< double >( 32, false )) == 0 );
-   DOCTEST_CHECK( doctest::Approx( dotest< double >( 256, false )) == 0 );
-   DOCTEST_CHECK( doctest::Approx( dotest< float >( 105, false )) == 0 ); // 3*5*7
-   DOCTEST_CHECK( doctest::Approx( dotest< double >( 154, false )) == 0 ); // 2*7*11
-   DOCTEST_CHECK( doctest::Approx( dotest< float >( 97, false )) == 0 ); // prime
-   DOCTEST_CHECK( doctest::Approx( dotest< float >( 32, true )) == 0 );
-   DOCTEST_CHECK( doctest::Approx( dotest< double >( 32, true )) == 0 );
-   DOCTEST_CHECK( doctest::Approx( dotest< double >( 256, true )) == 0 );
-   DOCTEST_CHECK( doctest::Approx( dotest< float >( 105, true )) == 0 ); // 3*5*7
-   DOCTEST_CHECK( doctest::Approx( dotest< double >( 154, true )) == 0 ); // 2*7*11
-   DOCTEST_CHECK( doctest::Approx( dotest< float >( 97, true )) == 0 ); // prime
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< float >( 32, false )) == 0 );
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< double >( 32, false )) == 0 );
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< double >( 256, false )) == 0 );
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< float >( 105, false )) == 0 ); // 3*5*7
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< double >( 154, false )) == 0 ); // 2*7*11
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< float >( 97, false )) == 0 ); // prime
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< float >( 32, true )) == 0 );
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< double >( 32, true )) == 0 );
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< double >( 256, true )) == 0 );
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< float >( 105, true )) == 0 ); // 3*5*7
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< double >( 154, true )) == 0 ); // 2*7*11
+   DOCTEST_CHECK( doctest::Approx( dotest_FFTW< float >( 97, true )) == 0 ); // prime
+   // Real-to-complex and complex-to-real, with aligned and unaligned buffers
+   for( bool aligned : { true, false } ) {
+      DOCTEST_CHECK( dotest_RFFTW< float >( 32, aligned ) < 1e-5 );
+      DOCTEST_CHECK( dotest_RFFTW< double >( 256, aligned ) < 1e-12 );
+      DOCTEST_CHECK( dotest_RFFTW< float >( 105, aligned ) < 1e-5 ); // 3*5*7
+      DOCTEST_CHECK( dotest_RFFTW< double >( 97, aligned ) < 1e-12 ); // prime
+   }
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing FFTW wisdom export and import") {
+   dip::FFTW< double > fftw( 60, false ); // makes sure there is some wisdom to export
+   dip::String wisdom = dip::FFTWisdomExport();
+   DOCTEST_CHECK( !wisdom.empty() );
+   DOCTEST_CHECK( dip::FFTWisdomImport( wisdom ));
+   DOCTEST_CHECK( !dip::FFTWisdomImport( "(not wisdom)" ));
 }
 
 #endif // DIP_CONFIG_HAS_FFTW
 
 #include "diplib/generation.h"
 #include "diplib/statistics.h"
+#include "diplib/testing.h"
 
 DOCTEST_TEST_CASE("[DIPlib] testing the FourierTransform function") {
    // === 2D image, 2D transform ===
@@ -1295,4 +1642,82 @@ DOCTEST_TEST_CASE("[DIPlib] testing the FourierTransform function") {
    DOCTEST_CHECK( maxmin.Minimum() > -2e-18 );
 }
 
+DOCTEST_TEST_CASE("[DIPlib] testing the FourierTransform function with real-valued data") {
+   dip::Random random( 0 );
+   for( auto const& sz : { dip::UnsignedArray{ 9 }, dip::UnsignedArray{ 7, 5 }, dip::UnsignedArray{ 8, 6 },
+                           dip::UnsignedArray{ 9, 4 }, dip::UnsignedArray{ 6, 7 } } ) {
+      for( auto const& opts : { dip::StringSet{}, dip::StringSet{ "corner" }, dip::StringSet{ "fast" } } ) {
+         dip::Image input{ sz, 1, dip::DT_DFLOAT };
+         input.Fill( 0 );
+         dip::UniformNoise( input, input, random );
+         // Real-to-complex transform must match the complex-to-complex transform
+         dip::Image expected = dip::FourierTransform( dip::Convert( input, dip::DT_DCOMPLEX ), opts );
+         dip::Image output = dip::FourierTransform( input, opts );
+         DOCTEST_CHECK( dip::MaximumAbs( output - expected ).As< dip::dfloat >() < 1e-12 );
+         // Complex-to-real inverse transform must match the real part of the complex-to-complex inverse transform
+         dip::StringSet inverseOpts = opts;
+         inverseOpts.insert( "inverse" );
+         dip::Image complexResult = dip::FourierTransform( output, inverseOpts ).Real();
+         inverseOpts.insert( "real" );
+         dip::Image realResult = dip::FourierTransform( output, inverseOpts );
+         DOCTEST_CHECK( realResult.DataType() == dip::DT_DFLOAT );
+         DOCTEST_CHECK( dip::MaximumAbs( realResult - complexResult ).As< dip::dfloat >() < 1e-12 );
+         // The "half" forward transform produces the first half of the full frequency domain
+         dip::StringSet halfOpts = opts;
+         halfOpts.insert( "half" );
+         dip::Image halfOutput = dip::FourierTransform( input, halfOpts );
+         dip::UnsignedArray halfSize = expected.Sizes();
+         halfSize[ 0 ] = halfSize[ 0 ] / 2 + 1;
+         DOCTEST_REQUIRE( halfOutput.Sizes() == halfSize );
+         dip::RangeArray window( sz.size() );
+         window[ 0 ].stop = static_cast< dip::sint >( halfSize[ 0 ] ) - 1;
+         DOCTEST_CHECK( dip::MaximumAbs( halfOutput - expected.At( window )).As< dip::dfloat >() < 1e-12 );
+         // The "half" inverse transform recovers the input; with an odd size, a protected output tells it the size
+         if( opts.count( "fast" ) == 0 ) {
+            halfOpts.insert( "inverse" );
+            dip::Image roundTrip{ sz, 1, dip::DT_DFLOAT };
+            roundTrip.Protect();
+            dip::FourierTransform( halfOutput, roundTrip, halfOpts );
+            DOCTEST_CHECK( roundTrip.Sizes() == sz );
+            DOCTEST_CHECK( dip::MaximumAbs( roundTrip - input ).As< dip::dfloat >() < 1e-12 );
+            // The internal helper gets the size explicitly, and leaves an unprotected output unprotected
+            dip::Image helperTrip;
+            dip::HalfInverseFourierTransform( halfOutput, helperTrip, sz, opts );
+            DOCTEST_CHECK( !helperTrip.IsProtected() );
+            DOCTEST_CHECK( helperTrip.Sizes() == sz );
+            DOCTEST_CHECK( dip::MaximumAbs( helperTrip - input ).As< dip::dfloat >() < 1e-12 );
+         }
+      }
+   }
+}
+
+DOCTEST_TEST_CASE("[DIPlib] testing the batched FourierTransform function") {
+   dip::Random random( 0 );
+   dip::ImageArray images( 50 );
+   for( auto& img : images ) {
+      img = dip::Image{ dip::UnsignedArray{ 16, 15 }, 1, dip::DT_SFLOAT };
+      img.Fill( 0 );
+      dip::UniformNoise( img, img, random );
+   }
+   dip::ImageConstRefArray in = dip::CreateImageConstRefArray( images );
+   dip::ImageArray out = dip::FourierTransform( in );
+   DOCTEST_REQUIRE( out.size() == images.size() );
+   for( dip::uint ii = 0; ii < images.size(); ++ii ) {
+      DOCTEST_CHECK( dip::testing::CompareImages( out[ ii ], dip::FourierTransform( images[ ii ] )));
+   }
+   // In place, inverse transform
+   dip::ImageConstRefArray outIn = dip::CreateImageConstRefArray( out );
+   dip::ImageRefArray outOut = dip::CreateImageRefArray( out );
+   dip::FourierTransform( outIn, outOut, { "inverse", "real" } );
+   for( dip::uint ii = 0; ii < images.size(); ++ii ) {
+      DOCTEST_CHECK( out[ ii ].DataType() == dip::DT_SFLOAT );
+      DOCTEST_CHECK( dip::MaximumAbs( out[ ii ] - images[ ii ] ).As< dip::dfloat >() < 1e-6 );
+   }
+   // Mismatched sizes
+   images.back() = dip::Image{ dip::UnsignedArray{ 16, 16 }, 1, dip::DT_SFLOAT };
+   images.back().Fill( 0 );
+   in = dip::CreateImageConstRefArray( images );
+   DOCTEST_CHECK_THROWS( dip::FourierTransform( in ));
+}
+
 #endif // DIP_CONFIG_ENABLE_DOCTEST
@@ -0,0 +1,42 @@
+/*
+ * DIPlib 3.0
+ * This file contains declarations for Fourier transform support functions.
+ *
+ * (c)2017-2020, Cris Luengo.
+ * Based on original DIPlib code: (c)1995-2014, Delft University of Technology.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIP_FOURIER_SUPPORT_H
+#define DIP_FOURIER_SUPPORT_H
+
+#include "diplib.h"
+
+namespace dip {
+
+// Computes the inverse Fourier transform of `in`, which holds the non-redundant half of the frequency domain, as
+// produced by `dip::FourierTransform` with the "half" option. `sizes` are the sizes of the real-valued spatial-domain
+// output, which tell whether the halved dimension has an odd or an even number of samples. The "inverse" and "half"
+// options are added to `options`. `out` is reforged as usual.
+void HalfInverseFourierTransform(
+      Image const& in,
+      Image& out,
+      UnsignedArray const& sizes,
+      StringSet options = {},
+      BooleanArray process = {}
+);
+
+} // namespace dip
+
+#endif //DIP_FOURIER_SUPPORT_H
@@ -59,6 +59,9 @@
 #include <complex>
 #include <vector>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include "diplib/library/numeric.h"
 #include "diplib/dft.h"
@@ -138,6 +141,8 @@ constexpr static const std::complex< double > DFTTab[] = {
 
 constexpr int maxFactors = 34;  // seems to be the max number of factors we'll ever get (given 31-bit limit?)
 
+constexpr std::size_t maxCachedDFTSizes = 64;  // the number of transform sizes for which we keep the tables
+
 std::vector< int > DFTFactorize( int n ) {
    std::vector< int > factors;
    factors.reserve( maxFactors );
@@ -179,52 +184,59 @@ std::vector< int > DFTFactorize( int n ) {
 } // namespace
 
 template< typename T >
-void DFT< T >::Initialize( std::size_t nfft, bool inverse ) {
-   DIP_ASSERT( nfft <= maximumDFTSize );
-   nfft_ = static_cast< int >( nfft );
-   inverse_ = inverse;
-   factors_ = DFTFactorize( nfft_ );
-   sz_ = 0;
+struct DFT< T >::Tables {
+   std::vector< int > factors;
+   std::vector< int > itab;
+   std::vector< std::complex< T >> wave;
+   int sz = 0; // Size of the buffer to be passed to DFT.
+
+   explicit Tables( int nfft );
+};
+
+template< typename T >
+DFT< T >::Tables::Tables( int nfft ) {
+   factors = DFTFactorize( nfft );
+   sz = 0;
    {
-      int ii = factors_.size() > 1 && ( factors_[ 0 ] & 1 ) == 0;
-      if(( factors_[ ii ] & 1 ) != 0 && factors_[ ii ] > 5 ) {
-         sz_ += ( factors_[ ii ] + 1 );
+      int ii = factors.size() > 1 && ( factors[ 0 ] & 1 ) == 0;
+      if(( factors[ ii ] & 1 ) != 0 && factors[ ii ] > 5 ) {
+         sz += ( factors[ ii ] + 1 );
       }
    }
-   itab_.resize( nfft_ );
-   wave_.resize( nfft_ );
+   itab.resize( nfft );
+   wave.resize( nfft );
 
-   int n = factors_[ 0 ];
+   int n = factors[ 0 ];
    int m = 0;
-   if( nfft_ <= 5 ) {
-      itab_[ 0 ] = 0;
-      itab_[ nfft_ - 1 ] = nfft_ - 1;
+   if( nfft <= 5 ) {
+      itab[ 0 ] = 0;
+      itab[ nfft - 1 ] = nfft - 1;
 
-      if( nfft_ != 4 ) {
-         for( int i = 1; i < nfft_ - 1; i++ ) {
-            itab_[ i ] = i;
+      if( nfft != 4 ) {
+         for( int i = 1; i < nfft - 1; i++ ) {
+            itab[ i ] = i;
          }
       } else {
-         itab_[ 1 ] = 2;
-         itab_[ 2 ] = 1;
+         itab[ 1 ] = 2;
+         itab[ 2 ] = 1;
       }
-      if( nfft_ == 5 ) {
-         wave_[ 0 ] = { 1., 0. };
+      if( nfft == 5 ) {
+         wave[ 0 ] = { 1., 0. };
       }
-      if( nfft_ != 4 ) {
+      if( nfft != 4 ) {
          return;
       }
       m = 2;
    } else {
       // radix[] is initialized from index 'nf' down to zero
-      DIP_ASSERT ( factors_.size() < maxFactors );
+      DIP_ASSERT ( factors.size() < maxFactors );
       int radix[ maxFactors ];
       int digits[ maxFactors ];
-      radix[ factors_.size() ] = 1;
-      digits[ factors_.size() ] = 0;
-      for( std::size_t i = 0; i < factors_.size(); i++ ) {
+      radix[ factors.size() ] = 1;
+      digits[ factors.size() ] = 0;
+      for( std::size_t i = 0; i < factors.size(); i++ ) {
          digits[ i ] = 0;
-         radix[ factors_.size() - i - 1 ] = radix[ factors_.size() - i ] * factors_[ factors_.size() - i - 1 ];
+         radix[ factors.size() - i - 1 ] = radix[ factors.size() - i ] * factors[ factors.size() - i - 1 ];
       }
 
       if(( n & 1 ) == 0 ) {
@@ -233,41 +245,41 @@ void DFT< T >::Initialize( std::size_t nfft, bool inverse ) {
          int na4 = na2 >> 1;
          for( m = 0; ( unsigned )( 1 << m ) < ( unsigned )n; m++ ) {}
          if( n <= 2 ) {
-            itab_[ 0 ] = 0;
-            itab_[ 1 ] = na2;
+            itab[ 0 ] = 0;
+            itab[ 1 ] = na2;
          } else if( n <= 256 ) {
             int shift = 10 - m;
             for( int i = 0; i <= n - 4; i += 4 ) {
                int j = ( bitrevTab[ i >> 2 ] >> shift ) * a;
-               itab_[ i ] = j;
-               itab_[ i + 1 ] = j + na2;
-               itab_[ i + 2 ] = j + na4;
-               itab_[ i + 3 ] = j + na2 + na4;
+               itab[ i ] = j;
+               itab[ i + 1 ] = j + na2;
+               itab[ i + 2 ] = j + na4;
+               itab[ i + 3 ] = j + na2 + na4;
             }
          } else {
             int shift = maxFactors - m;
             for( int i = 0; i < n; i += 4 ) {
                int i4 = i >> 2;
                int j = BitRev( i4, shift ) * a;
-               itab_[ i ] = j;
-               itab_[ i + 1 ] = j + na2;
-               itab_[ i + 2 ] = j + na4;
-               itab_[ i + 3 ] = j + na2 + na4;
+               itab[ i ] = j;
+               itab[ i + 1 ] = j + na2;
+               itab[ i + 2 ] = j + na4;
+               itab[ i + 3 ] = j + na2 + na4;
             }
          }
 
          digits[ 1 ]++;
 
-         if( factors_.size() >= 2 ) {
-            for( int i = n, j = radix[ 2 ]; i < nfft_; ) {
+         if( factors.size() >= 2 ) {
+            for( int i = n, j = radix[ 2 ]; i < nfft; ) {
                for( int k = 0; k < n; k++ ) {
-                  itab_[ i + k ] = itab_[ k ] + j;
+                  itab[ i + k ] = itab[ k ] + j;
                }
-               if(( i += n ) >= nfft_ ) {
+               if(( i += n ) >= nfft ) {
                   break;
                }
                j += radix[ 2 ];
-               for( int k = 1; ++digits[ k ] >= factors_[ k ]; k++ ) {
+               for( int k = 1; ++digits[ k ] >= factors[ k ]; k++ ) {
                   digits[ k ] = 0;
                   j += radix[ k + 2 ] - radix[ k ];
                }
@@ -275,12 +287,12 @@ void DFT< T >::Initialize( std::size_t nfft, bool inverse ) {
          }
       } else {
          for( int i = 0, j = 0;; ) {
-            itab_[ i ] = j;
-            if( ++i >= nfft_ ) {
+            itab[ i ] = j;
+            if( ++i >= nfft ) {
                break;
             }
             j += radix[ 1 ];
-            for( int k = 0; ++digits[ k ] >= factors_[ k ]; k++ ) {
+            for( int k = 0; ++digits[ k ] >= factors[ k ]; k++ ) {
                digits[ k ] = 0;
                j += radix[ k + 2 ] - radix[ k ];
             }
@@ -289,24 +301,47 @@ void DFT< T >::Initialize( std::size_t nfft, bool inverse ) {
    }
 
    std::complex< double > w, w1;
-   if(( nfft_ & ( nfft_ - 1 )) == 0 ) {
+   if(( nfft & ( nfft - 1 )) == 0 ) {
       w = w1 = DFTTab[ m ];
    } else {
-      double t = sin( -dip::pi * 2 / nfft_ );
+      double t = sin( -dip::pi * 2 / nfft );
       w = w1 = { std::sqrt( 1. - t * t ), t };
    }
-   n = ( nfft_ + 1 ) / 2;
-   wave_[ 0 ] = { 1., 0. };
-   if(( nfft_ & 1 ) == 0 ) {
-      wave_[ n ] = { -1., 0. };
+   n = ( nfft + 1 ) / 2;
+   wave[ 0 ] = { 1., 0. };
+   if(( nfft & 1 ) == 0 ) {
+      wave[ n ] = { -1., 0. };
    }
    for( int i = 1; i < n; i++ ) {
-      wave_[ i ] = w;
-      wave_[ nfft_ - i ] = std::conj( w );
+      wave[ i ] = w;
+      wave[ nfft - i ] = std::conj( w );
       w = { w.real() * w1.real() - w.imag() * w1.imag(), w.real() * w1.imag() + w.imag() * w1.real() };
    }
 }
 
+template< typename T >
+void DFT< T >::Initialize( std::size_t nfft, bool inverse ) {
+   DIP_ASSERT( nfft <= maximumDFTSize );
+   nfft_ = static_cast< int >( nfft );
+   inverse_ = inverse;
+   // The tables depend only on the size of the transform, they are computed once and shared by all objects
+   static std::mutex mutex;
+   static std::map< int, std::shared_ptr< Tables const >> cache;
+   std::lock_guard< std::mutex > lock( mutex );
+   auto it = cache.find( nfft_ );
+   if( it == cache.end() ) {
+      if( cache.size() >= maxCachedDFTSizes ) {
+         // Forget the tables that are not in use
+         for( auto jt = cache.begin(); jt != cache.end(); ) {
+            jt = jt->second.use_count() == 1 ? cache.erase( jt ) : std::next( jt );
+         }
+      }
+      it = cache.emplace( nfft_, std::make_shared< Tables const >( nfft_ )).first;
+   }
+   tables_ = it->second;
+   sz_ = tables_->sz;
+}
+
 template< typename T >
 void DFT< T >::Apply(
       const std::complex< T >* source,
@@ -314,9 +349,11 @@ void DFT< T >::Apply(
       std::complex< T >* buffer,
       T scale
 ) const {
+   std::vector< int > const& factors = tables_->factors;
+   std::complex< T > const* twiddles = tables_->wave.data();
    int n = nfft_;
-   int const* itab = itab_.data();
-   int nf = int( factors_.size() );
+   int const* itab = tables_->itab.data();
+   int nf = int( factors.size() );
    int tab_size = n;
    int n0 = n;
    int dw0 = tab_size;
@@ -349,7 +386,7 @@ void DFT< T >::Apply(
          }
       }
    } else {
-      DIP_ASSERT( factors_[ 0 ] == factors_[ nf - 1 ] );
+      DIP_ASSERT( factors[ 0 ] == factors[ nf - 1 ] );
       if( nf == 1 ) {
          if(( n & 3 ) == 0 ) {
             int n2 = n / 2;
@@ -392,9 +429,9 @@ void DFT< T >::Apply(
 
    n = 1;
    // 1. power-2 transforms
-   if(( factors_[ 0 ] & 1 ) == 0 ) {
+   if(( factors[ 0 ] & 1 ) == 0 ) {
       // radix-4 transform
-      for( ; n * 4 <= factors_[ 0 ]; ) {
+      for( ; n * 4 <= factors[ 0 ]; ) {
          int nx = n;
          n *= 4;
          dw0 /= 4;
@@ -417,16 +454,16 @@ void DFT< T >::Apply(
                v0 = destination + i + j;
                v1 = v0 + nx * 2;
                t2 = {
-                     v0[ nx ].real() * wave_[ dw * 2 ].real() - v0[ nx ].imag() * wave_[ dw * 2 ].imag(),
-                     v0[ nx ].real() * wave_[ dw * 2 ].imag() + v0[ nx ].imag() * wave_[ dw * 2 ].real()
+                     v0[ nx ].real() * twiddles[ dw * 2 ].real() - v0[ nx ].imag() * twiddles[ dw * 2 ].imag(),
+                     v0[ nx ].real() * twiddles[ dw * 2 ].imag() + v0[ nx ].imag() * twiddles[ dw * 2 ].real()
                };
                t0 = {
-                     v1[ 0 ].real() * wave_[ dw ].imag() + v1[ 0 ].imag() * wave_[ dw ].real(),
-                     v1[ 0 ].real() * wave_[ dw ].real() - v1[ 0 ].imag() * wave_[ dw ].imag()
+                     v1[ 0 ].real() * twiddles[ dw ].imag() + v1[ 0 ].imag() * twiddles[ dw ].real(),
+                     v1[ 0 ].real() * twiddles[ dw ].real() - v1[ 0 ].imag() * twiddles[ dw ].imag()
                };
                t3 = {
-                     v1[ nx ].real() * wave_[ dw * 3 ].imag() + v1[ nx ].imag() * wave_[ dw * 3 ].real(),
-                     v1[ nx ].real() * wave_[ dw * 3 ].real() - v1[ nx ].imag() * wave_[ dw * 3 ].imag()
+                     v1[ nx ].real() * twiddles[ dw * 3 ].imag() + v1[ nx ].imag() * twiddles[ dw * 3 ].real(),
+                     v1[ nx ].real() * twiddles[ dw * 3 ].real() - v1[ nx ].imag() * twiddles[ dw * 3 ].imag()
                };
                t1 = { t0.imag() + t3.imag(), t0.real() + t3.real() };
                t3 = std::conj( t0 - t3 );
@@ -441,7 +478,7 @@ void DFT< T >::Apply(
          }
       }
 
-      for( ; n < factors_[ 0 ]; ) {
+      for( ; n < factors[ 0 ]; ) {
          // do the remaining radix-2 transform
          int nx = n;
          n *= 2;
@@ -455,8 +492,8 @@ void DFT< T >::Apply(
             for( int j = 1, dw = dw0; j < nx; j++, dw += dw0 ) {
                v = destination + i + j;
                t1 = {
-                     v[ nx ].real() * wave_[ dw ].real() - v[ nx ].imag() * wave_[ dw ].imag(),
-                     v[ nx ].imag() * wave_[ dw ].real() + v[ nx ].real() * wave_[ dw ].imag()
+                     v[ nx ].real() * twiddles[ dw ].real() - v[ nx ].imag() * twiddles[ dw ].imag(),
+                     v[ nx ].imag() * twiddles[ dw ].real() + v[ nx ].real() * twiddles[ dw ].imag()
                };
                t0 = v[ 0 ];
                v[ 0 ] = t0 + t1;
@@ -467,8 +504,8 @@ void DFT< T >::Apply(
    }
 
    // 2. all the other transforms
-   for( int f_idx = ( factors_[ 0 ] & 1 ) ? 0 : 1; f_idx < nf; f_idx++ ) {
-      int factor = factors_[ f_idx ];
+   for( int f_idx = ( factors[ 0 ] & 1 ) ? 0 : 1; f_idx < nf; f_idx++ ) {
+      int factor = factors[ f_idx ];
       int nx = n;
       n *= factor;
       dw0 /= factor;
@@ -490,12 +527,12 @@ void DFT< T >::Apply(
             for( int j = 1, dw = dw0; j < nx; j++, dw += dw0 ) {
                v = destination + i + j;
                t0 = {
-                     v[ nx ].real() * wave_[ dw ].real() - v[ nx ].imag() * wave_[ dw ].imag(),
-                     v[ nx ].real() * wave_[ dw ].imag() + v[ nx ].imag() * wave_[ dw ].real()
+                     v[ nx ].real() * twiddles[ dw ].real() - v[ nx ].imag() * twiddles[ dw ].imag(),
+                     v[ nx ].real() * twiddles[ dw ].imag() + v[ nx ].imag() * twiddles[ dw ].real()
                };
                t2 = {
-                     v[ nx * 2 ].real() * wave_[ dw * 2 ].imag() + v[ nx * 2 ].imag() * wave_[ dw * 2 ].real(),
-                     v[ nx * 2 ].real() * wave_[ dw * 2 ].real() - v[ nx * 2 ].imag() * wave_[ dw * 2 ].imag()
+                     v[ nx * 2 ].real() * twiddles[ dw * 2 ].imag() + v[ nx * 2 ].imag() * twiddles[ dw * 2 ].real(),
+                     v[ nx * 2 ].real() * twiddles[ dw * 2 ].real() - v[ nx * 2 ].imag() * twiddles[ dw * 2 ].imag()
                };
                t1 = { t0.real() + t2.imag(), t0.imag() + t2.real() };
                t2 = { t0.imag() - t2.real(), t2.imag() - t0.real() };
@@ -519,22 +556,22 @@ void DFT< T >::Apply(
                std::complex< T >* v1 = v0 + nx * 2;
                std::complex< T >* v2 = v1 + nx * 2;
                std::complex< T > t3 = {
-                     v0[ nx ].real() * wave_[ dw ].real() - v0[ nx ].imag() * wave_[ dw ].imag(),
-                     v0[ nx ].real() * wave_[ dw ].imag() + v0[ nx ].imag() * wave_[ dw ].real()
+                     v0[ nx ].real() * twiddles[ dw ].real() - v0[ nx ].imag() * twiddles[ dw ].imag(),
+                     v0[ nx ].real() * twiddles[ dw ].imag() + v0[ nx ].imag() * twiddles[ dw ].real()
                };
                std::complex< T > t2 = {
-                     v2[ 0 ].real() * wave_[ dw * 4 ].real() - v2[ 0 ].imag() * wave_[ dw * 4 ].imag(),
-                     v2[ 0 ].real() * wave_[ dw * 4 ].imag() + v2[ 0 ].imag() * wave_[ dw * 4 ].real()
+                     v2[ 0 ].real() * twiddles[ dw * 4 ].real() - v2[ 0 ].imag() * twiddles[ dw * 4 ].imag(),
+                     v2[ 0 ].real() * twiddles[ dw * 4 ].imag() + v2[ 0 ].imag() * twiddles[ dw * 4 ].real()
                };
                std::complex< T > t1 = t3 + t2;
                t3 -= t2;
                std::complex< T > t4 = {
-                     v1[ nx ].real() * wave_[ dw * 3 ].real() - v1[ nx ].imag() * wave_[ dw * 3 ].imag(),
-                     v1[ nx ].real() * wave_[ dw * 3 ].imag() + v1[ nx ].imag() * wave_[ dw * 3 ].real()
+                     v1[ nx ].real() * twiddles[ dw * 3 ].real() - v1[ nx ].imag() * twiddles[ dw * 3 ].imag(),
+                     v1[ nx ].real() * twiddles[ dw * 3 ].imag() + v1[ nx ].imag() * twiddles[ dw * 3 ].real()
                };
                std::complex< T > t0 = {
-                     v1[ 0 ].real() * wave_[ dw * 2 ].real() - v1[ 0 ].imag() * wave_[ dw * 2 ].imag(),
-                     v1[ 0 ].real() * wave_[ dw * 2 ].imag() + v1[ 0 ].imag() * wave_[ dw * 2 ].real()
+                     v1[ 0 ].real() * twiddles[ dw * 2 ].real() - v1[ 0 ].imag() * twiddles[ dw * 2 ].imag(),
+                     v1[ 0 ].real() * twiddles[ dw * 2 ].imag() + v1[ 0 ].imag() * twiddles[ dw * 2 ].real()
                };
                t2 = t4 + t0;
                t4 -= t0;
@@ -576,11 +613,11 @@ void DFT< T >::Apply(
                      b[ p - 1 ] = t1;
                   }
                } else {
-                  const std::complex< T >* wave = wave_.data() + dw * factor;
+                  const std::complex< T >* wave = twiddles + dw * factor;
                   for( int p = 1, k = nx, d = dw; p <= factor2; p++, k += nx, d += dw ) {
                      std::complex< T > t2 = {
-                           v[ k ].real() * wave_[ d ].real() - v[ k ].imag() * wave_[ d ].imag(),
-                           v[ k ].real() * wave_[ d ].imag() + v[ k ].imag() * wave_[ d ].real()
+                           v[ k ].real() * twiddles[ d ].real() - v[ k ].imag() * twiddles[ d ].imag(),
+                           v[ k ].real() * twiddles[ d ].imag() + v[ k ].imag() * twiddles[ d ].real()
                      };
                      std::complex< T > t1 = {
                            v[ n - k ].real() * wave[ -d ].real() - v[ n - k ].imag() * wave[ -d ].imag(),
@@ -600,8 +637,8 @@ void DFT< T >::Apply(
                   int d = dw_f * p;
                   int dd = d;
                   for( int q = 0; q < factor2; q++ ) {
-                     std::complex< T > t0 = { wave_[ d ].real() * a[ q ].real(), wave_[ d ].imag() * a[ q ].imag() };
-                     std::complex< T > t1 = { wave_[ d ].real() * b[ q ].imag(), wave_[ d ].imag() * b[ q ].real() };
+                     std::complex< T > t0 = { twiddles[ d ].real() * a[ q ].real(), twiddles[ d ].imag() * a[ q ].imag() };
+                     std::complex< T > t1 = { twiddles[ d ].real() * b[ q ].imag(), twiddles[ d ].imag() * b[ q ].real() };
                      s1 += std::complex< T >{ t0.real() + t0.imag(), t1.real() - t1.imag() };
                      s0 += std::complex< T >{ t0.real() - t0.imag(), t1.real() + t1.imag() };
                      d += dd;
@@ -0,0 +1,179 @@
+/*
+ * DIPlib 3.0
+ * This file contains the definitions for dip::RDFT, the DFT of real-valued data.
+ *
+ * (c)2020, Cris Luengo.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "diplib.h"
+#include "diplib/dft.h"
+
+namespace dip {
+
+template< typename T >
+void RDFT< T >::Initialize( std::size_t nfft, bool inverse ) {
+   nfft_ = nfft;
+   if( nfft & 1u ) {
+      dft_.Initialize( nfft, inverse );
+      twiddle_.clear();
+   } else {
+      // x[2n] + i x[2n+1] is transformed with a DFT of half the size, the twiddle factors recombine the even
+      // and odd samples: X[k] = E[k] + W^k O[k], with W = exp(-2 pi i / nfft) for the forward transform.
+      std::size_t half = nfft / 2;
+      dft_.Initialize( half, inverse );
+      twiddle_.resize( half );
+      dfloat phase = ( inverse ? 2.0 : -2.0 ) * pi / static_cast< dfloat >( nfft );
+      for( std::size_t k = 0; k < half; ++k ) {
+         dfloat angle = phase * static_cast< dfloat >( k );
+         twiddle_[ k ] = { static_cast< T >( std::cos( angle )), static_cast< T >( std::sin( angle )) };
+      }
+   }
+}
+
+template< typename T >
+void RDFT< T >::Apply(
+      const T* source,
+      std::complex< T >* destination,
+      std::complex< T >* buffer,
+      T scale
+) const {
+   DIP_ASSERT( !IsInverse() );
+   std::size_t n = dft_.TransformSize();
+   std::complex< T >* packed = buffer;
+   std::complex< T >* spectrum = buffer + n;
+   std::complex< T >* work = buffer + 2 * n;
+   if( nfft_ & 1u ) {
+      for( std::size_t ii = 0; ii < n; ++ii ) {
+         packed[ ii ] = source[ ii ];
+      }
+      dft_.Apply( packed, spectrum, work, scale );
+      std::copy( spectrum, spectrum + n / 2 + 1, destination );
+      return;
+   }
+   for( std::size_t ii = 0; ii < n; ++ii ) {
+      packed[ ii ] = { source[ 2 * ii ], source[ 2 * ii + 1 ] };
+   }
+   dft_.Apply( packed, spectrum, work, T( 1 ));
+   destination[ 0 ] = ( spectrum[ 0 ].real() + spectrum[ 0 ].imag() ) * scale;
+   destination[ n ] = ( spectrum[ 0 ].real() - spectrum[ 0 ].imag() ) * scale;
+   for( std::size_t k = 1; k < n; ++k ) {
+      std::complex< T > a = spectrum[ k ];
+      std::complex< T > b = std::conj( spectrum[ n - k ] );
+      std::complex< T > even = ( a + b ) * T( 0.5 );
+      std::complex< T > odd = ( a - b ) * std::complex< T >( 0, T( -0.5 ));
+      destination[ k ] = ( even + twiddle_[ k ] * odd ) * scale;
+   }
+}
+
+template< typename T >
+void RDFT< T >::Apply(
+      const std::complex< T >* source,
+      T* destination,
+      std::complex< T >* buffer,
+      T scale
+) const {
+   DIP_ASSERT( IsInverse() );
+   std::size_t n = dft_.TransformSize();
+   std::complex< T >* packed = buffer;
+   std::complex< T >* result = buffer + n;
+   std::complex< T >* work = buffer + 2 * n;
+   if( nfft_ & 1u ) {
+      packed[ 0 ] = source[ 0 ].real();
+      for( std::size_t k = 1; k <= n / 2; ++k ) {
+         packed[ k ] = source[ k ];
+         packed[ n - k ] = std::conj( source[ k ] );
+      }
+      dft_.Apply( packed, result, work, scale );
+      for( std::size_t ii = 0; ii < n; ++ii ) {
+         destination[ ii ] = result[ ii ].real();
+      }
+      return;
+   }
+   // The even samples are the inverse transform of E[k] = X[k] + X[k+n], the odd samples that of
+   // O[k] = ( X[k] - X[k+n] ) W^-k, with X[k+n] = conj( X[n-k] ).
+   for( std::size_t k = 0; k < n; ++k ) {
+      std::complex< T > a = k == 0 ? std::complex< T >( source[ 0 ].real() ) : source[ k ];
+      std::complex< T > b = k == 0 ? std::complex< T >( source[ n ].real() ) : std::conj( source[ n - k ] );
+      std::complex< T > even = a + b;
+      std::complex< T > odd = ( a - b ) * twiddle_[ k ];
+      packed[ k ] = even + std::complex< T >( -odd.imag(), odd.real() ); // even + i * odd
+   }
+   dft_.Apply( packed, result, work, scale );
+   for( std::size_t ii = 0; ii < n; ++ii ) {
+      destination[ 2 * ii ] = result[ ii ].real();
+      destination[ 2 * ii + 1 ] = result[ ii ].imag();
+   }
+}
+
+template class RDFT< float >;
+template class RDFT< double >;
+
+} // namespace dip
+
+
+#ifdef DIP_CONFIG_ENABLE_DOCTEST
+#include "doctest.h"
+#include "diplib/random.h"
+
+namespace {
+
+// Compares the forward and inverse real-valued DFT with the complex DFT of the same data, returns the
+// largest relative error
+template< typename T >
+T CompareToComplexDFT( std::size_t nfft ) {
+   dip::Random random( nfft );
+   std::vector< T > data( nfft );
+   std::vector< std::complex< T >> complexData( nfft );
+   for( std::size_t ii = 0; ii < nfft; ++ii ) {
+      data[ ii ] = static_cast< T >( random() ) / static_cast< T >( random.max() ) - T( 0.5 );
+      complexData[ ii ] = data[ ii ];
+   }
+   dip::DFT< T > dft( nfft, false );
+   std::vector< std::complex< T >> buffer( dft.BufferSize() );
+   std::vector< std::complex< T >> expected( nfft );
+   dft.Apply( complexData.data(), expected.data(), buffer.data(), T( 1 ));
+   // Forward transform
+   dip::RDFT< T > rdft( nfft, false );
+   buffer.resize( rdft.BufferSize() );
+   std::vector< std::complex< T >> spectrum( nfft / 2 + 1 );
+   rdft.Apply( data.data(), spectrum.data(), buffer.data(), T( 1 ));
+   T norm = 0;
+   T error = 0;
+   for( std::size_t ii = 0; ii < spectrum.size(); ++ii ) {
+      norm = std::max( norm, std::abs( expected[ ii ] ));
+      error = std::max( error, std::abs( expected[ ii ] - spectrum[ ii ] ));
+   }
+   error /= norm;
+   // Inverse transform, should give back the input
+   dip::RDFT< T > irdft( nfft, true );
+   buffer.resize( irdft.BufferSize() );
+   std::vector< T > result( nfft );
+   irdft.Apply( spectrum.data(), result.data(), buffer.data(), T( 1 ) / static_cast< T >( nfft ));
+   for( std::size_t ii = 0; ii < nfft; ++ii ) {
+      error = std::max( error, std::abs( result[ ii ] - data[ ii ] ));
+   }
+   return error;
+}
+
+} // namespace
+
+DOCTEST_TEST_CASE("[DIPlib] testing the RDFT function") {
+   for( std::size_t nfft : { 2u, 3u, 4u, 7u, 10u, 32u, 97u, 105u, 154u, 256u } ) {
+      DOCTEST_CHECK( CompareToComplexDFT< float >( nfft ) < 1e-5 );
+      DOCTEST_CHECK( CompareToComplexDFT< double >( nfft ) < 1e-12 );
+   }
+}
+
+#endif // DIP_CONFIG_ENABLE_DOCTEST